@@ -0,0 +1,185 @@
+#include <frame_pacing.hpp>
+
+#include <cassert>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Frames between in-flight decisions.
+constexpr unsigned int pacingWindowFrameCount = 128;
+
+int64_t getTicks() noexcept
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return counter.QuadPart;
+}
+
+// Fewer frames in flight lowers latency, more absorb CPU spikes.
+void adaptFramesInFlight(FramePacer& pacer) noexcept
+{
+    if (++pacer.windowFrameCount < pacingWindowFrameCount)
+    {
+        return;
+    }
+
+    if (pacer.windowMissedCount > 1 && pacer.framesInFlight < pacer.maxFramesInFlight)
+    {
+        ++pacer.framesInFlight;
+
+        print("Frame pacing: %u missed presents, %u frames in flight\n", pacer.windowMissedCount, pacer.framesInFlight);
+    }
+    else if (pacer.windowMissedCount == 0 && pacer.windowFenceWaitCount > pacingWindowFrameCount / 2 && pacer.framesInFlight > pacer.minFramesInFlight)
+    {
+        // The CPU keeps running into the GPU without missing presents, the extra queued frame only adds latency.
+        --pacer.framesInFlight;
+
+        print("Frame pacing: GPU bound without misses, %u frames in flight\n", pacer.framesInFlight);
+    }
+
+    pacer.windowFrameCount = 0;
+    pacer.windowMissedCount = 0;
+    pacer.windowFenceWaitCount = 0;
+}
+}
+
+FramePacer createFramePacer(unsigned int minFramesInFlight, unsigned int maxFramesInFlight) noexcept
+{
+    assert(minFramesInFlight >= 1 && minFramesInFlight <= maxFramesInFlight && maxFramesInFlight <= maxPacedFramesInFlight);
+
+    FramePacer pacer;
+
+    pacer.minFramesInFlight = minFramesInFlight;
+    pacer.maxFramesInFlight = maxFramesInFlight;
+    pacer.framesInFlight = maxFramesInFlight > 2 && minFramesInFlight <= 2 ? 2 : maxFramesInFlight;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    pacer.frequency = frequency.QuadPart;
+
+    return pacer;
+}
+
+void destroyFramePacer(FramePacer& pacer) noexcept
+{
+    for (GLsync& fence : pacer.fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+void beginPacedFrame(FramePacer& pacer) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (pacer.frameIndex < pacer.framesInFlight)
+    {
+        return;
+    }
+
+    GLsync fence = pacer.fences[(pacer.frameIndex - pacer.framesInFlight) % maxPacedFramesInFlight];
+
+    if (!fence)
+    {
+        return;
+    }
+
+    // Zero timeout first, an already signaled fence means the GPU was waiting for this frame.
+    GLenum result = glClientWaitSync(fence, 0, 0);
+
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+    {
+        ++pacer.stats.gpuStarvedCount;
+
+        return;
+    }
+
+    const int64_t waitStart = getTicks();
+
+    while (result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+    }
+
+    assert(result != GL_WAIT_FAILED);
+
+    const double waitSeconds = static_cast<double>(getTicks() - waitStart) / static_cast<double>(pacer.frequency);
+
+    pacer.stats.fenceWaitSeconds += waitSeconds;
+    pacer.stats.maxFenceWaitSeconds = waitSeconds > pacer.stats.maxFenceWaitSeconds ? waitSeconds : pacer.stats.maxFenceWaitSeconds;
+
+    ++pacer.windowFenceWaitCount;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void endPacedFrame(FramePacer& pacer) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    GLsync& fence = pacer.fences[pacer.frameIndex % maxPacedFramesInFlight];
+
+    // Waited for or older than any frame still waited for.
+    if (fence)
+    {
+        glDeleteSync(fence);
+    }
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    const int64_t now = getTicks();
+
+    if (pacer.lastPresentTime)
+    {
+        const double interval = static_cast<double>(now - pacer.lastPresentTime) / static_cast<double>(pacer.frequency);
+
+        pacer.stats.presentIntervalSeconds += interval;
+        pacer.stats.presentIntervalSquaredSeconds += interval * interval;
+        pacer.stats.maxPresentIntervalSeconds = interval > pacer.stats.maxPresentIntervalSeconds ? interval : pacer.stats.maxPresentIntervalSeconds;
+        ++pacer.stats.frameCount;
+
+        // Tracks the shortest interval but follows refresh rate changes slowly.
+        if (pacer.refreshIntervalSeconds == 0.0 || interval < pacer.refreshIntervalSeconds)
+        {
+            pacer.refreshIntervalSeconds = interval;
+        }
+        else
+        {
+            pacer.refreshIntervalSeconds += (interval - pacer.refreshIntervalSeconds) * 0.001;
+        }
+
+        if (interval > pacer.refreshIntervalSeconds * 1.5)
+        {
+            ++pacer.stats.missedCount;
+            ++pacer.windowMissedCount;
+        }
+
+        adaptFramesInFlight(pacer);
+    }
+
+    pacer.lastPresentTime = now;
+    ++pacer.frameIndex;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void resumeFramePacing(FramePacer& pacer) noexcept
+{
+    pacer.lastPresentTime = 0;
+}
+
+FramePacingStats takeFramePacingStats(FramePacer& pacer) noexcept
+{
+    const FramePacingStats stats = pacer.stats;
+
+    pacer.stats = {};
+
+    return stats;
+}
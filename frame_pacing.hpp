@@ -0,0 +1,71 @@
+#ifndef KZ_FRAME_PACING_HPP
+#define KZ_FRAME_PACING_HPP
+
+#include "gl_functions.h"
+
+#include <cstdint>
+
+constexpr unsigned int maxPacedFramesInFlight = 3;
+
+struct FramePacingStats
+{
+    unsigned int frameCount{};
+
+    // Between consecutive returns from the swap.
+    double presentIntervalSeconds{};
+    double presentIntervalSquaredSeconds{};
+    double maxPresentIntervalSeconds{};
+
+    // CPU blocked on the fence of an earlier frame.
+    double fenceWaitSeconds{};
+    double maxFenceWaitSeconds{};
+
+    // Frames whose fence had already signaled, the GPU went idle waiting for the CPU.
+    unsigned int gpuStarvedCount{};
+
+    // Present intervals longer than one and a half refresh intervals.
+    unsigned int missedCount{};
+};
+
+// Fences bound how many frames the CPU may record ahead of the GPU.
+struct FramePacer
+{
+    GLsync fences[maxPacedFramesInFlight]{};
+    uint64_t frameIndex{};
+
+    // Adapts between the two, fixed when they are equal.
+    unsigned int minFramesInFlight{};
+    unsigned int maxFramesInFlight{};
+    unsigned int framesInFlight{};
+
+    int64_t frequency{};
+    int64_t lastPresentTime{};
+
+    // Shortest recent present interval, taken as the refresh interval.
+    double refreshIntervalSeconds{};
+
+    // Window the in-flight count is adapted over.
+    unsigned int windowFrameCount{};
+    unsigned int windowMissedCount{};
+    unsigned int windowFenceWaitCount{};
+
+    FramePacingStats stats;
+};
+
+FramePacer createFramePacer(unsigned int minFramesInFlight, unsigned int maxFramesInFlight) noexcept;
+
+void destroyFramePacer(FramePacer& pacer) noexcept;
+
+// Blocks until no more than framesInFlight - 1 earlier frames are unfinished on the GPU.
+void beginPacedFrame(FramePacer& pacer) noexcept;
+
+// After the swap, fences the frame and measures the present interval.
+void endPacedFrame(FramePacer& pacer) noexcept;
+
+// After the render loop idled, drops the last present so the gap is not measured as a missed frame.
+void resumeFramePacing(FramePacer& pacer) noexcept;
+
+// Returns and clears the stats gathered since the last call.
+FramePacingStats takeFramePacingStats(FramePacer& pacer) noexcept;
+
+#endif
@@ -0,0 +1,332 @@
+#include <frame_recording.hpp>
+#include <job_system.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Ranges small enough to balance over the workers, the merge order is the range order.
+constexpr unsigned int minObjectsPerBuffer = 256;
+constexpr unsigned int maxCommandBufferCount = 64;
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+// Column-major, clip[r] = sum of matrix[c * 4 + r] * v[c].
+void multiplyMatrices(GLfloat* result, const GLfloat* left, const GLfloat* right) noexcept
+{
+    for (unsigned int c = 0; c < 4; ++c)
+    {
+        for (unsigned int r = 0; r < 4; ++r)
+        {
+            result[c * 4 + r] = left[0 * 4 + r] * right[c * 4 + 0] + left[1 * 4 + r] * right[c * 4 + 1] +
+                                left[2 * 4 + r] * right[c * 4 + 2] + left[3 * 4 + r] * right[c * 4 + 3];
+        }
+    }
+}
+
+// Gribb-Hartmann planes from the rows of the view-projection, normalized for sphere tests.
+void extractFrustumPlanes(GLfloat planes[6][4], const GLfloat* m) noexcept
+{
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            planes[i * 2 + 0][j] = m[j * 4 + 3] + m[j * 4 + i];
+            planes[i * 2 + 1][j] = m[j * 4 + 3] - m[j * 4 + i];
+        }
+    }
+
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        const float length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            planes[i][j] /= length;
+        }
+    }
+}
+
+bool isSphereInFrustum(const GLfloat planes[6][4], const GLfloat* center, float radius) noexcept
+{
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        if (planes[i][0] * center[0] + planes[i][1] * center[1] + planes[i][2] * center[2] + planes[i][3] < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void recordSceneRange(void* userData, unsigned int bufferIndex) noexcept
+{
+    FrameRecording& recording = *static_cast<FrameRecording*>(userData);
+    RenderCommandBuffer& buffer = recording.commandBuffers[bufferIndex];
+
+    resetRenderCommandBuffer(buffer);
+
+    const size_t objectCount = recording.objects.size();
+    const size_t first = static_cast<size_t>(bufferIndex) * recording.objectsPerBuffer;
+    const size_t last = first + recording.objectsPerBuffer < objectCount ? first + recording.objectsPerBuffer : objectCount;
+
+    for (size_t i = first; i < last; ++i)
+    {
+        const SceneObject& object = recording.objects[i];
+
+        // The cube corners bound the rotated cube.
+        if (!isSphereInFrustum(recording.frustumPlanes, object.position, object.halfSize * 1.7320508f))
+        {
+            continue;
+        }
+
+        const float angle = recording.time * object.spin;
+        const float c = std::cos(angle) * object.halfSize;
+        const float s = std::sin(angle) * object.halfSize;
+
+        const GLfloat model[16] =
+        {
+               c, 0.0f,   -s, 0.0f,
+            0.0f, object.halfSize, 0.0f, 0.0f,
+               s, 0.0f,    c, 0.0f,
+            object.position[0], object.position[1], object.position[2], 1.0f,
+        };
+
+        GLfloat modelViewProjection[16];
+        multiplyMatrices(modelViewProjection, recording.viewProjection, model);
+
+        const GLfloat* matrix = pushCommandMatrix(buffer, modelViewProjection);
+
+        if (!matrix)
+        {
+            return;
+        }
+
+        const float depth = modelViewProjection[15] / recording.farZ;
+
+        DrawPacket* packet = pushCommandPacket(buffer, makeSortKey(renderPassColor, renderOrderOpaque, object.program, object.texture, depth));
+
+        packet->type = drawPacketArrays;
+        packet->depthTest = true;
+        packet->program = object.program;
+        packet->vertexArray = object.vertexArray;
+        packet->texture = object.texture;
+        packet->matrix = matrix;
+        packet->uniformProgram = object.program;
+        packet->matrixUniform = 0;
+        packet->count = 36;
+    }
+}
+
+bool isSamePacket(const DrawPacket& left, const DrawPacket& right) noexcept
+{
+    if (left.type != right.type || left.depthTest != right.depthTest || left.program != right.program || left.pipeline != right.pipeline ||
+        left.vertexArray != right.vertexArray || left.texture != right.texture || left.framebuffer != right.framebuffer ||
+        left.uniformProgram != right.uniformProgram || left.matrixUniform != right.matrixUniform || left.occlusionQuery != right.occlusionQuery ||
+        left.mode != right.mode || left.first != right.first || left.count != right.count || left.drawCount != right.drawCount ||
+        left.indirectBuffer != right.indirectBuffer || left.clearMask != right.clearMask)
+    {
+        return false;
+    }
+
+    if (std::memcmp(left.viewport, right.viewport, sizeof(left.viewport)) != 0 || std::memcmp(left.clearColor, right.clearColor, sizeof(left.clearColor)) != 0)
+    {
+        return false;
+    }
+
+    if (!left.matrix || !right.matrix)
+    {
+        return left.matrix == right.matrix;
+    }
+
+    return std::memcmp(left.matrix, right.matrix, 16 * sizeof(GLfloat)) == 0;
+}
+
+// Both queues must be sorted.
+bool isSameSubmission(const RenderQueue& left, const RenderQueue& right) noexcept
+{
+    if (left.packetCount != right.packetCount)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < left.packetCount; ++i)
+    {
+        if (left.keys[i] != right.keys[i] || !isSamePacket(left.packets[left.order[i]], right.packets[right.order[i]]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+}
+
+FrameRecording createFrameRecording(unsigned int objectCount) noexcept
+{
+    FrameRecording recording;
+
+    recording.objects.resize(objectCount);
+
+    unsigned int random = 0x9e3779b9u;
+
+    const auto nextRandom = [&random]()
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        return random;
+    };
+
+    const auto nextUnit = [&nextRandom]()
+    {
+        return static_cast<float>(nextRandom() & 0xffff) / 65535.0f;
+    };
+
+    for (SceneObject& object : recording.objects)
+    {
+        object.position[0] = -120.0f + 240.0f * nextUnit();
+        object.position[1] = -120.0f + 240.0f * nextUnit();
+        object.position[2] = -5.0f - 190.0f * nextUnit();
+        object.halfSize = 0.25f + nextUnit();
+        object.spin = -2.0f + 4.0f * nextUnit();
+
+        // 8 programs, 32 textures and 4 vertex arrays.
+        object.program = 1 + nextRandom() % 8;
+        object.texture = 1 + nextRandom() % 32;
+        object.vertexArray = 1 + nextRandom() % 4;
+    }
+
+    unsigned int bufferCount = (objectCount + minObjectsPerBuffer - 1) / minObjectsPerBuffer;
+    bufferCount = bufferCount < maxCommandBufferCount ? bufferCount : maxCommandBufferCount;
+    bufferCount = bufferCount > 0 ? bufferCount : 1;
+
+    recording.objectsPerBuffer = (objectCount + bufferCount - 1) / bufferCount;
+
+    recording.commandBuffers.reserve(bufferCount);
+
+    for (unsigned int i = 0; i < bufferCount; ++i)
+    {
+        recording.commandBuffers.push_back(createRenderCommandBuffer(recording.objectsPerBuffer, static_cast<size_t>(recording.objectsPerBuffer) * 16 * sizeof(GLfloat)));
+    }
+
+    // Camera at the origin looking down -z, frustum from -1 to 1 at the near plane.
+    const float nearZ = 1.0f;
+    const float farZ = 200.0f;
+
+    const GLfloat projection[16] =
+    {
+        nearZ, 0.0f, 0.0f, 0.0f,
+        0.0f, nearZ, 0.0f, 0.0f,
+        0.0f, 0.0f, -(farZ + nearZ) / (farZ - nearZ), -1.0f,
+        0.0f, 0.0f, -2.0f * farZ * nearZ / (farZ - nearZ), 0.0f,
+    };
+
+    std::memcpy(recording.viewProjection, projection, sizeof(projection));
+    extractFrustumPlanes(recording.frustumPlanes, recording.viewProjection);
+
+    recording.farZ = farZ;
+
+    return recording;
+}
+
+void recordSceneFrame(JobSystem* jobSystem, FrameRecording& recording, RenderQueue& queue, float time) noexcept
+{
+    recording.time = time;
+
+    const unsigned int bufferCount = static_cast<unsigned int>(recording.commandBuffers.size());
+
+    if (jobSystem)
+    {
+        runJobs(*jobSystem, recordSceneRange, &recording, bufferCount);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < bufferCount; ++i)
+        {
+            recordSceneRange(&recording, i);
+        }
+    }
+
+    mergeRenderCommandBuffers(queue, recording.commandBuffers.data(), bufferCount);
+}
+
+void benchmarkParallelRecording() noexcept
+{
+    constexpr unsigned int objectCounts[] = { 10000, 100000, 250000 };
+    constexpr unsigned int frameCount = 8;
+
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    for (const unsigned int objectCount : objectCounts)
+    {
+        // Single-threaded reference of the last frame.
+        FrameRecording referenceRecording = createFrameRecording(objectCount);
+        RenderQueue referenceQueue = createRenderQueue(objectCount, 0);
+
+        recordSceneFrame(nullptr, referenceRecording, referenceQueue, static_cast<float>(frameCount - 1) / 60.0f);
+        sortRenderQueue(referenceQueue);
+
+        FrameRecording recording = createFrameRecording(objectCount);
+        RenderQueue queue = createRenderQueue(objectCount, 0);
+
+        double singleThreadSeconds = 0.0;
+
+        for (unsigned int threadCount = 1; threadCount <= coreCount; ++threadCount)
+        {
+            JobSystem* jobSystem = createJobSystem(threadCount - 1);
+
+            double recordSeconds = 0.0;
+            double mergeSeconds = 0.0;
+
+            for (unsigned int frame = 0; frame < frameCount; ++frame)
+            {
+                beginRenderQueueFrame(queue);
+
+                const float time = static_cast<float>(frame) / 60.0f;
+                const double start = getSeconds();
+
+                recording.time = time;
+                runJobs(*jobSystem, recordSceneRange, &recording, static_cast<unsigned int>(recording.commandBuffers.size()));
+
+                const double recorded = getSeconds();
+
+                mergeRenderCommandBuffers(queue, recording.commandBuffers.data(), static_cast<unsigned int>(recording.commandBuffers.size()));
+
+                recordSeconds += recorded - start;
+                mergeSeconds += getSeconds() - recorded;
+            }
+
+            destroyJobSystem(jobSystem);
+
+            sortRenderQueue(queue);
+
+            const bool identical = isSameSubmission(queue, referenceQueue);
+
+            recordSeconds /= frameCount;
+            mergeSeconds /= frameCount;
+
+            if (threadCount == 1)
+            {
+                singleThreadSeconds = recordSeconds;
+            }
+
+            print("Parallel recording: %6u objects, %2u threads, %5u packets, record %7.3f ms (%5.2fx), merge %7.3f ms, %s\n",
+                objectCount, threadCount, queue.packetCount, recordSeconds * 1000.0, singleThreadSeconds / recordSeconds, mergeSeconds * 1000.0,
+                identical ? "identical" : "MISMATCH");
+        }
+    }
+}
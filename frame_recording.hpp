@@ -0,0 +1,46 @@
+#ifndef KZ_FRAME_RECORDING_HPP
+#define KZ_FRAME_RECORDING_HPP
+
+#include <render_queue.hpp>
+
+#include <vector>
+
+struct JobSystem;
+
+// Cube with one of a few materials, spinning around its vertical axis.
+struct SceneObject
+{
+    GLfloat position[3]{};
+    GLfloat halfSize{};
+    GLfloat spin{};
+
+    GLuint program{};
+    GLuint texture{};
+    GLuint vertexArray{};
+};
+
+// Frame prep split into contiguous object ranges, each job updates, culls and records one range into its own command buffer.
+struct FrameRecording
+{
+    std::vector<SceneObject> objects;
+    std::vector<RenderCommandBuffer> commandBuffers;
+    unsigned int objectsPerBuffer{};
+
+    GLfloat viewProjection[16]{};
+    GLfloat frustumPlanes[6][4]{};
+    GLfloat farZ{};
+
+    float time{};
+};
+
+// Deterministic scene of objects in front of a fixed camera, some outside the frustum.
+FrameRecording createFrameRecording(unsigned int objectCount) noexcept;
+
+// Records the scene at the given time with the jobs and merges the command buffers into the queue on this thread.
+// A null job system records every range in order on this thread, the queue ends up with the same packets either way.
+void recordSceneFrame(JobSystem* jobSystem, FrameRecording& recording, RenderQueue& queue, float time) noexcept;
+
+// Times update, cull and record from one to all cores and checks the sorted packets against single-threaded recording.
+void benchmarkParallelRecording() noexcept;
+
+#endif
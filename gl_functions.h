@@ -13,6 +13,9 @@
     X(PFNGLBINDBUFFERPROC,				 glBindBuffer               ) \
     X(PFNGLCREATEBUFFERSPROC,            glCreateBuffers            ) \
     X(PFNGLNAMEDBUFFERSTORAGEPROC,       glNamedBufferStorage       ) \
+    X(PFNGLMAPNAMEDBUFFERRANGEPROC,      glMapNamedBufferRange      ) \
+    X(PFNGLUNMAPNAMEDBUFFERPROC,         glUnmapNamedBuffer         ) \
+    X(PFNGLDELETEBUFFERSPROC,            glDeleteBuffers            ) \
     X(PFNGLBUFFERSTORAGEPROC,			 glBufferStorage			) \
     X(PFNGLBINDVERTEXARRAYPROC,          glBindVertexArray          ) \
     X(PFNGLISVERTEXARRAYPROC,			 glIsVertexArray            ) \
@@ -30,6 +33,13 @@
     X(PFNGLCREATESHADERPROGRAMVPROC,     glCreateShaderProgramv     ) \
     X(PFNGLGETPROGRAMIVPROC,             glGetProgramiv             ) \
     X(PFNGLGETPROGRAMINFOLOGPROC,        glGetProgramInfoLog        ) \
+    X(PFNGLPROGRAMPARAMETERIPROC,        glProgramParameteri        ) \
+    X(PFNGLGETPROGRAMBINARYPROC,         glGetProgramBinary         ) \
+    X(PFNGLPROGRAMBINARYPROC,            glProgramBinary            ) \
+    X(PFNGLGETSTRINGIPROC,               glGetStringi               ) \
+    X(PFNGLGETPROGRAMINTERFACEIVPROC,    glGetProgramInterfaceiv    ) \
+    X(PFNGLGETPROGRAMRESOURCEIVPROC,     glGetProgramResourceiv     ) \
+    X(PFNGLGETPROGRAMRESOURCENAMEPROC,   glGetProgramResourceName   ) \
     X(PFNGLGENPROGRAMPIPELINESPROC,      glGenProgramPipelines      ) \
     X(PFNGLUSEPROGRAMSTAGESPROC,         glUseProgramStages         ) \
     X(PFNGLBINDPROGRAMPIPELINEPROC,      glBindProgramPipeline      ) \
@@ -43,11 +53,22 @@
     X(PFNGLTEXTUREPARAMETERIPROC,        glTextureParameteri        ) \
     X(PFNGLTEXTURESTORAGE2DPROC,         glTextureStorage2D         ) \
     X(PFNGLTEXTURESUBIMAGE2DPROC,        glTextureSubImage2D        ) \
-    X(PFNGLGENFRAMEBUFFERSPROC,			 glGenFramebuffers			) \
+    X(PFNGLCOMPRESSEDTEXTURESUBIMAGE2DPROC, glCompressedTextureSubImage2D ) \
+    X(PFNGLTEXTURESTORAGE3DPROC,         glTextureStorage3D         ) \
+    X(PFNGLTEXTURESUBIMAGE3DPROC,        glTextureSubImage3D        ) \
+    X(PFNGLCOMPRESSEDTEXTURESUBIMAGE3DPROC, glCompressedTextureSubImage3D ) \
+    X(PFNGLGENERATETEXTUREMIPMAPPROC,    glGenerateTextureMipmap    ) \
+    X(PFNGLCREATESAMPLERSPROC,           glCreateSamplers           ) \
+    X(PFNGLDELETESAMPLERSPROC,           glDeleteSamplers           ) \
+    X(PFNGLSAMPLERPARAMETERIPROC,        glSamplerParameteri        ) \
+    X(PFNGLSAMPLERPARAMETERFPROC,        glSamplerParameterf        ) \
+    X(PFNGLBINDSAMPLERPROC,              glBindSampler              ) \
+    X(PFNGLCREATEFRAMEBUFFERSPROC,       glCreateFramebuffers       ) \
     X(PFNGLBINDFRAMEBUFFERPROC,			 glBindFramebuffer			) \
-    X(PFNGLFRAMEBUFFERTEXTURE2DPROC,	 glFramebufferTexture2D		) \
-    X(PFNGLDRAWBUFFERSPROC,				 glDrawBuffers				) \
-    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC,	 glCheckFramebufferStatus   ) \
+    X(PFNGLNAMEDFRAMEBUFFERTEXTUREPROC,  glNamedFramebufferTexture  ) \
+    X(PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC, glNamedFramebufferDrawBuffers ) \
+    X(PFNGLNAMEDFRAMEBUFFERREADBUFFERPROC, glNamedFramebufferReadBuffer ) \
+    X(PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC, glCheckNamedFramebufferStatus ) \
     X(PFNGLUSEPROGRAMPROC,				 glUseProgram				) \
     X(PFNGLLINKPROGRAMPROC,				 glLinkProgram				) \
     X(PFNGLPROGRAMUNIFORM3FPROC,		 glProgramUniform3f			) \
@@ -61,6 +82,9 @@
     X(PFNGLUNIFORM1FPROC,		 glUniform1f		) \
     X(PFNGLUNIFORM1UIPROC,		 glUniform1ui		) \
     X(PFNGLUNIFORM2IVPROC,		 glUniform2iv		) \
+    X(PFNGLUNIFORM1IPROC,		 glUniform1i		) \
+    X(PFNGLUNIFORM3FVPROC,		 glUniform3fv		) \
+    X(PFNGLUNIFORM4FVPROC,		 glUniform4fv		) \
     X(PFNGLGETATTACHEDSHADERSPROC,	     glGetAttachedShaders	    ) \
     X(PFNGLDELETESHADERPROC,	     glDeleteShader	    ) \
     X(PFNGLCREATESHADERPROC,	     glCreateShader	    ) \
@@ -76,11 +100,32 @@
     X(PFNGLISSHADERPROC,	     glIsShader	    ) \
     X(PFNGLGETUNIFORMLOCATIONPROC,	     glGetUniformLocation	    ) \
     X(PFNGLVERTEXATTRIBPOINTERPROC,	     glVertexAttribPointer	    ) \
+    X(PFNGLVERTEXATTRIBIPOINTERPROC,     glVertexAttribIPointer     ) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC,      glVertexAttribDivisor      ) \
     X(PFNGLBUFFERDATAPROC,	     glBufferData	    ) \
     X(PFNGLBUFFERSUBDATAPROC,	     glBufferSubData	    ) \
+    X(PFNGLNAMEDBUFFERSUBDATAPROC,       glNamedBufferSubData       ) \
+    X(PFNGLBINDBUFFERBASEPROC,           glBindBufferBase           ) \
+    X(PFNGLDISPATCHCOMPUTEPROC,          glDispatchCompute          ) \
+    X(PFNGLMEMORYBARRIERPROC,            glMemoryBarrier            ) \
+    X(PFNGLDRAWELEMENTSINDIRECTPROC,     glDrawElementsIndirect     ) \
+    X(PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC, glDrawArraysInstancedBaseInstance ) \
+    X(PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC, glDrawElementsInstancedBaseInstance ) \
+    X(PFNGLGETNAMEDBUFFERSUBDATAPROC,    glGetNamedBufferSubData    ) \
+    X(PFNGLBINDIMAGETEXTUREPROC,         glBindImageTexture         ) \
+    X(PFNGLGENQUERIESPROC,               glGenQueries               ) \
+    X(PFNGLDELETEQUERIESPROC,            glDeleteQueries            ) \
+    X(PFNGLBEGINQUERYPROC,               glBeginQuery               ) \
+    X(PFNGLENDQUERYPROC,                 glEndQuery                 ) \
+    X(PFNGLGETQUERYOBJECTUIVPROC,        glGetQueryObjectuiv        ) \
+    X(PFNGLGETQUERYOBJECTUI64VPROC,      glGetQueryObjectui64v      ) \
+    X(PFNGLFENCESYNCPROC,                glFenceSync                ) \
+    X(PFNGLCLIENTWAITSYNCPROC,           glClientWaitSync           ) \
+    X(PFNGLDELETESYNCPROC,               glDeleteSync               ) \
     X(PFNGLDEBUGMESSAGECALLBACKPROC,     glDebugMessageCallback     )
 
-#define X(type, name) static type name;
+// One set of function pointers shared by all translation units.
+#define X(type, name) inline type name;
 GL_FUNCTIONS(X)
 #undef X
 
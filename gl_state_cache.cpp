@@ -0,0 +1,206 @@
+#include <gl_state_cache.hpp>
+
+#include <cassert>
+
+namespace
+{
+enum CachedCapability : unsigned int
+{
+    cachedBlend,
+    cachedDepthTest,
+    cachedCullFace,
+    cachedCapabilityCount,
+};
+
+struct GLStateCache
+{
+    GLuint program{};
+    GLuint pipeline{};
+    GLuint vertexArray{};
+    GLuint textures[maxCachedTextureUnits]{};
+    GLuint samplers[maxCachedTextureUnits]{};
+    GLuint framebuffer{};
+    bool capabilities[cachedCapabilityCount]{};
+    GLint viewport[4]{};
+
+    // Each entry is trusted only after the cache issued it once.
+    bool programValid{};
+    bool pipelineValid{};
+    bool vertexArrayValid{};
+    bool texturesValid[maxCachedTextureUnits]{};
+    bool samplersValid[maxCachedTextureUnits]{};
+    bool framebufferValid{};
+    bool capabilitiesValid[cachedCapabilityCount]{};
+    bool viewportValid{};
+
+    GLStateCacheStats frameStats{};
+    GLStateCacheStats lastFrameStats{};
+};
+
+GLStateCache glStateCache;
+
+// Returns true when the call must be issued and records the new value.
+template<typename T>
+bool updateCachedValue(T& cached, bool& valid, T value) noexcept
+{
+    if (valid && cached == value)
+    {
+        ++glStateCache.frameStats.elidedCount;
+
+        return false;
+    }
+
+    cached = value;
+    valid = true;
+
+    ++glStateCache.frameStats.issuedCount;
+
+    return true;
+}
+
+int getCachedCapability(GLenum capability) noexcept
+{
+    switch (capability)
+    {
+        case GL_BLEND: return cachedBlend;
+        case GL_DEPTH_TEST: return cachedDepthTest;
+        case GL_CULL_FACE: return cachedCullFace;
+    }
+
+    return -1;
+}
+
+}
+
+void invalidateGLStateCache() noexcept
+{
+    const GLStateCacheStats frameStats = glStateCache.frameStats;
+    const GLStateCacheStats lastFrameStats = glStateCache.lastFrameStats;
+
+    glStateCache = {};
+
+    glStateCache.frameStats = frameStats;
+    glStateCache.lastFrameStats = lastFrameStats;
+}
+
+void cachedUseProgram(GLuint program) noexcept
+{
+    if (updateCachedValue(glStateCache.program, glStateCache.programValid, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void cachedBindProgramPipeline(GLuint pipeline) noexcept
+{
+    cachedUseProgram(0);
+
+    if (updateCachedValue(glStateCache.pipeline, glStateCache.pipelineValid, pipeline))
+    {
+        glBindProgramPipeline(pipeline);
+    }
+}
+
+void cachedBindVertexArray(GLuint vertexArray) noexcept
+{
+    if (updateCachedValue(glStateCache.vertexArray, glStateCache.vertexArrayValid, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void cachedBindTextureUnit(GLuint unit, GLuint texture) noexcept
+{
+    assert(unit < maxCachedTextureUnits);
+
+    if (updateCachedValue(glStateCache.textures[unit], glStateCache.texturesValid[unit], texture))
+    {
+        // Independent of the active texture unit.
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void forgetCachedTexture(GLuint texture) noexcept
+{
+    for (GLuint unit = 0; unit < maxCachedTextureUnits; ++unit)
+    {
+        if (glStateCache.textures[unit] == texture)
+        {
+            glStateCache.texturesValid[unit] = false;
+        }
+    }
+}
+
+void cachedBindSampler(GLuint unit, GLuint sampler) noexcept
+{
+    assert(unit < maxCachedTextureUnits);
+
+    if (updateCachedValue(glStateCache.samplers[unit], glStateCache.samplersValid[unit], sampler))
+    {
+        glBindSampler(unit, sampler);
+    }
+}
+
+void cachedBindFramebuffer(GLuint framebuffer) noexcept
+{
+    if (updateCachedValue(glStateCache.framebuffer, glStateCache.framebufferValid, framebuffer))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+}
+
+void cachedEnable(GLenum capability, bool enabled) noexcept
+{
+    const int cached = getCachedCapability(capability);
+
+    if (cached < 0 || updateCachedValue(glStateCache.capabilities[cached], glStateCache.capabilitiesValid[cached], enabled))
+    {
+        if (cached < 0)
+        {
+            ++glStateCache.frameStats.issuedCount;
+        }
+
+        if (enabled)
+        {
+            glEnable(capability);
+        }
+        else
+        {
+            glDisable(capability);
+        }
+    }
+}
+
+void cachedViewport(GLint x, GLint y, GLsizei width, GLsizei height) noexcept
+{
+    GLint* viewport = glStateCache.viewport;
+
+    if (glStateCache.viewportValid && viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height)
+    {
+        ++glStateCache.frameStats.elidedCount;
+
+        return;
+    }
+
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+
+    glStateCache.viewportValid = true;
+
+    ++glStateCache.frameStats.issuedCount;
+
+    glViewport(x, y, width, height);
+}
+
+void endGLStateCacheFrame() noexcept
+{
+    glStateCache.lastFrameStats = glStateCache.frameStats;
+    glStateCache.frameStats = {};
+}
+
+GLStateCacheStats getGLStateCacheStats() noexcept
+{
+    return glStateCache.lastFrameStats;
+}
@@ -0,0 +1,48 @@
+#ifndef KZ_GL_STATE_CACHE_HPP
+#define KZ_GL_STATE_CACHE_HPP
+
+#include "gl_functions.h"
+
+constexpr GLuint maxCachedTextureUnits = 16;
+
+// GL calls that reached the driver and calls dropped as redundant.
+struct GLStateCacheStats
+{
+    unsigned int issuedCount{};
+    unsigned int elidedCount{};
+};
+
+// Shadow of the bound GL state for the current context, calls that would not change it are dropped.
+// Code that changes the shadowed state with plain GL calls must invalidate the cache afterwards.
+void invalidateGLStateCache() noexcept;
+
+void cachedUseProgram(GLuint program) noexcept;
+
+// Also unbinds the program, a bound program overrides the pipeline.
+void cachedBindProgramPipeline(GLuint pipeline) noexcept;
+
+void cachedBindVertexArray(GLuint vertexArray) noexcept;
+
+// Tracks one texture per unit, only 2D textures are bound through the cache.
+void cachedBindTextureUnit(GLuint unit, GLuint texture) noexcept;
+
+// Call before deleting a texture, GL may hand its name to a new texture that a cached binding would then skip.
+void forgetCachedTexture(GLuint texture) noexcept;
+
+// Tracks one sampler per unit, zero leaves the sampling state to the texture.
+void cachedBindSampler(GLuint unit, GLuint sampler) noexcept;
+
+// Binds both the draw and the read framebuffer.
+void cachedBindFramebuffer(GLuint framebuffer) noexcept;
+
+// Blend, depth test and face culling are shadowed, other capabilities are passed through.
+void cachedEnable(GLenum capability, bool enabled) noexcept;
+
+void cachedViewport(GLint x, GLint y, GLsizei width, GLsizei height) noexcept;
+
+// Closes the frame's counters, read them with getGLStateCacheStats.
+void endGLStateCacheFrame() noexcept;
+
+GLStateCacheStats getGLStateCacheStats() noexcept;
+
+#endif
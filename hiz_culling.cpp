@@ -0,0 +1,246 @@
+#include <hiz_culling.hpp>
+#include <textured_cube_shader.hpp>
+#include <gl_state_cache.hpp>
+#include <texture_samplers.hpp>
+
+#include <cassert>
+
+namespace
+{
+constexpr GLuint reduceWorkGroupSize = 8;
+
+const GLchar* hiZReduceShaderSource =
+R"kz_shader(
+    layout(local_size_x = 8, local_size_y = 8) in;
+
+    uniform sampler2D depthTexture;
+
+    layout(r32f, binding = 0) readonly uniform image2D sourceLevel;
+    layout(r32f, binding = 1) writeonly uniform image2D destinationLevel;
+
+    uniform bool readDepth;
+    uniform ivec2 sourceSize;
+    uniform ivec2 destinationSize;
+
+    float loadSource(ivec2 position)
+    {
+        position = min(position, sourceSize - 1);
+
+        return readDepth ? texelFetch(depthTexture, position, 0).r : imageLoad(sourceLevel, position).r;
+    }
+
+    void main()
+    {
+        ivec2 position = ivec2(gl_GlobalInvocationID.xy);
+
+        if (any(greaterThanEqual(position, destinationSize)))
+        {
+            return;
+        }
+
+        ivec2 source = position * 2;
+
+        float depth = max(max(loadSource(source), loadSource(source + ivec2(1, 0))),
+                          max(loadSource(source + ivec2(0, 1)), loadSource(source + ivec2(1, 1))));
+
+        // Odd source sizes fold the extra column and row into the last texel, texel t of level l covers depth texels [t, t + 1) << (l + 1).
+        bool extraX = (sourceSize.x & 1) != 0 && position.x == destinationSize.x - 1;
+        bool extraY = (sourceSize.y & 1) != 0 && position.y == destinationSize.y - 1;
+
+        if (extraX)
+        {
+            depth = max(depth, max(loadSource(source + ivec2(2, 0)), loadSource(source + ivec2(2, 1))));
+        }
+
+        if (extraY)
+        {
+            depth = max(depth, max(loadSource(source + ivec2(0, 2)), loadSource(source + ivec2(1, 2))));
+        }
+
+        if (extraX && extraY)
+        {
+            depth = max(depth, loadSource(source + ivec2(2, 2)));
+        }
+
+        imageStore(destinationLevel, position, vec4(depth));
+    }
+)kz_shader";
+
+GLsizei getHalfSize(GLsizei size) noexcept
+{
+    return size > 1 ? size / 2 : 1;
+}
+
+}
+
+void submitHiZPyramidProgram() noexcept
+{
+    submitComputeShaderProgram(hiZReduceShaderSource);
+}
+
+HiZPyramid createHiZPyramid(GLuint depthTexture, GLsizei depthWidth, GLsizei depthHeight) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(depthWidth > 0 && depthHeight > 0);
+
+    HiZPyramid pyramid = {};
+
+    UniformReflection uniforms;
+    pyramid.reduceProgram = createComputeShaderProgram(hiZReduceShaderSource, uniforms);
+
+    pyramid.readDepthUniform = getUniformLocation(uniforms, uniformName("readDepth"));
+    pyramid.sourceSizeUniform = getUniformLocation(uniforms, uniformName("sourceSize"));
+    pyramid.destinationSizeUniform = getUniformLocation(uniforms, uniformName("destinationSize"));
+
+    assert(pyramid.readDepthUniform >= 0);
+    assert(pyramid.sourceSizeUniform >= 0);
+    assert(pyramid.destinationSizeUniform >= 0);
+
+    pyramid.depthTexture = depthTexture;
+    pyramid.depthWidth = depthWidth;
+    pyramid.depthHeight = depthHeight;
+
+    pyramid.width = getHalfSize(depthWidth);
+    pyramid.height = getHalfSize(depthHeight);
+
+    for (GLsizei width = pyramid.width, height = pyramid.height; ; width = getHalfSize(width), height = getHalfSize(height))
+    {
+        ++pyramid.levelCount;
+
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &pyramid.texture);
+    glTextureStorage2D(pyramid.texture, pyramid.levelCount, GL_R32F, pyramid.width, pyramid.height);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return pyramid;
+}
+
+void buildHiZPyramid(HiZPyramid& pyramid) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(pyramid.reduceProgram && pyramid.texture);
+
+    if (!pyramid.hasDepth)
+    {
+        return;
+    }
+
+    cachedUseProgram(pyramid.reduceProgram);
+
+    // Only fetched with texelFetch, filtering would mix depths of different texels.
+    cachedBindTextureUnit(0, pyramid.depthTexture);
+    cachedBindSampler(0, getSharedSampler(samplerPointClamp));
+
+    GLsizei sourceWidth = pyramid.depthWidth;
+    GLsizei sourceHeight = pyramid.depthHeight;
+
+    GLsizei width = pyramid.width;
+    GLsizei height = pyramid.height;
+
+    for (GLsizei level = 0; level < pyramid.levelCount; ++level)
+    {
+        const GLint sourceSize[] = { sourceWidth, sourceHeight };
+        const GLint destinationSize[] = { width, height };
+
+        glUniform1i(pyramid.readDepthUniform, level == 0);
+        glUniform2iv(pyramid.sourceSizeUniform, 1, sourceSize);
+        glUniform2iv(pyramid.destinationSizeUniform, 1, destinationSize);
+
+        if (level > 0)
+        {
+            glBindImageTexture(0, pyramid.texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        }
+
+        glBindImageTexture(1, pyramid.texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((static_cast<GLuint>(width) + reduceWorkGroupSize - 1) / reduceWorkGroupSize, (static_cast<GLuint>(height) + reduceWorkGroupSize - 1) / reduceWorkGroupSize, 1);
+
+        // The next level reads this one through the image unit.
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        sourceWidth = width;
+        sourceHeight = height;
+
+        width = getHalfSize(width);
+        height = getHalfSize(height);
+    }
+
+    // Culling fetches the pyramid as a texture.
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    pyramid.built = true;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+OcclusionQuery createOcclusionQuery() noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    OcclusionQuery occlusionQuery = {};
+
+    glGenQueries(1, &occlusionQuery.query);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return occlusionQuery;
+}
+
+bool isOccludedByQuery(OcclusionQuery& occlusionQuery) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (occlusionQuery.pending)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(occlusionQuery.query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available)
+        {
+            GLuint anySamplesPassed = GL_TRUE;
+            glGetQueryObjectuiv(occlusionQuery.query, GL_QUERY_RESULT, &anySamplesPassed);
+
+            occlusionQuery.occluded = anySamplesPassed == GL_FALSE;
+            occlusionQuery.pending = false;
+        }
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return occlusionQuery.occluded;
+}
+
+bool beginOcclusionQuery(OcclusionQuery& occlusionQuery) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (occlusionQuery.pending)
+    {
+        return false;
+    }
+
+    // Conservative may report visible for occluded proxies, never the reverse.
+    glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, occlusionQuery.query);
+
+    occlusionQuery.pending = true;
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return true;
+}
+
+void endOcclusionQuery(OcclusionQuery& occlusionQuery) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(occlusionQuery.pending);
+
+    glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
@@ -0,0 +1,69 @@
+#ifndef KZ_HIZ_CULLING_HPP
+#define KZ_HIZ_CULLING_HPP
+
+#include "gl_functions.h"
+
+// Per-frame culling counters, also the layout of the GPU counter buffer.
+struct OcclusionStats
+{
+    GLuint objectsTested{};
+    GLuint objectsOccluded{};
+    GLuint meshletsTested{};
+    GLuint meshletsFrustumCulled{};
+    GLuint meshletsConeCulled{};
+    GLuint meshletsOccluded{};
+    GLuint meshletsVisible{};
+    GLuint padding{};
+};
+
+// Max-depth mip chain of a depth texture, level 0 is half the depth resolution.
+struct HiZPyramid
+{
+    GLuint reduceProgram{};
+    GLint readDepthUniform{};
+    GLint sourceSizeUniform{};
+    GLint destinationSizeUniform{};
+
+    GLuint texture{};
+    GLsizei width{};
+    GLsizei height{};
+    GLsizei levelCount{};
+
+    // Depth attachment reduced by buildHiZPyramid.
+    GLuint depthTexture{};
+    GLsizei depthWidth{};
+    GLsizei depthHeight{};
+
+    // Set once the depth texture holds a rendered frame, an unbuilt pyramid must not cull.
+    bool hasDepth{};
+    bool built{};
+};
+
+// Fallback for draws without the compute cull pass, tests a proxy against the depth buffer.
+// Results are read one or more frames late so the CPU never waits on the GPU.
+struct OcclusionQuery
+{
+    GLuint query{};
+    bool pending{};
+    bool occluded{};
+};
+
+// Starts compiling the reduce program so createHiZPyramid does not wait for the whole compile.
+void submitHiZPyramidProgram() noexcept;
+
+HiZPyramid createHiZPyramid(GLuint depthTexture, GLsizei depthWidth, GLsizei depthHeight) noexcept;
+
+// Reduces the current contents of the depth texture, call before the depth is cleared for the new frame.
+void buildHiZPyramid(HiZPyramid& pyramid) noexcept;
+
+OcclusionQuery createOcclusionQuery() noexcept;
+
+// Polls the pending query without stalling and returns the latest known visibility.
+bool isOccludedByQuery(OcclusionQuery& occlusionQuery) noexcept;
+
+// Starts a query unless the previous result is still in flight, returns whether the proxy draw should be issued.
+bool beginOcclusionQuery(OcclusionQuery& occlusionQuery) noexcept;
+
+void endOcclusionQuery(OcclusionQuery& occlusionQuery) noexcept;
+
+#endif
@@ -0,0 +1,2368 @@
+#include <image_decoder.hpp>
+#include <job_system.hpp>
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// Larger images are rejected before anything is allocated.
+constexpr uint32_t maxImageSize = 16384;
+
+// Huffman codes of at most this many bits are decoded with one table lookup.
+constexpr int huffmanFastBits = 9;
+
+constexpr int deflateLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr int deflateLengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr int deflateDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+constexpr int deflateDistanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+constexpr unsigned char deflateCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// Natural order index of each zigzag position.
+constexpr unsigned char jpegZigzag[64] =
+{
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Deflate Huffman codes are read least significant bit first.
+struct InflateHuffmanTable
+{
+    // (length << 9) | symbol for codes of at most huffmanFastBits bits, 0 for longer codes.
+    uint16_t fast[1 << huffmanFastBits]{};
+
+    // Canonical codes of each length, maxCode is one past the last code left aligned to 16 bits.
+    uint16_t firstCode[17]{};
+    uint16_t firstSymbol[17]{};
+    uint32_t maxCode[17]{};
+
+    uint16_t symbols[288]{};
+};
+
+struct InflateBitReader
+{
+    const unsigned char* data{};
+    size_t size{};
+
+    // Reads past the end see zeros, position tells how far.
+    size_t position{};
+
+    uint64_t bits{};
+    int bitCount{};
+};
+
+// JPEG Huffman codes are read most significant bit first.
+struct JpegHuffmanTable
+{
+    // (length << 8) | symbol for codes of at most huffmanFastBits bits, 0 for longer codes.
+    uint16_t fast[1 << huffmanFastBits]{};
+
+    // One past the last code of each length left aligned to 16 bits, symbol index is code + valueOffset.
+    uint32_t maxCode[18]{};
+    int valueOffset[17]{};
+
+    unsigned char symbols[256]{};
+    unsigned int symbolCount{};
+};
+
+struct JpegBitReader
+{
+    const unsigned char* data{};
+    size_t size{};
+    size_t position{};
+
+    // Left aligned, zeros are shifted in after a marker or the end of the data.
+    uint64_t bits{};
+    int bitCount{};
+    bool isAtMarker{};
+};
+
+struct JpegComponent
+{
+    unsigned int id{};
+    int horizontalSampling{};
+    int verticalSampling{};
+    unsigned int quantizationTable{};
+    unsigned int dcTable{};
+    unsigned int acTable{};
+    int dcPredictor{};
+
+    // Samples of whole blocks covering all MCUs.
+    std::vector<unsigned char> plane;
+    size_t planeStride{};
+};
+
+struct JpegDecoder
+{
+    const unsigned char* data{};
+    size_t size{};
+    size_t position{};
+
+    // Zigzag order.
+    uint16_t quantizationTables[4][64]{};
+    bool isQuantizationTableDefined[4]{};
+
+    JpegHuffmanTable dcTables[4];
+    JpegHuffmanTable acTables[4];
+
+    JpegComponent components[3];
+    int componentCount{};
+
+    int width{};
+    int height{};
+    int maxHorizontalSampling{};
+    int maxVerticalSampling{};
+    int mcusPerLine{};
+    int mcusPerColumn{};
+
+    unsigned int restartInterval{};
+
+    // Adobe APP14 transform 0 marks three components as RGB.
+    bool isRgb{};
+};
+
+// Cosine basis of the 8 point inverse DCT, idct[x][u].
+struct IdctTable
+{
+    alignas(16) float basis[8][8];
+    alignas(16) float transposedBasis[8][8];
+};
+
+struct DecodeBatch
+{
+    const char* const* paths{};
+    TextureImage* images{};
+};
+
+struct MemoryDecodeBatch
+{
+    ImageFileFormat format{};
+    const std::vector<unsigned char>* file{};
+    TextureImage* images{};
+};
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+uint32_t readBigEndian32(const unsigned char* p) noexcept
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+unsigned int readBigEndian16(const unsigned char* p) noexcept
+{
+    return (static_cast<unsigned int>(p[0]) << 8) | static_cast<unsigned int>(p[1]);
+}
+
+unsigned int readLittleEndian16(const unsigned char* p) noexcept
+{
+    return static_cast<unsigned int>(p[0]) | (static_cast<unsigned int>(p[1]) << 8);
+}
+
+bool hasExtension(const char* path, const char* extension) noexcept
+{
+    const size_t pathLength = strlen(path);
+    const size_t extensionLength = strlen(extension);
+
+    if (pathLength < extensionLength)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < extensionLength; ++i)
+    {
+        const char c = path[pathLength - extensionLength + i];
+
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != extension[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Level 0 only, with capacity for the mip chain so generating it does not move the texels.
+void allocateImage(TextureImage& image, int width, int height) noexcept
+{
+    image.width = width;
+    image.height = height;
+    image.levelCount = 1;
+    image.internalFormat = GL_RGBA8;
+
+    TextureImage fullChain;
+    fullChain.width = width;
+    fullChain.height = height;
+
+    image.pixels.reserve(getTextureLevelOffset(fullChain, getFullMipLevelCount(width, height)));
+    image.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * textureTexelSize);
+}
+
+//
+// Row conversion to RGBA8, PackRGBA of intrinsics.h four or eight texels at a time.
+//
+
+void convertRgbaRow(const unsigned char* source, unsigned char* destination, int width) noexcept
+{
+    memcpy(destination, source, static_cast<size_t>(width) * 4);
+}
+
+// BGRA to RGBA, alpha is replaced by 255 when the source has none.
+void convertBgraRow(const unsigned char* source, unsigned char* destination, int width, bool hasAlpha) noexcept
+{
+    int x = 0;
+
+#if defined(__AVX2__)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        const __m256i alpha = _mm256_set1_epi32(hasAlpha ? 0 : static_cast<int>(0xFF000000u));
+
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + x * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x * 4), _mm256_or_si256(_mm256_shuffle_epi8(texels, shuffle), alpha));
+        }
+    }
+#endif
+
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m128i alpha = _mm_set1_epi32(hasAlpha ? 0 : static_cast<int>(0xFF000000u));
+
+    for (; x + 4 <= width; x += 4)
+    {
+        const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4), _mm_or_si128(_mm_shuffle_epi8(texels, shuffle), alpha));
+    }
+
+    for (; x < width; ++x)
+    {
+        destination[x * 4 + 0] = source[x * 4 + 2];
+        destination[x * 4 + 1] = source[x * 4 + 1];
+        destination[x * 4 + 2] = source[x * 4 + 0];
+        destination[x * 4 + 3] = hasAlpha ? source[x * 4 + 3] : 255;
+    }
+}
+
+// RGB or BGR to RGBA, redOffset is 0 for RGB and 2 for BGR.
+void convertThreeChannelRow(const unsigned char* source, unsigned char* destination, int width, int redOffset) noexcept
+{
+    const __m128i shuffle = redOffset == 0 ? _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1) :
+                                             _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    int x = 0;
+
+    // Each load reads 16 bytes for 12 used ones, so the last texels are left to the scalar loop.
+    for (; x + 6 <= width; x += 4)
+    {
+        const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4), _mm_or_si128(_mm_shuffle_epi8(texels, shuffle), alpha));
+    }
+
+    for (; x < width; ++x)
+    {
+        destination[x * 4 + 0] = source[x * 3 + redOffset];
+        destination[x * 4 + 1] = source[x * 3 + 1];
+        destination[x * 4 + 2] = source[x * 3 + 2 - redOffset];
+        destination[x * 4 + 3] = 255;
+    }
+}
+
+void convertGrayRow(const unsigned char* source, unsigned char* destination, int width) noexcept
+{
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i grays = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x));
+
+        for (int quarter = 0; quarter < 4; ++quarter)
+        {
+            const char i = static_cast<char>(quarter * 4);
+            const __m128i shuffle = _mm_setr_epi8(i, i, i, -1, i + 1, i + 1, i + 1, -1, i + 2, i + 2, i + 2, -1, i + 3, i + 3, i + 3, -1);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + (x + quarter * 4) * 4), _mm_or_si128(_mm_shuffle_epi8(grays, shuffle), alpha));
+        }
+    }
+
+    for (; x < width; ++x)
+    {
+        destination[x * 4 + 0] = source[x];
+        destination[x * 4 + 1] = source[x];
+        destination[x * 4 + 2] = source[x];
+        destination[x * 4 + 3] = 255;
+    }
+}
+
+void convertGrayAlphaRow(const unsigned char* source, unsigned char* destination, int width) noexcept
+{
+    const __m128i lowShuffle = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+    const __m128i highShuffle = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 2));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4), _mm_shuffle_epi8(texels, lowShuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4 + 16), _mm_shuffle_epi8(texels, highShuffle));
+    }
+
+    for (; x < width; ++x)
+    {
+        destination[x * 4 + 0] = source[x * 2];
+        destination[x * 4 + 1] = source[x * 2];
+        destination[x * 4 + 2] = source[x * 2];
+        destination[x * 4 + 3] = source[x * 2 + 1];
+    }
+}
+
+unsigned char clampToByte(float value) noexcept
+{
+    const int rounded = static_cast<int>(lrintf(value));
+
+    return static_cast<unsigned char>(rounded < 0 ? 0 : (rounded > 255 ? 255 : rounded));
+}
+
+// JFIF YCbCr to RGBA. Rounds and saturates like PackRGBA, then transposes four planar texels to RGBA order.
+void convertYCbCrRow(const unsigned char* luma, const unsigned char* blueDifference, const unsigned char* redDifference, unsigned char* destination, int width) noexcept
+{
+    const __m128 center = _mm_set1_ps(128.0f);
+    const __m128 crToR = _mm_set1_ps(1.402f);
+    const __m128 cbToG = _mm_set1_ps(0.344136f);
+    const __m128 crToG = _mm_set1_ps(0.714136f);
+    const __m128 cbToB = _mm_set1_ps(1.772f);
+    const __m128i opaque = _mm_set1_epi32(255);
+    const __m128i transpose = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4)
+    {
+        int32_t y4, cb4, cr4;
+        memcpy(&y4, luma + x, 4);
+        memcpy(&cb4, blueDifference + x, 4);
+        memcpy(&cr4, redDifference + x, 4);
+
+        const __m128 y = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(y4)));
+        const __m128 cb = _mm_sub_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(cb4))), center);
+        const __m128 cr = _mm_sub_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(cr4))), center);
+
+        const __m128 r = _mm_add_ps(y, _mm_mul_ps(cr, crToR));
+        const __m128 g = _mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(cb, cbToG)), _mm_mul_ps(cr, crToG));
+        const __m128 b = _mm_add_ps(y, _mm_mul_ps(cb, cbToB));
+
+        const __m128i redGreen = _mm_packs_epi32(_mm_cvtps_epi32(r), _mm_cvtps_epi32(g));
+        const __m128i blueAlpha = _mm_packs_epi32(_mm_cvtps_epi32(b), opaque);
+        const __m128i planar = _mm_packus_epi16(redGreen, blueAlpha);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x * 4), _mm_shuffle_epi8(planar, transpose));
+    }
+
+    for (; x < width; ++x)
+    {
+        const float y = static_cast<float>(luma[x]);
+        const float cb = static_cast<float>(blueDifference[x]) - 128.0f;
+        const float cr = static_cast<float>(redDifference[x]) - 128.0f;
+
+        destination[x * 4 + 0] = clampToByte(y + 1.402f * cr);
+        destination[x * 4 + 1] = clampToByte(y - 0.344136f * cb - 0.714136f * cr);
+        destination[x * 4 + 2] = clampToByte(y + 1.772f * cb);
+        destination[x * 4 + 3] = 255;
+    }
+}
+
+void convertPlanarRgbRow(const unsigned char* red, const unsigned char* green, const unsigned char* blue, unsigned char* destination, int width) noexcept
+{
+    for (int x = 0; x < width; ++x)
+    {
+        destination[x * 4 + 0] = red[x];
+        destination[x * 4 + 1] = green[x];
+        destination[x * 4 + 2] = blue[x];
+        destination[x * 4 + 3] = 255;
+    }
+}
+
+//
+// Inflate, zlib streams of PNG.
+//
+
+unsigned int reverseBits(unsigned int code, int length) noexcept
+{
+    unsigned int reversed = 0;
+
+    for (int i = 0; i < length; ++i)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+
+    return reversed;
+}
+
+bool buildInflateHuffmanTable(InflateHuffmanTable& table, const unsigned char* lengths, unsigned int symbolCount) noexcept
+{
+    int lengthCounts[16]{};
+
+    for (unsigned int symbol = 0; symbol < symbolCount; ++symbol)
+    {
+        ++lengthCounts[lengths[symbol]];
+    }
+
+    lengthCounts[0] = 0;
+    memset(table.fast, 0, sizeof(table.fast));
+
+    unsigned int nextCode[16]{};
+    unsigned int code = 0;
+    unsigned int symbolIndex = 0;
+
+    for (int length = 1; length < 16; ++length)
+    {
+        nextCode[length] = code;
+        table.firstCode[length] = static_cast<uint16_t>(code);
+        table.firstSymbol[length] = static_cast<uint16_t>(symbolIndex);
+
+        code += lengthCounts[length];
+
+        // Oversubscribed, incomplete codes are allowed.
+        if (code > (1u << length))
+        {
+            return false;
+        }
+
+        table.maxCode[length] = code << (16 - length);
+        code <<= 1;
+        symbolIndex += lengthCounts[length];
+    }
+
+    table.maxCode[16] = 0x10000;
+
+    for (unsigned int symbol = 0; symbol < symbolCount; ++symbol)
+    {
+        const int length = lengths[symbol];
+
+        if (length == 0)
+        {
+            continue;
+        }
+
+        const unsigned int index = nextCode[length] - table.firstCode[length] + table.firstSymbol[length];
+        table.symbols[index] = static_cast<uint16_t>(symbol);
+
+        if (length <= huffmanFastBits)
+        {
+            for (unsigned int i = reverseBits(nextCode[length], length); i < (1u << huffmanFastBits); i += 1u << length)
+            {
+                table.fast[i] = static_cast<uint16_t>((length << 9) | symbol);
+            }
+        }
+
+        ++nextCode[length];
+    }
+
+    return true;
+}
+
+// At least 57 bits are buffered afterwards.
+void refillInflateBits(InflateBitReader& reader) noexcept
+{
+    while (reader.bitCount <= 56)
+    {
+        const uint64_t byte = reader.position < reader.size ? reader.data[reader.position] : 0;
+
+        reader.bits |= byte << reader.bitCount;
+        reader.bitCount += 8;
+        ++reader.position;
+    }
+}
+
+unsigned int takeInflateBits(InflateBitReader& reader, int count) noexcept
+{
+    const unsigned int value = static_cast<unsigned int>(reader.bits & ((uint64_t(1) << count) - 1));
+
+    reader.bits >>= count;
+    reader.bitCount -= count;
+
+    return value;
+}
+
+// Needs 16 buffered bits, returns -1 for codes not in the table.
+int decodeInflateSymbol(InflateBitReader& reader, const InflateHuffmanTable& table) noexcept
+{
+    const unsigned int entry = table.fast[reader.bits & ((1u << huffmanFastBits) - 1)];
+
+    if (entry)
+    {
+        takeInflateBits(reader, static_cast<int>(entry >> 9));
+        return static_cast<int>(entry & 511);
+    }
+
+    const unsigned int code = reverseBits(static_cast<unsigned int>(reader.bits & 0xFFFF), 16);
+
+    int length = huffmanFastBits + 1;
+
+    while (code >= table.maxCode[length])
+    {
+        if (++length == 16)
+        {
+            return -1;
+        }
+    }
+
+    takeInflateBits(reader, length);
+
+    return table.symbols[(code >> (16 - length)) - table.firstCode[length] + table.firstSymbol[length]];
+}
+
+bool buildFixedInflateTables(InflateHuffmanTable& literals, InflateHuffmanTable& distances) noexcept
+{
+    unsigned char lengths[288];
+
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+
+    if (!buildInflateHuffmanTable(literals, lengths, 288))
+    {
+        return false;
+    }
+
+    memset(lengths, 5, 30);
+
+    return buildInflateHuffmanTable(distances, lengths, 30);
+}
+
+bool readDynamicInflateTables(InflateBitReader& reader, InflateHuffmanTable& literals, InflateHuffmanTable& distances) noexcept
+{
+    refillInflateBits(reader);
+
+    const unsigned int literalCount = takeInflateBits(reader, 5) + 257;
+    const unsigned int distanceCount = takeInflateBits(reader, 5) + 1;
+    const unsigned int codeLengthCount = takeInflateBits(reader, 4) + 4;
+
+    unsigned char codeLengthLengths[19]{};
+
+    for (unsigned int i = 0; i < codeLengthCount; ++i)
+    {
+        refillInflateBits(reader);
+        codeLengthLengths[deflateCodeLengthOrder[i]] = static_cast<unsigned char>(takeInflateBits(reader, 3));
+    }
+
+    InflateHuffmanTable codeLengths;
+
+    if (literalCount > 286 || distanceCount > 30 || !buildInflateHuffmanTable(codeLengths, codeLengthLengths, 19))
+    {
+        return false;
+    }
+
+    // Literal and distance lengths form one sequence, repeats may cross from one to the other.
+    unsigned char lengths[286 + 30]{};
+    unsigned int count = 0;
+
+    while (count < literalCount + distanceCount)
+    {
+        refillInflateBits(reader);
+
+        const int symbol = decodeInflateSymbol(reader, codeLengths);
+
+        if (symbol < 0)
+        {
+            return false;
+        }
+
+        if (symbol < 16)
+        {
+            lengths[count++] = static_cast<unsigned char>(symbol);
+            continue;
+        }
+
+        unsigned int repeat = 0;
+        unsigned char value = 0;
+
+        if (symbol == 16)
+        {
+            if (count == 0)
+            {
+                return false;
+            }
+
+            repeat = takeInflateBits(reader, 2) + 3;
+            value = lengths[count - 1];
+        }
+        else if (symbol == 17)
+        {
+            repeat = takeInflateBits(reader, 3) + 3;
+        }
+        else
+        {
+            repeat = takeInflateBits(reader, 7) + 11;
+        }
+
+        if (count + repeat > literalCount + distanceCount)
+        {
+            return false;
+        }
+
+        memset(lengths + count, value, repeat);
+        count += repeat;
+    }
+
+    // The end of block code must exist.
+    return lengths[256] != 0 && buildInflateHuffmanTable(literals, lengths, literalCount) &&
+           buildInflateHuffmanTable(distances, lengths + literalCount, distanceCount);
+}
+
+// Inflates a zlib stream into exactly size bytes, the Adler-32 checksum is not verified.
+bool inflateZlib(const unsigned char* data, size_t dataSize, unsigned char* output, size_t size) noexcept
+{
+    if (dataSize < 2 || (data[0] & 15) != 8 || (data[0] >> 4) > 7 || (data[1] & 0x20) || readBigEndian16(data) % 31 != 0)
+    {
+        return false;
+    }
+
+    InflateBitReader reader;
+    reader.data = data;
+    reader.size = dataSize;
+    reader.position = 2;
+
+    unsigned char* out = output;
+    unsigned char* const outEnd = output + size;
+
+    InflateHuffmanTable literals;
+    InflateHuffmanTable distances;
+
+    for (bool isFinal = false; !isFinal; )
+    {
+        refillInflateBits(reader);
+
+        isFinal = takeInflateBits(reader, 1) != 0;
+        const unsigned int blockType = takeInflateBits(reader, 2);
+
+        if (blockType == 0)
+        {
+            // Stored bytes start at the next byte boundary, the buffered whole bytes are given back.
+            takeInflateBits(reader, reader.bitCount & 7);
+            reader.position -= static_cast<size_t>(reader.bitCount / 8);
+            reader.bits = 0;
+            reader.bitCount = 0;
+
+            if (reader.position + 4 > reader.size)
+            {
+                return false;
+            }
+
+            const unsigned int length = readLittleEndian16(reader.data + reader.position);
+            const unsigned int inverseLength = readLittleEndian16(reader.data + reader.position + 2);
+            reader.position += 4;
+
+            if ((length ^ 0xFFFF) != inverseLength || length > reader.size - reader.position || length > static_cast<size_t>(outEnd - out))
+            {
+                return false;
+            }
+
+            memcpy(out, reader.data + reader.position, length);
+            out += length;
+            reader.position += length;
+
+            continue;
+        }
+
+        if (blockType == 3 ||
+            !(blockType == 1 ? buildFixedInflateTables(literals, distances) : readDynamicInflateTables(reader, literals, distances)))
+        {
+            return false;
+        }
+
+        for (;;)
+        {
+            // Enough for a length, its extra bits, a distance and its extra bits.
+            refillInflateBits(reader);
+
+            if (reader.position > reader.size + 16)
+            {
+                return false;
+            }
+
+            int symbol = decodeInflateSymbol(reader, literals);
+
+            if (symbol < 256)
+            {
+                if (symbol < 0 || out == outEnd)
+                {
+                    return false;
+                }
+
+                *out++ = static_cast<unsigned char>(symbol);
+                continue;
+            }
+
+            if (symbol == 256)
+            {
+                break;
+            }
+
+            symbol -= 257;
+
+            if (symbol >= 29)
+            {
+                return false;
+            }
+
+            const size_t length = static_cast<size_t>(deflateLengthBase[symbol]) + takeInflateBits(reader, deflateLengthExtraBits[symbol]);
+
+            const int distanceSymbol = decodeInflateSymbol(reader, distances);
+
+            if (distanceSymbol < 0 || distanceSymbol >= 30)
+            {
+                return false;
+            }
+
+            const size_t distance = static_cast<size_t>(deflateDistanceBase[distanceSymbol]) + takeInflateBits(reader, deflateDistanceExtraBits[distanceSymbol]);
+
+            if (distance > static_cast<size_t>(out - output) || length > static_cast<size_t>(outEnd - out))
+            {
+                return false;
+            }
+
+            // Byte by byte, the source may overlap the bytes being written.
+            const unsigned char* source = out - distance;
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                out[i] = source[i];
+            }
+
+            out += length;
+        }
+    }
+
+    // Reads past the end of the data are only allowed as padding of the last byte.
+    return out == outEnd && reader.position - static_cast<size_t>(reader.bitCount / 8) <= reader.size;
+}
+
+//
+// PNG
+//
+
+unsigned char getPaethPredictor(int left, int above, int aboveLeft) noexcept
+{
+    const int estimate = left + above - aboveLeft;
+    const int leftDistance = estimate > left ? estimate - left : left - estimate;
+    const int aboveDistance = estimate > above ? estimate - above : above - estimate;
+    const int aboveLeftDistance = estimate > aboveLeft ? estimate - aboveLeft : aboveLeft - estimate;
+
+    if (leftDistance <= aboveDistance && leftDistance <= aboveLeftDistance)
+    {
+        return static_cast<unsigned char>(left);
+    }
+
+    return static_cast<unsigned char>(aboveDistance <= aboveLeftDistance ? above : aboveLeft);
+}
+
+bool unfilterPngRow(unsigned char* row, const unsigned char* previousRow, size_t rowSize, size_t texelStride, unsigned int filter) noexcept
+{
+    switch (filter)
+    {
+        case 0:
+            break;
+
+        case 1:
+            for (size_t i = texelStride; i < rowSize; ++i)
+            {
+                row[i] = static_cast<unsigned char>(row[i] + row[i - texelStride]);
+            }
+            break;
+
+        case 2:
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= rowSize; i += 16)
+            {
+                const __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(previousRow + i)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), sum);
+            }
+
+            for (; i < rowSize; ++i)
+            {
+                row[i] = static_cast<unsigned char>(row[i] + previousRow[i]);
+            }
+            break;
+        }
+
+        case 3:
+            for (size_t i = 0; i < rowSize; ++i)
+            {
+                const int left = i >= texelStride ? row[i - texelStride] : 0;
+                row[i] = static_cast<unsigned char>(row[i] + ((left + previousRow[i]) >> 1));
+            }
+            break;
+
+        case 4:
+            for (size_t i = 0; i < rowSize; ++i)
+            {
+                const int left = i >= texelStride ? row[i - texelStride] : 0;
+                const int aboveLeft = i >= texelStride ? previousRow[i - texelStride] : 0;
+                row[i] = static_cast<unsigned char>(row[i] + getPaethPredictor(left, previousRow[i], aboveLeft));
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+bool decodePng(const unsigned char* data, size_t size, TextureImage& image) noexcept
+{
+    if (size < 8 || memcmp(data, pngSignature, 8) != 0)
+    {
+        print("PNG: missing signature.\n");
+        return false;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    unsigned int bitDepth = 0;
+    unsigned int colorType = 0;
+
+    // RGBA, transparent entries from tRNS.
+    unsigned char palette[256][4]{};
+    unsigned int paletteSize = 0;
+
+    // Color key of 8 bit gray and RGB images.
+    bool hasColorKey = false;
+    unsigned char colorKey[3]{};
+
+    // A single IDAT chunk is inflated in place, several are joined.
+    const unsigned char* compressed = nullptr;
+    size_t compressedSize = 0;
+    std::vector<unsigned char> joinedChunks;
+
+    size_t position = 8;
+    bool hasHeader = false;
+
+    for (;;)
+    {
+        if (size - position < 12)
+        {
+            print("PNG: truncated before IEND.\n");
+            return false;
+        }
+
+        const uint32_t length = readBigEndian32(data + position);
+        const unsigned char* type = data + position + 4;
+        const unsigned char* chunk = data + position + 8;
+
+        if (length > size - position - 12)
+        {
+            print("PNG: chunk length out of bounds.\n");
+            return false;
+        }
+
+        position += static_cast<size_t>(length) + 12;
+
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length != 13 || hasHeader)
+            {
+                return false;
+            }
+
+            width = readBigEndian32(chunk);
+            height = readBigEndian32(chunk + 4);
+            bitDepth = chunk[8];
+            colorType = chunk[9];
+            hasHeader = true;
+
+            if (chunk[10] != 0 || chunk[11] != 0)
+            {
+                print("PNG: unknown compression or filter method.\n");
+                return false;
+            }
+
+            if (chunk[12] != 0)
+            {
+                print("PNG: interlaced images are not supported.\n");
+                return false;
+            }
+        }
+        else if (!hasHeader)
+        {
+            print("PNG: IHDR must be the first chunk.\n");
+            return false;
+        }
+        else if (memcmp(type, "PLTE", 4) == 0)
+        {
+            if (length % 3 != 0 || length / 3 > 256)
+            {
+                return false;
+            }
+
+            paletteSize = length / 3;
+
+            for (unsigned int i = 0; i < paletteSize; ++i)
+            {
+                palette[i][0] = chunk[i * 3 + 0];
+                palette[i][1] = chunk[i * 3 + 1];
+                palette[i][2] = chunk[i * 3 + 2];
+                palette[i][3] = 255;
+            }
+        }
+        else if (memcmp(type, "tRNS", 4) == 0)
+        {
+            if (colorType == 3)
+            {
+                for (unsigned int i = 0; i < length && i < 256; ++i)
+                {
+                    palette[i][3] = chunk[i];
+                }
+            }
+            else if (colorType == 0 && length == 2 && bitDepth == 8)
+            {
+                hasColorKey = true;
+                colorKey[0] = colorKey[1] = colorKey[2] = chunk[1];
+            }
+            else if (colorType == 2 && length == 6 && bitDepth == 8)
+            {
+                hasColorKey = true;
+                colorKey[0] = chunk[1];
+                colorKey[1] = chunk[3];
+                colorKey[2] = chunk[5];
+            }
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+        {
+            if (compressed && joinedChunks.empty())
+            {
+                joinedChunks.assign(compressed, compressed + compressedSize);
+            }
+
+            if (!compressed)
+            {
+                compressed = chunk;
+                compressedSize = length;
+            }
+            else
+            {
+                joinedChunks.insert(joinedChunks.end(), chunk, chunk + length);
+                compressed = joinedChunks.data();
+                compressedSize = joinedChunks.size();
+            }
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        else if (!(type[0] & 0x20))
+        {
+            print("PNG: unknown critical chunk %.4s.\n", reinterpret_cast<const char*>(type));
+            return false;
+        }
+    }
+
+    int channelCount = 0;
+
+    switch (colorType)
+    {
+        case 0: channelCount = bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16 ? 1 : 0; break;
+        case 2: channelCount = bitDepth == 8 || bitDepth == 16 ? 3 : 0; break;
+        case 3: channelCount = (bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8) && paletteSize > 0 ? 1 : 0; break;
+        case 4: channelCount = bitDepth == 8 || bitDepth == 16 ? 2 : 0; break;
+        case 6: channelCount = bitDepth == 8 || bitDepth == 16 ? 4 : 0; break;
+    }
+
+    if (channelCount == 0 || width == 0 || height == 0 || width > maxImageSize || height > maxImageSize || !compressed)
+    {
+        print("PNG: unsupported %ux%u image, color type %u, bit depth %u.\n", width, height, colorType, bitDepth);
+        return false;
+    }
+
+    const size_t bitsPerTexel = static_cast<size_t>(channelCount) * bitDepth;
+    const size_t rowSize = (static_cast<size_t>(width) * bitsPerTexel + 7) / 8;
+    const size_t texelStride = bitsPerTexel >= 8 ? bitsPerTexel / 8 : 1;
+
+    // Every row starts with its filter type.
+    std::vector<unsigned char> filteredRows(static_cast<size_t>(height) * (rowSize + 1));
+
+    if (!inflateZlib(compressed, compressedSize, filteredRows.data(), filteredRows.size()))
+    {
+        print("PNG: corrupt image data.\n");
+        return false;
+    }
+
+    allocateImage(image, static_cast<int>(width), static_cast<int>(height));
+
+    // 16 bit channels and packed samples are first widened to one byte per channel.
+    std::vector<unsigned char> zeroRow(rowSize);
+    std::vector<unsigned char> samples(bitDepth != 8 ? static_cast<size_t>(width) * channelCount : 0);
+
+    const unsigned char* previousRow = zeroRow.data();
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        unsigned char* row = filteredRows.data() + static_cast<size_t>(y) * (rowSize + 1);
+
+        if (!unfilterPngRow(row + 1, previousRow, rowSize, texelStride, row[0]))
+        {
+            print("PNG: unknown filter type %u.\n", row[0]);
+            releaseTextureImage(image);
+            return false;
+        }
+
+        previousRow = row + 1;
+
+        const unsigned char* source = row + 1;
+        unsigned char* destination = image.pixels.data() + static_cast<size_t>(y) * width * textureTexelSize;
+
+        if (bitDepth == 16)
+        {
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                samples[i] = source[i * 2];
+            }
+
+            source = samples.data();
+        }
+        else if (bitDepth < 8)
+        {
+            // Palette indices stay as they are, gray levels are scaled to 0-255.
+            const unsigned int mask = (1u << bitDepth) - 1;
+            const unsigned int scale = colorType == 3 ? 1 : 255 / mask;
+
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const size_t bit = static_cast<size_t>(x) * bitDepth;
+                const unsigned int sample = (source[bit / 8] >> (8 - bitDepth - bit % 8)) & mask;
+
+                samples[x] = static_cast<unsigned char>(sample * scale);
+            }
+
+            source = samples.data();
+        }
+
+        switch (colorType)
+        {
+            case 0: convertGrayRow(source, destination, static_cast<int>(width)); break;
+            case 2: convertThreeChannelRow(source, destination, static_cast<int>(width), 0); break;
+            case 4: convertGrayAlphaRow(source, destination, static_cast<int>(width)); break;
+            case 6: convertRgbaRow(source, destination, static_cast<int>(width)); break;
+
+            case 3:
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    memcpy(destination + x * 4, palette[source[x]], 4);
+                }
+                break;
+        }
+
+        if (hasColorKey)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                unsigned char* texel = destination + x * 4;
+
+                if (texel[0] == colorKey[0] && texel[1] == colorKey[1] && texel[2] == colorKey[2])
+                {
+                    texel[3] = 0;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+//
+// JPEG
+//
+
+IdctTable createIdctTable() noexcept
+{
+    IdctTable table;
+
+    for (int x = 0; x < 8; ++x)
+    {
+        for (int u = 0; u < 8; ++u)
+        {
+            const float scale = u == 0 ? 0.5f / sqrtf(2.0f) : 0.5f;
+            const float value = scale * cosf(static_cast<float>((2 * x + 1) * u) * 3.14159265f / 16.0f);
+
+            table.basis[x][u] = value;
+            table.transposedBasis[u][x] = value;
+        }
+    }
+
+    return table;
+}
+
+const IdctTable& getIdctTable() noexcept
+{
+    static const IdctTable table = createIdctTable();
+
+    return table;
+}
+
+// Separable float IDCT, each pass sums basis-scaled rows. Rows without coefficients are skipped in the first pass.
+void inverseDctBlock(const float* coefficients, unsigned char* destination, size_t stride) noexcept
+{
+    const IdctTable& table = getIdctTable();
+
+    // Columns: rows[y] = sum over v of basis[y][v] * coefficients[v].
+    __m128 rows[8][2];
+
+    for (int y = 0; y < 8; ++y)
+    {
+        rows[y][0] = _mm_setzero_ps();
+        rows[y][1] = _mm_setzero_ps();
+    }
+
+    for (int v = 0; v < 8; ++v)
+    {
+        const __m128 low = _mm_loadu_ps(coefficients + v * 8);
+        const __m128 high = _mm_loadu_ps(coefficients + v * 8 + 4);
+
+        if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_or_ps(low, high), _mm_setzero_ps())) == 0)
+        {
+            continue;
+        }
+
+        for (int y = 0; y < 8; ++y)
+        {
+            const __m128 weight = _mm_set1_ps(table.basis[y][v]);
+
+            rows[y][0] = _mm_add_ps(rows[y][0], _mm_mul_ps(low, weight));
+            rows[y][1] = _mm_add_ps(rows[y][1], _mm_mul_ps(high, weight));
+        }
+    }
+
+    // Rows: texels[y][x] = sum over u of rows[y][u] * basis[x][u], then level shifted and packed.
+    const __m128 levelShift = _mm_set1_ps(128.0f);
+
+    for (int y = 0; y < 8; ++y)
+    {
+        alignas(16) float row[8];
+        _mm_store_ps(row, rows[y][0]);
+        _mm_store_ps(row + 4, rows[y][1]);
+
+        __m128 low = levelShift;
+        __m128 high = levelShift;
+
+        for (int u = 0; u < 8; ++u)
+        {
+            const __m128 weight = _mm_set1_ps(row[u]);
+
+            low = _mm_add_ps(low, _mm_mul_ps(weight, _mm_load_ps(table.transposedBasis[u])));
+            high = _mm_add_ps(high, _mm_mul_ps(weight, _mm_load_ps(table.transposedBasis[u] + 4)));
+        }
+
+        const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + static_cast<size_t>(y) * stride), _mm_packus_epi16(words, words));
+    }
+}
+
+bool buildJpegHuffmanTable(JpegHuffmanTable& table, const unsigned char* lengthCounts, const unsigned char* symbols) noexcept
+{
+    unsigned int symbolCount = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        symbolCount += lengthCounts[i];
+    }
+
+    if (symbolCount > 256)
+    {
+        return false;
+    }
+
+    memcpy(table.symbols, symbols, symbolCount);
+    table.symbolCount = symbolCount;
+    memset(table.fast, 0, sizeof(table.fast));
+
+    unsigned int code = 0;
+    unsigned int symbolIndex = 0;
+
+    for (int length = 1; length <= 16; ++length)
+    {
+        const unsigned int count = lengthCounts[length - 1];
+
+        // Oversubscribed, rejected before the fast table is filled since its entries would run past the end.
+        if (code + count > (1u << length))
+        {
+            return false;
+        }
+
+        table.valueOffset[length] = static_cast<int>(symbolIndex) - static_cast<int>(code);
+
+        for (unsigned int i = 0; i < count; ++i, ++code, ++symbolIndex)
+        {
+            if (length <= huffmanFastBits)
+            {
+                const unsigned int first = code << (huffmanFastBits - length);
+
+                for (unsigned int j = 0; j < (1u << (huffmanFastBits - length)); ++j)
+                {
+                    table.fast[first + j] = static_cast<uint16_t>((length << 8) | symbols[symbolIndex]);
+                }
+            }
+        }
+
+        table.maxCode[length] = code << (16 - length);
+        code <<= 1;
+    }
+
+    table.maxCode[17] = 0xFFFFFFFFu;
+
+    return true;
+}
+
+// Stops at markers, the position then stays on their 0xFF.
+void refillJpegBits(JpegBitReader& reader) noexcept
+{
+    while (reader.bitCount <= 56)
+    {
+        unsigned int byte = 0;
+
+        if (!reader.isAtMarker && reader.position < reader.size)
+        {
+            byte = reader.data[reader.position];
+
+            if (byte != 0xFF)
+            {
+                ++reader.position;
+            }
+            else if (reader.position + 1 < reader.size && reader.data[reader.position + 1] == 0)
+            {
+                reader.position += 2;
+            }
+            else
+            {
+                reader.isAtMarker = true;
+                byte = 0;
+            }
+        }
+        else
+        {
+            reader.isAtMarker = true;
+        }
+
+        reader.bits |= static_cast<uint64_t>(byte) << (56 - reader.bitCount);
+        reader.bitCount += 8;
+    }
+}
+
+unsigned int takeJpegBits(JpegBitReader& reader, int count) noexcept
+{
+    const unsigned int value = static_cast<unsigned int>(reader.bits >> (64 - count));
+
+    reader.bits <<= count;
+    reader.bitCount -= count;
+
+    return value;
+}
+
+int decodeJpegSymbol(JpegBitReader& reader, const JpegHuffmanTable& table) noexcept
+{
+    if (reader.bitCount < 16)
+    {
+        refillJpegBits(reader);
+    }
+
+    const unsigned int entry = table.fast[reader.bits >> (64 - huffmanFastBits)];
+
+    if (entry)
+    {
+        takeJpegBits(reader, static_cast<int>(entry >> 8));
+        return static_cast<int>(entry & 255);
+    }
+
+    const unsigned int code = static_cast<unsigned int>(reader.bits >> 48);
+
+    int length = huffmanFastBits + 1;
+
+    while (code >= table.maxCode[length])
+    {
+        if (++length > 16)
+        {
+            return -1;
+        }
+    }
+
+    const int index = static_cast<int>(code >> (16 - length)) + table.valueOffset[length];
+
+    if (index < 0 || index >= static_cast<int>(table.symbolCount))
+    {
+        return -1;
+    }
+
+    takeJpegBits(reader, length);
+
+    return table.symbols[index];
+}
+
+// Reads a magnitude category and sign extends it.
+int receiveJpegValue(JpegBitReader& reader, int category) noexcept
+{
+    if (category == 0)
+    {
+        return 0;
+    }
+
+    if (reader.bitCount < category)
+    {
+        refillJpegBits(reader);
+    }
+
+    const int value = static_cast<int>(takeJpegBits(reader, category));
+
+    return value < (1 << (category - 1)) ? value - (1 << category) + 1 : value;
+}
+
+bool decodeJpegBlock(JpegDecoder& decoder, JpegBitReader& reader, JpegComponent& component, unsigned char* destination) noexcept
+{
+    const uint16_t* quantization = decoder.quantizationTables[component.quantizationTable];
+
+    alignas(16) float coefficients[64]{};
+
+    const int dcCategory = decodeJpegSymbol(reader, decoder.dcTables[component.dcTable]);
+
+    if (dcCategory < 0 || dcCategory > 15)
+    {
+        return false;
+    }
+
+    component.dcPredictor += receiveJpegValue(reader, dcCategory);
+    coefficients[0] = static_cast<float>(component.dcPredictor * quantization[0]);
+
+    const JpegHuffmanTable& acTable = decoder.acTables[component.acTable];
+
+    for (int k = 1; k < 64; )
+    {
+        const int symbol = decodeJpegSymbol(reader, acTable);
+
+        if (symbol < 0)
+        {
+            return false;
+        }
+
+        const int zeroRun = symbol >> 4;
+        const int category = symbol & 15;
+
+        if (category == 0)
+        {
+            // ZRL skips 16 zeros, anything else ends the block.
+            if (zeroRun != 15)
+            {
+                break;
+            }
+
+            k += 16;
+            continue;
+        }
+
+        k += zeroRun;
+
+        if (k > 63)
+        {
+            return false;
+        }
+
+        coefficients[jpegZigzag[k]] = static_cast<float>(receiveJpegValue(reader, category) * quantization[k]);
+        ++k;
+    }
+
+    inverseDctBlock(coefficients, destination, component.planeStride);
+
+    return true;
+}
+
+// Skips fill bytes and the rest of the entropy coded data with its stuffed zeros, returns false at the end of the data.
+bool readJpegMarker(JpegDecoder& decoder, unsigned int& marker) noexcept
+{
+    do
+    {
+        while (decoder.position < decoder.size && decoder.data[decoder.position] != 0xFF)
+        {
+            ++decoder.position;
+        }
+
+        while (decoder.position < decoder.size && decoder.data[decoder.position] == 0xFF)
+        {
+            ++decoder.position;
+        }
+
+        if (decoder.position >= decoder.size)
+        {
+            return false;
+        }
+
+        marker = decoder.data[decoder.position++];
+    }
+    while (marker == 0);
+
+    return true;
+}
+
+// Resets the entropy decoder at an RSTn marker.
+void restartJpegScan(JpegDecoder& decoder, JpegBitReader& reader) noexcept
+{
+    size_t position = reader.position;
+
+    while (position + 1 < decoder.size && !(decoder.data[position] == 0xFF && decoder.data[position + 1] >= 0xD0 && decoder.data[position + 1] <= 0xD7))
+    {
+        ++position;
+    }
+
+    reader.position = position + 2 <= decoder.size ? position + 2 : decoder.size;
+    reader.bits = 0;
+    reader.bitCount = 0;
+    reader.isAtMarker = false;
+
+    for (int i = 0; i < decoder.componentCount; ++i)
+    {
+        decoder.components[i].dcPredictor = 0;
+    }
+}
+
+bool decodeJpegScan(JpegDecoder& decoder, JpegComponent* const* scanComponents, int scanComponentCount) noexcept
+{
+    JpegBitReader reader;
+    reader.data = decoder.data;
+    reader.size = decoder.size;
+    reader.position = decoder.position;
+
+    for (int i = 0; i < decoder.componentCount; ++i)
+    {
+        decoder.components[i].dcPredictor = 0;
+    }
+
+    unsigned int mcuIndex = 0;
+
+    if (scanComponentCount == 1)
+    {
+        // Not interleaved, the MCU is one block and only blocks inside the component are coded.
+        JpegComponent& component = *scanComponents[0];
+
+        const int componentWidth = (decoder.width * component.horizontalSampling + decoder.maxHorizontalSampling - 1) / decoder.maxHorizontalSampling;
+        const int componentHeight = (decoder.height * component.verticalSampling + decoder.maxVerticalSampling - 1) / decoder.maxVerticalSampling;
+        const int blocksPerLine = (componentWidth + 7) / 8;
+        const int blocksPerColumn = (componentHeight + 7) / 8;
+
+        for (int blockY = 0; blockY < blocksPerColumn; ++blockY)
+        {
+            for (int blockX = 0; blockX < blocksPerLine; ++blockX, ++mcuIndex)
+            {
+                if (decoder.restartInterval && mcuIndex > 0 && mcuIndex % decoder.restartInterval == 0)
+                {
+                    restartJpegScan(decoder, reader);
+                }
+
+                unsigned char* destination = component.plane.data() + static_cast<size_t>(blockY) * 8 * component.planeStride + static_cast<size_t>(blockX) * 8;
+
+                if (!decodeJpegBlock(decoder, reader, component, destination))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (int mcuY = 0; mcuY < decoder.mcusPerColumn; ++mcuY)
+        {
+            for (int mcuX = 0; mcuX < decoder.mcusPerLine; ++mcuX, ++mcuIndex)
+            {
+                if (decoder.restartInterval && mcuIndex > 0 && mcuIndex % decoder.restartInterval == 0)
+                {
+                    restartJpegScan(decoder, reader);
+                }
+
+                for (int i = 0; i < scanComponentCount; ++i)
+                {
+                    JpegComponent& component = *scanComponents[i];
+
+                    for (int v = 0; v < component.verticalSampling; ++v)
+                    {
+                        for (int h = 0; h < component.horizontalSampling; ++h)
+                        {
+                            const size_t blockX = static_cast<size_t>(mcuX * component.horizontalSampling + h);
+                            const size_t blockY = static_cast<size_t>(mcuY * component.verticalSampling + v);
+
+                            if (!decodeJpegBlock(decoder, reader, component, component.plane.data() + blockY * 8 * component.planeStride + blockX * 8))
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The next marker is searched from where the entropy data stopped.
+    decoder.position = reader.position;
+
+    return true;
+}
+
+bool readJpegFrame(JpegDecoder& decoder, const unsigned char* segment, size_t length) noexcept
+{
+    if (decoder.componentCount != 0 || length < 6)
+    {
+        return false;
+    }
+
+    if (segment[0] != 8)
+    {
+        print("JPEG: %u bit precision is not supported.\n", segment[0]);
+        return false;
+    }
+
+    decoder.height = static_cast<int>(readBigEndian16(segment + 1));
+    decoder.width = static_cast<int>(readBigEndian16(segment + 3));
+
+    const int componentCount = segment[5];
+
+    if (decoder.width == 0 || decoder.height == 0 || static_cast<uint32_t>(decoder.width) > maxImageSize || static_cast<uint32_t>(decoder.height) > maxImageSize)
+    {
+        print("JPEG: unsupported size %dx%d.\n", decoder.width, decoder.height);
+        return false;
+    }
+
+    if ((componentCount != 1 && componentCount != 3) || length < 6 + static_cast<size_t>(componentCount) * 3)
+    {
+        print("JPEG: %d components are not supported.\n", componentCount);
+        return false;
+    }
+
+    decoder.componentCount = componentCount;
+    decoder.maxHorizontalSampling = 1;
+    decoder.maxVerticalSampling = 1;
+
+    for (int i = 0; i < componentCount; ++i)
+    {
+        JpegComponent& component = decoder.components[i];
+        const unsigned char* specification = segment + 6 + i * 3;
+
+        component.id = specification[0];
+        component.horizontalSampling = specification[1] >> 4;
+        component.verticalSampling = specification[1] & 15;
+        component.quantizationTable = specification[2];
+
+        if (component.horizontalSampling < 1 || component.horizontalSampling > 4 || component.verticalSampling < 1 ||
+            component.verticalSampling > 4 || component.quantizationTable > 3)
+        {
+            return false;
+        }
+
+        decoder.maxHorizontalSampling = component.horizontalSampling > decoder.maxHorizontalSampling ? component.horizontalSampling : decoder.maxHorizontalSampling;
+        decoder.maxVerticalSampling = component.verticalSampling > decoder.maxVerticalSampling ? component.verticalSampling : decoder.maxVerticalSampling;
+    }
+
+    decoder.mcusPerLine = (decoder.width + decoder.maxHorizontalSampling * 8 - 1) / (decoder.maxHorizontalSampling * 8);
+    decoder.mcusPerColumn = (decoder.height + decoder.maxVerticalSampling * 8 - 1) / (decoder.maxVerticalSampling * 8);
+
+    for (int i = 0; i < componentCount; ++i)
+    {
+        JpegComponent& component = decoder.components[i];
+
+        // Upsampling only handles whole ratios.
+        if (decoder.maxHorizontalSampling % component.horizontalSampling != 0 || decoder.maxVerticalSampling % component.verticalSampling != 0)
+        {
+            print("JPEG: unsupported sampling factors.\n");
+            return false;
+        }
+
+        component.planeStride = static_cast<size_t>(decoder.mcusPerLine) * component.horizontalSampling * 8;
+        component.plane.resize(component.planeStride * static_cast<size_t>(decoder.mcusPerColumn) * component.verticalSampling * 8);
+    }
+
+    return true;
+}
+
+bool readJpegScanHeader(JpegDecoder& decoder, const unsigned char* segment, size_t length, JpegComponent** scanComponents, int& scanComponentCount) noexcept
+{
+    if (decoder.componentCount == 0 || length < 1)
+    {
+        return false;
+    }
+
+    scanComponentCount = segment[0];
+
+    if (scanComponentCount < 1 || scanComponentCount > decoder.componentCount || length != 4 + static_cast<size_t>(scanComponentCount) * 2)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < scanComponentCount; ++i)
+    {
+        const unsigned int id = segment[1 + i * 2];
+        const unsigned int tables = segment[2 + i * 2];
+
+        int index = 0;
+
+        while (index < decoder.componentCount && decoder.components[index].id != id)
+        {
+            ++index;
+        }
+
+        if (index == decoder.componentCount || (tables >> 4) > 3 || (tables & 15) > 3)
+        {
+            return false;
+        }
+
+        JpegComponent& component = decoder.components[index];
+        component.dcTable = tables >> 4;
+        component.acTable = tables & 15;
+
+        if (decoder.dcTables[component.dcTable].symbolCount == 0 || decoder.acTables[component.acTable].symbolCount == 0 ||
+            !decoder.isQuantizationTableDefined[component.quantizationTable])
+        {
+            print("JPEG: scan uses undefined tables.\n");
+            return false;
+        }
+
+        scanComponents[i] = &component;
+    }
+
+    const unsigned char* selection = segment + 1 + scanComponentCount * 2;
+
+    // Spectral selection and successive approximation of a sequential scan.
+    return selection[0] == 0 && selection[1] == 63 && selection[2] == 0;
+}
+
+// Writes the RGBA texels, chroma is upsampled by replication.
+void convertJpegImage(const JpegDecoder& decoder, TextureImage& image) noexcept
+{
+    const int width = decoder.width;
+
+    std::vector<unsigned char> upsampledRows[3];
+    const unsigned char* rows[3]{};
+
+    for (int y = 0; y < decoder.height; ++y)
+    {
+        for (int i = 0; i < decoder.componentCount; ++i)
+        {
+            const JpegComponent& component = decoder.components[i];
+
+            const int horizontalScale = decoder.maxHorizontalSampling / component.horizontalSampling;
+            const int verticalScale = decoder.maxVerticalSampling / component.verticalSampling;
+
+            const unsigned char* row = component.plane.data() + static_cast<size_t>(y / verticalScale) * component.planeStride;
+
+            if (horizontalScale == 1)
+            {
+                rows[i] = row;
+                continue;
+            }
+
+            std::vector<unsigned char>& upsampled = upsampledRows[i];
+            upsampled.resize(static_cast<size_t>(width) + 16);
+
+            int x = 0;
+
+            if (horizontalScale == 2)
+            {
+                for (; x + 32 <= width; x += 32)
+                {
+                    const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x / 2));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(upsampled.data() + x), _mm_unpacklo_epi8(samples, samples));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(upsampled.data() + x + 16), _mm_unpackhi_epi8(samples, samples));
+                }
+            }
+
+            for (; x < width; ++x)
+            {
+                upsampled[x] = row[x / horizontalScale];
+            }
+
+            rows[i] = upsampled.data();
+        }
+
+        unsigned char* destination = image.pixels.data() + static_cast<size_t>(y) * width * textureTexelSize;
+
+        if (decoder.componentCount == 1)
+        {
+            convertGrayRow(rows[0], destination, width);
+        }
+        else if (decoder.isRgb)
+        {
+            convertPlanarRgbRow(rows[0], rows[1], rows[2], destination, width);
+        }
+        else
+        {
+            convertYCbCrRow(rows[0], rows[1], rows[2], destination, width);
+        }
+    }
+}
+
+bool decodeJpeg(const unsigned char* data, size_t size, TextureImage& image) noexcept
+{
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+    {
+        print("JPEG: missing SOI marker.\n");
+        return false;
+    }
+
+    JpegDecoder decoder;
+    decoder.data = data;
+    decoder.size = size;
+    decoder.position = 2;
+
+    bool hasScan = false;
+
+    for (;;)
+    {
+        unsigned int marker = 0;
+
+        if (!readJpegMarker(decoder, marker))
+        {
+            // Some encoders leave out the EOI.
+            if (hasScan)
+            {
+                break;
+            }
+
+            print("JPEG: truncated.\n");
+            return false;
+        }
+
+        if (marker == 0xD9)
+        {
+            break;
+        }
+
+        // Markers without a segment.
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+        {
+            continue;
+        }
+
+        if (decoder.position + 2 > size)
+        {
+            return false;
+        }
+
+        const size_t length = readBigEndian16(data + decoder.position);
+
+        if (length < 2 || length > size - decoder.position)
+        {
+            print("JPEG: segment length out of bounds.\n");
+            return false;
+        }
+
+        const unsigned char* segment = data + decoder.position + 2;
+        const size_t segmentLength = length - 2;
+
+        decoder.position += length;
+
+        switch (marker)
+        {
+            // Baseline and extended sequential Huffman.
+            case 0xC0:
+            case 0xC1:
+                if (!readJpegFrame(decoder, segment, segmentLength))
+                {
+                    return false;
+                }
+                break;
+
+            case 0xC2:
+            case 0xC3:
+            case 0xC5:
+            case 0xC6:
+            case 0xC7:
+            case 0xC9:
+            case 0xCA:
+            case 0xCB:
+            case 0xCD:
+            case 0xCE:
+            case 0xCF:
+                print("JPEG: progressive, lossless and arithmetic coded images are not supported.\n");
+                return false;
+
+            case 0xC4:
+                for (size_t offset = 0; offset < segmentLength; )
+                {
+                    if (segmentLength - offset < 17)
+                    {
+                        return false;
+                    }
+
+                    const unsigned int tableClass = segment[offset] >> 4;
+                    const unsigned int tableIndex = segment[offset] & 15;
+                    const unsigned char* lengthCounts = segment + offset + 1;
+
+                    size_t symbolCount = 0;
+
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        symbolCount += lengthCounts[i];
+                    }
+
+                    if (tableClass > 1 || tableIndex > 3 || symbolCount > segmentLength - offset - 17)
+                    {
+                        return false;
+                    }
+
+                    JpegHuffmanTable& table = tableClass == 0 ? decoder.dcTables[tableIndex] : decoder.acTables[tableIndex];
+
+                    if (!buildJpegHuffmanTable(table, lengthCounts, lengthCounts + 16))
+                    {
+                        return false;
+                    }
+
+                    offset += 17 + symbolCount;
+                }
+                break;
+
+            case 0xDB:
+                for (size_t offset = 0; offset < segmentLength; )
+                {
+                    const unsigned int precision = segment[offset] >> 4;
+                    const unsigned int tableIndex = segment[offset] & 15;
+                    const size_t tableSize = precision ? 128 : 64;
+
+                    if (precision > 1 || tableIndex > 3 || segmentLength - offset - 1 < tableSize)
+                    {
+                        return false;
+                    }
+
+                    for (int i = 0; i < 64; ++i)
+                    {
+                        decoder.quantizationTables[tableIndex][i] = static_cast<uint16_t>(precision ? readBigEndian16(segment + offset + 1 + i * 2) : segment[offset + 1 + i]);
+                    }
+
+                    decoder.isQuantizationTableDefined[tableIndex] = true;
+                    offset += 1 + tableSize;
+                }
+                break;
+
+            case 0xDD:
+                if (segmentLength != 2)
+                {
+                    return false;
+                }
+
+                decoder.restartInterval = readBigEndian16(segment);
+                break;
+
+            case 0xEE:
+                if (segmentLength >= 12 && memcmp(segment, "Adobe", 5) == 0)
+                {
+                    decoder.isRgb = segment[11] == 0;
+                }
+                break;
+
+            case 0xDA:
+            {
+                JpegComponent* scanComponents[3]{};
+                int scanComponentCount = 0;
+
+                if (!readJpegScanHeader(decoder, segment, segmentLength, scanComponents, scanComponentCount) ||
+                    !decodeJpegScan(decoder, scanComponents, scanComponentCount))
+                {
+                    print("JPEG: corrupt scan.\n");
+                    return false;
+                }
+
+                hasScan = true;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    if (!hasScan)
+    {
+        print("JPEG: no image data.\n");
+        return false;
+    }
+
+    allocateImage(image, decoder.width, decoder.height);
+    convertJpegImage(decoder, image);
+
+    return true;
+}
+
+//
+// TGA
+//
+
+void convertTgaRow(const unsigned char* source, unsigned char* destination, int width, int texelSize, bool hasAlpha) noexcept
+{
+    switch (texelSize)
+    {
+        case 1: convertGrayRow(source, destination, width); break;
+        case 3: convertThreeChannelRow(source, destination, width, 2); break;
+        case 4: convertBgraRow(source, destination, width, hasAlpha); break;
+
+        // A1R5G5B5, little endian.
+        case 2:
+            for (int x = 0; x < width; ++x)
+            {
+                const unsigned int texel = readLittleEndian16(source + x * 2);
+
+                destination[x * 4 + 0] = static_cast<unsigned char>((((texel >> 10) & 31) * 255 + 15) / 31);
+                destination[x * 4 + 1] = static_cast<unsigned char>((((texel >> 5) & 31) * 255 + 15) / 31);
+                destination[x * 4 + 2] = static_cast<unsigned char>(((texel & 31) * 255 + 15) / 31);
+                destination[x * 4 + 3] = !hasAlpha || (texel & 0x8000) ? 255 : 0;
+            }
+            break;
+    }
+}
+
+bool decodeTga(const unsigned char* data, size_t size, TextureImage& image) noexcept
+{
+    constexpr size_t headerSize = 18;
+
+    if (size < headerSize)
+    {
+        print("TGA: truncated header.\n");
+        return false;
+    }
+
+    const unsigned int idLength = data[0];
+    const unsigned int colorMapType = data[1];
+    const unsigned int imageType = data[2];
+    const size_t colorMapLength = readLittleEndian16(data + 5);
+    const size_t colorMapEntrySize = (data[7] + 7u) / 8;
+    const int width = static_cast<int>(readLittleEndian16(data + 12));
+    const int height = static_cast<int>(readLittleEndian16(data + 14));
+    const unsigned int texelBits = data[16];
+    const unsigned int descriptor = data[17];
+
+    const bool isRunLengthEncoded = imageType == 10 || imageType == 11;
+    const bool isGray = imageType == 3 || imageType == 11;
+
+    if ((imageType != 2 && imageType != 3 && imageType != 10 && imageType != 11) || colorMapType > 1)
+    {
+        print("TGA: image type %u is not supported.\n", imageType);
+        return false;
+    }
+
+    if ((isGray && texelBits != 8) || (!isGray && texelBits != 15 && texelBits != 16 && texelBits != 24 && texelBits != 32) || (descriptor & 0x10) ||
+        width == 0 || height == 0)
+    {
+        print("TGA: unsupported %dx%d image with %u bits per texel.\n", width, height, texelBits);
+        return false;
+    }
+
+    const int texelSize = static_cast<int>((texelBits + 7) / 8);
+    const bool hasAlpha = (descriptor & 15) != 0;
+    const bool isTopDown = (descriptor & 0x20) != 0;
+    const size_t rowSize = static_cast<size_t>(width) * texelSize;
+
+    // A color map may come with true color images, it is not used.
+    size_t position = headerSize + idLength + (colorMapType ? colorMapLength * colorMapEntrySize : 0);
+
+    if (position > size || (!isRunLengthEncoded && rowSize * height > size - position))
+    {
+        print("TGA: truncated image data.\n");
+        return false;
+    }
+
+    allocateImage(image, width, height);
+
+    // Run-length packets may cross rows, so the packet state carries over.
+    std::vector<unsigned char> row(isRunLengthEncoded ? rowSize : 0);
+    unsigned char runTexel[4]{};
+    unsigned int packetRemaining = 0;
+    bool isRunPacket = false;
+
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char* source = data + position;
+
+        if (isRunLengthEncoded)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                if (packetRemaining == 0)
+                {
+                    if (position >= size)
+                    {
+                        print("TGA: truncated run-length data.\n");
+                        releaseTextureImage(image);
+                        return false;
+                    }
+
+                    const unsigned int packet = data[position++];
+
+                    packetRemaining = (packet & 127) + 1;
+                    isRunPacket = (packet & 128) != 0;
+
+                    if (isRunPacket)
+                    {
+                        if (static_cast<size_t>(texelSize) > size - position)
+                        {
+                            releaseTextureImage(image);
+                            return false;
+                        }
+
+                        memcpy(runTexel, data + position, texelSize);
+                        position += texelSize;
+                    }
+                }
+
+                if (isRunPacket)
+                {
+                    memcpy(row.data() + x * texelSize, runTexel, texelSize);
+                }
+                else
+                {
+                    if (static_cast<size_t>(texelSize) > size - position)
+                    {
+                        releaseTextureImage(image);
+                        return false;
+                    }
+
+                    memcpy(row.data() + x * texelSize, data + position, texelSize);
+                    position += texelSize;
+                }
+
+                --packetRemaining;
+            }
+
+            source = row.data();
+        }
+        else
+        {
+            position += rowSize;
+        }
+
+        const int destinationY = isTopDown ? y : height - 1 - y;
+        convertTgaRow(source, image.pixels.data() + static_cast<size_t>(destinationY) * width * textureTexelSize, width, texelSize, hasAlpha);
+    }
+
+    return true;
+}
+
+void decodeImageFileJob(void* userData, unsigned int jobIndex) noexcept
+{
+    const DecodeBatch& batch = *static_cast<const DecodeBatch*>(userData);
+
+    decodeImageFile(batch.paths[jobIndex], batch.images[jobIndex]);
+}
+
+void decodeMemoryImageJob(void* userData, unsigned int jobIndex) noexcept
+{
+    const MemoryDecodeBatch& batch = *static_cast<const MemoryDecodeBatch*>(userData);
+
+    decodeImage(batch.format, batch.file->data(), batch.file->size(), batch.images[jobIndex]);
+}
+
+//
+// Benchmark files.
+//
+
+struct BitWriter
+{
+    std::vector<unsigned char>& bytes;
+    uint32_t bits{};
+    int bitCount{};
+};
+
+void writeBits(BitWriter& writer, uint32_t value, int count) noexcept
+{
+    writer.bits |= value << writer.bitCount;
+    writer.bitCount += count;
+
+    while (writer.bitCount >= 8)
+    {
+        writer.bytes.push_back(static_cast<unsigned char>(writer.bits));
+        writer.bits >>= 8;
+        writer.bitCount -= 8;
+    }
+}
+
+void appendBigEndian32(std::vector<unsigned char>& bytes, uint32_t value) noexcept
+{
+    bytes.push_back(static_cast<unsigned char>(value >> 24));
+    bytes.push_back(static_cast<unsigned char>(value >> 16));
+    bytes.push_back(static_cast<unsigned char>(value >> 8));
+    bytes.push_back(static_cast<unsigned char>(value));
+}
+
+// Sub-filtered RGBA rows as fixed Huffman literals, enough to exercise the decode loop without a real compressor.
+std::vector<unsigned char> createBenchmarkPng(const std::vector<unsigned char>& texels, int size) noexcept
+{
+    std::vector<unsigned char> stream = { 0x78, 0x01 };
+    BitWriter writer{ stream };
+
+    writeBits(writer, 1, 1);
+    writeBits(writer, 1, 2);
+
+    for (int y = 0; y < size; ++y)
+    {
+        const unsigned char* row = texels.data() + static_cast<size_t>(y) * size * 4;
+
+        for (int i = -1; i < size * 4; ++i)
+        {
+            const unsigned int literal = i < 0 ? 1 : static_cast<unsigned char>(row[i] - (i >= 4 ? row[i - 4] : 0));
+
+            if (literal < 144)
+            {
+                writeBits(writer, reverseBits(0x30 + literal, 8), 8);
+            }
+            else
+            {
+                writeBits(writer, reverseBits(0x190 + literal - 144, 9), 9);
+            }
+        }
+    }
+
+    // End of block padded to a byte, then the unchecked Adler-32.
+    writeBits(writer, 0, 7);
+    writeBits(writer, 0, (8 - writer.bitCount) & 7);
+    stream.insert(stream.end(), 4, 0);
+
+    std::vector<unsigned char> file(pngSignature, pngSignature + 8);
+
+    const unsigned char header[13] = { 0, 0, static_cast<unsigned char>(size >> 8), static_cast<unsigned char>(size), 0, 0,
+                                       static_cast<unsigned char>(size >> 8), static_cast<unsigned char>(size), 8, 6, 0, 0, 0 };
+
+    const auto appendChunk = [&file](const char* type, const unsigned char* chunk, size_t length)
+    {
+        appendBigEndian32(file, static_cast<uint32_t>(length));
+        file.insert(file.end(), type, type + 4);
+        file.insert(file.end(), chunk, chunk + length);
+
+        // CRCs are not checked.
+        appendBigEndian32(file, 0);
+    };
+
+    appendChunk("IHDR", header, sizeof(header));
+    appendChunk("IDAT", stream.data(), stream.size());
+    appendChunk("IEND", nullptr, 0);
+
+    return file;
+}
+
+// Uncompressed bottom-up BGRA.
+std::vector<unsigned char> createBenchmarkTga(const std::vector<unsigned char>& texels, int size) noexcept
+{
+    std::vector<unsigned char> file(18);
+    file[2] = 2;
+    file[12] = static_cast<unsigned char>(size);
+    file[13] = static_cast<unsigned char>(size >> 8);
+    file[14] = static_cast<unsigned char>(size);
+    file[15] = static_cast<unsigned char>(size >> 8);
+    file[16] = 32;
+    file[17] = 8;
+
+    for (int y = size - 1; y >= 0; --y)
+    {
+        const unsigned char* row = texels.data() + static_cast<size_t>(y) * size * 4;
+
+        for (int x = 0; x < size; ++x)
+        {
+            const unsigned char bgra[4] = { row[x * 4 + 2], row[x * 4 + 1], row[x * 4 + 0], row[x * 4 + 3] };
+            file.insert(file.end(), bgra, bgra + 4);
+        }
+    }
+
+    return file;
+}
+}
+
+ImageFileFormat getImageFileFormat(const char* path, const unsigned char* data, size_t size) noexcept
+{
+    if (size >= 8 && memcmp(data, pngSignature, 8) == 0)
+    {
+        return imageFilePng;
+    }
+
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+    {
+        return imageFileJpeg;
+    }
+
+    return path && hasExtension(path, ".tga") ? imageFileTga : imageFileUnknown;
+}
+
+bool decodeImage(ImageFileFormat format, const unsigned char* data, size_t size, TextureImage& image) noexcept
+{
+    switch (format)
+    {
+        case imageFilePng: return decodePng(data, size, image);
+        case imageFileJpeg: return decodeJpeg(data, size, image);
+        case imageFileTga: return decodeTga(data, size, image);
+        case imageFileUnknown: break;
+    }
+
+    return false;
+}
+
+bool decodeImageFile(const char* path, TextureImage& image) noexcept
+{
+    MappedFile file = mapFileForReading(path);
+
+    if (!file.data)
+    {
+        print("Cannot open image %s.\n", path);
+        return false;
+    }
+
+    const ImageFileFormat format = getImageFileFormat(path, file.data, file.size);
+    const bool isDecoded = decodeImage(format, file.data, file.size, image);
+
+    if (!isDecoded)
+    {
+        print("Cannot decode image %s.\n", path);
+    }
+
+    unmapFile(file);
+
+    return isDecoded;
+}
+
+ImageDecodeStats decodeImageFiles(JobSystem* jobSystem, const char* const* paths, unsigned int count, TextureImage* images) noexcept
+{
+    const double start = getSeconds();
+
+    DecodeBatch batch;
+    batch.paths = paths;
+    batch.images = images;
+
+    if (jobSystem)
+    {
+        runJobs(*jobSystem, decodeImageFileJob, &batch, count);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            decodeImageFileJob(&batch, i);
+        }
+    }
+
+    ImageDecodeStats stats;
+    stats.imageCount = count;
+    stats.seconds = getSeconds() - start;
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (images[i].pixels.empty())
+        {
+            ++stats.failedCount;
+            continue;
+        }
+
+        stats.texelCount += static_cast<uint64_t>(images[i].width) * static_cast<uint64_t>(images[i].height);
+    }
+
+    return stats;
+}
+
+void benchmarkImageDecoding() noexcept
+{
+    constexpr int size = 1024;
+    constexpr unsigned int imageCount = 32;
+
+    // Gradients with noise, like the texture encoding benchmark.
+    std::vector<unsigned char> texels(static_cast<size_t>(size) * size * 4);
+
+    for (size_t i = 0; i < texels.size(); i += 4)
+    {
+        const size_t texel = i / 4;
+        texels[i + 0] = static_cast<unsigned char>(texel);
+        texels[i + 1] = static_cast<unsigned char>(texel >> 4);
+        texels[i + 2] = static_cast<unsigned char>((texel * 2654435761u) >> 28);
+        texels[i + 3] = 255;
+    }
+
+    // Three 1-bit codes in a Huffman table must be refused, not written past the fast lookup table.
+    {
+        std::vector<unsigned char> file = { 0xFF, 0xD8, 0xFF, 0xC4, 0x00, 0x16, 0x00, 3 };
+        file.insert(file.end(), 15, 0);
+        file.insert(file.end(), { 0, 1, 2, 0xFF, 0xD9 });
+
+        TextureImage image;
+        const bool isDecoded = decodeImage(imageFileJpeg, file.data(), file.size(), image);
+
+        assert(!isDecoded);
+        (void)isDecoded;
+    }
+
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    print("Image decoding, %u images of %dx%d:\n", imageCount, size, size);
+
+    for (const ImageFileFormat format : { imageFilePng, imageFileTga })
+    {
+        const std::vector<unsigned char> file = format == imageFilePng ? createBenchmarkPng(texels, size) : createBenchmarkTga(texels, size);
+
+        for (unsigned int threadCount = 1; ; threadCount = threadCount * 2 < coreCount ? threadCount * 2 : coreCount)
+        {
+            JobSystem* jobSystem = threadCount > 1 ? createJobSystem(threadCount - 1) : nullptr;
+
+            std::vector<TextureImage> images(imageCount);
+
+            MemoryDecodeBatch batch;
+            batch.format = format;
+            batch.file = &file;
+            batch.images = images.data();
+
+            const double start = getSeconds();
+
+            if (jobSystem)
+            {
+                runJobs(*jobSystem, decodeMemoryImageJob, &batch, imageCount);
+            }
+            else
+            {
+                for (unsigned int i = 0; i < imageCount; ++i)
+                {
+                    decodeMemoryImageJob(&batch, i);
+                }
+            }
+
+            const double seconds = getSeconds() - start;
+
+            if (jobSystem)
+            {
+                destroyJobSystem(jobSystem);
+            }
+
+            assert(images.back().pixels == texels);
+
+            print("    %s, %2u threads: %8.3f ms, %.1f Mtexels/s\n", format == imageFilePng ? "PNG" : "TGA",
+                threadCount, seconds * 1000.0, static_cast<double>(size) * size * imageCount / seconds * 1e-6);
+
+            if (threadCount == coreCount)
+            {
+                break;
+            }
+        }
+    }
+}
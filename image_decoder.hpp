@@ -0,0 +1,47 @@
+#ifndef KZ_IMAGE_DECODER_HPP
+#define KZ_IMAGE_DECODER_HPP
+
+#include <texture_image.hpp>
+
+#include <cstdint>
+
+struct JobSystem;
+
+enum ImageFileFormat : unsigned char
+{
+    imageFileUnknown,
+    imageFilePng,
+    imageFileJpeg,
+    imageFileTga,
+};
+
+struct ImageDecodeStats
+{
+    unsigned int imageCount{};
+    unsigned int failedCount{};
+
+    uint64_t texelCount{};
+
+    double seconds{};
+};
+
+// PNG and JPEG are recognized by their signature, TGA has none and is recognized by the .tga extension.
+ImageFileFormat getImageFileFormat(const char* path, const unsigned char* data, size_t size) noexcept;
+
+// Decodes into level 0 of a GL_RGBA8 image, the texels are swizzled straight into image.pixels.
+// The pixels have room for the full mip chain, so generateMipChain and the streamer work on them without another copy.
+// PNG: all color types and bit depths, no interlacing. JPEG: baseline and extended Huffman, gray or YCbCr, no progressive.
+// TGA: true color and gray, uncompressed or RLE. Makes no GL calls, so it may run on any thread.
+bool decodeImage(ImageFileFormat format, const unsigned char* data, size_t size, TextureImage& image) noexcept;
+
+// Maps the file for the duration of the decode.
+bool decodeImageFile(const char* path, TextureImage& image) noexcept;
+
+// Decodes every file in its own job, images[i] receives paths[i] and stays empty when it fails.
+// Decodes on the calling thread when no job system is given.
+ImageDecodeStats decodeImageFiles(JobSystem* jobSystem, const char* const* paths, unsigned int count, TextureImage* images) noexcept;
+
+// PNG and TGA decoding of a batch of 1024x1024 images from one to all cores.
+void benchmarkImageDecoding() noexcept;
+
+#endif
@@ -0,0 +1,55 @@
+#include <input_queue.hpp>
+
+bool pushInputEvent(InputQueue& queue, const InputEvent& event) noexcept
+{
+    return pushQueueItem(queue, event);
+}
+
+void readInputBatch(InputQueue& queue, InputBatch& batch) noexcept
+{
+    batch.eventCount = 0;
+    batch.coalescedCount = 0;
+    batch.oldestTime = 0;
+
+    // The window procedure keeps pushing during the drain, so a full batch leaves the rest for the next frame.
+    InputEvent event;
+    while (batch.eventCount < maxInputEvents && popQueueItem(queue, event))
+    {
+        if (batch.eventCount == 0)
+        {
+            batch.oldestTime = event.time;
+        }
+
+        // Only the last position of a run of moves matters.
+        if (event.type == inputEventMouseMove && batch.eventCount > 0 && batch.events[batch.eventCount - 1].type == inputEventMouseMove)
+        {
+            batch.events[batch.eventCount - 1] = event;
+            ++batch.coalescedCount;
+
+            continue;
+        }
+
+        batch.events[batch.eventCount++] = event;
+    }
+}
+
+void applyInputBatch(InputState& state, const InputBatch& batch) noexcept
+{
+    for (unsigned int i = 0; i < batch.eventCount; ++i)
+    {
+        const InputEvent& event = batch.events[i];
+
+        // Leaving carries no button state, captured buttons are still held.
+        if (event.type == inputEventMouseLeave)
+        {
+            state.x = -1;
+            state.y = -1;
+
+            continue;
+        }
+
+        state.x = event.x;
+        state.y = event.y;
+        state.buttons = event.buttons;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef KZ_INPUT_QUEUE_HPP
+#define KZ_INPUT_QUEUE_HPP
+
+#include <spsc_queue.hpp>
+
+#include <cstdint>
+
+constexpr unsigned int maxInputEvents = 256;
+
+enum InputEventType : unsigned char
+{
+    inputEventMouseMove,
+    inputEventButtonDown,
+    inputEventButtonUp,
+    inputEventMouseLeave,
+};
+
+// Bits of InputEvent::buttons.
+enum MouseButtonBits : unsigned int
+{
+    mouseButtonLeft = 1u << 0,
+    mouseButtonRight = 1u << 1,
+    mouseButtonMiddle = 1u << 2,
+    mouseButtonX1 = 1u << 3,
+    mouseButtonX2 = 1u << 4,
+};
+
+struct InputEvent
+{
+    InputEventType type{};
+
+    // Client position, top-left origin.
+    int x{};
+    int y{};
+
+    // All buttons held after the event, not a change, so a lost event can't invert the state.
+    unsigned int buttons{};
+
+    // QueryPerformanceCounter ticks when the window procedure received it.
+    int64_t time{};
+};
+
+typedef SpscQueue<InputEvent, maxInputEvents> InputQueue;
+
+// Events read in one drain of the queue, in arrival order.
+struct InputBatch
+{
+    InputEvent events[maxInputEvents];
+    unsigned int eventCount{};
+
+    // Moves dropped because the next event was a move too.
+    unsigned int coalescedCount{};
+
+    // Oldest event of the batch, zero when empty.
+    int64_t oldestTime{};
+};
+
+struct InputState
+{
+    // Negative while the cursor is outside the client area.
+    int x{ -1 };
+    int y{ -1 };
+
+    unsigned int buttons{};
+};
+
+// Window procedure side, returns false when the queue is full.
+bool pushInputEvent(InputQueue& queue, const InputEvent& event) noexcept;
+
+// Reads what was queued so far, up to maxInputEvents, consecutive moves collapse into the last one.
+void readInputBatch(InputQueue& queue, InputBatch& batch) noexcept;
+
+// Applies the batch in order.
+void applyInputBatch(InputState& state, const InputBatch& batch) noexcept;
+
+#endif
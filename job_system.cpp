@@ -0,0 +1,541 @@
+#include <job_system.hpp>
+#include <frame_recording.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr unsigned int idleSpinCount = 64;
+
+// Worker of the job system this thread belongs to, the creating thread is worker 0 and needs no entry.
+thread_local const JobSystem* currentJobSystem = nullptr;
+thread_local unsigned int currentWorkerIndex = 0;
+
+struct ParallelForData
+{
+    ParallelForFunction* function;
+    void* userData;
+    unsigned int begin;
+    unsigned int end;
+    unsigned int grain;
+};
+
+static_assert(sizeof(ParallelForData) <= jobDataSize, "Parallel-for range does not fit the job data");
+
+struct RunJobsData
+{
+    JobFunction* function;
+    void* userData;
+};
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+JobWorker& getCurrentWorker(JobSystem& jobSystem) noexcept
+{
+    return *jobSystem.workers[currentJobSystem == &jobSystem ? currentWorkerIndex : 0];
+}
+
+bool pushJob(WorkStealingDeque& deque, Job* job) noexcept
+{
+    const int64_t bottom = deque.bottom.load(std::memory_order_relaxed);
+    const int64_t top = deque.top.load(std::memory_order_acquire);
+
+    if (bottom - top >= static_cast<int64_t>(jobDequeCapacity))
+    {
+        return false;
+    }
+
+    deque.slots[bottom & (jobDequeCapacity - 1)].store(job, std::memory_order_relaxed);
+    deque.bottom.store(bottom + 1, std::memory_order_release);
+
+    return true;
+}
+
+Job* popJob(WorkStealingDeque& deque) noexcept
+{
+    const int64_t bottom = deque.bottom.load(std::memory_order_relaxed) - 1;
+
+    // The store must be visible to thieves before top is read.
+    deque.bottom.store(bottom, std::memory_order_seq_cst);
+
+    int64_t top = deque.top.load(std::memory_order_seq_cst);
+
+    if (top > bottom)
+    {
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+
+        return nullptr;
+    }
+
+    Job* job = deque.slots[bottom & (jobDequeCapacity - 1)].load(std::memory_order_relaxed);
+
+    if (top == bottom)
+    {
+        // Last job, race the thieves for it.
+        if (!deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+
+        deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* stealJob(WorkStealingDeque& deque) noexcept
+{
+    int64_t top = deque.top.load(std::memory_order_seq_cst);
+    const int64_t bottom = deque.bottom.load(std::memory_order_seq_cst);
+
+    if (top >= bottom)
+    {
+        return nullptr;
+    }
+
+    Job* job = deque.slots[top & (jobDequeCapacity - 1)].load(std::memory_order_relaxed);
+
+    if (!deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    return job;
+}
+
+bool isDequeEmpty(const WorkStealingDeque& deque) noexcept
+{
+    return deque.bottom.load(std::memory_order_relaxed) <= deque.top.load(std::memory_order_relaxed);
+}
+
+unsigned int nextRandom(unsigned int& state) noexcept
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+Job* getJob(JobSystem& jobSystem, JobWorker& worker) noexcept
+{
+    Job* job = popJob(worker.deque);
+
+    if (!job)
+    {
+        const unsigned int workerCount = static_cast<unsigned int>(jobSystem.workers.size());
+
+        if (workerCount > 1)
+        {
+            JobWorker& victim = *jobSystem.workers[nextRandom(worker.randomState) % workerCount];
+
+            if (&victim != &worker)
+            {
+                job = stealJob(victim.deque);
+            }
+        }
+    }
+
+    if (job)
+    {
+        jobSystem.queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+// Ring slots wrap onto jobs still running when one thread keeps more than maxJobsPerWorker unfinished.
+Job* allocateOverflowJob(JobWorker& worker) noexcept
+{
+    for (Job* job : worker.overflowJobs)
+    {
+        if (job->unfinishedJobs.load(std::memory_order_acquire) == 0)
+        {
+            return job;
+        }
+    }
+
+    Job* job = new Job;
+    worker.overflowJobs.push_back(job);
+
+    return job;
+}
+
+void finishJob(Job* job) noexcept
+{
+    while (job)
+    {
+        Job* parent = job->parent;
+
+        // The job slot may be reused as soon as the count reaches zero.
+        if (job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        job = parent;
+    }
+}
+
+void executeJob(JobSystem& jobSystem, Job* job) noexcept
+{
+    job->function(jobSystem, *job);
+
+    finishJob(job);
+}
+
+void workerThread(JobSystem* jobSystem, unsigned int workerIndex) noexcept
+{
+    currentJobSystem = jobSystem;
+    currentWorkerIndex = workerIndex;
+
+    JobWorker& worker = *jobSystem->workers[workerIndex];
+
+    unsigned int idleCount = 0;
+
+    while (!jobSystem->quit.load(std::memory_order_acquire))
+    {
+        if (Job* job = getJob(*jobSystem, worker))
+        {
+            executeJob(*jobSystem, job);
+            idleCount = 0;
+
+            continue;
+        }
+
+        if (++idleCount < idleSpinCount)
+        {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        // Nothing was queued for a while, sleep until the next push.
+        std::unique_lock<std::mutex> lock(jobSystem->mutex);
+
+        jobSystem->sleepingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+        jobSystem->wakeCondition.wait(lock, [&]()
+        {
+            return jobSystem->quit.load(std::memory_order_acquire) || jobSystem->queuedJobCount.load(std::memory_order_seq_cst) > 0;
+        });
+        jobSystem->sleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+
+        idleCount = 0;
+    }
+}
+
+void parallelForJob(JobSystem& jobSystem, Job& job) noexcept
+{
+    ParallelForData range;
+    std::memcpy(&range, job.data, sizeof(range));
+
+    JobWorker& worker = getCurrentWorker(jobSystem);
+
+    while (range.begin < range.end)
+    {
+        // Lazy binary splitting, the upper half is offered only once thieves emptied this deque.
+        if (range.end - range.begin > range.grain && isDequeEmpty(worker.deque))
+        {
+            ParallelForData upper = range;
+            upper.begin = range.begin + (range.end - range.begin) / 2;
+
+            range.end = upper.begin;
+
+            runJob(jobSystem, createJob(jobSystem, parallelForJob, &job, &upper, sizeof(upper)));
+
+            continue;
+        }
+
+        const unsigned int chunkEnd = range.end - range.begin > range.grain ? range.begin + range.grain : range.end;
+
+        range.function(range.userData, range.begin, chunkEnd);
+
+        range.begin = chunkEnd;
+    }
+}
+
+void runJobsRange(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const RunJobsData& data = *static_cast<const RunJobsData*>(userData);
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        data.function(data.userData, i);
+    }
+}
+
+void emptyJob(JobSystem&, Job&) noexcept
+{
+}
+
+void spawnEmptyJobs(JobSystem& jobSystem, Job& job) noexcept
+{
+    unsigned int count;
+    std::memcpy(&count, job.data, sizeof(count));
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        runJob(jobSystem, createJob(jobSystem, emptyJob, &job, nullptr, 0));
+    }
+}
+
+struct TransformBatch
+{
+    const float* input;
+    float* output;
+};
+
+// Stand-in for per-element transform work.
+void transformRange(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const TransformBatch& batch = *static_cast<const TransformBatch*>(userData);
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const float x = batch.input[i];
+
+        batch.output[i] = std::sqrt(x * x + 1.0f) * std::sin(x) + std::cos(x * 0.5f);
+    }
+}
+}
+
+unsigned int getDefaultWorkerThreadCount() noexcept
+{
+    const unsigned int coreCount = std::thread::hardware_concurrency();
+
+    return coreCount > 1 ? coreCount - 1 : 0;
+}
+
+JobSystem* createJobSystem(unsigned int workerThreadCount) noexcept
+{
+    JobSystem* jobSystem = new JobSystem;
+
+    for (unsigned int i = 0; i <= workerThreadCount; ++i)
+    {
+        JobWorker* worker = new JobWorker;
+        worker->randomState = 0x9e3779b9u * (i + 1);
+
+        jobSystem->workers.push_back(worker);
+    }
+
+    jobSystem->threads.reserve(workerThreadCount);
+
+    for (unsigned int i = 1; i <= workerThreadCount; ++i)
+    {
+        jobSystem->threads.emplace_back(workerThread, jobSystem, i);
+    }
+
+    return jobSystem;
+}
+
+void destroyJobSystem(JobSystem* jobSystem) noexcept
+{
+    if (!jobSystem)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobSystem->mutex);
+        jobSystem->quit.store(true, std::memory_order_release);
+    }
+
+    jobSystem->wakeCondition.notify_all();
+
+    for (std::thread& thread : jobSystem->threads)
+    {
+        thread.join();
+    }
+
+    for (JobWorker* worker : jobSystem->workers)
+    {
+        for (Job* job : worker->overflowJobs)
+        {
+            delete job;
+        }
+
+        delete worker;
+    }
+
+    delete jobSystem;
+}
+
+unsigned int getJobThreadCount(const JobSystem& jobSystem) noexcept
+{
+    return static_cast<unsigned int>(jobSystem.workers.size());
+}
+
+Job* createJob(JobSystem& jobSystem, JobEntry* function, Job* parent, const void* data, size_t dataSize) noexcept
+{
+    assert(function);
+    assert(dataSize <= jobDataSize);
+
+    JobWorker& worker = getCurrentWorker(jobSystem);
+    Job* job = &worker.jobs[worker.allocatedJobCount++ & (maxJobsPerWorker - 1)];
+
+    // Only a finished job can be reused.
+    if (job->unfinishedJobs.load(std::memory_order_acquire) != 0)
+    {
+        job = allocateOverflowJob(worker);
+    }
+
+    job->function = function;
+    job->parent = parent;
+    job->unfinishedJobs.store(1, std::memory_order_relaxed);
+
+    if (dataSize > 0)
+    {
+        std::memcpy(job->data, data, dataSize);
+    }
+
+    if (parent)
+    {
+        parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+void runJob(JobSystem& jobSystem, Job* job) noexcept
+{
+    JobWorker& worker = getCurrentWorker(jobSystem);
+
+    if (!pushJob(worker.deque, job))
+    {
+        executeJob(jobSystem, job);
+
+        return;
+    }
+
+    jobSystem.queuedJobCount.fetch_add(1, std::memory_order_seq_cst);
+
+    if (jobSystem.sleepingWorkerCount.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(jobSystem.mutex);
+        jobSystem.wakeCondition.notify_one();
+    }
+}
+
+void waitForJob(JobSystem& jobSystem, Job* job) noexcept
+{
+    JobWorker& worker = getCurrentWorker(jobSystem);
+
+    while (job->unfinishedJobs.load(std::memory_order_acquire) > 0)
+    {
+        if (Job* next = getJob(jobSystem, worker))
+        {
+            executeJob(jobSystem, next);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void parallelFor(JobSystem& jobSystem, ParallelForFunction* function, void* userData, unsigned int count, unsigned int grain) noexcept
+{
+    assert(function);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    const ParallelForData range = { function, userData, 0, count, grain > 0 ? grain : 1 };
+
+    Job* root = createJob(jobSystem, parallelForJob, nullptr, &range, sizeof(range));
+
+    // The root is run in place, only the split halves are queued.
+    executeJob(jobSystem, root);
+    waitForJob(jobSystem, root);
+}
+
+void runJobs(JobSystem& jobSystem, JobFunction* function, void* userData, unsigned int jobCount) noexcept
+{
+    RunJobsData data = { function, userData };
+
+    parallelFor(jobSystem, runJobsRange, &data, jobCount, 1);
+}
+
+void benchmarkJobSystem() noexcept
+{
+    constexpr unsigned int spawnCount = 2000;
+    constexpr unsigned int elementCount = 4 * 1024 * 1024;
+    constexpr unsigned int repeatCount = 8;
+
+    std::vector<float> input(elementCount);
+    std::vector<float> output(elementCount);
+
+    for (unsigned int i = 0; i < elementCount; ++i)
+    {
+        input[i] = static_cast<float>(i) * 0.001f;
+    }
+
+    FrameRecording recording = createFrameRecording(100000);
+    RenderQueue queue = createRenderQueue(100000, 0);
+
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    double singleThreadSeconds[3] = {};
+
+    for (unsigned int threadCount = 1; threadCount <= coreCount; ++threadCount)
+    {
+        JobSystem* jobSystem = createJobSystem(threadCount - 1);
+
+        double seconds[3] = {};
+
+        for (unsigned int repeat = 0; repeat < repeatCount; ++repeat)
+        {
+            const double spawnStart = getSeconds();
+
+            Job* root = createJob(*jobSystem, spawnEmptyJobs, nullptr, &spawnCount, sizeof(spawnCount));
+            runJob(*jobSystem, root);
+            waitForJob(*jobSystem, root);
+
+            const double transformStart = getSeconds();
+
+            TransformBatch batch = { input.data(), output.data() };
+            parallelFor(*jobSystem, transformRange, &batch, elementCount, 4096);
+
+            const double recordStart = getSeconds();
+
+            beginRenderQueueFrame(queue);
+            recordSceneFrame(jobSystem, recording, queue, static_cast<float>(repeat) / 60.0f);
+
+            const double recordEnd = getSeconds();
+
+            seconds[0] += transformStart - spawnStart;
+            seconds[1] += recordStart - transformStart;
+            seconds[2] += recordEnd - recordStart;
+        }
+
+        destroyJobSystem(jobSystem);
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            seconds[i] /= repeatCount;
+
+            if (threadCount == 1)
+            {
+                singleThreadSeconds[i] = seconds[i];
+            }
+        }
+
+        print("Job system: %2u threads, %u empty jobs %7.3f ms (%.2f us/job), parallel-for %u elements %7.3f ms (%5.2fx), record 100k objects %7.3f ms (%5.2fx)\n",
+            threadCount, spawnCount, seconds[0] * 1000.0, seconds[0] * 1000000.0 / spawnCount,
+            elementCount, seconds[1] * 1000.0, singleThreadSeconds[1] / seconds[1],
+            seconds[2] * 1000.0, singleThreadSeconds[2] / seconds[2]);
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef KZ_JOB_SYSTEM_HPP
+#define KZ_JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+struct JobSystem;
+
+typedef void JobEntry(JobSystem& jobSystem, Job& job);
+typedef void JobFunction(void* userData, unsigned int jobIndex);
+typedef void ParallelForFunction(void* userData, unsigned int begin, unsigned int end);
+
+constexpr size_t jobDataSize = 40;
+constexpr unsigned int maxJobsPerWorker = 4096;
+constexpr unsigned int jobDequeCapacity = 4096;
+
+// A job counts itself and its unfinished children, the parent is notified when the count drops to zero.
+struct alignas(64) Job
+{
+    JobEntry* function{};
+    Job* parent{};
+    std::atomic<int> unfinishedJobs{};
+
+    alignas(8) unsigned char data[jobDataSize]{};
+};
+
+// Chase-Lev deque, the owner pushes and pops at the bottom and thieves take from the top.
+struct WorkStealingDeque
+{
+    alignas(64) std::atomic<int64_t> top{};
+    alignas(64) std::atomic<int64_t> bottom{};
+    std::atomic<Job*> slots[jobDequeCapacity]{};
+};
+
+// Per-thread state, worker 0 is the thread that created the job system.
+struct JobWorker
+{
+    WorkStealingDeque deque;
+
+    // Ring of jobs created by this thread, a slot is reused after maxJobsPerWorker newer jobs.
+    Job jobs[maxJobsPerWorker];
+    unsigned int allocatedJobCount{};
+
+    // Taken when the ring slot is still live, reused once finished and freed with the job system.
+    std::vector<Job*> overflowJobs;
+
+    unsigned int randomState{};
+};
+
+struct JobSystem
+{
+    std::vector<JobWorker*> workers;
+    std::vector<std::thread> threads;
+
+    // Sleeping workers wait for queued jobs.
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::atomic<int> queuedJobCount{};
+    std::atomic<int> sleepingWorkerCount{};
+    std::atomic<bool> quit{};
+};
+
+// One worker per core besides the calling thread.
+unsigned int getDefaultWorkerThreadCount() noexcept;
+
+// Jobs may be created and waited for on the creating thread and inside jobs only.
+JobSystem* createJobSystem(unsigned int workerThreadCount) noexcept;
+
+void destroyJobSystem(JobSystem* jobSystem) noexcept;
+
+// Threads running jobs, workers and the creating thread.
+unsigned int getJobThreadCount(const JobSystem& jobSystem) noexcept;
+
+// The data is copied into the job, parent may be null.
+// Up to maxJobsPerWorker jobs per thread come from its ring, more unfinished jobs than that are allocated on the heap.
+// Threads outside the job system share the ring of the creating thread, so only the creating thread may create jobs there.
+Job* createJob(JobSystem& jobSystem, JobEntry* function, Job* parent, const void* data, size_t dataSize) noexcept;
+
+// Queues the job on the calling thread's deque, or runs it in place when the deque is full.
+void runJob(JobSystem& jobSystem, Job* job) noexcept;
+
+// Runs other jobs until the job and all its children have finished.
+void waitForJob(JobSystem& jobSystem, Job* job) noexcept;
+
+// Ranges are split in halves only while this thread's deque is empty, so work is divided as fast as it is stolen.
+// Each call gets at most grain elements.
+void parallelFor(JobSystem& jobSystem, ParallelForFunction* function, void* userData, unsigned int count, unsigned int grain) noexcept;
+
+// Runs jobIndex 0 to jobCount - 1 in any order and on any thread, returns when all have finished.
+void runJobs(JobSystem& jobSystem, JobFunction* function, void* userData, unsigned int jobCount) noexcept;
+
+// Spawn, parallel-for and frame recording timings from one to all cores.
+void benchmarkJobSystem() noexcept;
+
+#endif
@@ -0,0 +1,241 @@
+#include <low_latency.hpp>
+
+#include <cassert>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr double costAverageWeight = 0.1;
+constexpr double minMarginSeconds = 0.001;
+constexpr double maxMarginSeconds = 0.004;
+
+// Timer wakeups can be late by this much, the rest is spun.
+constexpr double spinSeconds = 0.0005;
+
+int64_t getTicks() noexcept
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return counter.QuadPart;
+}
+
+void addCostSample(double& average, double& deviation, double seconds) noexcept
+{
+    const double difference = seconds > average ? seconds - average : average - seconds;
+
+    average += (seconds - average) * costAverageWeight;
+    deviation += (difference - deviation) * costAverageWeight;
+}
+
+// Two deviations above the average cover all but the rare spikes.
+double getPredictedFrameSeconds(const LowLatencyScheduler& scheduler) noexcept
+{
+    return scheduler.cpuAverageSeconds + 2.0 * scheduler.cpuDeviationSeconds +
+           scheduler.gpuAverageSeconds + 2.0 * scheduler.gpuDeviationSeconds +
+           scheduler.marginSeconds;
+}
+
+void readGpuQueries(LowLatencyScheduler& scheduler) noexcept
+{
+    for (unsigned int i = 0; i < gpuFrameTimerCount; ++i)
+    {
+        if (!scheduler.gpuQueryPending[i])
+        {
+            continue;
+        }
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(scheduler.gpuQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (!available)
+        {
+            continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(scheduler.gpuQueries[i], GL_QUERY_RESULT, &elapsed);
+
+        const double seconds = static_cast<double>(elapsed) / 1000000000.0;
+
+        addCostSample(scheduler.gpuAverageSeconds, scheduler.gpuDeviationSeconds, seconds);
+        scheduler.stats.gpuSeconds += seconds;
+
+        scheduler.gpuQueryPending[i] = false;
+    }
+}
+
+void waitUntil(const LowLatencyScheduler& scheduler, int64_t targetTime) noexcept
+{
+    const int64_t spinTicks = static_cast<int64_t>(spinSeconds * static_cast<double>(scheduler.frequency));
+    const int64_t sleepTicks = targetTime - getTicks() - spinTicks;
+
+    if (sleepTicks > 0)
+    {
+        if (scheduler.timer)
+        {
+            // Relative due time in 100 ns units.
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -static_cast<LONGLONG>(static_cast<double>(sleepTicks) * 10000000.0 / static_cast<double>(scheduler.frequency));
+
+            if (SetWaitableTimer(scheduler.timer, &dueTime, 0, NULL, NULL, FALSE))
+            {
+                WaitForSingleObject(scheduler.timer, INFINITE);
+            }
+        }
+        else
+        {
+            // Default timer resolution can oversleep by a whole tick.
+            const DWORD milliseconds = static_cast<DWORD>(sleepTicks * 1000 / scheduler.frequency);
+
+            if (milliseconds > 1)
+            {
+                Sleep(milliseconds - 1);
+            }
+        }
+    }
+
+    while (getTicks() < targetTime)
+    {
+        YieldProcessor();
+    }
+}
+}
+
+LowLatencyScheduler createLowLatencyScheduler(bool enabled) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    LowLatencyScheduler scheduler;
+
+    scheduler.enabled = enabled;
+    scheduler.marginSeconds = minMarginSeconds;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    scheduler.frequency = frequency.QuadPart;
+
+    glGenQueries(gpuFrameTimerCount, scheduler.gpuQueries);
+
+    if (enabled)
+    {
+        scheduler.timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return scheduler;
+}
+
+void destroyLowLatencyScheduler(LowLatencyScheduler& scheduler) noexcept
+{
+    glDeleteQueries(gpuFrameTimerCount, scheduler.gpuQueries);
+
+    if (scheduler.timer)
+    {
+        CloseHandle(scheduler.timer);
+        scheduler.timer = NULL;
+    }
+}
+
+void waitForLatestFrameStart(LowLatencyScheduler& scheduler, const FramePacer& pacer) noexcept
+{
+    readGpuQueries(scheduler);
+
+    if (!scheduler.enabled || pacer.lastPresentTime == 0 || pacer.refreshIntervalSeconds == 0.0)
+    {
+        return;
+    }
+
+    const double latestStartSeconds = pacer.refreshIntervalSeconds - getPredictedFrameSeconds(scheduler);
+
+    if (latestStartSeconds <= 0.0)
+    {
+        return;
+    }
+
+    const int64_t targetTime = pacer.lastPresentTime + static_cast<int64_t>(latestStartSeconds * static_cast<double>(scheduler.frequency));
+    const int64_t waitStart = getTicks();
+
+    if (targetTime <= waitStart)
+    {
+        return;
+    }
+
+    waitUntil(scheduler, targetTime);
+
+    scheduler.stats.delaySeconds += static_cast<double>(getTicks() - waitStart) / static_cast<double>(scheduler.frequency);
+}
+
+void beginTimedFrame(LowLatencyScheduler& scheduler) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    scheduler.frameStartTime = getTicks();
+
+    // Still pending after all frames in flight retired, skip timing this frame.
+    if (!scheduler.gpuQueryPending[scheduler.gpuQueryIndex])
+    {
+        glBeginQuery(GL_TIME_ELAPSED, scheduler.gpuQueries[scheduler.gpuQueryIndex]);
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void endTimedFrame(LowLatencyScheduler& scheduler) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (!scheduler.gpuQueryPending[scheduler.gpuQueryIndex])
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+
+        scheduler.gpuQueryPending[scheduler.gpuQueryIndex] = true;
+        scheduler.gpuQueryIndex = (scheduler.gpuQueryIndex + 1) % gpuFrameTimerCount;
+    }
+
+    scheduler.frameCpuSeconds = static_cast<double>(getTicks() - scheduler.frameStartTime) / static_cast<double>(scheduler.frequency);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void recordFramePresent(LowLatencyScheduler& scheduler, const FramePacer& pacer, int64_t inputTime) noexcept
+{
+    scheduler.stats.predictedSeconds += getPredictedFrameSeconds(scheduler);
+
+    addCostSample(scheduler.cpuAverageSeconds, scheduler.cpuDeviationSeconds, scheduler.frameCpuSeconds);
+    scheduler.stats.cpuSeconds += scheduler.frameCpuSeconds;
+    ++scheduler.stats.frameCount;
+
+    const double presentInterval = static_cast<double>(pacer.lastPresentTime - scheduler.frameStartTime) / static_cast<double>(scheduler.frequency);
+
+    // Starting late enough to miss the vsync costs a whole refresh, back off quickly and creep back.
+    if (scheduler.enabled && pacer.refreshIntervalSeconds > 0.0 && presentInterval > pacer.refreshIntervalSeconds * 1.5)
+    {
+        scheduler.marginSeconds = scheduler.marginSeconds * 2.0 < maxMarginSeconds ? scheduler.marginSeconds * 2.0 : maxMarginSeconds;
+    }
+    else
+    {
+        scheduler.marginSeconds -= (scheduler.marginSeconds - minMarginSeconds) * 0.01;
+    }
+
+    if (inputTime)
+    {
+        const double latency = static_cast<double>(pacer.lastPresentTime - inputTime) / static_cast<double>(scheduler.frequency);
+
+        scheduler.stats.inputToPresentSeconds += latency;
+        scheduler.stats.maxInputToPresentSeconds = latency > scheduler.stats.maxInputToPresentSeconds ? latency : scheduler.stats.maxInputToPresentSeconds;
+        ++scheduler.stats.inputFrameCount;
+    }
+}
+
+LowLatencyStats takeLowLatencyStats(LowLatencyScheduler& scheduler) noexcept
+{
+    const LowLatencyStats stats = scheduler.stats;
+
+    scheduler.stats = {};
+
+    return stats;
+}
@@ -0,0 +1,75 @@
+#ifndef KZ_LOW_LATENCY_HPP
+#define KZ_LOW_LATENCY_HPP
+
+#include <frame_pacing.hpp>
+
+#include <cstdint>
+
+// One more than the frames that can be in flight, so a query is never reused before its result is read.
+constexpr unsigned int gpuFrameTimerCount = maxPacedFramesInFlight + 1;
+
+struct LowLatencyStats
+{
+    unsigned int frameCount{};
+
+    // Sleep before the frame start.
+    double delaySeconds{};
+
+    // Measured costs next to the predictions made for them.
+    double cpuSeconds{};
+    double gpuSeconds{};
+    double predictedSeconds{};
+
+    // Oldest input event applied by a frame to the return of its swap.
+    unsigned int inputFrameCount{};
+    double inputToPresentSeconds{};
+    double maxInputToPresentSeconds{};
+};
+
+// Starts each frame as late as the predicted CPU and GPU cost allow, so input is sampled just before the vsync it is shown at.
+struct LowLatencyScheduler
+{
+    bool enabled{};
+
+    // GL_TIME_ELAPSED around all GL work of a frame, read back without waiting.
+    GLuint gpuQueries[gpuFrameTimerCount]{};
+    bool gpuQueryPending[gpuFrameTimerCount]{};
+    unsigned int gpuQueryIndex{};
+
+    // Exponential averages of the cost and of its deviation.
+    double cpuAverageSeconds{};
+    double cpuDeviationSeconds{};
+    double gpuAverageSeconds{};
+    double gpuDeviationSeconds{};
+
+    // Safety before the vsync, grows on missed presents and decays back.
+    double marginSeconds{};
+
+    int64_t frequency{};
+    int64_t frameStartTime{};
+    double frameCpuSeconds{};
+
+    // High resolution waitable timer, null when the system has none.
+    HANDLE timer{};
+
+    LowLatencyStats stats;
+};
+
+LowLatencyScheduler createLowLatencyScheduler(bool enabled) noexcept;
+
+void destroyLowLatencyScheduler(LowLatencyScheduler& scheduler) noexcept;
+
+// Sleeps until the latest start that still makes the next vsync after the pacer's last present.
+void waitForLatestFrameStart(LowLatencyScheduler& scheduler, const FramePacer& pacer) noexcept;
+
+// Brackets the GL work of the frame, the swap stays outside.
+void beginTimedFrame(LowLatencyScheduler& scheduler) noexcept;
+void endTimedFrame(LowLatencyScheduler& scheduler) noexcept;
+
+// After endPacedFrame, inputTime is the oldest input event the frame applied or zero.
+void recordFramePresent(LowLatencyScheduler& scheduler, const FramePacer& pacer, int64_t inputTime) noexcept;
+
+// Returns and clears the stats gathered since the last call.
+LowLatencyStats takeLowLatencyStats(LowLatencyScheduler& scheduler) noexcept;
+
+#endif
@@ -0,0 +1,73 @@
+#include <mapped_file.hpp>
+
+#include <cassert>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+MappedFile mapFileForReading(const char* path) noexcept
+{
+    assert(path);
+
+    MappedFile result{};
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return result;
+    }
+
+    LARGE_INTEGER fileSize{};
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return result;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return result;
+    }
+
+    // Map the whole file, the OS pages it in on demand.
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return result;
+    }
+
+    result.fileHandle = file;
+    result.mappingHandle = mapping;
+    result.data = static_cast<const unsigned char*>(view);
+    result.size = static_cast<size_t>(fileSize.QuadPart);
+
+    return result;
+}
+
+void unmapFile(MappedFile& file) noexcept
+{
+    if (file.data)
+    {
+        UnmapViewOfFile(file.data);
+    }
+
+    if (file.mappingHandle)
+    {
+        CloseHandle(file.mappingHandle);
+    }
+
+    if (file.fileHandle)
+    {
+        CloseHandle(file.fileHandle);
+    }
+
+    file = {};
+}
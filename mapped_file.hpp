@@ -0,0 +1,20 @@
+#ifndef KZ_MAPPED_FILE_HPP
+#define KZ_MAPPED_FILE_HPP
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file.
+struct MappedFile
+{
+    void* fileHandle{};
+    void* mappingHandle{};
+
+    const unsigned char* data{};
+    size_t size{};
+};
+
+MappedFile mapFileForReading(const char* path) noexcept;
+
+void unmapFile(MappedFile& file) noexcept;
+
+#endif
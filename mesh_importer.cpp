@@ -0,0 +1,1806 @@
+#include <mesh_importer.hpp>
+#include <mapped_file.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Smallest OBJ text block handed to a single parsing task.
+constexpr size_t minimumObjChunkSize = 1u << 20;
+
+// Vertices or indices converted per glTF decoding task.
+constexpr size_t gltfBlockSize = 1u << 16;
+
+constexpr int missingObjIndex = INT_MIN;
+
+unsigned int getImportThreadCount(unsigned int requestedThreadCount) noexcept
+{
+    if (requestedThreadCount > 0)
+    {
+        return requestedThreadCount;
+    }
+
+    const unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+
+    return hardwareThreadCount > 0 ? hardwareThreadCount : 1;
+}
+
+// Runs the tasks on up to threadCount threads, each thread pulls the next task index from a shared counter.
+template <typename Task>
+void runParallel(size_t taskCount, unsigned int threadCount, const Task& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    std::atomic<size_t> nextTask{ 0 };
+
+    const auto worker = [&]()
+    {
+        for (;;)
+        {
+            const size_t taskIndex = nextTask.fetch_add(1, std::memory_order_relaxed);
+
+            if (taskIndex >= taskCount)
+            {
+                break;
+            }
+
+            task(taskIndex);
+        }
+    };
+
+    const size_t workerCount = taskCount < threadCount ? taskCount : threadCount;
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+
+    for (size_t i = 1; i < workerCount; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+
+    // The calling thread works too.
+    worker();
+
+    for (std::thread& thread : workers)
+    {
+        thread.join();
+    }
+}
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+void fillImportStats(MeshImportStats* stats, size_t bytesRead, size_t chunkCount, unsigned int threadCount, double seconds) noexcept
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    stats->bytesRead = bytesRead;
+    stats->chunkCount = chunkCount;
+    stats->threadCount = threadCount;
+    stats->seconds = seconds;
+    stats->megabytesPerSecond = seconds > 0.0 ? (static_cast<double>(bytesRead) / (1024.0 * 1024.0)) / seconds : 0.0;
+}
+
+bool isInlineSpace(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool isDigit(char c) noexcept
+{
+    return static_cast<unsigned int>(c - '0') < 10u;
+}
+
+const char* skipInlineSpaces(const char* p, const char* end) noexcept
+{
+    while (p < end && isInlineSpace(*p))
+    {
+        ++p;
+    }
+
+    return p;
+}
+
+const char* skipLine(const char* p, const char* end) noexcept
+{
+    const void* newLine = memchr(p, '\n', static_cast<size_t>(end - p));
+
+    return newLine ? static_cast<const char*>(newLine) + 1 : end;
+}
+
+// Locale independent number parsing, strtof is the bottleneck of naive OBJ loaders.
+const char* parseNumber(const char* p, const char* end, double& result) noexcept
+{
+    static constexpr double powersOfTen[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    constexpr int maxPowerOfTen = 22;
+
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    double value = 0.0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    while (p < end && isDigit(*p))
+    {
+        value = value * 10.0 + static_cast<double>(*p - '0');
+        hasDigits = true;
+        ++p;
+    }
+
+    if (p < end && *p == '.')
+    {
+        ++p;
+
+        while (p < end && isDigit(*p))
+        {
+            value = value * 10.0 + static_cast<double>(*p - '0');
+            hasDigits = true;
+            --exponent;
+            ++p;
+        }
+    }
+
+    if (!hasDigits)
+    {
+        result = 0.0;
+        return start;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+
+        int explicitExponent = 0;
+        while (p < end && isDigit(*p))
+        {
+            if (explicitExponent < 1000)
+            {
+                explicitExponent = explicitExponent * 10 + (*p - '0');
+            }
+            ++p;
+        }
+
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+
+    while (exponent < 0)
+    {
+        const int step = -exponent < maxPowerOfTen ? -exponent : maxPowerOfTen;
+        value /= powersOfTen[step];
+        exponent += step;
+    }
+
+    while (exponent > 0)
+    {
+        const int step = exponent < maxPowerOfTen ? exponent : maxPowerOfTen;
+        value *= powersOfTen[step];
+        exponent -= step;
+    }
+
+    result = negative ? -value : value;
+
+    return p;
+}
+
+const char* parseFloat(const char* p, const char* end, float& result) noexcept
+{
+    double value = 0.0;
+    p = parseNumber(p, end, value);
+
+    result = static_cast<float>(value);
+
+    return p;
+}
+
+const char* parseInt(const char* p, const char* end, int& result, bool& parsed) noexcept
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    long long value = 0;
+    parsed = false;
+
+    while (p < end && isDigit(*p))
+    {
+        if (value < INT_MAX)
+        {
+            value = value * 10 + (*p - '0');
+        }
+        parsed = true;
+        ++p;
+    }
+
+    if (value > INT_MAX)
+    {
+        value = INT_MAX;
+    }
+
+    result = static_cast<int>(negative ? -value : value);
+
+    return p;
+}
+
+// One face corner as written in the file, relative indices are kept chunk-local until the chunk offsets are known.
+struct ObjCorner
+{
+    int index[3];
+    unsigned int relativeMask;
+};
+
+struct ObjChunk
+{
+    const char* begin{};
+    const char* end{};
+
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+
+    // Triangulated faces, three corners per triangle.
+    std::vector<ObjCorner> corners;
+
+    size_t positionBase{};
+    size_t uvBase{};
+    size_t normalBase{};
+    size_t cornerBase{};
+
+    bool failed{};
+};
+
+const char* parseObjCorner(const char* p, const char* end, const size_t localCounts[3], ObjCorner& corner) noexcept
+{
+    corner.index[0] = corner.index[1] = corner.index[2] = missingObjIndex;
+    corner.relativeMask = 0;
+
+    // "v", "v/t", "v//n" or "v/t/n".
+    for (int component = 0; component < 3; ++component)
+    {
+        if (component > 0)
+        {
+            if (p >= end || *p != '/')
+            {
+                break;
+            }
+            ++p;
+        }
+
+        int value = 0;
+        bool parsed = false;
+        p = parseInt(p, end, value, parsed);
+
+        if (!parsed || value == 0)
+        {
+            continue;
+        }
+
+        if (value > 0)
+        {
+            corner.index[component] = value - 1;
+        }
+        else
+        {
+            corner.index[component] = static_cast<int>(static_cast<long long>(localCounts[component]) + value);
+            corner.relativeMask |= 1u << component;
+        }
+    }
+
+    return p;
+}
+
+void parseObjChunk(ObjChunk& chunk) noexcept
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+
+    std::vector<ObjCorner> polygon;
+
+    while (p < end)
+    {
+        p = skipInlineSpaces(p, end);
+
+        if (p >= end)
+        {
+            break;
+        }
+
+        if (p[0] == 'v' && p + 1 < end)
+        {
+            if (isInlineSpace(p[1]))
+            {
+                float position[3]{};
+                p += 2;
+
+                for (float& value : position)
+                {
+                    p = parseFloat(skipInlineSpaces(p, end), end, value);
+                }
+
+                chunk.positions.insert(chunk.positions.end(), position, position + 3);
+            }
+            else if (p[1] == 't' && p + 2 < end && isInlineSpace(p[2]))
+            {
+                float uv[2]{};
+                p += 3;
+
+                for (float& value : uv)
+                {
+                    p = parseFloat(skipInlineSpaces(p, end), end, value);
+                }
+
+                chunk.uvs.insert(chunk.uvs.end(), uv, uv + 2);
+            }
+            else if (p[1] == 'n' && p + 2 < end && isInlineSpace(p[2]))
+            {
+                float normal[3]{};
+                p += 3;
+
+                for (float& value : normal)
+                {
+                    p = parseFloat(skipInlineSpaces(p, end), end, value);
+                }
+
+                chunk.normals.insert(chunk.normals.end(), normal, normal + 3);
+            }
+        }
+        else if (p[0] == 'f' && p + 1 < end && isInlineSpace(p[1]))
+        {
+            p += 2;
+            polygon.clear();
+
+            const size_t localCounts[3] = { chunk.positions.size() / 3, chunk.uvs.size() / 2, chunk.normals.size() / 3 };
+
+            for (;;)
+            {
+                p = skipInlineSpaces(p, end);
+
+                if (p >= end || *p == '\n' || *p == '#')
+                {
+                    break;
+                }
+
+                ObjCorner corner;
+                const char* next = parseObjCorner(p, end, localCounts, corner);
+
+                if (next == p || corner.index[0] == missingObjIndex)
+                {
+                    chunk.failed = true;
+                    break;
+                }
+
+                polygon.push_back(corner);
+                p = next;
+            }
+
+            // Triangulate polygons as fans.
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+
+        // Everything else (groups, materials, smoothing, comments) is ignored.
+        p = skipLine(p, end);
+    }
+}
+
+struct ObjVertexKey
+{
+    int position;
+    int uv;
+    int normal;
+};
+
+bool operator==(const ObjVertexKey& left, const ObjVertexKey& right) noexcept
+{
+    return left.position == right.position && left.uv == right.uv && left.normal == right.normal;
+}
+
+uint32_t hashObjVertexKey(const ObjVertexKey& key) noexcept
+{
+    uint32_t hash = static_cast<uint32_t>(key.position) * 0x9E3779B1u;
+    hash ^= static_cast<uint32_t>(key.uv) * 0x85EBCA77u;
+    hash ^= static_cast<uint32_t>(key.normal) * 0xC2B2AE3Du;
+
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+
+    return hash;
+}
+
+// Open addressing table mapping unique vertex keys to their first-use order.
+struct ObjVertexTable
+{
+    std::vector<ObjVertexKey> keys;
+    std::vector<unsigned int> values;
+    std::vector<uint32_t> hashes;
+    size_t count{};
+
+    void reserve(size_t expectedCount)
+    {
+        size_t capacity = 16;
+        while (capacity < expectedCount * 2)
+        {
+            capacity <<= 1;
+        }
+
+        keys.assign(capacity, ObjVertexKey{ -1, -1, -1 });
+        values.assign(capacity, 0);
+        hashes.assign(capacity, 0);
+        count = 0;
+    }
+
+    void grow()
+    {
+        std::vector<ObjVertexKey> oldKeys;
+        std::vector<unsigned int> oldValues;
+        std::vector<uint32_t> oldHashes;
+
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        oldHashes.swap(hashes);
+
+        reserve(oldKeys.size());
+
+        for (size_t i = 0; i < oldKeys.size(); ++i)
+        {
+            if (oldKeys[i].position >= 0)
+            {
+                place(oldKeys[i], oldHashes[i], oldValues[i]);
+            }
+        }
+    }
+
+    void place(const ObjVertexKey& key, uint32_t hash, unsigned int value)
+    {
+        const size_t mask = keys.size() - 1;
+        size_t slot = hash & mask;
+
+        while (keys[slot].position >= 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        keys[slot] = key;
+        values[slot] = value;
+        hashes[slot] = hash;
+        ++count;
+    }
+
+    unsigned int findOrInsert(const ObjVertexKey& key, uint32_t hash, std::vector<ObjVertexKey>& uniqueKeys)
+    {
+        if ((count + 1) * 2 > keys.size())
+        {
+            grow();
+        }
+
+        const size_t mask = keys.size() - 1;
+        size_t slot = hash & mask;
+
+        while (keys[slot].position >= 0)
+        {
+            if (hashes[slot] == hash && keys[slot] == key)
+            {
+                return values[slot];
+            }
+
+            slot = (slot + 1) & mask;
+        }
+
+        const unsigned int value = static_cast<unsigned int>(uniqueKeys.size());
+
+        keys[slot] = key;
+        values[slot] = value;
+        hashes[slot] = hash;
+        ++count;
+
+        uniqueKeys.push_back(key);
+
+        return value;
+    }
+};
+
+int resolveObjIndex(const ObjCorner& corner, int component, size_t chunkBase, size_t count) noexcept
+{
+    const int index = corner.index[component];
+
+    if (index == missingObjIndex)
+    {
+        return -1;
+    }
+
+    const long long resolved = (corner.relativeMask & (1u << component)) ?
+        static_cast<long long>(chunkBase) + index :
+        static_cast<long long>(index);
+
+    // Out of range indices are reported through INT_MIN.
+    return (resolved >= 0 && resolved < static_cast<long long>(count)) ? static_cast<int>(resolved) : missingObjIndex;
+}
+
+// Minimal JSON DOM, nodes reference each other by index into a flat array.
+enum class JsonType : unsigned char
+{
+    Null,
+    Boolean,
+    Number,
+    String,
+    Array,
+    Object,
+};
+
+constexpr unsigned int noJsonNode = UINT_MAX;
+
+struct JsonNode
+{
+    JsonType type{};
+
+    // Member name when the node is a value inside an object.
+    std::string_view key;
+
+    // String contents without quotes, escapes are kept as written.
+    std::string_view text;
+
+    double number{};
+
+    unsigned int firstChild{ noJsonNode };
+    unsigned int nextSibling{ noJsonNode };
+};
+
+struct JsonParser
+{
+    const char* p{};
+    const char* end{};
+
+    std::vector<JsonNode> nodes;
+
+    unsigned int depth{};
+    bool failed{};
+};
+
+void skipJsonSpaces(JsonParser& parser) noexcept
+{
+    while (parser.p < parser.end && (*parser.p == ' ' || *parser.p == '\t' || *parser.p == '\r' || *parser.p == '\n'))
+    {
+        ++parser.p;
+    }
+}
+
+bool parseJsonString(JsonParser& parser, std::string_view& result) noexcept
+{
+    if (parser.p >= parser.end || *parser.p != '"')
+    {
+        return false;
+    }
+
+    const char* start = ++parser.p;
+
+    while (parser.p < parser.end && *parser.p != '"')
+    {
+        parser.p += (*parser.p == '\\') ? 2 : 1;
+    }
+
+    if (parser.p >= parser.end)
+    {
+        return false;
+    }
+
+    result = std::string_view(start, static_cast<size_t>(parser.p - start));
+    ++parser.p;
+
+    return true;
+}
+
+unsigned int parseJsonValue(JsonParser& parser) noexcept
+{
+    constexpr unsigned int maxJsonDepth = 128;
+
+    skipJsonSpaces(parser);
+
+    if (parser.failed || parser.p >= parser.end || parser.depth > maxJsonDepth)
+    {
+        parser.failed = true;
+        return noJsonNode;
+    }
+
+    const unsigned int nodeIndex = static_cast<unsigned int>(parser.nodes.size());
+    parser.nodes.emplace_back();
+
+    const char c = *parser.p;
+
+    if (c == '{' || c == '[')
+    {
+        const bool isObject = c == '{';
+        const char closing = isObject ? '}' : ']';
+
+        parser.nodes[nodeIndex].type = isObject ? JsonType::Object : JsonType::Array;
+        ++parser.p;
+        ++parser.depth;
+
+        unsigned int lastChild = noJsonNode;
+
+        skipJsonSpaces(parser);
+
+        if (parser.p < parser.end && *parser.p == closing)
+        {
+            ++parser.p;
+            --parser.depth;
+            return nodeIndex;
+        }
+
+        for (;;)
+        {
+            std::string_view key;
+
+            if (isObject)
+            {
+                skipJsonSpaces(parser);
+
+                if (!parseJsonString(parser, key))
+                {
+                    parser.failed = true;
+                    return noJsonNode;
+                }
+
+                skipJsonSpaces(parser);
+
+                if (parser.p >= parser.end || *parser.p != ':')
+                {
+                    parser.failed = true;
+                    return noJsonNode;
+                }
+
+                ++parser.p;
+            }
+
+            const unsigned int child = parseJsonValue(parser);
+
+            if (child == noJsonNode)
+            {
+                parser.failed = true;
+                return noJsonNode;
+            }
+
+            parser.nodes[child].key = key;
+
+            if (lastChild == noJsonNode)
+            {
+                parser.nodes[nodeIndex].firstChild = child;
+            }
+            else
+            {
+                parser.nodes[lastChild].nextSibling = child;
+            }
+
+            lastChild = child;
+
+            skipJsonSpaces(parser);
+
+            if (parser.p < parser.end && *parser.p == ',')
+            {
+                ++parser.p;
+                continue;
+            }
+
+            if (parser.p < parser.end && *parser.p == closing)
+            {
+                ++parser.p;
+                break;
+            }
+
+            parser.failed = true;
+            return noJsonNode;
+        }
+
+        --parser.depth;
+    }
+    else if (c == '"')
+    {
+        parser.nodes[nodeIndex].type = JsonType::String;
+
+        std::string_view text;
+        if (!parseJsonString(parser, text))
+        {
+            parser.failed = true;
+            return noJsonNode;
+        }
+
+        parser.nodes[nodeIndex].text = text;
+    }
+    else if (c == 't' || c == 'f' || c == 'n')
+    {
+        const std::string_view rest(parser.p, static_cast<size_t>(parser.end - parser.p));
+
+        if (rest.substr(0, 4) == "true")
+        {
+            parser.nodes[nodeIndex].type = JsonType::Boolean;
+            parser.nodes[nodeIndex].number = 1.0;
+            parser.p += 4;
+        }
+        else if (rest.substr(0, 5) == "false")
+        {
+            parser.nodes[nodeIndex].type = JsonType::Boolean;
+            parser.p += 5;
+        }
+        else if (rest.substr(0, 4) == "null")
+        {
+            parser.p += 4;
+        }
+        else
+        {
+            parser.failed = true;
+            return noJsonNode;
+        }
+    }
+    else
+    {
+        double value = 0.0;
+        const char* next = parseNumber(parser.p, parser.end, value);
+
+        if (next == parser.p)
+        {
+            parser.failed = true;
+            return noJsonNode;
+        }
+
+        parser.nodes[nodeIndex].type = JsonType::Number;
+        parser.nodes[nodeIndex].number = value;
+        parser.p = next;
+    }
+
+    return nodeIndex;
+}
+
+unsigned int getJsonMember(const std::vector<JsonNode>& nodes, unsigned int object, std::string_view key) noexcept
+{
+    if (object == noJsonNode || nodes[object].type != JsonType::Object)
+    {
+        return noJsonNode;
+    }
+
+    for (unsigned int child = nodes[object].firstChild; child != noJsonNode; child = nodes[child].nextSibling)
+    {
+        if (nodes[child].key == key)
+        {
+            return child;
+        }
+    }
+
+    return noJsonNode;
+}
+
+unsigned int getJsonElement(const std::vector<JsonNode>& nodes, unsigned int array, size_t index) noexcept
+{
+    if (array == noJsonNode || nodes[array].type != JsonType::Array)
+    {
+        return noJsonNode;
+    }
+
+    unsigned int child = nodes[array].firstChild;
+
+    for (size_t i = 0; i < index && child != noJsonNode; ++i)
+    {
+        child = nodes[child].nextSibling;
+    }
+
+    return child;
+}
+
+// Missing members give the fallback. Negative, fractional and out of range numbers give SIZE_MAX, so range checks reject them.
+size_t getJsonSize(const std::vector<JsonNode>& nodes, unsigned int node, size_t fallback) noexcept
+{
+    if (node == noJsonNode || nodes[node].type != JsonType::Number)
+    {
+        return fallback;
+    }
+
+    const double number = nodes[node].number;
+
+    // Also false for NaN, 2^53 keeps every accepted value exact and within size_t.
+    if (!(number >= 0.0 && number < 9007199254740992.0) || number != static_cast<double>(static_cast<uint64_t>(number)) ||
+        static_cast<uint64_t>(number) > SIZE_MAX)
+    {
+        return SIZE_MAX;
+    }
+
+    return static_cast<size_t>(number);
+}
+
+bool decodeBase64(std::string_view text, std::vector<unsigned char>& result) noexcept
+{
+    const auto decodeCharacter = [](char c) -> int
+    {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+
+    result.clear();
+    result.reserve(text.size() / 4 * 3);
+
+    unsigned int bits = 0;
+    int bitCount = 0;
+
+    for (const char c : text)
+    {
+        if (c == '=')
+        {
+            break;
+        }
+
+        const int value = decodeCharacter(c);
+
+        if (value < 0)
+        {
+            return false;
+        }
+
+        bits = (bits << 6) | static_cast<unsigned int>(value);
+        bitCount += 6;
+
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            result.push_back(static_cast<unsigned char>((bits >> bitCount) & 0xff));
+        }
+    }
+
+    return true;
+}
+
+constexpr unsigned int gltfByte = 5120;
+constexpr unsigned int gltfUnsignedByte = 5121;
+constexpr unsigned int gltfShort = 5122;
+constexpr unsigned int gltfUnsignedShort = 5123;
+constexpr unsigned int gltfUnsignedInt = 5125;
+constexpr unsigned int gltfFloat = 5126;
+
+constexpr unsigned int gltfTriangles = 4;
+
+struct GltfBuffer
+{
+    const unsigned char* data{};
+    size_t size{};
+};
+
+// Strided view of an accessor inside its buffer.
+struct GltfAccessor
+{
+    const unsigned char* data{};
+    size_t count{};
+    size_t stride{};
+
+    unsigned int componentType{};
+    unsigned int componentCount{};
+    bool normalized{};
+};
+
+struct GltfPrimitive
+{
+    GltfAccessor positions;
+    GltfAccessor normals;
+    GltfAccessor uvs;
+    GltfAccessor indices;
+
+    size_t vertexBase{};
+    size_t indexBase{};
+    size_t indexCount{};
+};
+
+size_t getGltfComponentSize(unsigned int componentType) noexcept
+{
+    switch (componentType)
+    {
+    case gltfByte:
+    case gltfUnsignedByte:
+        return 1;
+    case gltfShort:
+    case gltfUnsignedShort:
+        return 2;
+    case gltfUnsignedInt:
+    case gltfFloat:
+        return 4;
+    }
+
+    return 0;
+}
+
+unsigned int getGltfComponentCount(std::string_view type) noexcept
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+
+    return 0;
+}
+
+bool getGltfAccessor(const std::vector<JsonNode>& nodes, unsigned int root, const std::vector<GltfBuffer>& buffers, size_t accessorIndex, GltfAccessor& result) noexcept
+{
+    const unsigned int accessor = getJsonElement(nodes, getJsonMember(nodes, root, "accessors"), accessorIndex);
+    const unsigned int typeNode = getJsonMember(nodes, accessor, "type");
+
+    if (accessor == noJsonNode || typeNode == noJsonNode)
+    {
+        return false;
+    }
+
+    // Sparse accessors and accessors without a buffer view are not supported.
+    const size_t bufferViewIndex = getJsonSize(nodes, getJsonMember(nodes, accessor, "bufferView"), SIZE_MAX);
+    const unsigned int bufferView = getJsonElement(nodes, getJsonMember(nodes, root, "bufferViews"), bufferViewIndex);
+
+    if (bufferView == noJsonNode || getJsonMember(nodes, accessor, "sparse") != noJsonNode)
+    {
+        return false;
+    }
+
+    const size_t bufferIndex = getJsonSize(nodes, getJsonMember(nodes, bufferView, "buffer"), SIZE_MAX);
+
+    if (bufferIndex >= buffers.size())
+    {
+        return false;
+    }
+
+    result.componentType = static_cast<unsigned int>(getJsonSize(nodes, getJsonMember(nodes, accessor, "componentType"), 0));
+    result.componentCount = getGltfComponentCount(nodes[typeNode].text);
+    result.count = getJsonSize(nodes, getJsonMember(nodes, accessor, "count"), 0);
+
+    const unsigned int normalized = getJsonMember(nodes, accessor, "normalized");
+    result.normalized = normalized != noJsonNode && nodes[normalized].number != 0.0;
+
+    const size_t componentSize = getGltfComponentSize(result.componentType);
+    const size_t elementSize = componentSize * result.componentCount;
+
+    if (elementSize == 0)
+    {
+        return false;
+    }
+
+    const size_t viewOffset = getJsonSize(nodes, getJsonMember(nodes, bufferView, "byteOffset"), 0);
+    const size_t viewLength = getJsonSize(nodes, getJsonMember(nodes, bufferView, "byteLength"), 0);
+    const size_t accessorOffset = getJsonSize(nodes, getJsonMember(nodes, accessor, "byteOffset"), 0);
+
+    result.stride = getJsonSize(nodes, getJsonMember(nodes, bufferView, "byteStride"), elementSize);
+
+    const GltfBuffer& buffer = buffers[bufferIndex];
+
+    // Validate the whole accessor range against the view and the buffer.
+    if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset || result.stride < elementSize)
+    {
+        return false;
+    }
+
+    // Compared by division, the end of the last element could wrap around.
+    if (result.count > 0 && (accessorOffset > viewLength || elementSize > viewLength - accessorOffset ||
+        result.count - 1 > (viewLength - accessorOffset - elementSize) / result.stride))
+    {
+        return false;
+    }
+
+    result.data = buffer.data + viewOffset + accessorOffset;
+
+    return true;
+}
+
+float readGltfComponent(const unsigned char* p, unsigned int componentType, bool normalized) noexcept
+{
+    switch (componentType)
+    {
+    case gltfFloat:
+    {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    case gltfUnsignedByte:
+        return normalized ? static_cast<float>(*p) / 255.0f : static_cast<float>(*p);
+    case gltfByte:
+    {
+        const float value = static_cast<float>(static_cast<signed char>(*p));
+        return normalized ? (value / 127.0f < -1.0f ? -1.0f : value / 127.0f) : value;
+    }
+    case gltfUnsignedShort:
+    {
+        unsigned short value;
+        memcpy(&value, p, sizeof(value));
+        return normalized ? static_cast<float>(value) / 65535.0f : static_cast<float>(value);
+    }
+    case gltfShort:
+    {
+        short value;
+        memcpy(&value, p, sizeof(value));
+        const float result = static_cast<float>(value);
+        return normalized ? (result / 32767.0f < -1.0f ? -1.0f : result / 32767.0f) : result;
+    }
+    }
+
+    return 0.0f;
+}
+
+unsigned int readGltfIndex(const unsigned char* p, unsigned int componentType) noexcept
+{
+    switch (componentType)
+    {
+    case gltfUnsignedByte:
+        return *p;
+    case gltfUnsignedShort:
+    {
+        unsigned short value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    case gltfUnsignedInt:
+    {
+        unsigned int value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    }
+
+    return 0;
+}
+
+void readGltfElement(const GltfAccessor& accessor, size_t index, float* result, unsigned int componentCount) noexcept
+{
+    const unsigned char* element = accessor.data + accessor.stride * index;
+    const size_t componentSize = getGltfComponentSize(accessor.componentType);
+
+    for (unsigned int i = 0; i < componentCount; ++i)
+    {
+        result[i] = i < accessor.componentCount ? readGltfComponent(element + i * componentSize, accessor.componentType, accessor.normalized) : 0.0f;
+    }
+}
+
+bool hasExtension(const char* path, const char* extension) noexcept
+{
+    const size_t pathLength = strlen(path);
+    const size_t extensionLength = strlen(extension);
+
+    if (pathLength < extensionLength)
+    {
+        return false;
+    }
+
+    const char* suffix = path + pathLength - extensionLength;
+
+    for (size_t i = 0; i < extensionLength; ++i)
+    {
+        const char c = (suffix[i] >= 'A' && suffix[i] <= 'Z') ? static_cast<char>(suffix[i] - 'A' + 'a') : suffix[i];
+
+        if (c != extension[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isGlbFile(const unsigned char* data, size_t size) noexcept
+{
+    return size >= 12 && memcmp(data, "glTF", 4) == 0;
+}
+
+unsigned int readLittleEndian32(const unsigned char* p) noexcept
+{
+    return static_cast<unsigned int>(p[0]) | (static_cast<unsigned int>(p[1]) << 8) |
+           (static_cast<unsigned int>(p[2]) << 16) | (static_cast<unsigned int>(p[3]) << 24);
+}
+
+}
+
+bool importObjMesh(const char* text, size_t size, MeshData& mesh, unsigned int threadCount, MeshImportStats* stats) noexcept
+{
+    assert(text);
+
+    const unsigned int importThreadCount = getImportThreadCount(threadCount);
+    const double startTime = getSeconds();
+
+    // Split the text into line aligned chunks, a few per thread to balance uneven content.
+    std::vector<ObjChunk> chunks;
+    {
+        size_t chunkSize = size / (static_cast<size_t>(importThreadCount) * 4);
+        chunkSize = chunkSize > minimumObjChunkSize ? chunkSize : minimumObjChunkSize;
+
+        const char* p = text;
+        const char* end = text + size;
+
+        while (p < end)
+        {
+            const char* chunkEnd = static_cast<size_t>(end - p) > chunkSize ? skipLine(p + chunkSize, end) : end;
+
+            ObjChunk chunk;
+            chunk.begin = p;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+
+            p = chunkEnd;
+        }
+    }
+
+    // Tokenize all chunks in parallel.
+    runParallel(chunks.size(), importThreadCount, [&](size_t i) { parseObjChunk(chunks[i]); });
+
+    size_t positionCount = 0;
+    size_t uvCount = 0;
+    size_t normalCount = 0;
+    size_t cornerCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        if (chunk.failed)
+        {
+            print("OBJ import failed: malformed face.\n");
+            return false;
+        }
+
+        chunk.positionBase = positionCount;
+        chunk.uvBase = uvCount;
+        chunk.normalBase = normalCount;
+        chunk.cornerBase = cornerCount;
+
+        positionCount += chunk.positions.size() / 3;
+        uvCount += chunk.uvs.size() / 2;
+        normalCount += chunk.normals.size() / 3;
+        cornerCount += chunk.corners.size();
+    }
+
+    if (cornerCount == 0 || positionCount > INT_MAX || uvCount > INT_MAX || normalCount > INT_MAX || cornerCount > UINT_MAX)
+    {
+        print("OBJ import failed: no faces or too many elements.\n");
+        return false;
+    }
+
+    // Gather the per-chunk attribute streams into global arrays.
+    std::vector<float> positions(positionCount * 3);
+    std::vector<float> uvs(uvCount * 2);
+    std::vector<float> normals(normalCount * 3);
+
+    runParallel(chunks.size(), importThreadCount, [&](size_t i)
+    {
+        const ObjChunk& chunk = chunks[i];
+
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.uvBase * 2);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+    });
+
+    // Resolve corners to absolute vertex keys and hash them into one partition per thread.
+    const size_t partitionCount = importThreadCount < USHRT_MAX ? importThreadCount : USHRT_MAX;
+
+    std::vector<ObjVertexKey> keys(cornerCount);
+    std::vector<uint32_t> hashes(cornerCount);
+    std::vector<unsigned short> partitions(cornerCount);
+    std::atomic<bool> invalidIndex{ false };
+
+    // Corners of each chunk in each partition, rows by chunk.
+    std::vector<size_t> chunkPartitionCounts(chunks.size() * partitionCount);
+
+    runParallel(chunks.size(), importThreadCount, [&](size_t i)
+    {
+        const ObjChunk& chunk = chunks[i];
+        size_t* partitionCounts = &chunkPartitionCounts[i * partitionCount];
+
+        for (size_t j = 0; j < chunk.corners.size(); ++j)
+        {
+            const ObjCorner& corner = chunk.corners[j];
+            const size_t cornerIndex = chunk.cornerBase + j;
+
+            ObjVertexKey key;
+            key.position = resolveObjIndex(corner, 0, chunk.positionBase, positionCount);
+            key.uv = resolveObjIndex(corner, 1, chunk.uvBase, uvCount);
+            key.normal = resolveObjIndex(corner, 2, chunk.normalBase, normalCount);
+
+            if (key.position < 0 || key.uv == missingObjIndex || key.normal == missingObjIndex)
+            {
+                invalidIndex.store(true, std::memory_order_relaxed);
+                key = { 0, -1, -1 };
+            }
+
+            const uint32_t hash = hashObjVertexKey(key);
+
+            keys[cornerIndex] = key;
+            hashes[cornerIndex] = hash;
+            const unsigned short partition = static_cast<unsigned short>((static_cast<uint64_t>(hash) * partitionCount) >> 32);
+
+            partitions[cornerIndex] = partition;
+            ++partitionCounts[partition];
+        }
+    });
+
+    if (invalidIndex.load())
+    {
+        print("OBJ import failed: face index out of range.\n");
+        return false;
+    }
+
+    // Bucket the corners by partition, in corner order within each bucket.
+    // The counts turn into each chunk's write offset in each bucket, so the chunks scatter in parallel.
+    std::vector<size_t> partitionStarts(partitionCount + 1);
+    size_t bucketedCount = 0;
+
+    for (size_t partition = 0; partition < partitionCount; ++partition)
+    {
+        partitionStarts[partition] = bucketedCount;
+
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            const size_t count = chunkPartitionCounts[i * partitionCount + partition];
+
+            chunkPartitionCounts[i * partitionCount + partition] = bucketedCount;
+            bucketedCount += count;
+        }
+    }
+
+    partitionStarts[partitionCount] = bucketedCount;
+
+    std::vector<unsigned int> bucketedCorners(cornerCount);
+
+    runParallel(chunks.size(), importThreadCount, [&](size_t i)
+    {
+        const ObjChunk& chunk = chunks[i];
+        size_t* partitionOffsets = &chunkPartitionCounts[i * partitionCount];
+
+        for (size_t j = chunk.cornerBase; j < chunk.cornerBase + chunk.corners.size(); ++j)
+        {
+            bucketedCorners[partitionOffsets[partitions[j]]++] = static_cast<unsigned int>(j);
+        }
+    });
+
+    // Deduplicate each partition independently, the result does not depend on thread timing.
+    std::vector<unsigned int> partitionIndices(cornerCount);
+    std::vector<std::vector<ObjVertexKey>> uniqueKeys(partitionCount);
+
+    runParallel(partitionCount, importThreadCount, [&](size_t partition)
+    {
+        const size_t begin = partitionStarts[partition];
+        const size_t end = partitionStarts[partition + 1];
+
+        ObjVertexTable table;
+        table.reserve((end - begin) / 2);
+
+        for (size_t k = begin; k < end; ++k)
+        {
+            const unsigned int i = bucketedCorners[k];
+
+            partitionIndices[i] = table.findOrInsert(keys[i], hashes[i], uniqueKeys[partition]);
+        }
+    });
+
+    // Unique vertices of each partition are laid out one after another.
+    std::vector<size_t> partitionBases(partitionCount);
+    size_t vertexCount = 0;
+
+    for (size_t partition = 0; partition < partitionCount; ++partition)
+    {
+        partitionBases[partition] = vertexCount;
+        vertexCount += uniqueKeys[partition].size();
+    }
+
+    mesh.vertices.resize(vertexCount);
+    mesh.indices.resize(cornerCount);
+
+    runParallel(chunks.size(), importThreadCount, [&](size_t i)
+    {
+        const ObjChunk& chunk = chunks[i];
+
+        for (size_t j = chunk.cornerBase; j < chunk.cornerBase + chunk.corners.size(); ++j)
+        {
+            mesh.indices[j] = static_cast<unsigned int>(partitionBases[partitions[j]] + partitionIndices[j]);
+        }
+    });
+
+    runParallel(partitionCount, importThreadCount, [&](size_t partition)
+    {
+        const std::vector<ObjVertexKey>& partitionKeys = uniqueKeys[partition];
+
+        for (size_t j = 0; j < partitionKeys.size(); ++j)
+        {
+            const ObjVertexKey& key = partitionKeys[j];
+            MeshVertex& vertex = mesh.vertices[partitionBases[partition] + j];
+
+            vertex = {};
+
+            memcpy(vertex.position, &positions[static_cast<size_t>(key.position) * 3], sizeof(vertex.position));
+
+            if (key.normal >= 0)
+            {
+                memcpy(vertex.normal, &normals[static_cast<size_t>(key.normal) * 3], sizeof(vertex.normal));
+            }
+
+            if (key.uv >= 0)
+            {
+                memcpy(vertex.uv, &uvs[static_cast<size_t>(key.uv) * 2], sizeof(vertex.uv));
+            }
+        }
+    });
+
+    fillImportStats(stats, size, chunks.size(), importThreadCount, getSeconds() - startTime);
+
+    return true;
+}
+
+bool importGltfMesh(const char* path, const unsigned char* data, size_t size, MeshData& mesh, unsigned int threadCount, MeshImportStats* stats) noexcept
+{
+    assert(path && data);
+
+    const unsigned int importThreadCount = getImportThreadCount(threadCount);
+    const double startTime = getSeconds();
+
+    const char* jsonBegin = reinterpret_cast<const char*>(data);
+    const char* jsonEnd = jsonBegin + size;
+
+    GltfBuffer glbBinaryChunk{};
+
+    // Binary glTF: 12 byte header followed by a JSON chunk and an optional BIN chunk.
+    if (isGlbFile(data, size))
+    {
+        constexpr unsigned int glbJsonChunk = 0x4E4F534A;
+        constexpr unsigned int glbBinaryChunkType = 0x004E4942;
+
+        size_t offset = 12;
+        jsonBegin = jsonEnd = nullptr;
+
+        while (offset + 8 <= size)
+        {
+            const size_t chunkLength = readLittleEndian32(data + offset);
+            const unsigned int chunkType = readLittleEndian32(data + offset + 4);
+
+            offset += 8;
+
+            if (chunkLength > size - offset)
+            {
+                break;
+            }
+
+            if (chunkType == glbJsonChunk && !jsonBegin)
+            {
+                jsonBegin = reinterpret_cast<const char*>(data + offset);
+                jsonEnd = jsonBegin + chunkLength;
+            }
+            else if (chunkType == glbBinaryChunkType && !glbBinaryChunk.data)
+            {
+                glbBinaryChunk.data = data + offset;
+                glbBinaryChunk.size = chunkLength;
+            }
+
+            // Chunks are 4 byte aligned.
+            offset += (chunkLength + 3) & ~size_t(3);
+        }
+
+        if (!jsonBegin)
+        {
+            print("glTF import failed: missing JSON chunk.\n");
+            return false;
+        }
+    }
+
+    JsonParser parser;
+    parser.p = jsonBegin;
+    parser.end = jsonEnd;
+    parser.nodes.reserve(static_cast<size_t>(jsonEnd - jsonBegin) / 8);
+
+    const unsigned int root = parseJsonValue(parser);
+
+    if (parser.failed || root == noJsonNode || parser.nodes[root].type != JsonType::Object)
+    {
+        print("glTF import failed: invalid JSON.\n");
+        return false;
+    }
+
+    const std::vector<JsonNode>& nodes = parser.nodes;
+
+    // Resolve buffers: the GLB binary chunk, embedded base64 data or files next to the asset.
+    std::vector<GltfBuffer> buffers;
+    std::vector<std::vector<unsigned char>> decodedBuffers;
+    std::vector<MappedFile> mappedBuffers;
+
+    size_t bytesRead = size;
+    bool buffersValid = true;
+
+    const unsigned int buffersNode = getJsonMember(nodes, root, "buffers");
+
+    for (unsigned int buffer = buffersNode != noJsonNode ? nodes[buffersNode].firstChild : noJsonNode; buffer != noJsonNode; buffer = nodes[buffer].nextSibling)
+    {
+        const unsigned int uri = getJsonMember(nodes, buffer, "uri");
+
+        if (uri == noJsonNode)
+        {
+            buffers.push_back(glbBinaryChunk);
+            continue;
+        }
+
+        const std::string_view uriText = nodes[uri].text;
+
+        if (uriText.substr(0, 5) == "data:")
+        {
+            const size_t comma = uriText.find(',');
+
+            decodedBuffers.emplace_back();
+
+            if (comma == std::string_view::npos || uriText.find(";base64") > comma || !decodeBase64(uriText.substr(comma + 1), decodedBuffers.back()))
+            {
+                buffersValid = false;
+                break;
+            }
+
+            buffers.push_back({ decodedBuffers.back().data(), decodedBuffers.back().size() });
+            continue;
+        }
+
+        const char* separator = strrchr(path, '\\');
+        const char* forwardSeparator = strrchr(path, '/');
+
+        if (!separator || (forwardSeparator && forwardSeparator > separator))
+        {
+            separator = forwardSeparator;
+        }
+
+        std::string bufferPath = separator ? std::string(path, static_cast<size_t>(separator - path + 1)) : std::string();
+        bufferPath.append(uriText.data(), uriText.size());
+
+        MappedFile bufferFile = mapFileForReading(bufferPath.c_str());
+
+        if (!bufferFile.data)
+        {
+            print("glTF import failed: cannot open buffer %s.\n", bufferPath.c_str());
+            buffersValid = false;
+            break;
+        }
+
+        bytesRead += bufferFile.size;
+
+        mappedBuffers.push_back(bufferFile);
+        buffers.push_back({ bufferFile.data, bufferFile.size });
+    }
+
+    // Gather triangle primitives of all meshes. Node transforms are not applied, primitives are merged in mesh space.
+    std::vector<GltfPrimitive> primitives;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+
+    const unsigned int meshesNode = getJsonMember(nodes, root, "meshes");
+
+    for (unsigned int meshNode = meshesNode != noJsonNode ? nodes[meshesNode].firstChild : noJsonNode; buffersValid && meshNode != noJsonNode; meshNode = nodes[meshNode].nextSibling)
+    {
+        const unsigned int primitivesNode = getJsonMember(nodes, meshNode, "primitives");
+
+        for (unsigned int primitiveNode = primitivesNode != noJsonNode ? nodes[primitivesNode].firstChild : noJsonNode; primitiveNode != noJsonNode; primitiveNode = nodes[primitiveNode].nextSibling)
+        {
+            if (getJsonSize(nodes, getJsonMember(nodes, primitiveNode, "mode"), gltfTriangles) != gltfTriangles)
+            {
+                continue;
+            }
+
+            const unsigned int attributes = getJsonMember(nodes, primitiveNode, "attributes");
+
+            GltfPrimitive primitive;
+
+            if (!getGltfAccessor(nodes, root, buffers, getJsonSize(nodes, getJsonMember(nodes, attributes, "POSITION"), SIZE_MAX), primitive.positions) ||
+                primitive.positions.componentCount != 3)
+            {
+                buffersValid = false;
+                break;
+            }
+
+            const unsigned int normalAccessor = getJsonMember(nodes, attributes, "NORMAL");
+            const unsigned int uvAccessor = getJsonMember(nodes, attributes, "TEXCOORD_0");
+            const unsigned int indexAccessor = getJsonMember(nodes, primitiveNode, "indices");
+
+            if ((normalAccessor != noJsonNode && !getGltfAccessor(nodes, root, buffers, getJsonSize(nodes, normalAccessor, SIZE_MAX), primitive.normals)) ||
+                (uvAccessor != noJsonNode && !getGltfAccessor(nodes, root, buffers, getJsonSize(nodes, uvAccessor, SIZE_MAX), primitive.uvs)) ||
+                (indexAccessor != noJsonNode && !getGltfAccessor(nodes, root, buffers, getJsonSize(nodes, indexAccessor, SIZE_MAX), primitive.indices)))
+            {
+                buffersValid = false;
+                break;
+            }
+
+            if ((primitive.normals.data && primitive.normals.count < primitive.positions.count) ||
+                (primitive.uvs.data && primitive.uvs.count < primitive.positions.count))
+            {
+                buffersValid = false;
+                break;
+            }
+
+            primitive.vertexBase = vertexCount;
+            primitive.indexBase = indexCount;
+            primitive.indexCount = primitive.indices.data ? primitive.indices.count : primitive.positions.count;
+            primitive.indexCount -= primitive.indexCount % 3;
+
+            vertexCount += primitive.positions.count;
+            indexCount += primitive.indexCount;
+
+            primitives.push_back(primitive);
+        }
+    }
+
+    bool imported = buffersValid && indexCount > 0 && vertexCount <= UINT_MAX;
+
+    size_t blockCount = 0;
+
+    if (imported)
+    {
+        // Split every primitive into fixed size vertex and index blocks and decode them in parallel.
+        struct GltfBlock
+        {
+            size_t primitive;
+            size_t begin;
+            size_t end;
+            bool indices;
+        };
+
+        std::vector<GltfBlock> blocks;
+
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            for (size_t begin = 0; begin < primitives[i].positions.count; begin += gltfBlockSize)
+            {
+                const size_t end = begin + gltfBlockSize < primitives[i].positions.count ? begin + gltfBlockSize : primitives[i].positions.count;
+                blocks.push_back({ i, begin, end, false });
+            }
+
+            for (size_t begin = 0; begin < primitives[i].indexCount; begin += gltfBlockSize)
+            {
+                const size_t end = begin + gltfBlockSize < primitives[i].indexCount ? begin + gltfBlockSize : primitives[i].indexCount;
+                blocks.push_back({ i, begin, end, true });
+            }
+        }
+
+        mesh.vertices.resize(vertexCount);
+        mesh.indices.resize(indexCount);
+
+        std::atomic<bool> invalidIndex{ false };
+
+        runParallel(blocks.size(), importThreadCount, [&](size_t i)
+        {
+            const GltfBlock& block = blocks[i];
+            const GltfPrimitive& primitive = primitives[block.primitive];
+
+            if (block.indices)
+            {
+                for (size_t j = block.begin; j < block.end; ++j)
+                {
+                    const unsigned int index = primitive.indices.data ?
+                        readGltfIndex(primitive.indices.data + primitive.indices.stride * j, primitive.indices.componentType) :
+                        static_cast<unsigned int>(j);
+
+                    if (index >= primitive.positions.count)
+                    {
+                        invalidIndex.store(true, std::memory_order_relaxed);
+                    }
+
+                    mesh.indices[primitive.indexBase + j] = static_cast<unsigned int>(primitive.vertexBase + index);
+                }
+
+                return;
+            }
+
+            for (size_t j = block.begin; j < block.end; ++j)
+            {
+                MeshVertex& vertex = mesh.vertices[primitive.vertexBase + j];
+
+                readGltfElement(primitive.positions, j, vertex.position, 3);
+
+                if (primitive.normals.data)
+                {
+                    readGltfElement(primitive.normals, j, vertex.normal, 3);
+                }
+                else
+                {
+                    vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+                }
+
+                if (primitive.uvs.data)
+                {
+                    readGltfElement(primitive.uvs, j, vertex.uv, 2);
+
+                    // glTF has the UV origin at the top-left.
+                    vertex.uv[1] = 1.0f - vertex.uv[1];
+                }
+                else
+                {
+                    vertex.uv[0] = vertex.uv[1] = 0.0f;
+                }
+            }
+        });
+
+        blockCount = blocks.size();
+        imported = !invalidIndex.load();
+    }
+
+    for (MappedFile& bufferFile : mappedBuffers)
+    {
+        unmapFile(bufferFile);
+    }
+
+    if (!imported)
+    {
+        print("glTF import failed: invalid or unsupported buffers, accessors or primitives.\n");
+        return false;
+    }
+
+    fillImportStats(stats, bytesRead, blockCount, importThreadCount, getSeconds() - startTime);
+
+    return true;
+}
+
+bool importMesh(const char* path, MeshData& mesh, unsigned int threadCount, MeshImportStats* stats) noexcept
+{
+    assert(path);
+
+    MappedFile file = mapFileForReading(path);
+
+    if (!file.data)
+    {
+        print("Cannot open mesh file: %s\n", path);
+        return false;
+    }
+
+    mesh = {};
+
+    MeshImportStats importStats{};
+    bool imported = false;
+
+    if (isGlbFile(file.data, file.size) || hasExtension(path, ".gltf"))
+    {
+        imported = importGltfMesh(path, file.data, file.size, mesh, threadCount, &importStats);
+    }
+    else
+    {
+        imported = importObjMesh(reinterpret_cast<const char*>(file.data), file.size, mesh, threadCount, &importStats);
+    }
+
+    unmapFile(file);
+
+    if (imported)
+    {
+        print("Imported %s: %zu vertices, %zu triangles, %.1f MB in %.3f s (%.1f MB/s, %u threads)\n",
+            path, mesh.vertices.size(), mesh.indices.size() / 3,
+            static_cast<double>(importStats.bytesRead) / (1024.0 * 1024.0), importStats.seconds,
+            importStats.megabytesPerSecond, importStats.threadCount);
+    }
+
+    if (stats)
+    {
+        *stats = importStats;
+    }
+
+    return imported;
+}
+
+void fitMeshToUnitCube(MeshData& mesh) noexcept
+{
+    if (mesh.vertices.empty())
+    {
+        return;
+    }
+
+    float boundsMin[3];
+    float boundsMax[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        boundsMin[axis] = boundsMax[axis] = mesh.vertices[0].position[axis];
+    }
+
+    for (const MeshVertex& vertex : mesh.vertices)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            boundsMin[axis] = vertex.position[axis] < boundsMin[axis] ? vertex.position[axis] : boundsMin[axis];
+            boundsMax[axis] = vertex.position[axis] > boundsMax[axis] ? vertex.position[axis] : boundsMax[axis];
+        }
+    }
+
+    float extent = 0.0f;
+    float center[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis] = 0.5f * (boundsMin[axis] + boundsMax[axis]);
+        extent = (boundsMax[axis] - boundsMin[axis]) > extent ? (boundsMax[axis] - boundsMin[axis]) : extent;
+    }
+
+    const float scale = extent > 0.0f ? 2.0f / extent : 1.0f;
+
+    for (MeshVertex& vertex : mesh.vertices)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            vertex.position[axis] = (vertex.position[axis] - center[axis]) * scale;
+        }
+    }
+}
+
+void benchmarkMeshImport(const char* path, unsigned int iterations) noexcept
+{
+    assert(path && iterations > 0);
+
+    const unsigned int maxThreadCount = getImportThreadCount(0);
+
+    for (unsigned int threadCount = 1;; threadCount *= 2)
+    {
+        threadCount = threadCount < maxThreadCount ? threadCount : maxThreadCount;
+
+        double bestMegabytesPerSecond = 0.0;
+        double totalSeconds = 0.0;
+        size_t bytesRead = 0;
+
+        for (unsigned int i = 0; i < iterations; ++i)
+        {
+            MeshData mesh;
+            MeshImportStats stats;
+
+            if (!importMesh(path, mesh, threadCount, &stats))
+            {
+                return;
+            }
+
+            bytesRead = stats.bytesRead;
+            totalSeconds += stats.seconds;
+            bestMegabytesPerSecond = stats.megabytesPerSecond > bestMegabytesPerSecond ? stats.megabytesPerSecond : bestMegabytesPerSecond;
+        }
+
+        const double averageMegabytesPerSecond = (static_cast<double>(bytesRead) * iterations / (1024.0 * 1024.0)) / totalSeconds;
+
+        print("Mesh import benchmark: %2u threads, best %8.1f MB/s, average %8.1f MB/s\n", threadCount, bestMegabytesPerSecond, averageMegabytesPerSecond);
+
+        if (threadCount == maxThreadCount)
+        {
+            break;
+        }
+    }
+}
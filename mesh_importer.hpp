@@ -0,0 +1,46 @@
+#ifndef KZ_MESH_IMPORTER_HPP
+#define KZ_MESH_IMPORTER_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Interleaved vertex layout shared by every imported mesh.
+struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+// Indexed triangle list ready for upload into a VAO.
+struct MeshData
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+struct MeshImportStats
+{
+    size_t bytesRead{};
+    size_t chunkCount{};
+    unsigned int threadCount{};
+
+    double seconds{};
+    double megabytesPerSecond{};
+};
+
+// Imports an OBJ, glTF 2.0 (.gltf) or binary glTF (.glb) file.
+// Passing zero threads uses all hardware threads.
+bool importMesh(const char* path, MeshData& mesh, unsigned int threadCount = 0, MeshImportStats* stats = nullptr) noexcept;
+
+bool importObjMesh(const char* text, size_t size, MeshData& mesh, unsigned int threadCount, MeshImportStats* stats = nullptr) noexcept;
+
+bool importGltfMesh(const char* path, const unsigned char* data, size_t size, MeshData& mesh, unsigned int threadCount, MeshImportStats* stats = nullptr) noexcept;
+
+// Scales and centers the mesh into the [-1, 1] cube the cube view is set up for.
+void fitMeshToUnitCube(MeshData& mesh) noexcept;
+
+// Imports the same file with 1, 2, 4 ... N threads and prints the MB/s for each run.
+void benchmarkMeshImport(const char* path, unsigned int iterations) noexcept;
+
+#endif
@@ -0,0 +1,507 @@
+#include <mesh_optimizer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Cache size the Forsyth scoring models, larger than real hardware so the order stays good across GPUs.
+constexpr unsigned int forsythCacheSize = 32;
+constexpr unsigned int forsythMaxValence = 32;
+
+// FIFO size used for statistics and cluster boundaries.
+constexpr unsigned int fifoCacheSize = 16;
+
+constexpr unsigned int noTriangle = UINT_MAX;
+
+struct ForsythScoreTables
+{
+    float cachePosition[forsythCacheSize + 3];
+    float valence[forsythMaxValence + 1];
+};
+
+ForsythScoreTables getForsythScoreTables() noexcept
+{
+    ForsythScoreTables tables{};
+
+    for (unsigned int i = 0; i < forsythCacheSize + 3; ++i)
+    {
+        if (i < 3)
+        {
+            // The last triangle's vertices get a fixed score so the next triangle does not just reuse its edge.
+            tables.cachePosition[i] = 0.75f;
+        }
+        else if (i < forsythCacheSize)
+        {
+            const float scaler = 1.0f / static_cast<float>(forsythCacheSize - 3);
+            tables.cachePosition[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, 1.5f);
+        }
+    }
+
+    for (unsigned int i = 1; i <= forsythMaxValence; ++i)
+    {
+        // Boost vertices with few triangles left so they are finished off.
+        tables.valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+    }
+
+    return tables;
+}
+
+float getForsythVertexScore(const ForsythScoreTables& tables, int cachePosition, unsigned int remainingValence) noexcept
+{
+    if (remainingValence == 0)
+    {
+        return -1.0f;
+    }
+
+    const float cacheScore = cachePosition >= 0 ? tables.cachePosition[cachePosition] : 0.0f;
+    const float valenceScore = tables.valence[remainingValence < forsythMaxValence ? remainingValence : forsythMaxValence];
+
+    return cacheScore + valenceScore;
+}
+
+void getTriangleNormal(const std::vector<MeshVertex>& vertices, const unsigned int* triangle, float normal[3]) noexcept
+{
+    const float* a = vertices[triangle[0]].position;
+    const float* b = vertices[triangle[1]].position;
+    const float* c = vertices[triangle[2]].position;
+
+    const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+    // Not normalized, the length is twice the triangle area.
+    normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) noexcept
+{
+    assert(indices.size() % 3 == 0);
+    assert(cacheSize > 0);
+
+    VertexCacheStats result{};
+
+    if (indices.empty())
+    {
+        return result;
+    }
+
+    // A vertex is in the FIFO if fewer than cacheSize misses happened since it was last loaded.
+    std::vector<size_t> loadTimestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+
+    size_t timestamp = static_cast<size_t>(cacheSize) + 1;
+    size_t misses = 0;
+    size_t uniqueCount = 0;
+
+    for (const unsigned int index : indices)
+    {
+        assert(index < vertexCount);
+
+        if (timestamp - loadTimestamps[index] > cacheSize)
+        {
+            loadTimestamps[index] = timestamp++;
+            ++misses;
+        }
+
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            ++uniqueCount;
+        }
+    }
+
+    result.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    result.atvr = static_cast<float>(misses) / static_cast<float>(uniqueCount);
+
+    return result;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) noexcept
+{
+    assert(indices.size() % 3 == 0);
+
+    const size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    const ForsythScoreTables tables = getForsythScoreTables();
+
+    // Vertex to triangle adjacency, remaining triangles of each vertex are kept at the front of its list.
+    std::vector<unsigned int> valences(vertexCount, 0);
+
+    for (const unsigned int index : indices)
+    {
+        assert(index < vertexCount);
+        ++valences[index];
+    }
+
+    std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valences[i];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> remainingValences(vertexCount, 0);
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            const unsigned int vertex = indices[triangle * 3 + corner];
+            adjacency[adjacencyOffsets[vertex] + remainingValences[vertex]++] = static_cast<unsigned int>(triangle);
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    std::vector<float> triangleScores(triangleCount, 0.0f);
+    std::vector<bool> emitted(triangleCount, false);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        vertexScores[vertex] = getForsythVertexScore(tables, -1, remainingValences[vertex]);
+    }
+
+    unsigned int bestTriangle = 0;
+    float bestScore = -1.0f;
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const unsigned int* corners = &indices[triangle * 3];
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+
+        if (triangleScores[triangle] > bestScore)
+        {
+            bestScore = triangleScores[triangle];
+            bestTriangle = static_cast<unsigned int>(triangle);
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    unsigned int cache[forsythCacheSize + 3];
+    unsigned int cacheCount = 0;
+
+    // Fallback scan position when the cache has no candidates left.
+    size_t nextUnemitted = 0;
+
+    while (result.size() < indices.size())
+    {
+        if (bestTriangle == noTriangle)
+        {
+            while (emitted[nextUnemitted])
+            {
+                ++nextUnemitted;
+            }
+
+            bestTriangle = static_cast<unsigned int>(nextUnemitted);
+        }
+
+        const unsigned int* corners = &indices[static_cast<size_t>(bestTriangle) * 3];
+
+        result.insert(result.end(), corners, corners + 3);
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from the remaining adjacency of its vertices.
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            const unsigned int vertex = corners[corner];
+            unsigned int* triangles = &adjacency[adjacencyOffsets[vertex]];
+
+            for (unsigned int i = 0; i < remainingValences[vertex]; ++i)
+            {
+                if (triangles[i] == bestTriangle)
+                {
+                    triangles[i] = triangles[remainingValences[vertex] - 1];
+                    --remainingValences[vertex];
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache.
+        unsigned int newCache[forsythCacheSize + 3];
+        unsigned int newCacheCount = 0;
+
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            newCache[newCacheCount++] = corners[corner];
+        }
+
+        for (unsigned int i = 0; i < cacheCount; ++i)
+        {
+            const unsigned int vertex = cache[i];
+
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        // Vertices pushed out of the cache lose their cache score.
+        for (unsigned int i = forsythCacheSize; i < newCacheCount; ++i)
+        {
+            cachePositions[newCache[i]] = -1;
+        }
+
+        newCacheCount = newCacheCount < forsythCacheSize ? newCacheCount : forsythCacheSize;
+
+        for (unsigned int i = 0; i < newCacheCount; ++i)
+        {
+            cachePositions[newCache[i]] = static_cast<int>(i);
+        }
+
+        // Rescore every touched vertex and propagate the change to its remaining triangles.
+        const auto rescoreVertex = [&](unsigned int vertex)
+        {
+            const float score = getForsythVertexScore(tables, cachePositions[vertex], remainingValences[vertex]);
+            const float delta = score - vertexScores[vertex];
+
+            vertexScores[vertex] = score;
+
+            const unsigned int* triangles = &adjacency[adjacencyOffsets[vertex]];
+
+            for (unsigned int i = 0; i < remainingValences[vertex]; ++i)
+            {
+                triangleScores[triangles[i]] += delta;
+            }
+        };
+
+        for (unsigned int i = 0; i < cacheCount; ++i)
+        {
+            if (cachePositions[cache[i]] < 0)
+            {
+                rescoreVertex(cache[i]);
+            }
+        }
+
+        for (unsigned int i = 0; i < newCacheCount; ++i)
+        {
+            rescoreVertex(newCache[i]);
+        }
+
+        // Only triangles touching the cache are candidates for the next pick.
+        bestTriangle = noTriangle;
+        bestScore = -1.0f;
+
+        for (unsigned int i = 0; i < newCacheCount; ++i)
+        {
+            const unsigned int vertex = newCache[i];
+            const unsigned int* triangles = &adjacency[adjacencyOffsets[vertex]];
+
+            for (unsigned int j = 0; j < remainingValences[vertex]; ++j)
+            {
+                if (triangleScores[triangles[j]] > bestScore)
+                {
+                    bestScore = triangleScores[triangles[j]];
+                    bestTriangle = triangles[j];
+                }
+            }
+        }
+
+        std::copy(newCache, newCache + newCacheCount, cache);
+        cacheCount = newCacheCount;
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<MeshVertex>& vertices, float threshold) noexcept
+{
+    assert(indices.size() % 3 == 0);
+    assert(threshold >= 1.0f);
+
+    const size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Cluster boundaries are the triangles where the cache order had to restart, all three vertices miss.
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<size_t> loadTimestamps(vertices.size(), 0);
+        size_t timestamp = fifoCacheSize + 1;
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            unsigned int misses = 0;
+
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                const unsigned int vertex = indices[triangle * 3 + corner];
+
+                if (timestamp - loadTimestamps[vertex] > fifoCacheSize)
+                {
+                    loadTimestamps[vertex] = timestamp++;
+                    ++misses;
+                }
+            }
+
+            if (triangle == 0 || misses == 3)
+            {
+                clusterStarts.push_back(triangle);
+            }
+        }
+    }
+
+    if (clusterStarts.size() < 2)
+    {
+        return;
+    }
+
+    float meshCentroid[3] = {};
+    float meshArea = 0.0f;
+
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        float centroid[3];
+        float normal[3];
+        float sortKey;
+    };
+
+    std::vector<Cluster> clusters(clusterStarts.size());
+
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        Cluster& cluster = clusters[i];
+
+        cluster.begin = clusterStarts[i];
+        cluster.end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount;
+
+        float clusterArea = 0.0f;
+        cluster.centroid[0] = cluster.centroid[1] = cluster.centroid[2] = 0.0f;
+        cluster.normal[0] = cluster.normal[1] = cluster.normal[2] = 0.0f;
+
+        // Area weighted centroid and normal.
+        for (size_t triangle = cluster.begin; triangle < cluster.end; ++triangle)
+        {
+            const unsigned int* corners = &indices[triangle * 3];
+
+            float normal[3];
+            getTriangleNormal(vertices, corners, normal);
+
+            const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float triangleCentroid = (vertices[corners[0]].position[axis] + vertices[corners[1]].position[axis] + vertices[corners[2]].position[axis]) / 3.0f;
+
+                cluster.centroid[axis] += triangleCentroid * area;
+                cluster.normal[axis] += normal[axis];
+                meshCentroid[axis] += triangleCentroid * area;
+            }
+
+            clusterArea += area;
+        }
+
+        meshArea += clusterArea;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            cluster.centroid[axis] = clusterArea > 0.0f ? cluster.centroid[axis] / clusterArea : 0.0f;
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        meshCentroid[axis] = meshArea > 0.0f ? meshCentroid[axis] / meshArea : 0.0f;
+    }
+
+    // Clusters that face away from the mesh center are the likely occluders, draw them first.
+    for (Cluster& cluster : clusters)
+    {
+        const float length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+
+        cluster.sortKey = 0.0f;
+
+        if (length > 0.0f)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                cluster.sortKey += (cluster.centroid[axis] - meshCentroid[axis]) * cluster.normal[axis] / length;
+            }
+        }
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& left, const Cluster& right) { return left.sortKey > right.sortKey; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    for (const Cluster& cluster : clusters)
+    {
+        result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+
+    // Keep the new order only if it does not cost too much vertex cache efficiency.
+    const VertexCacheStats before = analyzeVertexCache(indices, vertices.size(), fifoCacheSize);
+    const VertexCacheStats after = analyzeVertexCache(result, vertices.size(), fifoCacheSize);
+
+    if (after.acmr <= before.acmr * threshold)
+    {
+        indices.swap(result);
+    }
+}
+
+void optimizeVertexFetch(MeshData& mesh) noexcept
+{
+    std::vector<unsigned int> remap(mesh.vertices.size(), UINT_MAX);
+    unsigned int nextVertex = 0;
+
+    for (unsigned int& index : mesh.indices)
+    {
+        assert(index < mesh.vertices.size());
+
+        if (remap[index] == UINT_MAX)
+        {
+            remap[index] = nextVertex++;
+        }
+
+        index = remap[index];
+    }
+
+    std::vector<MeshVertex> vertices(nextVertex);
+
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        if (remap[i] != UINT_MAX)
+        {
+            vertices[remap[i]] = mesh.vertices[i];
+        }
+    }
+
+    mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(MeshData& mesh) noexcept
+{
+    constexpr float overdrawThreshold = 1.05f;
+
+    const VertexCacheStats before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), fifoCacheSize);
+
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    optimizeOverdraw(mesh.indices, mesh.vertices, overdrawThreshold);
+    optimizeVertexFetch(mesh);
+
+    const VertexCacheStats after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), fifoCacheSize);
+
+    print("Mesh optimization: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+}
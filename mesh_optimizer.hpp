@@ -0,0 +1,32 @@
+#ifndef KZ_MESH_OPTIMIZER_HPP
+#define KZ_MESH_OPTIMIZER_HPP
+
+#include <mesh_importer.hpp>
+
+// Post-transform vertex cache efficiency of an index buffer.
+struct VertexCacheStats
+{
+    // Average cache miss ratio, transformed vertices per triangle (0.5 is optimal for grids, 3 is worst).
+    float acmr{};
+
+    // Average transform to vertex ratio, transformed vertices per unique vertex (1 is optimal).
+    float atvr{};
+};
+
+// Simulates a FIFO post-transform cache of the given size.
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) noexcept;
+
+// Reorders triangles for the post-transform cache (Forsyth's linear-speed optimizer).
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) noexcept;
+
+// Reorders the cache-optimized triangle clusters so that outward facing clusters draw first (Tipsify style).
+// Cluster order is kept only if the ACMR stays within the threshold, e.g. 1.05.
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<MeshVertex>& vertices, float threshold) noexcept;
+
+// Reorders vertices by first use and drops unreferenced ones, indices are remapped.
+void optimizeVertexFetch(MeshData& mesh) noexcept;
+
+// Runs all passes in order and prints ACMR/ATVR before and after.
+void optimizeMesh(MeshData& mesh) noexcept;
+
+#endif
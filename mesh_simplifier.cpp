@@ -0,0 +1,607 @@
+#include <mesh_simplifier.hpp>
+#include <mesh_optimizer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Border edges are held in place by planes this many times stronger than the surface planes.
+constexpr double borderQuadricWeight = 10.0;
+
+// Levels below this many indices are not worth a separate draw range.
+constexpr size_t minimumLodIndexCount = 3 * 64;
+
+// Each level must remove at least this fraction of the previous level's triangles.
+constexpr float minimumLodReduction = 0.1f;
+
+// Symmetric 4x4 quadric, stored as the upper triangle plus the accumulated weight.
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+void addQuadric(Quadric& result, const Quadric& quadric) noexcept
+{
+    result.a00 += quadric.a00;
+    result.a01 += quadric.a01;
+    result.a02 += quadric.a02;
+    result.a11 += quadric.a11;
+    result.a12 += quadric.a12;
+    result.a22 += quadric.a22;
+    result.b0 += quadric.b0;
+    result.b1 += quadric.b1;
+    result.b2 += quadric.b2;
+    result.c += quadric.c;
+    result.weight += quadric.weight;
+}
+
+// Quadric of the squared distance to the plane n.p + d = 0 with a unit normal.
+Quadric getPlaneQuadric(const double normal[3], double distance, double weight) noexcept
+{
+    Quadric result;
+
+    result.a00 = weight * normal[0] * normal[0];
+    result.a01 = weight * normal[0] * normal[1];
+    result.a02 = weight * normal[0] * normal[2];
+    result.a11 = weight * normal[1] * normal[1];
+    result.a12 = weight * normal[1] * normal[2];
+    result.a22 = weight * normal[2] * normal[2];
+    result.b0 = weight * normal[0] * distance;
+    result.b1 = weight * normal[1] * distance;
+    result.b2 = weight * normal[2] * distance;
+    result.c = weight * distance * distance;
+    result.weight = weight;
+
+    return result;
+}
+
+// Weighted mean squared distance of the point to the planes of the quadric.
+double evaluateQuadric(const Quadric& quadric, const float position[3]) noexcept
+{
+    const double x = position[0];
+    const double y = position[1];
+    const double z = position[2];
+
+    const double error =
+        x * x * quadric.a00 + y * y * quadric.a11 + z * z * quadric.a22 +
+        2.0 * (x * y * quadric.a01 + x * z * quadric.a02 + y * z * quadric.a12) +
+        2.0 * (x * quadric.b0 + y * quadric.b1 + z * quadric.b2) +
+        quadric.c;
+
+    const double result = quadric.weight > 0.0 ? error / quadric.weight : 0.0;
+
+    return result > 0.0 ? result : 0.0;
+}
+
+void getTriangleNormal(const float* a, const float* b, const float* c, double normal[3]) noexcept
+{
+    const double ab[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+    const double ac[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+
+    normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+double normalize(double vector[3]) noexcept
+{
+    const double length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+
+    if (length > 0.0)
+    {
+        vector[0] /= length;
+        vector[1] /= length;
+        vector[2] /= length;
+    }
+
+    return length;
+}
+
+// Maps every vertex to the first vertex with a bitwise identical position, attribute seams collapse together.
+std::vector<unsigned int> getPositionRemap(const std::vector<MeshVertex>& vertices) noexcept
+{
+    std::vector<unsigned int> order(vertices.size());
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = static_cast<unsigned int>(i);
+    }
+
+    const auto lessPosition = [&](unsigned int left, unsigned int right)
+    {
+        const int compare = memcmp(vertices[left].position, vertices[right].position, sizeof(vertices[left].position));
+        return compare < 0 || (compare == 0 && left < right);
+    };
+
+    std::sort(order.begin(), order.end(), lessPosition);
+
+    std::vector<unsigned int> remap(vertices.size());
+
+    for (size_t i = 0; i < order.size();)
+    {
+        size_t j = i + 1;
+
+        while (j < order.size() && memcmp(vertices[order[i]].position, vertices[order[j]].position, sizeof(vertices[order[i]].position)) == 0)
+        {
+            ++j;
+        }
+
+        for (size_t k = i; k < j; ++k)
+        {
+            remap[order[k]] = order[i];
+        }
+
+        i = j;
+    }
+
+    return remap;
+}
+
+float getAttributeDistance(const MeshVertex& left, const MeshVertex& right) noexcept
+{
+    float distance = 0.0f;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        distance += (left.normal[i] - right.normal[i]) * (left.normal[i] - right.normal[i]);
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        distance += (left.uv[i] - right.uv[i]) * (left.uv[i] - right.uv[i]);
+    }
+
+    return distance;
+}
+
+}
+
+float simplifyMesh(std::vector<unsigned int>& destination, const std::vector<unsigned int>& indices, const std::vector<MeshVertex>& vertices, size_t targetIndexCount) noexcept
+{
+    assert(indices.size() % 3 == 0);
+
+    const size_t vertexCount = vertices.size();
+    const std::vector<unsigned int> positionRemap = getPositionRemap(vertices);
+
+    // Topology works on position-welded vertices, the original corner vertex is kept to restore attributes.
+    std::vector<unsigned int> corners;
+    std::vector<unsigned int> originalCorners;
+
+    corners.reserve(indices.size());
+    originalCorners.reserve(indices.size());
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const unsigned int a = positionRemap[indices[i + 0]];
+        const unsigned int b = positionRemap[indices[i + 1]];
+        const unsigned int c = positionRemap[indices[i + 2]];
+
+        if (a != b && b != c && c != a)
+        {
+            corners.insert(corners.end(), { a, b, c });
+            originalCorners.insert(originalCorners.end(), { indices[i + 0], indices[i + 1], indices[i + 2] });
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+
+    // Area weighted plane quadrics.
+    for (size_t i = 0; i < corners.size(); i += 3)
+    {
+        const float* a = vertices[corners[i + 0]].position;
+        const float* b = vertices[corners[i + 1]].position;
+        const float* c = vertices[corners[i + 2]].position;
+
+        double normal[3];
+        getTriangleNormal(a, b, c, normal);
+
+        const double area = normalize(normal) * 0.5;
+        const double distance = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+        const Quadric quadric = getPlaneQuadric(normal, distance, area);
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            addQuadric(quadrics[corners[i + corner]], quadric);
+        }
+    }
+
+    // Open borders get a plane through the edge perpendicular to the triangle so silhouettes of open meshes hold.
+    {
+        struct Edge
+        {
+            unsigned int low;
+            unsigned int high;
+            unsigned int triangle;
+        };
+
+        std::vector<Edge> edges;
+        edges.reserve(corners.size());
+
+        for (size_t i = 0; i < corners.size(); i += 3)
+        {
+            for (int edge = 0; edge < 3; ++edge)
+            {
+                const unsigned int a = corners[i + edge];
+                const unsigned int b = corners[i + (edge + 1) % 3];
+
+                edges.push_back({ a < b ? a : b, a < b ? b : a, static_cast<unsigned int>(i / 3) });
+            }
+        }
+
+        std::sort(edges.begin(), edges.end(), [](const Edge& left, const Edge& right)
+        {
+            return left.low < right.low || (left.low == right.low && left.high < right.high);
+        });
+
+        for (size_t i = 0; i < edges.size();)
+        {
+            size_t j = i + 1;
+
+            while (j < edges.size() && edges[j].low == edges[i].low && edges[j].high == edges[i].high)
+            {
+                ++j;
+            }
+
+            if (j - i == 1)
+            {
+                const unsigned int* triangle = &corners[static_cast<size_t>(edges[i].triangle) * 3];
+
+                double faceNormal[3];
+                getTriangleNormal(vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position, faceNormal);
+                normalize(faceNormal);
+
+                const float* a = vertices[edges[i].low].position;
+                const float* b = vertices[edges[i].high].position;
+
+                double edgeDirection[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+                const double edgeLength = normalize(edgeDirection);
+
+                double normal[3] =
+                {
+                    edgeDirection[1] * faceNormal[2] - edgeDirection[2] * faceNormal[1],
+                    edgeDirection[2] * faceNormal[0] - edgeDirection[0] * faceNormal[2],
+                    edgeDirection[0] * faceNormal[1] - edgeDirection[1] * faceNormal[0],
+                };
+                normalize(normal);
+
+                const double distance = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+                const Quadric quadric = getPlaneQuadric(normal, distance, edgeLength * edgeLength * borderQuadricWeight);
+
+                addQuadric(quadrics[edges[i].low], quadric);
+                addQuadric(quadrics[edges[i].high], quadric);
+            }
+
+            i = j;
+        }
+    }
+
+    const size_t targetTriangleCount = targetIndexCount / 3;
+    double maxError = 0.0;
+
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+    std::vector<unsigned int> vertexTriangles;
+    std::vector<unsigned char> locked(vertexCount);
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double error;
+    };
+
+    std::vector<Collapse> collapses;
+
+    // Each pass collapses a set of independent edges in order of increasing error.
+    while (corners.size() / 3 > targetTriangleCount)
+    {
+        const size_t triangleCount = corners.size() / 3;
+
+        // Vertex to triangle adjacency of the current triangles.
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+
+        for (const unsigned int vertex : corners)
+        {
+            ++triangleOffsets[vertex + 1];
+        }
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        }
+
+        vertexTriangles.resize(corners.size());
+
+        {
+            std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+
+            for (size_t i = 0; i < corners.size(); ++i)
+            {
+                vertexTriangles[fill[corners[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+
+        collapses.clear();
+
+        for (size_t i = 0; i < corners.size(); i += 3)
+        {
+            for (int edge = 0; edge < 3; ++edge)
+            {
+                const unsigned int a = corners[i + edge];
+                const unsigned int b = corners[i + (edge + 1) % 3];
+
+                Quadric quadric = quadrics[a];
+                addQuadric(quadric, quadrics[b]);
+
+                const double errorAtA = evaluateQuadric(quadric, vertices[a].position);
+                const double errorAtB = evaluateQuadric(quadric, vertices[b].position);
+
+                collapses.push_back(errorAtB <= errorAtA ? Collapse{ a, b, errorAtB } : Collapse{ b, a, errorAtA });
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) { return left.error < right.error; });
+
+        std::fill(locked.begin(), locked.end(), static_cast<unsigned char>(0));
+
+        std::vector<unsigned int> collapseRemap;
+        size_t removedTriangles = 0;
+        size_t collapseCount = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (triangleCount - removedTriangles <= targetTriangleCount)
+            {
+                break;
+            }
+
+            if (locked[collapse.from] || locked[collapse.to])
+            {
+                continue;
+            }
+
+            const float* target = vertices[collapse.to].position;
+
+            // Reject collapses that flip any triangle that survives the collapse.
+            bool flips = false;
+            size_t collapsedTriangles = 0;
+
+            for (unsigned int t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; ++t)
+            {
+                const unsigned int* triangle = &corners[static_cast<size_t>(vertexTriangles[t]) * 3];
+
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++collapsedTriangles;
+                    continue;
+                }
+
+                const float* positions[3];
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    positions[corner] = triangle[corner] == collapse.from ? target : vertices[triangle[corner]].position;
+                }
+
+                double before[3];
+                double after[3];
+                getTriangleNormal(vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position, before);
+                getTriangleNormal(positions[0], positions[1], positions[2], after);
+
+                flips = (before[0] * after[0] + before[1] * after[1] + before[2] * after[2]) <= 0.0;
+            }
+
+            if (flips)
+            {
+                continue;
+            }
+
+            if (collapseRemap.empty())
+            {
+                collapseRemap.resize(vertexCount);
+
+                for (size_t i = 0; i < vertexCount; ++i)
+                {
+                    collapseRemap[i] = static_cast<unsigned int>(i);
+                }
+            }
+
+            collapseRemap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+            // Lock the one-ring so flip tests of later collapses in this pass stay valid.
+            for (unsigned int t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; ++t)
+            {
+                const unsigned int* triangle = &corners[static_cast<size_t>(vertexTriangles[t]) * 3];
+
+                locked[triangle[0]] = locked[triangle[1]] = locked[triangle[2]] = 1;
+            }
+
+            maxError = collapse.error > maxError ? collapse.error : maxError;
+            removedTriangles += collapsedTriangles;
+            ++collapseCount;
+        }
+
+        if (collapseCount == 0)
+        {
+            break;
+        }
+
+        // Apply the collapses and drop the triangles that became degenerate.
+        size_t writeIndex = 0;
+
+        for (size_t i = 0; i < corners.size(); i += 3)
+        {
+            const unsigned int a = collapseRemap[corners[i + 0]];
+            const unsigned int b = collapseRemap[corners[i + 1]];
+            const unsigned int c = collapseRemap[corners[i + 2]];
+
+            if (a != b && b != c && c != a)
+            {
+                corners[writeIndex + 0] = a;
+                corners[writeIndex + 1] = b;
+                corners[writeIndex + 2] = c;
+
+                originalCorners[writeIndex + 0] = originalCorners[i + 0];
+                originalCorners[writeIndex + 1] = originalCorners[i + 1];
+                originalCorners[writeIndex + 2] = originalCorners[i + 2];
+
+                writeIndex += 3;
+            }
+        }
+
+        corners.resize(writeIndex);
+        originalCorners.resize(writeIndex);
+    }
+
+    // Vertices that share a welded position, used to pick the closest attributes for moved corners.
+    std::vector<unsigned int> wedgeOffsets(vertexCount + 1, 0);
+    std::vector<unsigned int> wedges(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        ++wedgeOffsets[positionRemap[i] + 1];
+    }
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        wedgeOffsets[i + 1] += wedgeOffsets[i];
+    }
+
+    {
+        std::vector<unsigned int> fill(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            wedges[fill[positionRemap[i]]++] = static_cast<unsigned int>(i);
+        }
+    }
+
+    destination.resize(corners.size());
+
+    for (size_t i = 0; i < corners.size(); ++i)
+    {
+        const unsigned int welded = corners[i];
+        const unsigned int original = originalCorners[i];
+
+        if (positionRemap[original] == welded)
+        {
+            destination[i] = original;
+            continue;
+        }
+
+        unsigned int best = welded;
+        float bestDistance = -1.0f;
+
+        for (unsigned int w = wedgeOffsets[welded]; w < wedgeOffsets[welded + 1]; ++w)
+        {
+            const float distance = getAttributeDistance(vertices[wedges[w]], vertices[original]);
+
+            if (bestDistance < 0.0f || distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = wedges[w];
+            }
+        }
+
+        destination[i] = best;
+    }
+
+    return static_cast<float>(std::sqrt(maxError));
+}
+
+MeshLodChain generateMeshLodChain(MeshData& mesh, unsigned int maxLodCount) noexcept
+{
+    assert(maxLodCount > 0);
+
+    MeshLodChain chain{};
+
+    if (mesh.vertices.empty())
+    {
+        return chain;
+    }
+
+    // Bounding sphere around the box center.
+    {
+        float boundsMin[3];
+        float boundsMax[3];
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            boundsMin[axis] = boundsMax[axis] = mesh.vertices[0].position[axis];
+        }
+
+        for (const MeshVertex& vertex : mesh.vertices)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                boundsMin[axis] = vertex.position[axis] < boundsMin[axis] ? vertex.position[axis] : boundsMin[axis];
+                boundsMax[axis] = vertex.position[axis] > boundsMax[axis] ? vertex.position[axis] : boundsMax[axis];
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            chain.boundsCenter[axis] = 0.5f * (boundsMin[axis] + boundsMax[axis]);
+        }
+
+        float radiusSquared = 0.0f;
+
+        for (const MeshVertex& vertex : mesh.vertices)
+        {
+            const float dx = vertex.position[0] - chain.boundsCenter[0];
+            const float dy = vertex.position[1] - chain.boundsCenter[1];
+            const float dz = vertex.position[2] - chain.boundsCenter[2];
+
+            const float distanceSquared = dx * dx + dy * dy + dz * dz;
+            radiusSquared = distanceSquared > radiusSquared ? distanceSquared : radiusSquared;
+        }
+
+        chain.boundsRadius = std::sqrt(radiusSquared);
+    }
+
+    chain.lods.push_back({ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f });
+
+    // Each level is simplified from the previous one, so errors accumulate along the chain.
+    std::vector<unsigned int> source = mesh.indices;
+    float error = 0.0f;
+
+    while (chain.lods.size() < maxLodCount)
+    {
+        const size_t targetIndexCount = (source.size() / 6) * 3;
+
+        if (targetIndexCount < minimumLodIndexCount)
+        {
+            break;
+        }
+
+        std::vector<unsigned int> lod;
+        error += simplifyMesh(lod, source, mesh.vertices, targetIndexCount);
+
+        if (static_cast<float>(lod.size()) > static_cast<float>(source.size()) * (1.0f - minimumLodReduction))
+        {
+            break;
+        }
+
+        optimizeVertexCache(lod, mesh.vertices.size());
+
+        chain.lods.push_back({ static_cast<unsigned int>(mesh.indices.size()), static_cast<unsigned int>(lod.size()), error });
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+
+        source.swap(lod);
+    }
+
+    for (size_t i = 0; i < chain.lods.size(); ++i)
+    {
+        print("Mesh LOD %zu: %u triangles, error %.5f\n", i, chain.lods[i].indexCount / 3, chain.lods[i].error);
+    }
+
+    return chain;
+}
@@ -0,0 +1,33 @@
+#ifndef KZ_MESH_SIMPLIFIER_HPP
+#define KZ_MESH_SIMPLIFIER_HPP
+
+#include <mesh_importer.hpp>
+
+// Index range of one level of detail inside MeshData::indices.
+struct MeshLod
+{
+    unsigned int firstIndex{};
+    unsigned int indexCount{};
+
+    // Maximum geometric deviation from LOD 0 in mesh units.
+    float error{};
+};
+
+struct MeshLodChain
+{
+    // LOD 0 is the full mesh, each following level has roughly half the triangles.
+    std::vector<MeshLod> lods;
+
+    // Bounding sphere in mesh units, used to project the LOD error to pixels.
+    float boundsCenter[3]{};
+    float boundsRadius{};
+};
+
+// Quadric error edge-collapse simplification, all vertices of the input are kept and only indices are produced.
+// Returns the deviation of the result from the input in mesh units.
+float simplifyMesh(std::vector<unsigned int>& destination, const std::vector<unsigned int>& indices, const std::vector<MeshVertex>& vertices, size_t targetIndexCount) noexcept;
+
+// Appends the simplified levels to mesh.indices, the vertex buffer is shared by all levels.
+MeshLodChain generateMeshLodChain(MeshData& mesh, unsigned int maxLodCount) noexcept;
+
+#endif
@@ -0,0 +1,195 @@
+#include <meshlet.hpp>
+
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+void computeMeshletBounds(Meshlet& meshlet, const MeshData& mesh) noexcept
+{
+    const unsigned int* indices = &mesh.indices[meshlet.firstIndex];
+
+    float boundsMin[3];
+    float boundsMax[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        boundsMin[axis] = boundsMax[axis] = mesh.vertices[indices[0]].position[axis];
+    }
+
+    for (unsigned int i = 0; i < meshlet.indexCount; ++i)
+    {
+        const float* position = mesh.vertices[indices[i]].position;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            boundsMin[axis] = position[axis] < boundsMin[axis] ? position[axis] : boundsMin[axis];
+            boundsMax[axis] = position[axis] > boundsMax[axis] ? position[axis] : boundsMax[axis];
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        meshlet.center[axis] = 0.5f * (boundsMin[axis] + boundsMax[axis]);
+    }
+
+    float radiusSquared = 0.0f;
+
+    for (unsigned int i = 0; i < meshlet.indexCount; ++i)
+    {
+        const float* position = mesh.vertices[indices[i]].position;
+
+        const float dx = position[0] - meshlet.center[0];
+        const float dy = position[1] - meshlet.center[1];
+        const float dz = position[2] - meshlet.center[2];
+
+        const float distanceSquared = dx * dx + dy * dy + dz * dz;
+        radiusSquared = distanceSquared > radiusSquared ? distanceSquared : radiusSquared;
+    }
+
+    meshlet.radius = std::sqrt(radiusSquared);
+
+    // Normal cone from the unit face normals, counter-clockwise triangles face front.
+    float normals[maxMeshletTriangles][3];
+    unsigned int normalCount = 0;
+
+    float axis[3] = {};
+
+    for (unsigned int i = 0; i < meshlet.indexCount; i += 3)
+    {
+        const float* a = mesh.vertices[indices[i + 0]].position;
+        const float* b = mesh.vertices[indices[i + 1]].position;
+        const float* c = mesh.vertices[indices[i + 2]].position;
+
+        const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+        float* normal = normals[normalCount];
+        normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+        normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+        normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        // Degenerate triangles do not constrain the cone.
+        if (length <= 0.0f)
+        {
+            continue;
+        }
+
+        for (int component = 0; component < 3; ++component)
+        {
+            normal[component] /= length;
+            axis[component] += normal[component];
+        }
+
+        ++normalCount;
+    }
+
+    const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+    meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+    meshlet.coneCutoff = 1.0f;
+
+    if (normalCount == 0 || axisLength <= 0.0f)
+    {
+        return;
+    }
+
+    for (int component = 0; component < 3; ++component)
+    {
+        meshlet.coneAxis[component] = axis[component] / axisLength;
+    }
+
+    float minimumDot = 1.0f;
+
+    for (unsigned int i = 0; i < normalCount; ++i)
+    {
+        const float dot = normals[i][0] * meshlet.coneAxis[0] + normals[i][1] * meshlet.coneAxis[1] + normals[i][2] * meshlet.coneAxis[2];
+        minimumDot = dot < minimumDot ? dot : minimumDot;
+    }
+
+    // Normals spread over more than a hemisphere can not be culled as a whole.
+    if (minimumDot > 0.0f)
+    {
+        meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+    }
+}
+
+}
+
+void buildMeshlets(std::vector<Meshlet>& meshlets, const MeshData& mesh, unsigned int firstIndex, unsigned int indexCount) noexcept
+{
+    assert(indexCount % 3 == 0);
+    assert(static_cast<size_t>(firstIndex) + indexCount <= mesh.indices.size());
+
+    // Vertices of the open meshlet, a cache-optimized order keeps neighbours close in the index buffer.
+    unsigned int meshletVertices[maxMeshletVertices];
+    unsigned int meshletVertexCount = 0;
+
+    Meshlet meshlet{};
+    meshlet.firstIndex = firstIndex;
+
+    const auto closeMeshlet = [&]()
+    {
+        if (meshlet.indexCount > 0)
+        {
+            computeMeshletBounds(meshlet, mesh);
+            meshlets.push_back(meshlet);
+        }
+
+        meshlet = {};
+        meshletVertexCount = 0;
+    };
+
+    // Corners of the triangle not yet in the open meshlet.
+    const auto countNewVertices = [&](unsigned int i, unsigned int* newVertices)
+    {
+        unsigned int newVertexCount = 0;
+
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            const unsigned int vertex = mesh.indices[i + corner];
+
+            bool found = false;
+            for (unsigned int j = 0; j < meshletVertexCount && !found; ++j)
+            {
+                found = meshletVertices[j] == vertex;
+            }
+
+            for (unsigned int j = 0; j < newVertexCount && !found; ++j)
+            {
+                found = newVertices[j] == vertex;
+            }
+
+            if (!found)
+            {
+                newVertices[newVertexCount++] = vertex;
+            }
+        }
+
+        return newVertexCount;
+    };
+
+    for (unsigned int i = firstIndex; i < firstIndex + indexCount; i += 3)
+    {
+        unsigned int newVertices[3];
+        unsigned int newVertexCount = countNewVertices(i, newVertices);
+
+        if (meshletVertexCount + newVertexCount > maxMeshletVertices || meshlet.indexCount / 3 + 1 > maxMeshletTriangles)
+        {
+            closeMeshlet();
+            meshlet.firstIndex = i;
+            newVertexCount = countNewVertices(i, newVertices);
+        }
+
+        for (unsigned int j = 0; j < newVertexCount; ++j)
+        {
+            meshletVertices[meshletVertexCount++] = newVertices[j];
+        }
+
+        meshlet.indexCount += 3;
+    }
+
+    closeMeshlet();
+}
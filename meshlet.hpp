@@ -0,0 +1,29 @@
+#ifndef KZ_MESHLET_HPP
+#define KZ_MESHLET_HPP
+
+#include <mesh_importer.hpp>
+
+// Limits of one cluster, sized so a cluster's vertices stay in the post-transform cache.
+constexpr unsigned int maxMeshletVertices = 64;
+constexpr unsigned int maxMeshletTriangles = 124;
+
+// Contiguous range of triangles in the index buffer with its culling bounds.
+struct Meshlet
+{
+    unsigned int firstIndex{};
+    unsigned int indexCount{};
+
+    // Bounding sphere.
+    float center[3]{};
+    float radius{};
+
+    // Normal cone, the cluster is back-facing when viewed from inside the negative cone.
+    // A cutoff of one disables cone culling for the cluster.
+    float coneAxis[3]{};
+    float coneCutoff{ 1.0f };
+};
+
+// Splits the index range into meshlets in index order, the range is expected to be cache optimized.
+void buildMeshlets(std::vector<Meshlet>& meshlets, const MeshData& mesh, unsigned int firstIndex, unsigned int indexCount) noexcept;
+
+#endif
@@ -0,0 +1,433 @@
+#include <meshlet_culling.hpp>
+#include <textured_cube_shader.hpp>
+#include <gl_state_cache.hpp>
+#include <texture_samplers.hpp>
+
+#include <cmath>
+#include <cassert>
+
+namespace
+{
+// Meshlet layout of the cull shader, std430.
+struct GpuMeshlet
+{
+    GLfloat sphere[4];
+    GLfloat cone[4];
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLuint padding[2];
+};
+
+static_assert(sizeof(GpuMeshlet) == 48, "Meshlet must match the std430 layout");
+
+// Matches DrawElementsIndirectCommand.
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+constexpr GLuint cullWorkGroupSize = 64;
+
+const GLchar* meshletCullShaderSource =
+R"kz_shader(
+    layout(local_size_x = 64) in;
+
+    struct Meshlet
+    {
+        vec4 sphere;
+        vec4 cone;
+        uint firstIndex;
+        uint indexCount;
+        uint padding0;
+        uint padding1;
+    };
+
+    layout(std430, binding = 0) readonly buffer Meshlets { Meshlet meshlets[]; };
+    layout(std430, binding = 1) readonly buffer SourceIndices { uint sourceIndices[]; };
+    layout(std430, binding = 2) writeonly buffer CulledIndices { uint culledIndices[]; };
+    layout(std430, binding = 3) buffer DrawCommand
+    {
+        uint count;
+        uint instanceCount;
+        uint firstIndex;
+        int baseVertex;
+        uint baseInstance;
+    };
+
+    layout(std430, binding = 4) buffer Stats
+    {
+        uint objectsTested;
+        uint objectsOccluded;
+        uint meshletsTested;
+        uint meshletsFrustumCulled;
+        uint meshletsConeCulled;
+        uint meshletsOccluded;
+        uint meshletsVisible;
+    };
+
+    // Normalized model space planes, inside is positive.
+    uniform vec4 frustumPlanes[6];
+    uniform vec3 cameraPosition;
+    uniform uint firstMeshlet;
+    uniform uint meshletCount;
+    uniform bool coneCulling;
+
+    // Max-depth pyramid of the previous frame, level 0 is half of depthSize.
+    uniform mat4 modelViewProjection;
+    uniform vec4 objectSphere;
+    uniform bool hiZCulling;
+    uniform ivec2 depthSize;
+    layout(binding = 0) uniform sampler2D hiZPyramid;
+
+    // Compares the nearest depth of the sphere's box against the farthest depth under its screen rectangle.
+    bool isSphereOccluded(vec3 center, float radius)
+    {
+        vec2 ndcMin = vec2(1.0f);
+        vec2 ndcMax = vec2(-1.0f);
+        float nearestDepth = 1.0f;
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            vec3 offset = vec3((corner & 1) != 0 ? radius : -radius, (corner & 2) != 0 ? radius : -radius, (corner & 4) != 0 ? radius : -radius);
+            vec4 clip = modelViewProjection * vec4(center + offset, 1.0f);
+
+            // Crossing the eye plane, the projection is unbounded.
+            if (clip.w <= 0.0f)
+            {
+                return false;
+            }
+
+            vec3 ndc = clip.xyz / clip.w;
+
+            ndcMin = min(ndcMin, ndc.xy);
+            ndcMax = max(ndcMax, ndc.xy);
+            nearestDepth = min(nearestDepth, ndc.z * 0.5f + 0.5f);
+        }
+
+        ivec2 texelMin = clamp(ivec2((ndcMin * 0.5f + 0.5f) * vec2(depthSize)), ivec2(0), depthSize - 1) >> 1;
+        ivec2 texelMax = clamp(ivec2((ndcMax * 0.5f + 0.5f) * vec2(depthSize)), ivec2(0), depthSize - 1) >> 1;
+
+        // Coarsest needed level where the rectangle spans at most 2x2 texels.
+        int levelCount = textureQueryLevels(hiZPyramid);
+        int level = 0;
+
+        while (level + 1 < levelCount && any(greaterThan((texelMax >> level) - (texelMin >> level), ivec2(1))))
+        {
+            ++level;
+        }
+
+        // The last texel of a level also covers the folded odd row and column.
+        ivec2 levelSize = textureSize(hiZPyramid, level);
+        ivec2 a = min(texelMin >> level, levelSize - 1);
+        ivec2 b = min(texelMax >> level, levelSize - 1);
+
+        float farthestDepth = max(max(texelFetch(hiZPyramid, a, level).r, texelFetch(hiZPyramid, ivec2(b.x, a.y), level).r),
+                                  max(texelFetch(hiZPyramid, ivec2(a.x, b.y), level).r, texelFetch(hiZPyramid, b, level).r));
+
+        return nearestDepth > farthestDepth;
+    }
+
+    void main()
+    {
+        uint meshletIndex = gl_GlobalInvocationID.x;
+
+        bool objectOccluded = hiZCulling && isSphereOccluded(objectSphere.xyz, objectSphere.w);
+
+        if (meshletIndex == 0)
+        {
+            atomicAdd(objectsTested, 1);
+
+            if (objectOccluded)
+            {
+                atomicAdd(objectsOccluded, 1);
+            }
+        }
+
+        if (meshletIndex >= meshletCount || objectOccluded)
+        {
+            return;
+        }
+
+        atomicAdd(meshletsTested, 1);
+
+        Meshlet meshlet = meshlets[firstMeshlet + meshletIndex];
+
+        vec3 center = meshlet.sphere.xyz;
+        float radius = meshlet.sphere.w;
+
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            if (dot(frustumPlanes[plane].xyz, center) + frustumPlanes[plane].w < -radius)
+            {
+                atomicAdd(meshletsFrustumCulled, 1);
+                return;
+            }
+        }
+
+        // Every triangle faces away when the camera is inside the negative normal cone.
+        vec3 view = center - cameraPosition;
+
+        if (coneCulling && dot(view, meshlet.cone.xyz) >= meshlet.cone.w * length(view) + radius)
+        {
+            atomicAdd(meshletsConeCulled, 1);
+            return;
+        }
+
+        if (hiZCulling && isSphereOccluded(center, radius))
+        {
+            atomicAdd(meshletsOccluded, 1);
+            return;
+        }
+
+        atomicAdd(meshletsVisible, 1);
+
+        uint offset = atomicAdd(count, meshlet.indexCount);
+
+        for (uint i = 0; i < meshlet.indexCount; ++i)
+        {
+            culledIndices[offset + i] = sourceIndices[meshlet.firstIndex + i];
+        }
+    }
+)kz_shader";
+
+// Gribb-Hartmann planes from the column-major MVP, in model space.
+void getFrustumPlanes(GLfloat planes[6][4], const GLfloat* modelViewProjection) noexcept
+{
+    // Row r of the matrix is (m[r], m[4 + r], m[8 + r], m[12 + r]).
+    const auto row = [modelViewProjection](int r, int c) { return modelViewProjection[c * 4 + r]; };
+
+    for (int c = 0; c < 4; ++c)
+    {
+        planes[0][c] = row(3, c) + row(0, c);
+        planes[1][c] = row(3, c) - row(0, c);
+        planes[2][c] = row(3, c) + row(1, c);
+        planes[3][c] = row(3, c) - row(1, c);
+        planes[4][c] = row(3, c) + row(2, c);
+        planes[5][c] = row(3, c) - row(2, c);
+    }
+
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        const float length = std::sqrt(planes[plane][0] * planes[plane][0] + planes[plane][1] * planes[plane][1] + planes[plane][2] * planes[plane][2]);
+
+        if (length > 0.0f)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                planes[plane][c] /= length;
+            }
+        }
+    }
+}
+
+// The eye maps to clip x = y = w = 0, solved from those three rows with Cramer's rule.
+bool getCameraPosition(GLfloat position[3], const GLfloat* modelViewProjection) noexcept
+{
+    const auto row = [modelViewProjection](int r, int c) { return modelViewProjection[c * 4 + r]; };
+
+    const float a[3][3] =
+    {
+        { row(0, 0), row(0, 1), row(0, 2) },
+        { row(1, 0), row(1, 1), row(1, 2) },
+        { row(3, 0), row(3, 1), row(3, 2) },
+    };
+
+    const float b[3] = { -row(0, 3), -row(1, 3), -row(3, 3) };
+
+    const auto determinant = [](const float m[3][3])
+    {
+        return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    };
+
+    const float det = determinant(a);
+
+    // Orthographic projections have no eye point.
+    if (std::fabs(det) < 1e-12f)
+    {
+        return false;
+    }
+
+    for (int column = 0; column < 3; ++column)
+    {
+        float m[3][3];
+
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                m[r][c] = c == column ? b[r] : a[r][c];
+            }
+        }
+
+        position[column] = determinant(m) / det;
+    }
+
+    return true;
+}
+
+}
+
+void submitMeshletCullingProgram() noexcept
+{
+    submitComputeShaderProgram(meshletCullShaderSource);
+}
+
+MeshletCullingContext createMeshletCulling(const std::vector<Meshlet>& meshlets, GLuint sourceIndexBuffer, GLsizei maxIndexCount) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(!meshlets.empty());
+    assert(glIsBuffer(sourceIndexBuffer));
+    assert(maxIndexCount > 0);
+
+    MeshletCullingContext context = {};
+
+    UniformReflection uniforms;
+    context.cullProgram = createComputeShaderProgram(meshletCullShaderSource, uniforms);
+
+    context.frustumPlanesUniform = getUniformLocation(uniforms, uniformName("frustumPlanes"));
+    context.cameraPositionUniform = getUniformLocation(uniforms, uniformName("cameraPosition"));
+    context.firstMeshletUniform = getUniformLocation(uniforms, uniformName("firstMeshlet"));
+    context.meshletCountUniform = getUniformLocation(uniforms, uniformName("meshletCount"));
+    context.coneCullingUniform = getUniformLocation(uniforms, uniformName("coneCulling"));
+
+    context.modelViewProjectionUniform = getUniformLocation(uniforms, uniformName("modelViewProjection"));
+    context.objectSphereUniform = getUniformLocation(uniforms, uniformName("objectSphere"));
+    context.hiZCullingUniform = getUniformLocation(uniforms, uniformName("hiZCulling"));
+    context.depthSizeUniform = getUniformLocation(uniforms, uniformName("depthSize"));
+
+    assert(context.frustumPlanesUniform >= 0);
+    assert(context.meshletCountUniform >= 0);
+    assert(context.hiZCullingUniform >= 0);
+
+    std::vector<GpuMeshlet> gpuMeshlets(meshlets.size());
+
+    for (size_t i = 0; i < meshlets.size(); ++i)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        GpuMeshlet& gpuMeshlet = gpuMeshlets[i];
+
+        gpuMeshlet = {};
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            gpuMeshlet.sphere[axis] = meshlet.center[axis];
+            gpuMeshlet.cone[axis] = meshlet.coneAxis[axis];
+        }
+
+        gpuMeshlet.sphere[3] = meshlet.radius;
+        gpuMeshlet.cone[3] = meshlet.coneCutoff;
+        gpuMeshlet.firstIndex = meshlet.firstIndex;
+        gpuMeshlet.indexCount = meshlet.indexCount;
+    }
+
+    glCreateBuffers(1, &context.meshletBuffer);
+    glNamedBufferStorage(context.meshletBuffer, static_cast<GLsizeiptr>(gpuMeshlets.size() * sizeof(GpuMeshlet)), gpuMeshlets.data(), 0);
+
+    context.meshletCount = static_cast<GLuint>(meshlets.size());
+    context.sourceIndexBuffer = sourceIndexBuffer;
+
+    for (MeshletCullOutput& output : context.outputs)
+    {
+        glCreateBuffers(1, &output.indexBuffer);
+        glNamedBufferStorage(output.indexBuffer, static_cast<GLsizeiptr>(maxIndexCount) * sizeof(GLuint), nullptr, 0);
+
+        // The command is reset with a sub data upload before every cull.
+        glCreateBuffers(1, &output.drawCommandBuffer);
+        glNamedBufferStorage(output.drawCommandBuffer, sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        glCreateBuffers(1, &output.statsBuffer);
+        glNamedBufferStorage(output.statsBuffer, sizeof(OcclusionStats), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return context;
+}
+
+void cullMeshlets(MeshletCullingContext& context, MeshletCullPass pass, const GLfloat* modelViewProjection, const GLfloat* objectSphere, unsigned int firstMeshlet, unsigned int meshletCount, const HiZPyramid* hiZPyramid) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(pass < meshletCullPassCount);
+    assert(firstMeshlet + meshletCount <= context.meshletCount);
+
+    MeshletCullOutput& output = context.outputs[pass];
+
+    // A frame old, the dispatch has finished by now and the read does not stall.
+    if (output.statsPending)
+    {
+        glGetNamedBufferSubData(output.statsBuffer, 0, sizeof(OcclusionStats), &context.stats[pass]);
+    }
+
+    const DrawElementsIndirectCommand emptyCommand = { 0, 1, 0, 0, 0 };
+    glNamedBufferSubData(output.drawCommandBuffer, 0, sizeof(emptyCommand), &emptyCommand);
+
+    const OcclusionStats emptyStats = {};
+    glNamedBufferSubData(output.statsBuffer, 0, sizeof(emptyStats), &emptyStats);
+
+    output.statsPending = true;
+
+    const bool hiZCulling = context.hiZCulling && hiZPyramid && hiZPyramid->built;
+
+    GLfloat frustumPlanes[6][4];
+    getFrustumPlanes(frustumPlanes, modelViewProjection);
+
+    GLfloat cameraPosition[3] = {};
+    const bool hasCameraPosition = getCameraPosition(cameraPosition, modelViewProjection);
+
+    cachedUseProgram(context.cullProgram);
+
+    glUniform4fv(context.frustumPlanesUniform, 6, &frustumPlanes[0][0]);
+    glUniform3fv(context.cameraPositionUniform, 1, cameraPosition);
+    glUniform1ui(context.firstMeshletUniform, firstMeshlet);
+    glUniform1ui(context.meshletCountUniform, meshletCount);
+    glUniform1i(context.coneCullingUniform, context.coneCulling && hasCameraPosition);
+
+    glUniformMatrix4fv(context.modelViewProjectionUniform, 1, GL_FALSE, modelViewProjection);
+    glUniform4fv(context.objectSphereUniform, 1, objectSphere);
+    glUniform1i(context.hiZCullingUniform, hiZCulling);
+
+    if (hiZCulling)
+    {
+        const GLint depthSize[] = { hiZPyramid->depthWidth, hiZPyramid->depthHeight };
+        glUniform2iv(context.depthSizeUniform, 1, depthSize);
+
+        cachedBindTextureUnit(0, hiZPyramid->texture);
+        cachedBindSampler(0, getSharedSampler(samplerPointClamp));
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, context.meshletBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, context.sourceIndexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, output.indexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, output.drawCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, output.statsBuffer);
+
+    glDispatchCompute((meshletCount + cullWorkGroupSize - 1) / cullWorkGroupSize, 1, 1);
+
+    // The draw sources both the compacted indices and the command written above.
+    glMemoryBarrier(GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void drawCulledMeshlets(const MeshletCullingContext& context, MeshletCullPass pass) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(pass < meshletCullPassCount);
+
+    const MeshletCullOutput& output = context.outputs[pass];
+
+    assert(glIsVertexArray(output.vertexArray));
+
+    cachedBindVertexArray(output.vertexArray);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, output.drawCommandBuffer);
+
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
@@ -0,0 +1,74 @@
+#ifndef KZ_MESHLET_CULLING_HPP
+#define KZ_MESHLET_CULLING_HPP
+
+#include "gl_functions.h"
+#include <meshlet.hpp>
+#include <hiz_culling.hpp>
+
+// Passes culled separately, each pass keeps its compacted output until it is culled again.
+enum MeshletCullPass : unsigned int
+{
+    meshletColorPass,
+    meshletIDPass,
+    meshletCullPassCount,
+};
+
+// Compacted indices of the visible meshlets and the indirect draw that consumes them.
+struct MeshletCullOutput
+{
+    GLuint indexBuffer{};
+    GLuint drawCommandBuffer{};
+
+    // Mesh vertex attributes with indexBuffer as the element array, set up by the owner of the vertex layout.
+    GLuint vertexArray{};
+
+    // OcclusionStats counters of the last cull, read back at the start of the next one.
+    GLuint statsBuffer{};
+    bool statsPending{};
+};
+
+struct MeshletCullingContext
+{
+    GLuint cullProgram{};
+
+    GLint frustumPlanesUniform{};
+    GLint cameraPositionUniform{};
+    GLint firstMeshletUniform{};
+    GLint meshletCountUniform{};
+    GLint coneCullingUniform{};
+    GLint modelViewProjectionUniform{};
+    GLint objectSphereUniform{};
+    GLint hiZCullingUniform{};
+    GLint depthSizeUniform{};
+
+    // Meshlet bounds as shader storage.
+    GLuint meshletBuffer{};
+    GLuint meshletCount{};
+
+    // Uncompacted mesh indices read by the cull shader.
+    GLuint sourceIndexBuffer{};
+
+    MeshletCullOutput outputs[meshletCullPassCount]{};
+
+    // Counters of each pass from the previous cull.
+    OcclusionStats stats[meshletCullPassCount]{};
+
+    bool coneCulling{ true };
+    bool hiZCulling{ true };
+};
+
+// Starts compiling the cull program so createMeshletCulling does not wait for the whole compile.
+void submitMeshletCullingProgram() noexcept;
+
+// Uploads the meshlets and allocates outputs large enough for maxIndexCount indices.
+MeshletCullingContext createMeshletCulling(const std::vector<Meshlet>& meshlets, GLuint sourceIndexBuffer, GLsizei maxIndexCount) noexcept;
+
+// Dispatches the cull shader over the meshlet range and writes the compacted output of the pass.
+// The object sphere (center, radius) and the meshlets are tested against the pyramid when it is built.
+// Leaves the cull program bound, the caller binds its own.
+void cullMeshlets(MeshletCullingContext& context, MeshletCullPass pass, const GLfloat* modelViewProjection, const GLfloat* objectSphere, unsigned int firstMeshlet, unsigned int meshletCount, const HiZPyramid* hiZPyramid) noexcept;
+
+// Draws the compacted output of the pass with the currently bound program.
+void drawCulledMeshlets(const MeshletCullingContext& context, MeshletCullPass pass) noexcept;
+
+#endif
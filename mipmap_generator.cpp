@@ -0,0 +1,465 @@
+#include <mipmap_generator.hpp>
+#include <job_system.hpp>
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr int kaiserTapCount = 8;
+constexpr float kaiserAlpha = 4.0f;
+
+// A level is split into jobs of at least this many texels.
+constexpr unsigned int texelsPerJob = 16 * 1024;
+
+struct SrgbTables
+{
+    float toLinear[256];
+
+    // Indexed by the linear value in 12 bits.
+    unsigned char fromLinear[4096];
+};
+
+// Source and destination of one pass, texels are linear RGBA floats.
+struct MipPass
+{
+    const float* source{};
+    GLsizei sourceWidth{};
+    GLsizei sourceHeight{};
+
+    float* destination{};
+    GLsizei destinationWidth{};
+
+    const float* weights{};
+
+    // Encoded texels read by the decode pass and written by the encode pass.
+    unsigned char* texels{};
+    bool isSrgb{};
+};
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+SrgbTables createSrgbTables() noexcept
+{
+    SrgbTables tables;
+
+    for (int i = 0; i < 256; ++i)
+    {
+        const float value = static_cast<float>(i) / 255.0f;
+
+        tables.toLinear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (int i = 0; i < 4096; ++i)
+    {
+        const float value = static_cast<float>(i) / 4095.0f;
+        const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+
+        tables.fromLinear[i] = static_cast<unsigned char>(encoded * 255.0f + 0.5f);
+    }
+
+    return tables;
+}
+
+const SrgbTables& getSrgbTables() noexcept
+{
+    static const SrgbTables tables = createSrgbTables();
+
+    return tables;
+}
+
+// Zeroth order modified Bessel function of the first kind.
+float getBesselI0(float x) noexcept
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+
+    for (int k = 1; k < 16; ++k)
+    {
+        const float factor = x / (2.0f * static_cast<float>(k));
+        term *= factor * factor;
+        sum += term;
+    }
+
+    return sum;
+}
+
+// Taps at source texels 2x - 3 to 2x + 4 for destination texel x, the same for every texel at a factor of two.
+void getKaiserWeights(float* weights) noexcept
+{
+    constexpr float pi = 3.14159265358979f;
+    constexpr float radius = kaiserTapCount / 4.0f;
+
+    float sum = 0.0f;
+
+    for (int i = 0; i < kaiserTapCount; ++i)
+    {
+        // Distance in destination texels between the tap and the destination center.
+        const float t = (static_cast<float>(i) - 3.5f) * 0.5f;
+        const float sinc = sinf(pi * t) / (pi * t);
+        const float window = t / radius;
+
+        weights[i] = sinc * getBesselI0(kaiserAlpha * sqrtf(1.0f - window * window)) / getBesselI0(kaiserAlpha);
+        sum += weights[i];
+    }
+
+    for (int i = 0; i < kaiserTapCount; ++i)
+    {
+        weights[i] /= sum;
+    }
+}
+
+GLsizei clampTexel(GLsizei index, GLsizei size) noexcept
+{
+    return index < 0 ? 0 : (index >= size ? size - 1 : index);
+}
+
+void decodeRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const MipPass& pass = *static_cast<const MipPass*>(userData);
+    const float* toLinear = getSrgbTables().toLinear;
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        const size_t rowOffset = static_cast<size_t>(y) * static_cast<size_t>(pass.destinationWidth) * 4;
+
+        const unsigned char* texel = pass.texels + rowOffset;
+        float* destination = pass.destination + rowOffset;
+
+        for (GLsizei x = 0; x < pass.destinationWidth; ++x, texel += 4, destination += 4)
+        {
+            const __m128 value = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*reinterpret_cast<const int*>(texel))));
+            __m128 linear = _mm_mul_ps(value, _mm_set1_ps(1.0f / 255.0f));
+
+            if (pass.isSrgb)
+            {
+                // Alpha is stored linear.
+                linear = _mm_setr_ps(toLinear[texel[0]], toLinear[texel[1]], toLinear[texel[2]], _mm_cvtss_f32(_mm_shuffle_ps(linear, linear, _MM_SHUFFLE(3, 3, 3, 3))));
+            }
+
+            _mm_storeu_ps(destination, linear);
+        }
+    }
+}
+
+void encodeRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const MipPass& pass = *static_cast<const MipPass*>(userData);
+    const unsigned char* fromLinear = getSrgbTables().fromLinear;
+
+    // The table covers the color channels of sRGB images, alpha is always scaled to 255.
+    const __m128 scale = pass.isSrgb ? _mm_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f) : _mm_set1_ps(255.0f);
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        const size_t rowOffset = static_cast<size_t>(y) * static_cast<size_t>(pass.destinationWidth) * 4;
+
+        const float* source = pass.source + rowOffset;
+        unsigned char* texel = pass.texels + rowOffset;
+
+        for (GLsizei x = 0; x < pass.destinationWidth; ++x, source += 4, texel += 4)
+        {
+            // The Kaiser lobes can overshoot.
+            const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            const __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+
+            if (pass.isSrgb)
+            {
+                alignas(16) int indices[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices), quantized);
+
+                texel[0] = fromLinear[indices[0]];
+                texel[1] = fromLinear[indices[1]];
+                texel[2] = fromLinear[indices[2]];
+                texel[3] = static_cast<unsigned char>(indices[3]);
+            }
+            else
+            {
+                const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(quantized, quantized), quantized);
+                *reinterpret_cast<int*>(texel) = _mm_cvtsi128_si32(packed);
+            }
+        }
+    }
+}
+
+void boxFilterRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const MipPass& pass = *static_cast<const MipPass*>(userData);
+    const size_t sourceStride = static_cast<size_t>(pass.sourceWidth) * 4;
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        // Odd sizes repeat the last row or column.
+        const float* row0 = pass.source + static_cast<size_t>(clampTexel(2 * static_cast<GLsizei>(y), pass.sourceHeight)) * sourceStride;
+        const float* row1 = pass.source + static_cast<size_t>(clampTexel(2 * static_cast<GLsizei>(y) + 1, pass.sourceHeight)) * sourceStride;
+        float* destination = pass.destination + static_cast<size_t>(y) * static_cast<size_t>(pass.destinationWidth) * 4;
+
+        GLsizei x = 0;
+
+#if defined(__AVX__)
+        // Two destination texels from four source texels of each row.
+        for (; x + 1 < pass.destinationWidth && 2 * x + 3 < pass.sourceWidth; x += 2)
+        {
+            const __m256 sum01 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x), _mm256_loadu_ps(row1 + 8 * x));
+            const __m256 sum23 = _mm256_add_ps(_mm256_loadu_ps(row0 + 8 * x + 8), _mm256_loadu_ps(row1 + 8 * x + 8));
+
+            // [0 + 1, 2 + 3] from [0, 1] and [2, 3].
+            const __m256 even = _mm256_permute2f128_ps(sum01, sum23, 0x20);
+            const __m256 odd = _mm256_permute2f128_ps(sum01, sum23, 0x31);
+
+            _mm256_storeu_ps(destination + 4 * x, _mm256_mul_ps(_mm256_add_ps(even, odd), _mm256_set1_ps(0.25f)));
+        }
+#endif
+
+        for (; x < pass.destinationWidth; ++x)
+        {
+            const size_t x0 = static_cast<size_t>(clampTexel(2 * x, pass.sourceWidth)) * 4;
+            const size_t x1 = static_cast<size_t>(clampTexel(2 * x + 1, pass.sourceWidth)) * 4;
+
+            const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)), _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+
+            _mm_storeu_ps(destination + 4 * x, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+        }
+    }
+}
+
+// Halves the width, every source row to one row of the same height.
+void kaiserFilterColumns(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const MipPass& pass = *static_cast<const MipPass*>(userData);
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        const float* row = pass.source + static_cast<size_t>(y) * static_cast<size_t>(pass.sourceWidth) * 4;
+        float* destination = pass.destination + static_cast<size_t>(y) * static_cast<size_t>(pass.destinationWidth) * 4;
+
+        for (GLsizei x = 0; x < pass.destinationWidth; ++x)
+        {
+            __m128 sum = _mm_setzero_ps();
+
+            for (int i = 0; i < kaiserTapCount; ++i)
+            {
+                const float* texel = row + static_cast<size_t>(clampTexel(2 * x - 3 + i, pass.sourceWidth)) * 4;
+
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(pass.weights[i])));
+            }
+
+            _mm_storeu_ps(destination + 4 * x, sum);
+        }
+    }
+}
+
+// Halves the height of the column pass output, whole rows are weighted at once.
+void kaiserFilterRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const MipPass& pass = *static_cast<const MipPass*>(userData);
+    const size_t rowSize = static_cast<size_t>(pass.sourceWidth) * 4;
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        const float* rows[kaiserTapCount];
+
+        for (int i = 0; i < kaiserTapCount; ++i)
+        {
+            rows[i] = pass.source + static_cast<size_t>(clampTexel(2 * static_cast<GLsizei>(y) - 3 + i, pass.sourceHeight)) * rowSize;
+        }
+
+        float* destination = pass.destination + static_cast<size_t>(y) * rowSize;
+
+        size_t offset = 0;
+
+#if defined(__AVX__)
+        for (; offset + 8 <= rowSize; offset += 8)
+        {
+            __m256 sum = _mm256_setzero_ps();
+
+            for (int i = 0; i < kaiserTapCount; ++i)
+            {
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[i] + offset), _mm256_set1_ps(pass.weights[i])));
+            }
+
+            _mm256_storeu_ps(destination + offset, sum);
+        }
+#endif
+
+        for (; offset < rowSize; offset += 4)
+        {
+            __m128 sum = _mm_setzero_ps();
+
+            for (int i = 0; i < kaiserTapCount; ++i)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[i] + offset), _mm_set1_ps(pass.weights[i])));
+            }
+
+            _mm_storeu_ps(destination + offset, sum);
+        }
+    }
+}
+
+void runRows(JobSystem* jobSystem, ParallelForFunction* function, MipPass& pass, GLsizei rowCount, GLsizei rowWidth) noexcept
+{
+    if (!jobSystem)
+    {
+        function(&pass, 0, static_cast<unsigned int>(rowCount));
+        return;
+    }
+
+    const unsigned int grain = static_cast<unsigned int>(rowWidth) >= texelsPerJob ? 1 : texelsPerJob / static_cast<unsigned int>(rowWidth);
+
+    parallelFor(*jobSystem, function, &pass, static_cast<unsigned int>(rowCount), grain);
+}
+}
+
+void generateMipChain(TextureImage& image, MipFilter filter, JobSystem* jobSystem) noexcept
+{
+    assert(image.width > 0 && image.height > 0);
+    assert(!getTextureFormatInfo(image.internalFormat).isCompressed && !image.file.data);
+    assert(image.pixels.size() >= getTextureLevelByteCount(image, 0));
+
+    const bool isSrgb = getTextureFormatInfo(image.internalFormat).isSrgb;
+
+    image.levelCount = getFullMipLevelCount(image.width, image.height);
+    image.pixels.resize(getTextureLevelOffset(image, image.levelCount));
+
+    float weights[kaiserTapCount];
+    getKaiserWeights(weights);
+
+    std::vector<float> source(static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * 4);
+    std::vector<float> destination;
+    std::vector<float> columns;
+
+    MipPass decode;
+    decode.destination = source.data();
+    decode.destinationWidth = image.width;
+    decode.texels = image.pixels.data();
+    decode.isSrgb = isSrgb;
+
+    runRows(jobSystem, decodeRows, decode, image.height, image.width);
+
+    for (GLsizei level = 1; level < image.levelCount; ++level)
+    {
+        const GLsizei sourceWidth = getMipLevelSize(image.width, level - 1);
+        const GLsizei sourceHeight = getMipLevelSize(image.height, level - 1);
+        const GLsizei width = getMipLevelSize(image.width, level);
+        const GLsizei height = getMipLevelSize(image.height, level);
+
+        destination.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+        if (filter == mipFilterKaiser)
+        {
+            columns.resize(static_cast<size_t>(width) * static_cast<size_t>(sourceHeight) * 4);
+
+            MipPass columnPass;
+            columnPass.source = source.data();
+            columnPass.sourceWidth = sourceWidth;
+            columnPass.sourceHeight = sourceHeight;
+            columnPass.destination = columns.data();
+            columnPass.destinationWidth = width;
+            columnPass.weights = weights;
+
+            runRows(jobSystem, kaiserFilterColumns, columnPass, sourceHeight, width);
+
+            MipPass rowPass;
+            rowPass.source = columns.data();
+            rowPass.sourceWidth = width;
+            rowPass.sourceHeight = sourceHeight;
+            rowPass.destination = destination.data();
+            rowPass.destinationWidth = width;
+            rowPass.weights = weights;
+
+            runRows(jobSystem, kaiserFilterRows, rowPass, height, width);
+        }
+        else
+        {
+            MipPass boxPass;
+            boxPass.source = source.data();
+            boxPass.sourceWidth = sourceWidth;
+            boxPass.sourceHeight = sourceHeight;
+            boxPass.destination = destination.data();
+            boxPass.destinationWidth = width;
+
+            runRows(jobSystem, boxFilterRows, boxPass, height, width);
+        }
+
+        MipPass encode;
+        encode.source = destination.data();
+        encode.destinationWidth = width;
+        encode.texels = image.pixels.data() + getTextureLevelOffset(image, level);
+        encode.isSrgb = isSrgb;
+
+        runRows(jobSystem, encodeRows, encode, height, width);
+
+        // The next level filters the unquantized texels.
+        std::swap(source, destination);
+    }
+}
+
+void benchmarkMipGeneration() noexcept
+{
+    constexpr GLsizei size = 2048;
+    constexpr unsigned int iterations = 4;
+
+    TextureImage sourceImage;
+    sourceImage.width = size;
+    sourceImage.height = size;
+    sourceImage.internalFormat = GL_SRGB8_ALPHA8;
+    sourceImage.pixels.resize(getTextureLevelByteCount(sourceImage, 0));
+
+    unsigned int random = 12345;
+
+    for (unsigned char& value : sourceImage.pixels)
+    {
+        random = random * 1664525u + 1013904223u;
+        value = static_cast<unsigned char>(random >> 24);
+    }
+
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    print("Mip generation, %dx%d sRGB, %u iterations:\n", size, size, iterations);
+
+    for (const MipFilter filter : { mipFilterBox, mipFilterKaiser })
+    {
+        for (unsigned int threadCount = 1; ; threadCount = threadCount * 2 < coreCount ? threadCount * 2 : coreCount)
+        {
+            JobSystem* jobSystem = threadCount > 1 ? createJobSystem(threadCount - 1) : nullptr;
+
+            double bestSeconds = 1e9;
+
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                TextureImage image = sourceImage;
+
+                const double start = getSeconds();
+                generateMipChain(image, filter, jobSystem);
+                const double seconds = getSeconds() - start;
+
+                bestSeconds = seconds < bestSeconds ? seconds : bestSeconds;
+            }
+
+            if (jobSystem)
+            {
+                destroyJobSystem(jobSystem);
+            }
+
+            print("    %s, %2u threads: %8.3f ms\n", filter == mipFilterBox ? "box   " : "kaiser", threadCount, bestSeconds * 1000.0);
+
+            if (threadCount == coreCount)
+            {
+                break;
+            }
+        }
+    }
+}
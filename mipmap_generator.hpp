@@ -0,0 +1,24 @@
+#ifndef KZ_MIPMAP_GENERATOR_HPP
+#define KZ_MIPMAP_GENERATOR_HPP
+
+#include <texture_image.hpp>
+
+struct JobSystem;
+
+enum MipFilter : unsigned int
+{
+    // 2x2 average, the fastest.
+    mipFilterBox,
+
+    // 8 tap Kaiser-windowed sinc, keeps detail sharper at each level.
+    mipFilterKaiser,
+};
+
+// Replaces all levels after 0 with the full chain down to 1x1, filtered in linear space when the image is sRGB.
+// The rows of each level are split over the job system when one is given.
+void generateMipChain(TextureImage& image, MipFilter filter, JobSystem* jobSystem) noexcept;
+
+// Box and Kaiser chains of a 2048x2048 image from one to all cores.
+void benchmarkMipGeneration() noexcept;
+
+#endif
@@ -0,0 +1,594 @@
+#include <procedural_texture.hpp>
+#include <job_system.hpp>
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+void print(const char* format, ...);
+
+namespace
+{
+// A texture is split into jobs of at least this many texels.
+constexpr unsigned int texelsPerJob = 16 * 1024;
+
+struct ProceduralPass
+{
+    const ProceduralTextureDesc* desc{};
+
+    // Layers below come from the base texels.
+    int firstLayer{};
+
+    // Set when the composite below the top layer is stored for later updates.
+    bool writesBase{};
+    unsigned char* baseTexels{};
+
+    unsigned char* texels{};
+};
+
+// What a layer needs of the row being drawn.
+struct LayerRow
+{
+    float cellCount{};
+
+    int checkerCellRow{};
+
+    float gradientColumnScale{};
+    float gradientRowOffset{};
+
+    float gridCellWidth{};
+    float gridHalfLineWidth{};
+    float gridRowCoverage{};
+
+    // Hashed lattice rows above and below, and the weight of the one below, of each octave.
+    int octaveCount{};
+    uint32_t noiseHashedRows[maxNoiseOctaveCount][2]{};
+    float noiseRowWeights[maxNoiseOctaveCount]{};
+    float noiseScale{};
+};
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+bool isSameLayer(const ProceduralLayer& a, const ProceduralLayer& b) noexcept
+{
+    return a.pattern == b.pattern && a.firstColor == b.firstColor && a.secondColor == b.secondColor && a.opacity == b.opacity &&
+           a.cellCount == b.cellCount && a.lineWidth == b.lineWidth && a.octaveCount == b.octaveCount && a.seed == b.seed && a.angle == b.angle;
+}
+
+float clampUnit(float value) noexcept
+{
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+float getSmoothstep(float t) noexcept
+{
+    return t * t * (3.0f - 2.0f * t);
+}
+
+uint32_t hashNoiseRow(uint32_t latticeRow, uint32_t seed, int octave) noexcept
+{
+    return latticeRow * 0xD8163841u ^ (seed * 0x9E3779B1u + static_cast<uint32_t>(octave) * 0x85EBCA6Bu);
+}
+
+// Lattice value in [0, 1].
+float getNoiseLatticeValue(uint32_t latticeColumn, uint32_t hashedRow) noexcept
+{
+    uint32_t hash = latticeColumn * 0x8DA6B343u ^ hashedRow;
+
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+
+    return static_cast<float>(hash >> 8) * (1.0f / 16777215.0f);
+}
+
+LayerRow createLayerRow(const ProceduralLayer& layer, GLsizei width, GLsizei height, GLsizei y) noexcept
+{
+    LayerRow row;
+
+    const int cellCount = layer.cellCount > 1 ? layer.cellCount : 1;
+    const float v = (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+
+    row.cellCount = static_cast<float>(cellCount);
+
+    switch (layer.pattern)
+    {
+        case proceduralChecker:
+            row.checkerCellRow = static_cast<int>(v * row.cellCount);
+            break;
+
+        case proceduralGradient:
+        {
+            // Scaled so the ramp just reaches both colors at the far corners.
+            const float c = cosf(layer.angle);
+            const float s = sinf(layer.angle);
+            const float scale = 1.0f / (fabsf(c) + fabsf(s));
+
+            row.gradientColumnScale = c * scale;
+            row.gradientRowOffset = (v - 0.5f) * s * scale + 0.5f - 0.5f * c * scale;
+            break;
+        }
+
+        case proceduralGrid:
+        {
+            const float cellHeight = static_cast<float>(height) / row.cellCount;
+            const float cellY = v * row.cellCount - floorf(v * row.cellCount);
+            const float distance = (cellY < 1.0f - cellY ? cellY : 1.0f - cellY) * cellHeight;
+
+            row.gridCellWidth = static_cast<float>(width) / row.cellCount;
+            row.gridHalfLineWidth = layer.lineWidth * row.gridCellWidth * 0.5f;
+            row.gridRowCoverage = clampUnit(layer.lineWidth * cellHeight * 0.5f + 0.5f - distance);
+            break;
+        }
+
+        case proceduralNoise:
+        {
+            row.octaveCount = layer.octaveCount < 1 ? 1 : (layer.octaveCount > maxNoiseOctaveCount ? maxNoiseOctaveCount : layer.octaveCount);
+
+            float amplitudeSum = 0.0f;
+
+            for (int octave = 0; octave < row.octaveCount; ++octave)
+            {
+                // The lattice wraps at the period, so the noise tiles.
+                const int period = cellCount << octave;
+                const float latticeY = v * static_cast<float>(period);
+                const int row0 = static_cast<int>(latticeY) < period - 1 ? static_cast<int>(latticeY) : period - 1;
+                const int row1 = row0 + 1 == period ? 0 : row0 + 1;
+
+                row.noiseHashedRows[octave][0] = hashNoiseRow(static_cast<uint32_t>(row0), layer.seed, octave);
+                row.noiseHashedRows[octave][1] = hashNoiseRow(static_cast<uint32_t>(row1), layer.seed, octave);
+                row.noiseRowWeights[octave] = getSmoothstep(clampUnit(latticeY - static_cast<float>(row0)));
+
+                amplitudeSum += 1.0f / static_cast<float>(1 << octave);
+            }
+
+            row.noiseScale = 1.0f / amplitudeSum;
+            break;
+        }
+    }
+
+    return row;
+}
+
+// Mix between the layer colors and coverage of the layer at horizontal position u.
+void evaluateLayer(const ProceduralLayer& layer, const LayerRow& row, float u, float& mix, float& coverage) noexcept
+{
+    mix = 0.0f;
+    coverage = 1.0f;
+
+    switch (layer.pattern)
+    {
+        case proceduralChecker:
+            mix = static_cast<float>((static_cast<int>(u * row.cellCount) + row.checkerCellRow) & 1);
+            break;
+
+        case proceduralGradient:
+            mix = clampUnit(u * row.gradientColumnScale + row.gradientRowOffset);
+            break;
+
+        case proceduralGrid:
+        {
+            const float cellX = u * row.cellCount - floorf(u * row.cellCount);
+            const float distance = (cellX < 1.0f - cellX ? cellX : 1.0f - cellX) * row.gridCellWidth;
+            const float columnCoverage = clampUnit(row.gridHalfLineWidth + 0.5f - distance);
+
+            coverage = columnCoverage > row.gridRowCoverage ? columnCoverage : row.gridRowCoverage;
+            break;
+        }
+
+        case proceduralNoise:
+        {
+            float sum = 0.0f;
+
+            for (int octave = 0; octave < row.octaveCount; ++octave)
+            {
+                const int period = static_cast<int>(row.cellCount) << octave;
+                const float latticeX = u * static_cast<float>(period);
+                const int column0 = static_cast<int>(latticeX) < period - 1 ? static_cast<int>(latticeX) : period - 1;
+                const int column1 = column0 + 1 == period ? 0 : column0 + 1;
+                const float weight = getSmoothstep(clampUnit(latticeX - static_cast<float>(column0)));
+
+                const float top0 = getNoiseLatticeValue(static_cast<uint32_t>(column0), row.noiseHashedRows[octave][0]);
+                const float top1 = getNoiseLatticeValue(static_cast<uint32_t>(column1), row.noiseHashedRows[octave][0]);
+                const float bottom0 = getNoiseLatticeValue(static_cast<uint32_t>(column0), row.noiseHashedRows[octave][1]);
+                const float bottom1 = getNoiseLatticeValue(static_cast<uint32_t>(column1), row.noiseHashedRows[octave][1]);
+
+                const float top = top0 + (top1 - top0) * weight;
+                const float bottom = bottom0 + (bottom1 - bottom0) * weight;
+
+                sum += (top + (bottom - top) * row.noiseRowWeights[octave]) / static_cast<float>(1 << octave);
+            }
+
+            mix = sum * row.noiseScale;
+            break;
+        }
+    }
+}
+
+#if defined(__AVX2__)
+__m256 clampUnit8(__m256 value) noexcept
+{
+    return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+__m256 getSmoothstep8(__m256 t) noexcept
+{
+    return _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_add_ps(t, t)));
+}
+
+__m256 getNoiseLatticeValue8(__m256i latticeColumns, uint32_t hashedRow) noexcept
+{
+    __m256i hash = _mm256_xor_si256(_mm256_mullo_epi32(latticeColumns, _mm256_set1_epi32(static_cast<int>(0x8DA6B343u))), _mm256_set1_epi32(static_cast<int>(hashedRow)));
+
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+    hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32(0x2C1B3C6D));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 12));
+
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(hash, 8)), _mm256_set1_ps(1.0f / 16777215.0f));
+}
+
+// evaluateLayer of eight texels.
+void evaluateLayer8(const ProceduralLayer& layer, const LayerRow& row, __m256 u, __m256& mix, __m256& coverage) noexcept
+{
+    mix = _mm256_setzero_ps();
+    coverage = _mm256_set1_ps(1.0f);
+
+    switch (layer.pattern)
+    {
+        case proceduralChecker:
+        {
+            const __m256i cellColumns = _mm256_cvttps_epi32(_mm256_mul_ps(u, _mm256_set1_ps(row.cellCount)));
+            const __m256i parity = _mm256_and_si256(_mm256_add_epi32(cellColumns, _mm256_set1_epi32(row.checkerCellRow)), _mm256_set1_epi32(1));
+
+            mix = _mm256_cvtepi32_ps(parity);
+            break;
+        }
+
+        case proceduralGradient:
+            mix = clampUnit8(_mm256_add_ps(_mm256_mul_ps(u, _mm256_set1_ps(row.gradientColumnScale)), _mm256_set1_ps(row.gradientRowOffset)));
+            break;
+
+        case proceduralGrid:
+        {
+            const __m256 cellPosition = _mm256_mul_ps(u, _mm256_set1_ps(row.cellCount));
+            const __m256 cellX = _mm256_sub_ps(cellPosition, _mm256_floor_ps(cellPosition));
+            const __m256 distance = _mm256_mul_ps(_mm256_min_ps(cellX, _mm256_sub_ps(_mm256_set1_ps(1.0f), cellX)), _mm256_set1_ps(row.gridCellWidth));
+            const __m256 columnCoverage = clampUnit8(_mm256_sub_ps(_mm256_set1_ps(row.gridHalfLineWidth + 0.5f), distance));
+
+            coverage = _mm256_max_ps(columnCoverage, _mm256_set1_ps(row.gridRowCoverage));
+            break;
+        }
+
+        case proceduralNoise:
+        {
+            __m256 sum = _mm256_setzero_ps();
+
+            for (int octave = 0; octave < row.octaveCount; ++octave)
+            {
+                const int period = static_cast<int>(row.cellCount) << octave;
+                const __m256 latticeX = _mm256_mul_ps(u, _mm256_set1_ps(static_cast<float>(period)));
+                const __m256i column0 = _mm256_min_epi32(_mm256_cvttps_epi32(latticeX), _mm256_set1_epi32(period - 1));
+                const __m256i nextColumn = _mm256_add_epi32(column0, _mm256_set1_epi32(1));
+                const __m256i column1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(nextColumn, _mm256_set1_epi32(period)), nextColumn);
+                const __m256 weight = getSmoothstep8(clampUnit8(_mm256_sub_ps(latticeX, _mm256_cvtepi32_ps(column0))));
+
+                const __m256 top0 = getNoiseLatticeValue8(column0, row.noiseHashedRows[octave][0]);
+                const __m256 top1 = getNoiseLatticeValue8(column1, row.noiseHashedRows[octave][0]);
+                const __m256 bottom0 = getNoiseLatticeValue8(column0, row.noiseHashedRows[octave][1]);
+                const __m256 bottom1 = getNoiseLatticeValue8(column1, row.noiseHashedRows[octave][1]);
+
+                const __m256 top = _mm256_add_ps(top0, _mm256_mul_ps(_mm256_sub_ps(top1, top0), weight));
+                const __m256 bottom = _mm256_add_ps(bottom0, _mm256_mul_ps(_mm256_sub_ps(bottom1, bottom0), weight));
+                const __m256 value = _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), _mm256_set1_ps(row.noiseRowWeights[octave])));
+
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(value, _mm256_set1_ps(1.0f / static_cast<float>(1 << octave))));
+            }
+
+            mix = _mm256_mul_ps(sum, _mm256_set1_ps(row.noiseScale));
+            break;
+        }
+    }
+}
+#endif
+
+// Channels are planar floats in 0-255, padded to a multiple of eight texels.
+void drawLayerRow(const ProceduralLayer& layer, GLsizei width, GLsizei height, GLsizei y, float* const* channels) noexcept
+{
+    const LayerRow row = createLayerRow(layer, width, height, y);
+    const float inverseWidth = 1.0f / static_cast<float>(width);
+
+    float firstColor[3];
+    float colorDifference[3];
+
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        const int shift = 16 - channel * 8;
+
+        firstColor[channel] = static_cast<float>((layer.firstColor >> shift) & 0xff);
+        colorDifference[channel] = static_cast<float>((layer.secondColor >> shift) & 0xff) - firstColor[channel];
+    }
+
+    GLsizei x = 0;
+
+#if defined(__AVX2__)
+    const __m256 texelCenters = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+    // The padding texels are drawn too.
+    for (; x < width; x += 8)
+    {
+        const __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), texelCenters), _mm256_set1_ps(inverseWidth));
+
+        __m256 mix, coverage;
+        evaluateLayer8(layer, row, u, mix, coverage);
+
+        const __m256 weight = _mm256_mul_ps(coverage, _mm256_set1_ps(layer.opacity));
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const __m256 color = _mm256_add_ps(_mm256_set1_ps(firstColor[channel]), _mm256_mul_ps(mix, _mm256_set1_ps(colorDifference[channel])));
+            const __m256 below = _mm256_loadu_ps(channels[channel] + x);
+
+            _mm256_storeu_ps(channels[channel] + x, _mm256_add_ps(below, _mm256_mul_ps(_mm256_sub_ps(color, below), weight)));
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        float mix, coverage;
+        evaluateLayer(layer, row, (static_cast<float>(x) + 0.5f) * inverseWidth, mix, coverage);
+
+        const float weight = coverage * layer.opacity;
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const float color = firstColor[channel] + mix * colorDifference[channel];
+            float& below = channels[channel][x];
+
+            below += (color - below) * weight;
+        }
+    }
+}
+
+void unpackRow(const unsigned char* texels, float* const* channels, GLsizei width) noexcept
+{
+    GLsizei x = 0;
+
+#if defined(__AVX2__)
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(texels + x * 4));
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const __m256i value = _mm256_and_si256(_mm256_srli_epi32(packed, channel * 8), _mm256_set1_epi32(0xff));
+            _mm256_storeu_ps(channels[channel] + x, _mm256_cvtepi32_ps(value));
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            channels[channel][x] = static_cast<float>(texels[x * 4 + channel]);
+        }
+    }
+}
+
+// RGBA8 with opaque alpha, rounded like PackRGBA.
+void packRow(float* const* channels, unsigned char* texels, GLsizei width) noexcept
+{
+    GLsizei x = 0;
+
+#if defined(__AVX2__)
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i packed = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(channels[channel] + x), _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+            packed = _mm256_or_si256(packed, _mm256_slli_epi32(_mm256_cvtps_epi32(value), channel * 8));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + x * 4), packed);
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const float value = channels[channel][x];
+            texels[x * 4 + channel] = static_cast<unsigned char>(value < 0.0f ? 0 : (value > 255.0f ? 255 : static_cast<int>(value + 0.5f)));
+        }
+
+        texels[x * 4 + 3] = 255;
+    }
+}
+
+void generateRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const ProceduralPass& pass = *static_cast<const ProceduralPass*>(userData);
+    const ProceduralTextureDesc& desc = *pass.desc;
+
+    const size_t paddedWidth = (static_cast<size_t>(desc.width) + 7) & ~size_t(7);
+
+    std::vector<float> row(paddedWidth * 3);
+    float* const channels[3] = { row.data(), row.data() + paddedWidth, row.data() + paddedWidth * 2 };
+
+    for (unsigned int y = begin; y < end; ++y)
+    {
+        const size_t rowOffset = static_cast<size_t>(y) * static_cast<size_t>(desc.width) * 4;
+
+        if (pass.firstLayer > 0)
+        {
+            unpackRow(pass.baseTexels + rowOffset, channels, desc.width);
+        }
+        else
+        {
+            std::fill(row.begin(), row.end(), 0.0f);
+        }
+
+        for (int layer = pass.firstLayer; layer < desc.layerCount; ++layer)
+        {
+            // Continues from the stored bytes, so redrawing only the top layer later gives the same texels.
+            if (pass.writesBase && layer == desc.layerCount - 1)
+            {
+                packRow(channels, pass.baseTexels + rowOffset, desc.width);
+                unpackRow(pass.baseTexels + rowOffset, channels, desc.width);
+            }
+
+            drawLayerRow(desc.layers[layer], desc.width, desc.height, static_cast<GLsizei>(y), channels);
+        }
+
+        packRow(channels, pass.texels + rowOffset, desc.width);
+    }
+}
+
+ProceduralTextureDesc createBenchmarkDesc(GLsizei size) noexcept
+{
+    ProceduralTextureDesc desc;
+    desc.width = size;
+    desc.height = size;
+    desc.layerCount = 4;
+
+    desc.layers[0].pattern = proceduralGradient;
+    desc.layers[0].firstColor = 0x203040;
+    desc.layers[0].secondColor = 0xc0d0e0;
+    desc.layers[0].angle = 0.5f;
+
+    desc.layers[1].pattern = proceduralNoise;
+    desc.layers[1].firstColor = 0x000000;
+    desc.layers[1].secondColor = 0xffffff;
+    desc.layers[1].opacity = 0.5f;
+    desc.layers[1].cellCount = 16;
+    desc.layers[1].octaveCount = 5;
+
+    desc.layers[2].pattern = proceduralChecker;
+    desc.layers[2].firstColor = 0xccaa44;
+    desc.layers[2].opacity = 0.25f;
+
+    desc.layers[3].pattern = proceduralGrid;
+    desc.layers[3].firstColor = 0x101010;
+    desc.layers[3].cellCount = 32;
+
+    return desc;
+}
+}
+
+bool updateProceduralTexture(ProceduralTexture& texture, const ProceduralTextureDesc& desc, JobSystem* jobSystem) noexcept
+{
+    assert(desc.width > 0 && desc.height > 0);
+    assert(desc.layerCount > 0 && desc.layerCount <= maxProceduralLayerCount);
+
+    const bool isSameSize = texture.isGenerated && texture.desc.width == desc.width && texture.desc.height == desc.height;
+
+    int firstChangedLayer = 0;
+
+    while (isSameSize && firstChangedLayer < desc.layerCount && firstChangedLayer < texture.desc.layerCount &&
+           isSameLayer(texture.desc.layers[firstChangedLayer], desc.layers[firstChangedLayer]))
+    {
+        ++firstChangedLayer;
+    }
+
+    const bool isSameLayerCount = texture.desc.layerCount == desc.layerCount;
+
+    if (isSameSize && isSameLayerCount && firstChangedLayer == desc.layerCount)
+    {
+        return false;
+    }
+
+    const double start = getSeconds();
+
+    const int topLayer = desc.layerCount - 1;
+    const size_t byteCount = static_cast<size_t>(desc.width) * static_cast<size_t>(desc.height) * textureTexelSize;
+
+    // Level 0 only, with capacity for the mip chain so generating it does not move the texels.
+    TextureImage& image = texture.image;
+    image.width = desc.width;
+    image.height = desc.height;
+    image.levelCount = getFullMipLevelCount(desc.width, desc.height);
+    image.internalFormat = GL_RGBA8;
+    image.pixels.reserve(getTextureLevelOffset(image, image.levelCount));
+    image.levelCount = 1;
+    image.pixels.resize(byteCount);
+
+    texture.baseTexels.resize(topLayer > 0 ? byteCount : 0);
+
+    ProceduralPass pass;
+    pass.desc = &desc;
+    pass.firstLayer = isSameSize && isSameLayerCount && firstChangedLayer >= topLayer ? topLayer : 0;
+    pass.writesBase = pass.firstLayer == 0 && topLayer > 0;
+    pass.baseTexels = texture.baseTexels.data();
+    pass.texels = image.pixels.data();
+
+    const unsigned int rowsPerJob = texelsPerJob / static_cast<unsigned int>(desc.width);
+
+    if (jobSystem)
+    {
+        parallelFor(*jobSystem, generateRows, &pass, static_cast<unsigned int>(desc.height), rowsPerJob > 0 ? rowsPerJob : 1);
+    }
+    else
+    {
+        generateRows(&pass, 0, static_cast<unsigned int>(desc.height));
+    }
+
+    texture.desc = desc;
+    texture.isGenerated = true;
+    texture.drawnLayerCount = desc.layerCount - pass.firstLayer;
+    texture.seconds = getSeconds() - start;
+
+    return true;
+}
+
+void benchmarkProceduralTextures() noexcept
+{
+    constexpr GLsizei size = 4096;
+
+    const ProceduralTextureDesc desc = createBenchmarkDesc(size);
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    print("Procedural textures, %dx%d with %d layers:\n", size, size, desc.layerCount);
+
+    for (unsigned int threadCount = 1; ; threadCount = threadCount * 2 < coreCount ? threadCount * 2 : coreCount)
+    {
+        JobSystem* jobSystem = threadCount > 1 ? createJobSystem(threadCount - 1) : nullptr;
+
+        ProceduralTexture texture;
+        updateProceduralTexture(texture, desc, jobSystem);
+
+        const double fullSeconds = texture.seconds;
+
+        // Only the grid overlay changes, the layers below come from the base.
+        ProceduralTextureDesc overlayDesc = desc;
+        overlayDesc.layers[desc.layerCount - 1].firstColor = 0xf0f0f0;
+
+        updateProceduralTexture(texture, overlayDesc, jobSystem);
+
+        if (jobSystem)
+        {
+            destroyJobSystem(jobSystem);
+        }
+
+        print("    %2u threads: %8.3f ms, %.1f Mtexels/s, overlay change %8.3f ms\n", threadCount, fullSeconds * 1000.0,
+            static_cast<double>(size) * size / fullSeconds * 1e-6, texture.seconds * 1000.0);
+
+        if (threadCount == coreCount)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef KZ_PROCEDURAL_TEXTURE_HPP
+#define KZ_PROCEDURAL_TEXTURE_HPP
+
+#include <texture_image.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct JobSystem;
+
+enum ProceduralPattern : unsigned char
+{
+    // Cells alternate between the two colors, the top left cell has the first.
+    proceduralChecker,
+
+    // Fractal value noise between the two colors.
+    proceduralNoise,
+
+    // Ramp from the first to the second color along the angle.
+    proceduralGradient,
+
+    // Antialiased lines in the first color on the cell borders, the layers below show between them.
+    proceduralGrid,
+};
+
+constexpr int maxProceduralLayerCount = 8;
+constexpr int maxNoiseOctaveCount = 8;
+
+struct ProceduralLayer
+{
+    ProceduralPattern pattern{};
+
+    // 0xRRGGBB.
+    unsigned int firstColor{};
+    unsigned int secondColor{ 0xffffff };
+
+    // Blend over the layers below.
+    float opacity{ 1.0f };
+
+    // Checker, grid and noise lattice cells along each side, whole so the patterns tile.
+    int cellCount{ 8 };
+
+    // Grid line width as a fraction of a cell.
+    float lineWidth{ 0.05f };
+
+    // Noise octaves, each of twice the frequency and half the amplitude of the previous one.
+    int octaveCount{ 4 };
+    uint32_t seed{};
+
+    // Gradient direction in radians, 0 runs from left to right.
+    float angle{};
+};
+
+// Layers are drawn bottom first over opaque black.
+struct ProceduralTextureDesc
+{
+    GLsizei width{};
+    GLsizei height{};
+
+    ProceduralLayer layers[maxProceduralLayerCount];
+    int layerCount{};
+};
+
+struct ProceduralTexture
+{
+    // What the image was last generated from.
+    ProceduralTextureDesc desc;
+    bool isGenerated{};
+
+    // Composite of all layers but the top one, so a change of only the top layer, usually an overlay, redraws that layer alone.
+    std::vector<unsigned char> baseTexels;
+
+    // Level 0 in GL_RGBA8 with room for the mip chain. It may be moved out after an update, the next update allocates it again.
+    TextureImage image;
+
+    // Layers drawn and seconds taken by the last update that regenerated.
+    int drawnLayerCount{};
+    double seconds{};
+};
+
+// Regenerates the image when the description changed and returns whether it did.
+// Rows are split over the job system when one is given, eight texels at a time with AVX2.
+bool updateProceduralTexture(ProceduralTexture& texture, const ProceduralTextureDesc& desc, JobSystem* jobSystem) noexcept;
+
+// Four layers at 4096x4096 from one to all cores, then a change of the top layer.
+void benchmarkProceduralTextures() noexcept;
+
+#endif
@@ -0,0 +1,299 @@
+#include <program_cache.hpp>
+#include <mapped_file.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr uint32_t programBinaryMagic = 0x4e42504bu; // "KPBN"
+constexpr uint32_t programBinaryVersion = 1;
+
+// Followed by the binary of the given length.
+struct ProgramBinaryHeader
+{
+    uint32_t magic{};
+    uint32_t version{};
+    uint64_t key{};
+    uint32_t binaryFormat{};
+    uint32_t length{};
+};
+
+struct ProgramCache
+{
+    std::string directory;
+
+    // Seeds every key, changes with the driver.
+    uint64_t driverHash{};
+
+    bool isEnabled{};
+
+    ProgramCacheStats stats;
+};
+
+ProgramCache programCache;
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+// 64-bit FNV-1a, long enough that distinct programs do not share a file.
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) noexcept
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+uint64_t hashString(uint64_t hash, const char* string) noexcept
+{
+    // The terminator separates the strings, so moving text from one to the next changes the key.
+    return hashBytes(hash, string ? string : "", string ? strlen(string) + 1 : 1);
+}
+
+std::string getProgramBinaryPath(uint64_t key) noexcept
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+
+    return programCache.directory + name;
+}
+
+// Returns zero when there is no binary for the key or the driver does not take it.
+GLuint loadProgramBinary(const std::string& path, uint64_t key, bool isSeparable) noexcept
+{
+    MappedFile file = mapFileForReading(path.c_str());
+
+    if (!file.data)
+    {
+        return 0;
+    }
+
+    ProgramBinaryHeader header{};
+
+    if (file.size >= sizeof(header))
+    {
+        memcpy(&header, file.data, sizeof(header));
+    }
+
+    GLuint program = 0;
+
+    if (header.magic == programBinaryMagic && header.version == programBinaryVersion && header.key == key &&
+        header.length > 0 && header.length == file.size - sizeof(header))
+    {
+        program = glCreateProgram();
+
+        if (isSeparable)
+        {
+            glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        }
+
+        glProgramBinary(program, header.binaryFormat, file.data + sizeof(header), static_cast<GLsizei>(header.length));
+
+        // Loading fails like linking, e.g. when the driver changed without changing its version strings.
+        GLint linkStatus{};
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+
+        if (linkStatus == GL_FALSE)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    unmapFile(file);
+
+    if (!program)
+    {
+        ++programCache.stats.rejectedCount;
+
+        DeleteFileA(path.c_str());
+    }
+
+    // A refused binary leaves an error behind on some drivers.
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    return program;
+}
+
+void storeProgramBinary(const std::string& path, uint64_t key, GLuint program) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    GLint length{};
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<unsigned char> data(sizeof(ProgramBinaryHeader) + static_cast<size_t>(length));
+
+    ProgramBinaryHeader header{};
+    header.magic = programBinaryMagic;
+    header.version = programBinaryVersion;
+    header.key = key;
+
+    GLsizei writtenLength{};
+    GLenum binaryFormat{};
+    glGetProgramBinary(program, length, &writtenLength, &binaryFormat, data.data() + sizeof(header));
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    if (writtenLength <= 0)
+    {
+        return;
+    }
+
+    header.binaryFormat = binaryFormat;
+    header.length = static_cast<uint32_t>(writtenLength);
+    memcpy(data.data(), &header, sizeof(header));
+
+    // Written aside and moved over, so a crash never leaves a torn binary under the key.
+    const std::string temporaryPath = path + ".tmp";
+
+    HANDLE file = CreateFileA(temporaryPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        print("Cannot create program binary: %s\n", temporaryPath.c_str());
+        return;
+    }
+
+    const DWORD byteCount = static_cast<DWORD>(sizeof(header) + header.length);
+
+    DWORD written = 0;
+    const bool saved = WriteFile(file, data.data(), byteCount, &written, NULL) && written == byteCount;
+
+    CloseHandle(file);
+
+    if (saved && MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        ++programCache.stats.storedCount;
+    }
+    else
+    {
+        print("Cannot write program binary: %s\n", path.c_str());
+        DeleteFileA(temporaryPath.c_str());
+    }
+}
+
+}
+
+void initializeProgramCache(const char* directory) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(directory);
+
+    programCache = {};
+    programCache.directory = directory;
+
+    uint64_t driverHash = 14695981039346656037ull;
+    driverHash = hashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    driverHash = hashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    driverHash = hashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    driverHash = hashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION)));
+    driverHash = hashBytes(driverHash, &programBinaryVersion, sizeof(programBinaryVersion));
+
+    programCache.driverHash = driverHash;
+
+    // Drivers may support the entry points with no format at all, then no binary can be retrieved.
+    GLint formatCount{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+    if (formatCount <= 0)
+    {
+        print("Program binaries are not supported, every program is compiled\n");
+        return;
+    }
+
+    if (!CreateDirectoryA(directory, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        print("Cannot create program cache directory: %s\n", directory);
+        return;
+    }
+
+    programCache.isEnabled = true;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+uint64_t getProgramCacheKey(const GLchar* const* sources, unsigned int sourceCount, bool isSeparable) noexcept
+{
+    assert(sources && sourceCount > 0);
+
+    uint64_t key = hashBytes(programCache.driverHash, &sourceCount, sizeof(sourceCount));
+    key = hashBytes(key, &isSeparable, sizeof(isSeparable));
+
+    for (unsigned int i = 0; i < sourceCount; ++i)
+    {
+        key = hashString(key, sources[i]);
+    }
+
+    return key;
+}
+
+GLuint loadCachedProgram(uint64_t key, bool isSeparable) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    const double start = getSeconds();
+
+    const GLuint program = programCache.isEnabled ? loadProgramBinary(getProgramBinaryPath(key), key, isSeparable) : 0;
+
+    if (program)
+    {
+        ++programCache.stats.hitCount;
+    }
+    else
+    {
+        ++programCache.stats.missCount;
+    }
+
+    programCache.stats.seconds += getSeconds() - start;
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return program;
+}
+
+void storeCachedProgram(uint64_t key, GLuint program) noexcept
+{
+    assert(program);
+
+    if (!programCache.isEnabled)
+    {
+        return;
+    }
+
+    const double start = getSeconds();
+
+    storeProgramBinary(getProgramBinaryPath(key), key, program);
+
+    programCache.stats.seconds += getSeconds() - start;
+}
+
+ProgramCacheStats getProgramCacheStats() noexcept
+{
+    return programCache.stats;
+}
@@ -0,0 +1,38 @@
+#ifndef KZ_PROGRAM_CACHE_HPP
+#define KZ_PROGRAM_CACHE_HPP
+
+#include "gl_functions.h"
+
+#include <cstdint>
+
+struct ProgramCacheStats
+{
+    // Loads that found a usable binary and loads that did not, the misses include the binaries the driver refused.
+    unsigned int hitCount{};
+    unsigned int missCount{};
+    unsigned int rejectedCount{};
+
+    unsigned int storedCount{};
+
+    // Spent loading and storing binaries, compiles are not counted.
+    double seconds{};
+};
+
+// Program binaries of the current context in one file per program under the directory, which is created when missing.
+// The driver vendor, renderer and version are part of every key, so a driver update starts from an empty cache.
+// Without any binary format, or before this is called, nothing is loaded or stored.
+void initializeProgramCache(const char* directory) noexcept;
+
+// The key hashes the sources in order, so pass every string the shaders are compiled from, headers included.
+// A separable program is loaded as separable, its binary does not link like the monolithic one.
+uint64_t getProgramCacheKey(const GLchar* const* sources, unsigned int sourceCount, bool isSeparable) noexcept;
+
+// Returns the program linked from the stored binary, zero when there is none or the driver refuses it.
+GLuint loadCachedProgram(uint64_t key, bool isSeparable) noexcept;
+
+// The program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT so the driver keeps its binary.
+void storeCachedProgram(uint64_t key, GLuint program) noexcept;
+
+ProgramCacheStats getProgramCacheStats() noexcept;
+
+#endif
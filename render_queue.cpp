@@ -0,0 +1,491 @@
+#include <render_queue.hpp>
+#include <gl_state_cache.hpp>
+#include <hiz_culling.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr unsigned int radixBits = 8;
+constexpr unsigned int radixBucketCount = 1u << radixBits;
+constexpr unsigned int radixPassCount = 64 / radixBits;
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+void radixSortKeys(uint64_t* keys, unsigned int* order, uint64_t* keyScratch, unsigned int* orderScratch, unsigned int count) noexcept
+{
+    uint64_t* const sortedKeys = keys;
+    unsigned int* const sortedOrder = order;
+
+    // All digit histograms in one read of the keys.
+    unsigned int histograms[radixPassCount][radixBucketCount] = {};
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const uint64_t key = keys[i];
+
+        for (unsigned int pass = 0; pass < radixPassCount; ++pass)
+        {
+            ++histograms[pass][(key >> (pass * radixBits)) & (radixBucketCount - 1)];
+        }
+    }
+
+    for (unsigned int pass = 0; pass < radixPassCount; ++pass)
+    {
+        unsigned int* histogram = histograms[pass];
+
+        // Keys sharing this digit keep their order, the pass would only copy.
+        if (histogram[(keys[0] >> (pass * radixBits)) & (radixBucketCount - 1)] == count)
+        {
+            continue;
+        }
+
+        unsigned int offset = 0;
+
+        for (unsigned int bucket = 0; bucket < radixBucketCount; ++bucket)
+        {
+            const unsigned int bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const unsigned int destination = histogram[(keys[i] >> (pass * radixBits)) & (radixBucketCount - 1)]++;
+
+            keyScratch[destination] = keys[i];
+            orderScratch[destination] = order[i];
+        }
+
+        uint64_t* swapKeys = keys;
+        keys = keyScratch;
+        keyScratch = swapKeys;
+
+        unsigned int* swapOrder = order;
+        order = orderScratch;
+        orderScratch = swapOrder;
+    }
+
+    // An odd number of scatter passes leaves the result in the scratch arrays.
+    if (keys != sortedKeys)
+    {
+        std::memcpy(sortedKeys, keys, count * sizeof(uint64_t));
+        std::memcpy(sortedOrder, order, count * sizeof(unsigned int));
+    }
+}
+
+// Logical state changes between consecutive packets, before the GL state cache.
+void countStateChanges(RenderQueueStats& stats, const DrawPacket* previous, const DrawPacket& packet) noexcept
+{
+    ++stats.packetCount;
+
+    if (!previous || previous->program != packet.program || previous->pipeline != packet.pipeline)
+    {
+        ++stats.programChanges;
+    }
+
+    if (!previous || previous->vertexArray != packet.vertexArray)
+    {
+        ++stats.vertexArrayChanges;
+    }
+
+    if (!previous || previous->texture != packet.texture)
+    {
+        ++stats.textureChanges;
+    }
+}
+
+void submitDrawPacket(RenderQueue& queue, const DrawPacket& packet) noexcept
+{
+    cachedBindFramebuffer(packet.framebuffer);
+    cachedViewport(packet.viewport[0], packet.viewport[1], packet.viewport[2], packet.viewport[3]);
+
+    if (packet.type == drawPacketClear)
+    {
+        glClearColor(packet.clearColor[0], packet.clearColor[1], packet.clearColor[2], packet.clearColor[3]);
+        glClear(packet.clearMask);
+
+        return;
+    }
+
+    if (packet.program)
+    {
+        cachedUseProgram(packet.program);
+    }
+    else
+    {
+        cachedBindProgramPipeline(packet.pipeline);
+    }
+
+    cachedBindVertexArray(packet.vertexArray);
+
+    if (packet.texture)
+    {
+        cachedBindTextureUnit(0, packet.texture);
+        cachedBindSampler(0, packet.sampler);
+    }
+
+    cachedEnable(GL_DEPTH_TEST, packet.depthTest);
+
+    if (packet.matrix && (packet.matrix != queue.submittedMatrix || packet.uniformProgram != queue.submittedUniformProgram))
+    {
+        glProgramUniformMatrix4fv(packet.uniformProgram, packet.matrixUniform, 1, GL_FALSE, packet.matrix);
+
+        queue.submittedMatrix = packet.matrix;
+        queue.submittedUniformProgram = packet.uniformProgram;
+    }
+
+    if (packet.occlusionQuery)
+    {
+        // Still waiting for the previous result.
+        if (!beginOcclusionQuery(*packet.occlusionQuery))
+        {
+            return;
+        }
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+    }
+
+    switch (packet.type)
+    {
+        case drawPacketArrays:
+        {
+            for (GLsizei i = 0; i < packet.drawCount; ++i)
+            {
+                const GLuint baseInstance = packet.baseInstance + static_cast<GLuint>(i * packet.instanceCount);
+
+                glDrawArraysInstancedBaseInstance(packet.mode, static_cast<GLint>(packet.first) + i * packet.count, packet.count, packet.instanceCount, baseInstance);
+            }
+        } break;
+
+        case drawPacketElements:
+        {
+            for (GLsizei i = 0; i < packet.drawCount; ++i)
+            {
+                const uintptr_t firstIndexOffset = (static_cast<uintptr_t>(packet.first) + static_cast<uintptr_t>(i) * static_cast<uintptr_t>(packet.count)) * sizeof(GLuint);
+
+                const GLuint baseInstance = packet.baseInstance + static_cast<GLuint>(i * packet.instanceCount);
+
+                glDrawElementsInstancedBaseInstance(packet.mode, packet.count, GL_UNSIGNED_INT, reinterpret_cast<const void*>(firstIndexOffset), packet.instanceCount, baseInstance);
+            }
+        } break;
+
+        case drawPacketElementsIndirect:
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.indirectBuffer);
+            glDrawElementsIndirect(packet.mode, GL_UNSIGNED_INT, nullptr);
+        } break;
+
+        default:
+        {
+            assert(!"Unknown draw packet type");
+        } break;
+    }
+
+    if (packet.occlusionQuery)
+    {
+        endOcclusionQuery(*packet.occlusionQuery);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+    }
+}
+
+}
+
+uint64_t makeSortKey(RenderPass pass, RenderOrder order, GLuint program, GLuint texture, float depth) noexcept
+{
+    assert(pass < 16 && order < 4);
+
+    depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+
+    const uint64_t quantizedDepth = static_cast<uint64_t>(static_cast<double>(depth) * 4294967295.0);
+
+    return (static_cast<uint64_t>(pass) << 60) |
+           (static_cast<uint64_t>(order) << 58) |
+           (static_cast<uint64_t>(program & 0x3ff) << 48) |
+           (static_cast<uint64_t>(texture & 0xffff) << 32) |
+           quantizedDepth;
+}
+
+RenderQueue createRenderQueue(unsigned int packetCapacity, size_t arenaBytes) noexcept
+{
+    assert(packetCapacity > 0);
+
+    RenderQueue queue;
+
+    queue.packetCapacity = packetCapacity;
+
+    // Packets are the first allocation of every frame.
+    queue.arena.memory.resize(static_cast<size_t>(packetCapacity) * sizeof(DrawPacket) + alignof(DrawPacket) + arenaBytes);
+
+    queue.keys.resize(packetCapacity);
+    queue.keyScratch.resize(packetCapacity);
+    queue.order.resize(packetCapacity);
+    queue.orderScratch.resize(packetCapacity);
+
+    beginRenderQueueFrame(queue);
+
+    return queue;
+}
+
+void beginRenderQueueFrame(RenderQueue& queue) noexcept
+{
+    queue.arena.offset = 0;
+
+    queue.packets = static_cast<DrawPacket*>(allocateFromArena(queue.arena, static_cast<size_t>(queue.packetCapacity) * sizeof(DrawPacket), alignof(DrawPacket)));
+    queue.packetCount = 0;
+
+    assert(queue.packets);
+
+    queue.submittedMatrix = nullptr;
+    queue.submittedUniformProgram = 0;
+
+    queue.frameStats = {};
+}
+
+void* allocateFromArena(FrameArena& arena, size_t size, size_t alignment) noexcept
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    const uintptr_t base = reinterpret_cast<uintptr_t>(arena.memory.data());
+    const uintptr_t aligned = (base + arena.offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    const size_t offset = static_cast<size_t>(aligned - base);
+
+    if (offset + size > arena.memory.size())
+    {
+        return nullptr;
+    }
+
+    arena.offset = offset + size;
+
+    return arena.memory.data() + offset;
+}
+
+const GLfloat* pushFrameMatrix(RenderQueue& queue, const GLfloat* matrix) noexcept
+{
+    GLfloat* copy = static_cast<GLfloat*>(allocateFromArena(queue.arena, 16 * sizeof(GLfloat), alignof(GLfloat)));
+
+    if (!copy)
+    {
+        print("Render queue arena is full\n");
+
+        return nullptr;
+    }
+
+    std::memcpy(copy, matrix, 16 * sizeof(GLfloat));
+
+    return copy;
+}
+
+DrawPacket* pushDrawPacket(RenderQueue& queue, uint64_t sortKey) noexcept
+{
+    if (queue.packetCount == queue.packetCapacity)
+    {
+        print("Render queue is full\n");
+
+        return nullptr;
+    }
+
+    const unsigned int index = queue.packetCount++;
+
+    queue.keys[index] = sortKey;
+    queue.order[index] = index;
+
+    DrawPacket* packet = new (&queue.packets[index]) DrawPacket{};
+
+    return packet;
+}
+
+RenderCommandBuffer createRenderCommandBuffer(unsigned int packetCapacity, size_t arenaBytes) noexcept
+{
+    RenderCommandBuffer buffer;
+
+    buffer.arena.memory.resize(arenaBytes);
+    buffer.keys.reserve(packetCapacity);
+    buffer.packets.reserve(packetCapacity);
+
+    return buffer;
+}
+
+void resetRenderCommandBuffer(RenderCommandBuffer& buffer) noexcept
+{
+    buffer.arena.offset = 0;
+    buffer.keys.clear();
+    buffer.packets.clear();
+}
+
+const GLfloat* pushCommandMatrix(RenderCommandBuffer& buffer, const GLfloat* matrix) noexcept
+{
+    GLfloat* copy = static_cast<GLfloat*>(allocateFromArena(buffer.arena, 16 * sizeof(GLfloat), alignof(GLfloat)));
+
+    if (!copy)
+    {
+        print("Render command buffer arena is full\n");
+
+        return nullptr;
+    }
+
+    std::memcpy(copy, matrix, 16 * sizeof(GLfloat));
+
+    return copy;
+}
+
+DrawPacket* pushCommandPacket(RenderCommandBuffer& buffer, uint64_t sortKey) noexcept
+{
+    buffer.keys.push_back(sortKey);
+    buffer.packets.emplace_back();
+
+    return &buffer.packets.back();
+}
+
+void mergeRenderCommandBuffers(RenderQueue& queue, const RenderCommandBuffer* buffers, unsigned int bufferCount) noexcept
+{
+    for (unsigned int i = 0; i < bufferCount; ++i)
+    {
+        const RenderCommandBuffer& buffer = buffers[i];
+        const unsigned int available = queue.packetCapacity - queue.packetCount;
+
+        unsigned int count = static_cast<unsigned int>(buffer.packets.size());
+
+        if (count > available)
+        {
+            print("Render queue is full\n");
+
+            count = available;
+        }
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        const unsigned int first = queue.packetCount;
+
+        std::memcpy(&queue.keys[first], buffer.keys.data(), count * sizeof(uint64_t));
+        std::memcpy(&queue.packets[first], buffer.packets.data(), count * sizeof(DrawPacket));
+
+        for (unsigned int j = 0; j < count; ++j)
+        {
+            queue.order[first + j] = first + j;
+        }
+
+        queue.packetCount += count;
+    }
+}
+
+void sortRenderQueue(RenderQueue& queue) noexcept
+{
+    if (queue.packetCount < 2)
+    {
+        return;
+    }
+
+    radixSortKeys(queue.keys.data(), queue.order.data(), queue.keyScratch.data(), queue.orderScratch.data(), queue.packetCount);
+}
+
+void submitRenderQueue(RenderQueue& queue) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    sortRenderQueue(queue);
+
+    const DrawPacket* previous = nullptr;
+
+    for (unsigned int i = 0; i < queue.packetCount; ++i)
+    {
+        const DrawPacket& packet = queue.packets[queue.order[i]];
+
+        countStateChanges(queue.frameStats, previous, packet);
+        submitDrawPacket(queue, packet);
+
+        previous = &packet;
+    }
+
+    // The packet block is reused, matrices in the arena stay valid until the next frame.
+    queue.packetCount = 0;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void benchmarkRenderQueue() noexcept
+{
+    constexpr unsigned int packetCounts[] = { 10000, 100000, 1000000 };
+
+    for (const unsigned int packetCount : packetCounts)
+    {
+        RenderQueue queue = createRenderQueue(packetCount, 0);
+
+        // Deterministic spread over 16 programs, 64 textures and 32 vertex arrays.
+        unsigned int random = 0x12345678u;
+
+        const auto nextRandom = [&random]()
+        {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+
+            return random;
+        };
+
+        const double recordStart = getSeconds();
+
+        for (unsigned int i = 0; i < packetCount; ++i)
+        {
+            const GLuint program = 1 + nextRandom() % 16;
+            const GLuint texture = 1 + nextRandom() % 64;
+            const float depth = static_cast<float>(nextRandom() & 0xffff) / 65535.0f;
+
+            DrawPacket* packet = pushDrawPacket(queue, makeSortKey(renderPassColor, renderOrderOpaque, program, texture, depth));
+
+            packet->type = drawPacketElements;
+            packet->program = program;
+            packet->texture = texture;
+            packet->vertexArray = 1 + nextRandom() % 32;
+            packet->count = 36;
+        }
+
+        const double sortStart = getSeconds();
+
+        RenderQueueStats unsortedStats = {};
+        for (unsigned int i = 0; i < queue.packetCount; ++i)
+        {
+            countStateChanges(unsortedStats, i > 0 ? &queue.packets[i - 1] : nullptr, queue.packets[i]);
+        }
+
+        const double unsortedWalkSeconds = getSeconds() - sortStart;
+        const double sortStartAfterWalk = getSeconds();
+
+        sortRenderQueue(queue);
+
+        const double sortEnd = getSeconds();
+
+        RenderQueueStats sortedStats = {};
+        const DrawPacket* previous = nullptr;
+        for (unsigned int i = 0; i < queue.packetCount; ++i)
+        {
+            const DrawPacket& packet = queue.packets[queue.order[i]];
+            countStateChanges(sortedStats, previous, packet);
+            previous = &packet;
+        }
+
+        const double walkEnd = getSeconds();
+
+        print("Render queue benchmark: %7u packets, record %7.3f ms, sort %7.3f ms, walk %7.3f ms (unsorted %7.3f ms)\n",
+            packetCount, (sortStart - recordStart) * 1000.0, (sortEnd - sortStartAfterWalk) * 1000.0, (walkEnd - sortEnd) * 1000.0, unsortedWalkSeconds * 1000.0);
+        print("    program changes %7u -> %7u, texture changes %7u -> %7u\n",
+            unsortedStats.programChanges, sortedStats.programChanges, unsortedStats.textureChanges, sortedStats.textureChanges);
+    }
+}
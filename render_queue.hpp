@@ -0,0 +1,162 @@
+#ifndef KZ_RENDER_QUEUE_HPP
+#define KZ_RENDER_QUEUE_HPP
+
+#include "gl_functions.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct OcclusionQuery;
+
+// Passes in submission order, the pass is the most significant part of the sort key.
+enum RenderPass : unsigned int
+{
+    renderPassID,
+    renderPassColor,
+    renderPassPicking,
+    renderPassAxis,
+};
+
+// Order of packets inside a pass.
+enum RenderOrder : unsigned int
+{
+    renderOrderClear,
+    renderOrderOpaque,
+    renderOrderQuery,
+};
+
+enum DrawPacketType : unsigned char
+{
+    drawPacketClear,
+    drawPacketArrays,
+    drawPacketElements,
+    drawPacketElementsIndirect,
+};
+
+// Everything needed to issue one draw, state is applied through the GL state cache.
+struct DrawPacket
+{
+    DrawPacketType type{};
+    bool depthTest{};
+
+    // Program, or zero to bind the pipeline.
+    GLuint program{};
+    GLuint pipeline{};
+    GLuint vertexArray{};
+    GLuint texture{};
+    GLuint sampler{};
+    GLuint framebuffer{};
+    GLint viewport[4]{};
+
+    // Matrix in the frame arena, set with glProgramUniformMatrix4fv on uniformProgram when it changes.
+    const GLfloat* matrix{};
+    GLuint uniformProgram{};
+    GLint matrixUniform{ -1 };
+
+    // Draws and the proxy of a query are wrapped in it, color and depth writes are off for queries.
+    OcclusionQuery* occlusionQuery{};
+
+    GLenum mode{ GL_TRIANGLES };
+
+    // Arrays: first vertex, elements: first index. Repeated drawCount times with first advanced by count.
+    GLuint first{};
+    GLsizei count{};
+    GLsizei drawCount{ 1 };
+
+    // Instances of each draw, a repeat advances baseInstance by instanceCount so it reads its own per-instance attributes.
+    GLsizei instanceCount{ 1 };
+    GLuint baseInstance{};
+
+    GLuint indirectBuffer{};
+
+    GLfloat clearColor[4]{};
+    GLbitfield clearMask{};
+};
+
+// Bump allocator reset every frame.
+struct FrameArena
+{
+    std::vector<unsigned char> memory;
+    size_t offset{};
+};
+
+struct RenderQueueStats
+{
+    unsigned int packetCount{};
+    unsigned int programChanges{};
+    unsigned int vertexArrayChanges{};
+    unsigned int textureChanges{};
+};
+
+struct RenderQueue
+{
+    FrameArena arena;
+
+    // Packets of the current submission, allocated from the arena.
+    DrawPacket* packets{};
+    unsigned int packetCount{};
+    unsigned int packetCapacity{};
+
+    // Sort key and packet index pairs with their radix scratch.
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> keyScratch;
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> orderScratch;
+
+    // Last submitted uniform, a matrix shared by packets is set once.
+    const GLfloat* submittedMatrix{};
+    GLuint submittedUniformProgram{};
+
+    RenderQueueStats frameStats{};
+};
+
+// Packets recorded by a job without touching GL, merged into a queue on the GL thread.
+struct RenderCommandBuffer
+{
+    // Matrices, valid until the buffer is reset.
+    FrameArena arena;
+
+    std::vector<uint64_t> keys;
+    std::vector<DrawPacket> packets;
+};
+
+// pass:4 | order:2 | program:10 | texture:16 | depth:32, depth increases away from the camera.
+uint64_t makeSortKey(RenderPass pass, RenderOrder order, GLuint program, GLuint texture, float depth) noexcept;
+
+RenderQueue createRenderQueue(unsigned int packetCapacity, size_t arenaBytes) noexcept;
+
+// Frees every packet and arena allocation of the previous frame.
+void beginRenderQueueFrame(RenderQueue& queue) noexcept;
+
+void* allocateFromArena(FrameArena& arena, size_t size, size_t alignment) noexcept;
+
+// Copies the matrix into the frame arena so packets can reference it until submission.
+const GLfloat* pushFrameMatrix(RenderQueue& queue, const GLfloat* matrix) noexcept;
+
+// Returns nullptr when the queue is full, the caller drops the draw.
+DrawPacket* pushDrawPacket(RenderQueue& queue, uint64_t sortKey) noexcept;
+
+RenderCommandBuffer createRenderCommandBuffer(unsigned int packetCapacity, size_t arenaBytes) noexcept;
+
+// Only once the queue the packets were merged into has been submitted.
+void resetRenderCommandBuffer(RenderCommandBuffer& buffer) noexcept;
+
+const GLfloat* pushCommandMatrix(RenderCommandBuffer& buffer, const GLfloat* matrix) noexcept;
+
+// The packet is valid until the next push to the same buffer.
+DrawPacket* pushCommandPacket(RenderCommandBuffer& buffer, uint64_t sortKey) noexcept;
+
+// Appends the packets in buffer order, so the stable sort orders equal keys the same as a single recording thread.
+void mergeRenderCommandBuffers(RenderQueue& queue, const RenderCommandBuffer* buffers, unsigned int bufferCount) noexcept;
+
+// Stable LSD radix sort of the recorded keys, digits shared by every key are skipped.
+void sortRenderQueue(RenderQueue& queue) noexcept;
+
+// Sorts, issues and drops the recorded packets, arena memory lives until the next frame.
+void submitRenderQueue(RenderQueue& queue) noexcept;
+
+// Records, sorts and walks 10k to 1M packets without GL and prints the timings.
+void benchmarkRenderQueue() noexcept;
+
+#endif
@@ -0,0 +1,581 @@
+#include <shader_compiler.hpp>
+#include <program_cache.hpp>
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define Invariant(cond) do { if (!(cond)) __debugbreak(); } while (0)
+
+void print(const char* format, ...);
+
+namespace
+{
+// A shader attached to programs that are still linking, programs with the same stage source share it.
+struct CompiledShader
+{
+    GLenum type{};
+    const GLchar* headerSource{};
+    const GLchar* source{};
+
+    GLuint shader{};
+    unsigned int useCount{};
+};
+
+struct PendingProgram
+{
+    ShaderProgramSource source;
+    uint64_t key{};
+
+    GLuint program{};
+    GLuint shaders[maxShaderProgramStageCount]{};
+    bool isFromCache{};
+
+    // Written by the thread that links the program, under the compiler mutex in the worker context mode.
+    bool isLinked{};
+    bool hasFailed{};
+    std::string log;
+};
+
+struct ShaderCompiler
+{
+    ShaderCompileMode mode{};
+
+    // Submitted and not taken yet, only the render thread adds and removes programs.
+    std::vector<std::unique_ptr<PendingProgram>> pendingPrograms;
+
+    // Only touched by the thread that compiles, the render thread or the worker.
+    std::vector<CompiledShader> shaders;
+
+    HDC dc{};
+    HGLRC workerContext{};
+    std::thread worker;
+
+    // Programs for the worker to link, and the wake-ups in both directions.
+    std::mutex mutex;
+    std::condition_variable submitCondition;
+    std::condition_variable linkCondition;
+    std::vector<PendingProgram*> queue;
+    bool quit{};
+
+    ShaderCompilerStats stats;
+};
+
+ShaderCompiler shaderCompiler;
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+const char* getShaderStageName(GLenum type) noexcept
+{
+    switch (type)
+    {
+        case GL_VERTEX_SHADER: return "vertex";
+        case GL_FRAGMENT_SHADER: return "fragment";
+        case GL_COMPUTE_SHADER: return "compute";
+    }
+
+    assert(!"Unsupported shader stage");
+
+    return "";
+}
+
+// The stage names are hashed with the sources, the same text may compile for different stages.
+uint64_t getShaderProgramKey(const ShaderProgramSource& source) noexcept
+{
+    assert(source.stageCount > 0 && source.stageCount <= maxShaderProgramStageCount);
+
+    const GLchar* strings[1 + 2 * maxShaderProgramStageCount];
+    unsigned int stringCount = 0;
+
+    strings[stringCount++] = source.headerSource ? source.headerSource : "";
+
+    for (unsigned int i = 0; i < source.stageCount; ++i)
+    {
+        strings[stringCount++] = getShaderStageName(source.stages[i].type);
+        strings[stringCount++] = source.stages[i].source;
+    }
+
+    return getProgramCacheKey(strings, stringCount, source.isSeparable);
+}
+
+PendingProgram* findPendingProgram(uint64_t key) noexcept
+{
+    for (const std::unique_ptr<PendingProgram>& pendingProgram : shaderCompiler.pendingPrograms)
+    {
+        if (pendingProgram->key == key)
+        {
+            return pendingProgram.get();
+        }
+    }
+
+    return nullptr;
+}
+
+// Starts the compile without asking for its status, which would wait for it.
+GLuint acquireShader(const GLchar* headerSource, const ShaderStageSource& stage) noexcept
+{
+    for (CompiledShader& compiledShader : shaderCompiler.shaders)
+    {
+        if (compiledShader.type == stage.type && compiledShader.headerSource == headerSource && compiledShader.source == stage.source)
+        {
+            ++compiledShader.useCount;
+
+            return compiledShader.shader;
+        }
+    }
+
+    const GLuint shader = glCreateShader(stage.type);
+
+    const GLchar* sources[] = {
+        headerSource,
+        stage.source,
+    };
+
+    // User null-terminated shader source.
+    if (headerSource)
+    {
+        glShaderSource(shader, 2, sources, nullptr);
+    }
+    else
+    {
+        glShaderSource(shader, 1, &stage.source, nullptr);
+    }
+
+    glCompileShader(shader);
+
+    CompiledShader compiledShader{};
+    compiledShader.type = stage.type;
+    compiledShader.headerSource = headerSource;
+    compiledShader.source = stage.source;
+    compiledShader.shader = shader;
+    compiledShader.useCount = 1;
+
+    shaderCompiler.shaders.push_back(compiledShader);
+
+    return shader;
+}
+
+void releaseShader(GLuint shader) noexcept
+{
+    std::vector<CompiledShader>& shaders = shaderCompiler.shaders;
+
+    for (size_t i = 0; i < shaders.size(); ++i)
+    {
+        if (shaders[i].shader == shader)
+        {
+            if (--shaders[i].useCount == 0)
+            {
+                glDeleteShader(shader);
+
+                shaders[i] = shaders.back();
+                shaders.pop_back();
+            }
+
+            return;
+        }
+    }
+
+    assert(!"Shader was not acquired");
+}
+
+// Queues the link behind the compiles, the driver resolves the dependency without the caller waiting.
+void startLink(PendingProgram& pendingProgram) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    const ShaderProgramSource& source = pendingProgram.source;
+
+    for (unsigned int i = 0; i < source.stageCount; ++i)
+    {
+        pendingProgram.shaders[i] = acquireShader(source.headerSource, source.stages[i]);
+    }
+
+    pendingProgram.program = glCreateProgram();
+
+    if (source.isSeparable)
+    {
+        glProgramParameteri(pendingProgram.program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    }
+
+    // The driver keeps the binary so the program cache can store it.
+    glProgramParameteri(pendingProgram.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    for (unsigned int i = 0; i < source.stageCount; ++i)
+    {
+        glAttachShader(pendingProgram.program, pendingProgram.shaders[i]);
+    }
+
+    glLinkProgram(pendingProgram.program);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void appendInfoLog(std::string& log, GLuint object, bool isProgram) noexcept
+{
+    GLint logSize{};
+
+    if (isProgram)
+    {
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &logSize);
+    }
+    else
+    {
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &logSize);
+    }
+
+    if (logSize > 1)
+    {
+        const size_t offset = log.size();
+        log.resize(offset + static_cast<size_t>(logSize));
+
+        if (isProgram)
+        {
+            glGetProgramInfoLog(object, logSize, nullptr, log.data() + offset);
+        }
+        else
+        {
+            glGetShaderInfoLog(object, logSize, nullptr, log.data() + offset);
+        }
+
+        // Drop the terminator written into the string.
+        log.resize(offset + strlen(log.c_str() + offset));
+    }
+}
+
+// Waits for the link, keeps the logs of a failed one and lets go of the shaders.
+void finishLink(PendingProgram& pendingProgram) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    GLint linkStatus{};
+    glGetProgramiv(pendingProgram.program, GL_LINK_STATUS, &linkStatus);
+
+    pendingProgram.hasFailed = linkStatus == GL_FALSE;
+
+    for (unsigned int i = 0; i < pendingProgram.source.stageCount; ++i)
+    {
+        const GLuint shader = pendingProgram.shaders[i];
+
+        if (pendingProgram.hasFailed)
+        {
+            GLint compileStatus{};
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+
+            if (compileStatus == GL_FALSE)
+            {
+                pendingProgram.log += getShaderStageName(pendingProgram.source.stages[i].type);
+                pendingProgram.log += " shader:\n";
+
+                appendInfoLog(pendingProgram.log, shader, false);
+            }
+        }
+
+        glDetachShader(pendingProgram.program, shader);
+        releaseShader(shader);
+
+        pendingProgram.shaders[i] = 0;
+    }
+
+    if (pendingProgram.hasFailed)
+    {
+        appendInfoLog(pendingProgram.log, pendingProgram.program, true);
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void runCompileWorker() noexcept
+{
+    const BOOL ok = wglMakeCurrent(shaderCompiler.dc, shaderCompiler.workerContext);
+    Invariant(ok && "Failed to make the shader compiler context current");
+
+    std::vector<PendingProgram*> batch;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(shaderCompiler.mutex);
+            shaderCompiler.submitCondition.wait(lock, [] { return shaderCompiler.quit || !shaderCompiler.queue.empty(); });
+
+            if (shaderCompiler.queue.empty())
+            {
+                break;
+            }
+
+            batch.swap(shaderCompiler.queue);
+        }
+
+        // Every link of the batch is queued before the first is waited for, so shared stages compile once.
+        for (PendingProgram* pendingProgram : batch)
+        {
+            startLink(*pendingProgram);
+        }
+
+        for (PendingProgram* pendingProgram : batch)
+        {
+            finishLink(*pendingProgram);
+
+            // Changes to shared objects are only guaranteed visible to the other context once complete.
+            glFinish();
+
+            {
+                std::lock_guard<std::mutex> lock(shaderCompiler.mutex);
+                pendingProgram->isLinked = true;
+            }
+
+            shaderCompiler.linkCondition.notify_all();
+        }
+
+        batch.clear();
+    }
+
+    wglMakeCurrent(NULL, NULL);
+}
+
+bool hasExtension(const char* name) noexcept
+{
+    GLint extensionCount{};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+
+        if (extension && strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
+void initializeShaderCompiler(HDC dc, HGLRC workerContext) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(shaderCompiler.mode == shaderCompileSerial && !shaderCompiler.workerContext);
+
+    shaderCompiler.stats = {};
+
+    if (hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile"))
+    {
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)wglGetProcAddress("glMaxShaderCompilerThreadsKHR");
+
+        if (!maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)wglGetProcAddress("glMaxShaderCompilerThreadsARB");
+        }
+
+        // All ones lets the driver pick the thread count, some drivers only go parallel once asked.
+        if (maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads(0xffffffffu);
+        }
+
+        shaderCompiler.mode = shaderCompileDriverThreads;
+
+        if (workerContext)
+        {
+            wglDeleteContext(workerContext);
+        }
+    }
+    else if (workerContext)
+    {
+        shaderCompiler.mode = shaderCompileWorkerContext;
+        shaderCompiler.dc = dc;
+        shaderCompiler.workerContext = workerContext;
+        shaderCompiler.quit = false;
+        shaderCompiler.worker = std::thread(runCompileWorker);
+    }
+
+    shaderCompiler.stats.mode = shaderCompiler.mode;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void shutdownShaderCompiler() noexcept
+{
+    if (shaderCompiler.worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(shaderCompiler.mutex);
+            shaderCompiler.quit = true;
+        }
+
+        shaderCompiler.submitCondition.notify_all();
+        shaderCompiler.worker.join();
+    }
+
+    if (shaderCompiler.workerContext)
+    {
+        wglDeleteContext(shaderCompiler.workerContext);
+    }
+
+    for (std::unique_ptr<PendingProgram>& pendingProgram : shaderCompiler.pendingPrograms)
+    {
+        for (unsigned int i = 0; i < pendingProgram->source.stageCount; ++i)
+        {
+            if (pendingProgram->shaders[i])
+            {
+                releaseShader(pendingProgram->shaders[i]);
+            }
+        }
+
+        glDeleteProgram(pendingProgram->program);
+    }
+
+    shaderCompiler.pendingPrograms.clear();
+    shaderCompiler.queue.clear();
+    shaderCompiler.workerContext = NULL;
+    shaderCompiler.mode = shaderCompileSerial;
+}
+
+void submitShaderProgram(const ShaderProgramSource& source) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    const uint64_t key = getShaderProgramKey(source);
+
+    if (findPendingProgram(key))
+    {
+        return;
+    }
+
+    std::unique_ptr<PendingProgram> pendingProgram = std::make_unique<PendingProgram>();
+    pendingProgram->source = source;
+    pendingProgram->key = key;
+
+    // Binaries load quickly and are loaded right away, only misses are compiled.
+    pendingProgram->program = loadCachedProgram(key, source.isSeparable);
+
+    if (pendingProgram->program)
+    {
+        pendingProgram->isFromCache = true;
+        pendingProgram->isLinked = true;
+
+        ++shaderCompiler.stats.cachedCount;
+    }
+    else
+    {
+        ++shaderCompiler.stats.compiledCount;
+
+        if (shaderCompiler.mode == shaderCompileWorkerContext)
+        {
+            {
+                std::lock_guard<std::mutex> lock(shaderCompiler.mutex);
+                shaderCompiler.queue.push_back(pendingProgram.get());
+            }
+
+            shaderCompiler.submitCondition.notify_one();
+        }
+        else
+        {
+            startLink(*pendingProgram);
+        }
+    }
+
+    shaderCompiler.pendingPrograms.push_back(std::move(pendingProgram));
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+GLuint takeShaderProgram(const ShaderProgramSource& source) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    const uint64_t key = getShaderProgramKey(source);
+
+    PendingProgram* pendingProgram = findPendingProgram(key);
+
+    if (!pendingProgram)
+    {
+        submitShaderProgram(source);
+
+        pendingProgram = findPendingProgram(key);
+    }
+
+    assert(pendingProgram);
+
+    if (!pendingProgram->isFromCache)
+    {
+        const double start = getSeconds();
+
+        bool waited = true;
+
+        if (shaderCompiler.mode == shaderCompileWorkerContext)
+        {
+            std::unique_lock<std::mutex> lock(shaderCompiler.mutex);
+
+            waited = !pendingProgram->isLinked;
+            shaderCompiler.linkCondition.wait(lock, [pendingProgram] { return pendingProgram->isLinked; });
+        }
+        else
+        {
+            // Only driver threads tell whether the link is done without waiting for it.
+            if (shaderCompiler.mode == shaderCompileDriverThreads)
+            {
+                GLint isComplete{};
+                glGetProgramiv(pendingProgram->program, GL_COMPLETION_STATUS_KHR, &isComplete);
+
+                waited = isComplete == GL_FALSE;
+            }
+
+            finishLink(*pendingProgram);
+            pendingProgram->isLinked = true;
+        }
+
+        if (waited)
+        {
+            ++shaderCompiler.stats.waitedCount;
+            shaderCompiler.stats.waitSeconds += getSeconds() - start;
+        }
+
+        if (pendingProgram->hasFailed)
+        {
+            print("%s", pendingProgram->log.c_str());
+            print("Shader program linking failed!\n");
+            Invariant(false);
+        }
+
+        storeCachedProgram(key, pendingProgram->program);
+    }
+
+    const GLuint program = pendingProgram->program;
+
+    std::vector<std::unique_ptr<PendingProgram>>& pendingPrograms = shaderCompiler.pendingPrograms;
+
+    for (size_t i = 0; i < pendingPrograms.size(); ++i)
+    {
+        if (pendingPrograms[i].get() == pendingProgram)
+        {
+            pendingPrograms[i] = std::move(pendingPrograms.back());
+            pendingPrograms.pop_back();
+            break;
+        }
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return program;
+}
+
+ShaderCompilerStats getShaderCompilerStats() noexcept
+{
+    return shaderCompiler.stats;
+}
@@ -0,0 +1,68 @@
+#ifndef KZ_SHADER_COMPILER_HPP
+#define KZ_SHADER_COMPILER_HPP
+
+#include "gl_functions.h"
+
+constexpr unsigned int maxShaderProgramStageCount = 2;
+
+// The strings are read after the call returns, until the program is taken, so they must outlive it. String literals do.
+struct ShaderStageSource
+{
+    GLenum type{};
+    const GLchar* source{};
+};
+
+// The header, if any, is compiled in front of every stage.
+struct ShaderProgramSource
+{
+    const GLchar* headerSource{};
+
+    ShaderStageSource stages[maxShaderProgramStageCount]{};
+    unsigned int stageCount{};
+
+    bool isSeparable{};
+};
+
+enum ShaderCompileMode : unsigned char
+{
+    // Compiles wherever the driver does, at the latest when the program is taken.
+    shaderCompileSerial,
+
+    // GL_KHR_parallel_shader_compile, the driver compiles on its own threads.
+    shaderCompileDriverThreads,
+
+    // Compiles on a thread of our own with a context sharing objects with the render context.
+    shaderCompileWorkerContext,
+};
+
+struct ShaderCompilerStats
+{
+    ShaderCompileMode mode{};
+
+    // Programs compiled and linked, and programs loaded from the program cache instead.
+    unsigned int compiledCount{};
+    unsigned int cachedCount{};
+
+    // Programs still compiling when taken, and the time the render thread waited for them.
+    unsigned int waitedCount{};
+    double waitSeconds{};
+};
+
+// The worker context must share objects with the current context, it is only used when the driver cannot compile in parallel.
+// The compiler owns it from here on, it may be null.
+void initializeShaderCompiler(HDC dc, HGLRC workerContext) noexcept;
+
+// Stops the worker and deletes the programs nobody took.
+void shutdownShaderCompiler() noexcept;
+
+// Starts compiling and linking the program without waiting for either, nothing happens when it is already pending.
+// Submit every program at startup before taking any, so they compile together instead of one after another.
+void submitShaderProgram(const ShaderProgramSource& source) noexcept;
+
+// Returns the linked program and hands it to the caller, waiting for its compile only.
+// A program that was not submitted before is submitted now. Compile and link errors are printed and halt.
+GLuint takeShaderProgram(const ShaderProgramSource& source) noexcept;
+
+ShaderCompilerStats getShaderCompilerStats() noexcept;
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef KZ_SPSC_QUEUE_HPP
+#define KZ_SPSC_QUEUE_HPP
+
+#include <atomic>
+
+// Bounded single-producer single-consumer ring, neither side blocks or locks.
+template <typename T, unsigned int Capacity>
+struct SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Queue capacity must be a power of two");
+
+    // Written by the consumer.
+    alignas(64) std::atomic<unsigned int> head{};
+
+    // Written by the producer.
+    alignas(64) std::atomic<unsigned int> tail{};
+
+    T items[Capacity]{};
+};
+
+// Producer side, returns false when the queue is full.
+template <typename T, unsigned int Capacity>
+bool pushQueueItem(SpscQueue<T, Capacity>& queue, const T& item) noexcept
+{
+    const unsigned int tail = queue.tail.load(std::memory_order_relaxed);
+
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity)
+    {
+        return false;
+    }
+
+    queue.items[tail & (Capacity - 1)] = item;
+    queue.tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+// Consumer side, returns false when the queue is empty.
+template <typename T, unsigned int Capacity>
+bool popQueueItem(SpscQueue<T, Capacity>& queue, T& item) noexcept
+{
+    const unsigned int head = queue.head.load(std::memory_order_relaxed);
+
+    if (head == queue.tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    item = queue.items[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,321 @@
+#include <texture_cache.hpp>
+#include <gl_state_cache.hpp>
+
+#include <cassert>
+#include <utility>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr unsigned int invalidEntry = ~0u;
+
+uint32_t hashTextureAsset(TextureAssetID asset) noexcept
+{
+    uint32_t hash = asset * 0x9E3779B1u;
+
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+
+    return hash;
+}
+
+unsigned int findEntry(const TextureCache& cache, TextureAssetID asset) noexcept
+{
+    if (cache.table.empty())
+    {
+        return invalidEntry;
+    }
+
+    const size_t mask = cache.table.size() - 1;
+
+    for (size_t slot = hashTextureAsset(asset) & mask; ; slot = (slot + 1) & mask)
+    {
+        const unsigned int index = cache.table[slot];
+
+        if (index == invalidEntry || cache.entries[index].asset == asset)
+        {
+            return index;
+        }
+    }
+}
+
+void insertTableEntry(std::vector<unsigned int>& table, const std::vector<CachedTexture>& entries, unsigned int index) noexcept
+{
+    const size_t mask = table.size() - 1;
+    size_t slot = hashTextureAsset(entries[index].asset) & mask;
+
+    while (table[slot] != invalidEntry)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    table[slot] = index;
+}
+
+unsigned int addEntry(TextureCache& cache, TextureAssetID asset) noexcept
+{
+    // At most half full, so probe sequences stay short.
+    if ((cache.entries.size() + 1) * 2 > cache.table.size())
+    {
+        std::vector<unsigned int> table(cache.table.empty() ? 64 : cache.table.size() * 2, invalidEntry);
+
+        for (unsigned int index = 0; index < cache.entries.size(); ++index)
+        {
+            insertTableEntry(table, cache.entries, index);
+        }
+
+        cache.table = std::move(table);
+    }
+
+    CachedTexture entry;
+    entry.asset = asset;
+    entry.previous = invalidEntry;
+    entry.next = invalidEntry;
+
+    const unsigned int index = static_cast<unsigned int>(cache.entries.size());
+
+    cache.entries.push_back(entry);
+    insertTableEntry(cache.table, cache.entries, index);
+
+    return index;
+}
+
+void unlinkEntry(TextureCache& cache, unsigned int index) noexcept
+{
+    CachedTexture& entry = cache.entries[index];
+
+    if (entry.previous != invalidEntry)
+    {
+        cache.entries[entry.previous].next = entry.next;
+    }
+    else
+    {
+        cache.mostRecent = entry.next;
+    }
+
+    if (entry.next != invalidEntry)
+    {
+        cache.entries[entry.next].previous = entry.previous;
+    }
+    else
+    {
+        cache.leastRecent = entry.previous;
+    }
+
+    entry.previous = invalidEntry;
+    entry.next = invalidEntry;
+}
+
+void linkMostRecent(TextureCache& cache, unsigned int index) noexcept
+{
+    CachedTexture& entry = cache.entries[index];
+
+    entry.previous = invalidEntry;
+    entry.next = cache.mostRecent;
+
+    if (cache.mostRecent != invalidEntry)
+    {
+        cache.entries[cache.mostRecent].previous = index;
+    }
+    else
+    {
+        cache.leastRecent = index;
+    }
+
+    cache.mostRecent = index;
+}
+
+// Publishes a loading texture once the streamer reports it resident.
+bool isEntryResident(CachedTexture& entry, const TextureStreamer& streamer) noexcept
+{
+    if (entry.state == cachedTextureLoading && getResidentTexture(streamer, entry.upload, 0) != 0)
+    {
+        entry.state = cachedTextureResident;
+    }
+
+    return entry.state == cachedTextureResident;
+}
+
+void loadEntry(TextureCache& cache, TextureStreamer& streamer, unsigned int index) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    CachedTexture& entry = cache.entries[index];
+
+    TextureImage image;
+
+    if (!cache.load(cache.loadUserData, entry.asset, image))
+    {
+        print("Texture cache: cannot load asset %u.\n", entry.asset);
+        entry.state = cachedTextureFailed;
+        return;
+    }
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &entry.texture);
+    glTextureStorage3D(entry.texture, image.levelCount, image.internalFormat, image.width, image.height, 1);
+
+    entry.byteCount = getTextureLevelOffset(image, image.levelCount);
+    entry.upload = requestTextureLayerUpload(streamer, entry.texture, 0, std::move(image));
+    entry.state = cachedTextureLoading;
+
+    cache.gpuByteCount += entry.byteCount;
+    ++cache.stats.loadCount;
+
+    linkMostRecent(cache, index);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void evictEntry(TextureCache& cache, TextureStreamer& streamer, unsigned int index) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    CachedTexture& entry = cache.entries[index];
+
+    assert(entry.state == cachedTextureResident);
+
+    unlinkEntry(cache, index);
+
+    releaseStreamedTexture(streamer, entry.upload);
+    forgetCachedTexture(entry.texture);
+    glDeleteTextures(1, &entry.texture);
+
+    cache.gpuByteCount -= entry.byteCount;
+    ++cache.stats.evictionCount;
+
+    entry.texture = 0;
+    entry.byteCount = 0;
+    entry.state = cachedTextureEvicted;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+}
+
+TextureCache createTextureCache(size_t byteBudget, TextureLoadFunction* load, void* loadUserData) noexcept
+{
+    assert(byteBudget > 0 && load);
+
+    TextureCache cache;
+    cache.mostRecent = invalidEntry;
+    cache.leastRecent = invalidEntry;
+    cache.byteBudget = byteBudget;
+    cache.load = load;
+    cache.loadUserData = loadUserData;
+
+    return cache;
+}
+
+void destroyTextureCache(TextureCache& cache, TextureStreamer& streamer) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    for (CachedTexture& entry : cache.entries)
+    {
+        // A texture still loading keeps its streamer entry until the streamer is destroyed.
+        if (isEntryResident(entry, streamer))
+        {
+            releaseStreamedTexture(streamer, entry.upload);
+        }
+
+        if (entry.texture)
+        {
+            forgetCachedTexture(entry.texture);
+            glDeleteTextures(1, &entry.texture);
+        }
+    }
+
+    cache = {};
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+GLuint getCachedTexture(TextureCache& cache, TextureStreamer& streamer, TextureAssetID asset, GLuint fallback) noexcept
+{
+    unsigned int index = findEntry(cache, asset);
+
+    if (index == invalidEntry)
+    {
+        index = addEntry(cache, asset);
+    }
+
+    CachedTexture& entry = cache.entries[index];
+    entry.lastUseFrame = cache.frameCount;
+
+    if (entry.state == cachedTextureEvicted)
+    {
+        ++cache.stats.missCount;
+        loadEntry(cache, streamer, index);
+
+        return fallback;
+    }
+
+    if (entry.state == cachedTextureFailed)
+    {
+        ++cache.stats.missCount;
+        return fallback;
+    }
+
+    if (cache.mostRecent != index)
+    {
+        unlinkEntry(cache, index);
+        linkMostRecent(cache, index);
+    }
+
+    if (!isEntryResident(entry, streamer))
+    {
+        ++cache.stats.missCount;
+        return fallback;
+    }
+
+    ++cache.stats.hitCount;
+
+    return entry.texture;
+}
+
+void updateTextureCache(TextureCache& cache, TextureStreamer& streamer) noexcept
+{
+    unsigned int index = cache.leastRecent;
+
+    while (cache.gpuByteCount > cache.byteBudget && index != invalidEntry)
+    {
+        CachedTexture& entry = cache.entries[index];
+
+        // Everything closer to the front was used in this frame too.
+        if (entry.lastUseFrame == cache.frameCount)
+        {
+            break;
+        }
+
+        const unsigned int previous = entry.previous;
+
+        // Rows may still be queued into a loading texture.
+        if (isEntryResident(entry, streamer))
+        {
+            evictEntry(cache, streamer, index);
+        }
+
+        index = previous;
+    }
+
+    ++cache.frameCount;
+}
+
+TextureCacheStats takeTextureCacheStats(TextureCache& cache) noexcept
+{
+    TextureCacheStats stats = cache.stats;
+
+    for (const CachedTexture& entry : cache.entries)
+    {
+        stats.residentCount += entry.state == cachedTextureResident ? 1 : 0;
+        stats.loadingCount += entry.state == cachedTextureLoading ? 1 : 0;
+    }
+
+    stats.gpuByteCount = cache.gpuByteCount;
+    stats.byteBudget = cache.byteBudget;
+
+    cache.stats = {};
+
+    return stats;
+}
@@ -0,0 +1,95 @@
+#ifndef KZ_TEXTURE_CACHE_HPP
+#define KZ_TEXTURE_CACHE_HPP
+
+#include "gl_functions.h"
+#include <texture_streaming.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Caller-chosen key of a texture asset, e.g. an index into a list of files.
+using TextureAssetID = uint32_t;
+
+// Fills the image of the asset on every load and reload, returns false when the asset cannot be read.
+using TextureLoadFunction = bool(void* userData, TextureAssetID asset, TextureImage& image);
+
+enum CachedTextureState : unsigned char
+{
+    cachedTextureEvicted,
+    cachedTextureLoading,
+    cachedTextureResident,
+    cachedTextureFailed,
+};
+
+struct CachedTexture
+{
+    TextureAssetID asset{};
+    CachedTextureState state{};
+
+    // Single layer array owned by the cache, so it is sampled like a pooled material at layer 0.
+    GLuint texture{};
+    StreamedTextureID upload{};
+    size_t byteCount{};
+
+    // Most recently used first, indices into TextureCache::entries.
+    unsigned int previous{};
+    unsigned int next{};
+    uint64_t lastUseFrame{};
+};
+
+struct TextureCacheStats
+{
+    // Lookups that found the texture resident, and the others.
+    unsigned int hitCount{};
+    unsigned int missCount{};
+
+    unsigned int loadCount{};
+    unsigned int evictionCount{};
+
+    // Current state, not reset by takeTextureCacheStats.
+    unsigned int residentCount{};
+    unsigned int loadingCount{};
+    uint64_t gpuByteCount{};
+    uint64_t byteBudget{};
+};
+
+// Textures by asset ID under a GPU memory budget, the least recently used are evicted and reloaded on demand through the streamer.
+struct TextureCache
+{
+    std::vector<CachedTexture> entries;
+
+    // Open addressing from asset ID to entry index, entries are never removed.
+    std::vector<unsigned int> table;
+
+    // List ends, invalidEntry when empty.
+    unsigned int mostRecent{};
+    unsigned int leastRecent{};
+
+    // Storage of resident and loading textures.
+    size_t gpuByteCount{};
+    size_t byteBudget{};
+
+    TextureLoadFunction* load{};
+    void* loadUserData{};
+
+    uint64_t frameCount{};
+
+    TextureCacheStats stats;
+};
+
+TextureCache createTextureCache(size_t byteBudget, TextureLoadFunction* load, void* loadUserData) noexcept;
+
+void destroyTextureCache(TextureCache& cache, TextureStreamer& streamer) noexcept;
+
+// Marks the asset used this frame and returns its texture once resident, the fallback while it is loading or cannot load.
+// An evicted asset is loaded again and queued on the streamer.
+GLuint getCachedTexture(TextureCache& cache, TextureStreamer& streamer, TextureAssetID asset, GLuint fallback) noexcept;
+
+// Once per frame after the streamer update: evicts least recently used textures until the cache fits its budget.
+// Textures used since the previous update and textures still loading are kept, so the budget may be exceeded for a while.
+void updateTextureCache(TextureCache& cache, TextureStreamer& streamer) noexcept;
+
+// Returns the counters gathered since the last call and clears them.
+TextureCacheStats takeTextureCacheStats(TextureCache& cache) noexcept;
+
+#endif
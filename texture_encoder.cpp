@@ -0,0 +1,639 @@
+#include <texture_encoder.hpp>
+#include <job_system.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+void print(const char* format, ...);
+
+namespace
+{
+// A level is split into jobs of at least this many blocks.
+constexpr unsigned int blocksPerJob = 1024;
+
+// BC7 4-bit index interpolation weights out of 64.
+constexpr int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+using EncodeBlockFunction = void(const unsigned char* texels, unsigned char* block);
+
+struct EncodePass
+{
+    const unsigned char* source{};
+    GLsizei width{};
+    GLsizei height{};
+
+    unsigned char* destination{};
+    GLsizei blocksPerRow{};
+    size_t blockSize{};
+
+    EncodeBlockFunction* encodeBlock{};
+};
+
+double getSeconds() noexcept
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+}
+
+int clampByte(int value) noexcept
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+int getSquaredDistance(const unsigned char* a, const int* b, int channelCount) noexcept
+{
+    int distance = 0;
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        const int d = a[c] - b[c];
+        distance += d * d;
+    }
+
+    return distance;
+}
+
+uint16_t packRgb565(const int* color) noexcept
+{
+    const int r = (color[0] * 31 + 127) / 255;
+    const int g = (color[1] * 63 + 127) / 255;
+    const int b = (color[2] * 31 + 127) / 255;
+
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRgb565(uint16_t packed, int* color) noexcept
+{
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Bounding box of the colors with the diagonal picked by the sign of the covariance, inset by 1/16 of its size.
+void encodeBc1Block(const unsigned char* texels, unsigned char* block) noexcept
+{
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const int value = texels[i * 4 + c];
+            minColor[c] = value < minColor[c] ? value : minColor[c];
+            maxColor[c] = value > maxColor[c] ? value : maxColor[c];
+        }
+    }
+
+    // Red and blue are flipped against green, which has the most precision.
+    int covarianceRed = 0;
+    int covarianceBlue = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int green = texels[i * 4 + 1] * 2 - (minColor[1] + maxColor[1]);
+        covarianceRed += (texels[i * 4 + 0] * 2 - (minColor[0] + maxColor[0])) * green;
+        covarianceBlue += (texels[i * 4 + 2] * 2 - (minColor[2] + maxColor[2])) * green;
+    }
+
+    if (covarianceRed < 0)
+    {
+        std::swap(minColor[0], maxColor[0]);
+    }
+
+    if (covarianceBlue < 0)
+    {
+        std::swap(minColor[2], maxColor[2]);
+    }
+
+    for (int c = 0; c < 3; ++c)
+    {
+        const int inset = (maxColor[c] - minColor[c]) / 16;
+        maxColor[c] = clampByte(maxColor[c] - inset);
+        minColor[c] = clampByte(minColor[c] + inset);
+    }
+
+    uint16_t color0 = packRgb565(maxColor);
+    uint16_t color1 = packRgb565(minColor);
+
+    // color0 > color1 selects the four color mode, equal endpoints leave all indices at 0.
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    int palette[4][3];
+    unpackRgb565(color0, palette[0]);
+    unpackRgb565(color1, palette[1]);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+
+    if (color0 != color1)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestIndex = 0;
+            int bestDistance = getSquaredDistance(texels + i * 4, palette[0], 3);
+
+            for (int index = 1; index < 4; ++index)
+            {
+                const int distance = getSquaredDistance(texels + i * 4, palette[index], 3);
+
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = index;
+                }
+            }
+
+            indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+        }
+    }
+
+    block[0] = static_cast<unsigned char>(color0);
+    block[1] = static_cast<unsigned char>(color0 >> 8);
+    block[2] = static_cast<unsigned char>(color1);
+    block[3] = static_cast<unsigned char>(color1 >> 8);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        block[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+}
+
+// Rounds an endpoint to 7 bits plus the shared p-bit, the p-bit giving the lower error is kept.
+void quantizeBc7Endpoint(const float* endpoint, int* quantized, int& pBit) noexcept
+{
+    float bestError = 1e30f;
+
+    for (int p = 0; p < 2; ++p)
+    {
+        int candidate[4];
+        float error = 0.0f;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            int value = static_cast<int>(std::lround((endpoint[c] - static_cast<float>(p)) * 0.5f));
+            value = value < 0 ? 0 : (value > 127 ? 127 : value);
+            candidate[c] = value;
+
+            const float d = static_cast<float>((value << 1) | p) - endpoint[c];
+            error += d * d;
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            pBit = p;
+            memcpy(quantized, candidate, sizeof(candidate));
+        }
+    }
+}
+
+struct BitWriter
+{
+    uint64_t bits[2]{};
+    int position{};
+};
+
+void writeBits(BitWriter& writer, uint32_t value, int count) noexcept
+{
+    for (int i = 0; i < count; ++i, ++writer.position)
+    {
+        writer.bits[writer.position >> 6] |= static_cast<uint64_t>((value >> i) & 1) << (writer.position & 63);
+    }
+}
+
+// Mode 6: one subset, 7-bit RGBA endpoints with a p-bit each and 4-bit indices, the endpoints span the principal axis.
+void encodeBc7Block(const unsigned char* texels, unsigned char* block) noexcept
+{
+    float mean[4]{};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            mean[c] += texels[i * 4 + c];
+        }
+    }
+
+    for (float& value : mean)
+    {
+        value *= 1.0f / 16.0f;
+    }
+
+    float covariance[4][4]{};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[4];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            d[c] = texels[i * 4 + c] - mean[c];
+        }
+
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                covariance[row][column] += d[row] * d[column];
+            }
+        }
+    }
+
+    // Power iteration from the luminance direction converges in a few steps for 16 texels.
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4]{};
+        float length = 0.0f;
+
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                next[row] += covariance[row][column] * axis[column];
+            }
+
+            length = std::fabs(next[row]) > length ? std::fabs(next[row]) : length;
+        }
+
+        if (length < 1e-6f)
+        {
+            break;
+        }
+
+        for (int c = 0; c < 4; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float axisLength = 0.0f;
+
+    for (float value : axis)
+    {
+        axisLength += value * value;
+    }
+
+    float minProjection = 0.0f;
+    float maxProjection = 0.0f;
+
+    if (axisLength > 0.0f)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            float projection = 0.0f;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+            }
+
+            projection /= axisLength;
+            minProjection = projection < minProjection ? projection : minProjection;
+            maxProjection = projection > maxProjection ? projection : maxProjection;
+        }
+    }
+
+    float endpoints[2][4];
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const float low = mean[c] + axis[c] * minProjection;
+        const float high = mean[c] + axis[c] * maxProjection;
+        endpoints[0][c] = low < 0.0f ? 0.0f : (low > 255.0f ? 255.0f : low);
+        endpoints[1][c] = high < 0.0f ? 0.0f : (high > 255.0f ? 255.0f : high);
+    }
+
+    int quantized[2][4];
+    int pBits[2];
+    quantizeBc7Endpoint(endpoints[0], quantized[0], pBits[0]);
+    quantizeBc7Endpoint(endpoints[1], quantized[1], pBits[1]);
+
+    int palette[16][4];
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const int e0 = (quantized[0][c] << 1) | pBits[0];
+        const int e1 = (quantized[1][c] << 1) | pBits[1];
+
+        for (int index = 0; index < 16; ++index)
+        {
+            palette[index][c] = ((64 - bc7Weights[index]) * e0 + bc7Weights[index] * e1 + 32) >> 6;
+        }
+    }
+
+    int indices[16];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int bestIndex = 0;
+        int bestDistance = getSquaredDistance(texels + i * 4, palette[0], 4);
+
+        for (int index = 1; index < 16; ++index)
+        {
+            const int distance = getSquaredDistance(texels + i * 4, palette[index], 4);
+
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                bestIndex = index;
+            }
+        }
+
+        indices[i] = bestIndex;
+    }
+
+    // The anchor index is stored without its top bit, so it must be below 8.
+    if (indices[0] >= 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pBits[0], pBits[1]);
+
+        for (int& index : indices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer;
+    writeBits(writer, 1u << 6, 7);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        writeBits(writer, static_cast<uint32_t>(quantized[0][c]), 7);
+        writeBits(writer, static_cast<uint32_t>(quantized[1][c]), 7);
+    }
+
+    writeBits(writer, static_cast<uint32_t>(pBits[0]), 1);
+    writeBits(writer, static_cast<uint32_t>(pBits[1]), 1);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        writeBits(writer, static_cast<uint32_t>(indices[i]), i == 0 ? 3 : 4);
+    }
+
+    assert(writer.position == 128);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        block[i] = static_cast<unsigned char>(writer.bits[i >> 3] >> ((i & 7) * 8));
+    }
+}
+
+void encodeBlockRows(void* userData, unsigned int begin, unsigned int end) noexcept
+{
+    const EncodePass& pass = *static_cast<const EncodePass*>(userData);
+
+    unsigned char texels[16 * 4];
+
+    for (unsigned int blockRow = begin; blockRow < end; ++blockRow)
+    {
+        for (GLsizei blockColumn = 0; blockColumn < pass.blocksPerRow; ++blockColumn)
+        {
+            // Blocks over the level edge repeat the last row and column.
+            for (GLsizei y = 0; y < 4; ++y)
+            {
+                const GLsizei sourceY = static_cast<GLsizei>(blockRow) * 4 + y;
+                const unsigned char* sourceRow = pass.source + static_cast<size_t>(sourceY < pass.height ? sourceY : pass.height - 1) * pass.width * textureTexelSize;
+
+                for (GLsizei x = 0; x < 4; ++x)
+                {
+                    const GLsizei sourceX = blockColumn * 4 + x;
+                    memcpy(texels + (y * 4 + x) * 4, sourceRow + static_cast<size_t>(sourceX < pass.width ? sourceX : pass.width - 1) * textureTexelSize, textureTexelSize);
+                }
+            }
+
+            pass.encodeBlock(texels, pass.destination + (static_cast<size_t>(blockRow) * pass.blocksPerRow + blockColumn) * pass.blockSize);
+        }
+    }
+}
+
+void writeLittleEndian32(unsigned char* p, uint32_t value) noexcept
+{
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+    p[2] = static_cast<unsigned char>(value >> 16);
+    p[3] = static_cast<unsigned char>(value >> 24);
+}
+
+uint32_t getDxgiFormat(GLenum internalFormat) noexcept
+{
+    switch (internalFormat)
+    {
+        case GL_RGBA8: return 28;
+        case GL_SRGB8_ALPHA8: return 29;
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return 71;
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: return 72;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return 77;
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return 78;
+        case GL_COMPRESSED_RED_RGTC1: return 80;
+        case GL_COMPRESSED_RG_RGTC2: return 83;
+        case GL_COMPRESSED_RGBA_BPTC_UNORM: return 98;
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM: return 99;
+    }
+
+    return 0;
+}
+}
+
+bool encodeTextureImage(const TextureImage& source, GLenum compressedFormat, TextureImage& destination, JobSystem* jobSystem) noexcept
+{
+    assert(source.width > 0 && source.height > 0 && source.levelCount > 0);
+    assert(&source != &destination);
+
+    const TextureFormatInfo sourceFormat = getTextureFormatInfo(source.internalFormat);
+    const TextureFormatInfo format = getTextureFormatInfo(compressedFormat);
+
+    EncodeBlockFunction* encodeBlock = nullptr;
+
+    switch (compressedFormat)
+    {
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            encodeBlock = encodeBc1Block;
+            break;
+
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            encodeBlock = encodeBc7Block;
+            break;
+    }
+
+    if (!encodeBlock || sourceFormat.blockSize != textureTexelSize || sourceFormat.isCompressed || sourceFormat.isSrgb != format.isSrgb)
+    {
+        print("Texture encoding failed: cannot encode format 0x%04X to 0x%04X.\n", source.internalFormat, compressedFormat);
+        return false;
+    }
+
+    TextureImage result;
+    result.width = source.width;
+    result.height = source.height;
+    result.levelCount = source.levelCount;
+    result.internalFormat = compressedFormat;
+    result.pixels.resize(getTextureLevelOffset(result, result.levelCount));
+
+    for (GLsizei level = 0; level < source.levelCount; ++level)
+    {
+        EncodePass pass;
+        pass.source = getTextureLevelData(source, level);
+        pass.width = getMipLevelSize(source.width, level);
+        pass.height = getMipLevelSize(source.height, level);
+        pass.destination = result.pixels.data() + getTextureLevelOffset(result, level);
+        pass.blocksPerRow = (pass.width + 3) / 4;
+        pass.blockSize = format.blockSize;
+        pass.encodeBlock = encodeBlock;
+
+        const unsigned int blockRowCount = static_cast<unsigned int>(getTextureLevelRowCount(result, level));
+
+        if (jobSystem)
+        {
+            const unsigned int blocksPerRow = static_cast<unsigned int>(pass.blocksPerRow);
+            const unsigned int grain = blocksPerRow >= blocksPerJob ? 1 : blocksPerJob / blocksPerRow;
+
+            parallelFor(*jobSystem, encodeBlockRows, &pass, blockRowCount, grain);
+        }
+        else
+        {
+            encodeBlockRows(&pass, 0, blockRowCount);
+        }
+    }
+
+    releaseTextureImage(destination);
+    destination = std::move(result);
+
+    return true;
+}
+
+bool saveDdsTexture(const char* path, const TextureImage& image) noexcept
+{
+    assert(path);
+
+    const uint32_t dxgiFormat = getDxgiFormat(image.internalFormat);
+
+    if (dxgiFormat == 0)
+    {
+        print("Cannot save format 0x%04X as DDS.\n", image.internalFormat);
+        return false;
+    }
+
+    const TextureFormatInfo format = getTextureFormatInfo(image.internalFormat);
+
+    unsigned char header[4 + 124 + 20]{};
+    memcpy(header, "DDS ", 4);
+
+    // Caps, height, width, pitch or linear size and mip count are set, the pixel format only points to the DX10 header.
+    writeLittleEndian32(header + 4, 124);
+    writeLittleEndian32(header + 8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | (format.isCompressed ? 0x80000 : 0x8));
+    writeLittleEndian32(header + 12, static_cast<uint32_t>(image.height));
+    writeLittleEndian32(header + 16, static_cast<uint32_t>(image.width));
+    writeLittleEndian32(header + 20, static_cast<uint32_t>(format.isCompressed ? getTextureLevelByteCount(image, 0) : getTextureLevelRowSize(image, 0)));
+    writeLittleEndian32(header + 28, static_cast<uint32_t>(image.levelCount));
+    writeLittleEndian32(header + 76, 32);
+    writeLittleEndian32(header + 80, 0x4);
+    memcpy(header + 84, "DX10", 4);
+    writeLittleEndian32(header + 108, 0x1000 | (image.levelCount > 1 ? 0x400008 : 0));
+
+    writeLittleEndian32(header + 128, dxgiFormat);
+    writeLittleEndian32(header + 132, 3);
+    writeLittleEndian32(header + 140, 1);
+
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        print("Cannot create texture file: %s\n", path);
+        return false;
+    }
+
+    DWORD written = 0;
+    bool saved = WriteFile(file, header, sizeof(header), &written, NULL) && written == sizeof(header);
+
+    for (GLsizei level = 0; saved && level < image.levelCount; ++level)
+    {
+        const DWORD byteCount = static_cast<DWORD>(getTextureLevelByteCount(image, level));
+        saved = WriteFile(file, getTextureLevelData(image, level), byteCount, &written, NULL) && written == byteCount;
+    }
+
+    CloseHandle(file);
+
+    if (!saved)
+    {
+        print("Cannot write texture file: %s\n", path);
+        DeleteFileA(path);
+    }
+
+    return saved;
+}
+
+void benchmarkTextureEncoding() noexcept
+{
+    constexpr GLsizei size = 2048;
+
+    TextureImage sourceImage;
+    sourceImage.width = size;
+    sourceImage.height = size;
+    sourceImage.levelCount = getFullMipLevelCount(size, size);
+    sourceImage.internalFormat = GL_RGBA8;
+    sourceImage.pixels.resize(getTextureLevelOffset(sourceImage, sourceImage.levelCount));
+
+    // Smooth gradients with noise, flat random data would only measure the worst case.
+    for (size_t i = 0; i < sourceImage.pixels.size(); i += textureTexelSize)
+    {
+        const size_t texel = i / textureTexelSize;
+        sourceImage.pixels[i + 0] = static_cast<unsigned char>(texel);
+        sourceImage.pixels[i + 1] = static_cast<unsigned char>(texel >> 4);
+        sourceImage.pixels[i + 2] = static_cast<unsigned char>((texel * 2654435761u) >> 28);
+        sourceImage.pixels[i + 3] = 255;
+    }
+
+    const unsigned int coreCount = getDefaultWorkerThreadCount() + 1;
+
+    print("Texture encoding, %dx%d with %d levels:\n", size, size, sourceImage.levelCount);
+
+    for (const GLenum compressedFormat : { GLenum(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT), GLenum(GL_COMPRESSED_RGBA_BPTC_UNORM) })
+    {
+        for (unsigned int threadCount = 1; ; threadCount = threadCount * 2 < coreCount ? threadCount * 2 : coreCount)
+        {
+            JobSystem* jobSystem = threadCount > 1 ? createJobSystem(threadCount - 1) : nullptr;
+
+            TextureImage image;
+
+            const double start = getSeconds();
+            encodeTextureImage(sourceImage, compressedFormat, image, jobSystem);
+            const double seconds = getSeconds() - start;
+
+            if (jobSystem)
+            {
+                destroyJobSystem(jobSystem);
+            }
+
+            print("    %s, %2u threads: %8.3f ms, %.1f Mtexels/s\n", compressedFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? "BC1" : "BC7",
+                threadCount, seconds * 1000.0, static_cast<double>(sourceImage.pixels.size() / textureTexelSize) / seconds * 1e-6);
+
+            if (threadCount == coreCount)
+            {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef KZ_TEXTURE_ENCODER_HPP
+#define KZ_TEXTURE_ENCODER_HPP
+
+#include <texture_image.hpp>
+
+struct JobSystem;
+
+// Encodes every level of an RGBA8 or sRGB image to BC1 (GL_COMPRESSED_RGBA_S3TC_DXT1_EXT and its sRGB variant)
+// or BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM and its sRGB variant), the sRGB-ness of source and destination must match.
+// BC1 fits the bounding box diagonal, BC7 uses mode 6 only with endpoints on the principal axis.
+// Block rows are split over the job system when one is given.
+bool encodeTextureImage(const TextureImage& source, GLenum compressedFormat, TextureImage& destination, JobSystem* jobSystem) noexcept;
+
+// Writes all levels as a DDS file with a DX10 header, readable by loadTextureFile.
+bool saveDdsTexture(const char* path, const TextureImage& image) noexcept;
+
+// BC1 and BC7 encoding of a 2048x2048 image with its mip chain from one to all cores.
+void benchmarkTextureEncoding() noexcept;
+
+#endif
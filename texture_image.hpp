@@ -0,0 +1,145 @@
+#ifndef KZ_TEXTURE_IMAGE_HPP
+#define KZ_TEXTURE_IMAGE_HPP
+
+#include "gl_functions.h"
+#include <mapped_file.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// EXT_texture_sRGB formats of S3TC, not part of glcorearb.h.
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+constexpr size_t textureTexelSize = 4;
+constexpr GLsizei maxTextureLevelCount = 16;
+
+// Uncompressed formats are 1x1 blocks of one texel.
+struct TextureFormatInfo
+{
+    GLsizei blockWidth{};
+    GLsizei blockHeight{};
+    size_t blockSize{};
+
+    // GL pixel format and type of uncompressed uploads.
+    GLenum uploadFormat{};
+    GLenum uploadType{};
+
+    bool isCompressed{};
+    bool isSrgb{};
+};
+
+// Texels of every mip level, level 0 first.
+struct TextureImage
+{
+    GLsizei width{};
+    GLsizei height{};
+    GLsizei levelCount{ 1 };
+
+    // GL_RGBA8, GL_SRGB8_ALPHA8 or one of the BC and ETC2 formats.
+    GLenum internalFormat{ GL_RGBA8 };
+
+    // Levels packed one after another.
+    std::vector<unsigned char> pixels;
+
+    // When mapped, the levels are read in place from the container and pixels stays empty.
+    // The image owns the mapping, so a mapped image is moved but never copied, and the moved-from image is not released.
+    MappedFile file;
+    size_t fileLevelOffsets[maxTextureLevelCount]{};
+};
+
+inline TextureFormatInfo getTextureFormatInfo(GLenum internalFormat) noexcept
+{
+    switch (internalFormat)
+    {
+        case GL_RGBA8: return { 1, 1, 4, GL_RGBA, GL_UNSIGNED_BYTE, false, false };
+        case GL_SRGB8_ALPHA8: return { 1, 1, 4, GL_RGBA, GL_UNSIGNED_BYTE, false, true };
+
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return { 4, 4, 8, 0, 0, true, false };
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: return { 4, 4, 8, 0, 0, true, false };
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: return { 4, 4, 8, 0, 0, true, true };
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT: return { 4, 4, 8, 0, 0, true, true };
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return { 4, 4, 16, 0, 0, true, false };
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return { 4, 4, 16, 0, 0, true, true };
+        case GL_COMPRESSED_RED_RGTC1: return { 4, 4, 8, 0, 0, true, false };
+        case GL_COMPRESSED_RG_RGTC2: return { 4, 4, 16, 0, 0, true, false };
+        case GL_COMPRESSED_RGBA_BPTC_UNORM: return { 4, 4, 16, 0, 0, true, false };
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM: return { 4, 4, 16, 0, 0, true, true };
+        case GL_COMPRESSED_RGB8_ETC2: return { 4, 4, 8, 0, 0, true, false };
+        case GL_COMPRESSED_SRGB8_ETC2: return { 4, 4, 8, 0, 0, true, true };
+        case GL_COMPRESSED_RGBA8_ETC2_EAC: return { 4, 4, 16, 0, 0, true, false };
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC: return { 4, 4, 16, 0, 0, true, true };
+    }
+
+    return {};
+}
+
+inline GLsizei getMipLevelSize(GLsizei size, GLsizei level) noexcept
+{
+    const GLsizei levelSize = size >> level;
+
+    return levelSize > 0 ? levelSize : 1;
+}
+
+// Levels down to 1x1.
+inline GLsizei getFullMipLevelCount(GLsizei width, GLsizei height) noexcept
+{
+    GLsizei levelCount = 1;
+
+    for (GLsizei size = width > height ? width : height; size > 1; size >>= 1)
+    {
+        ++levelCount;
+    }
+
+    return levelCount;
+}
+
+// Rows of blocks, texel rows for uncompressed formats.
+inline GLsizei getTextureLevelRowCount(const TextureImage& image, GLsizei level) noexcept
+{
+    const TextureFormatInfo format = getTextureFormatInfo(image.internalFormat);
+
+    return (getMipLevelSize(image.height, level) + format.blockHeight - 1) / format.blockHeight;
+}
+
+inline size_t getTextureLevelRowSize(const TextureImage& image, GLsizei level) noexcept
+{
+    const TextureFormatInfo format = getTextureFormatInfo(image.internalFormat);
+
+    return static_cast<size_t>((getMipLevelSize(image.width, level) + format.blockWidth - 1) / format.blockWidth) * format.blockSize;
+}
+
+inline size_t getTextureLevelByteCount(const TextureImage& image, GLsizei level) noexcept
+{
+    return static_cast<size_t>(getTextureLevelRowCount(image, level)) * getTextureLevelRowSize(image, level);
+}
+
+// Offset of the level inside the packed pixels.
+inline size_t getTextureLevelOffset(const TextureImage& image, GLsizei level) noexcept
+{
+    size_t offset = 0;
+
+    for (GLsizei i = 0; i < level; ++i)
+    {
+        offset += getTextureLevelByteCount(image, i);
+    }
+
+    return offset;
+}
+
+inline const unsigned char* getTextureLevelData(const TextureImage& image, GLsizei level) noexcept
+{
+    return image.file.data ? image.file.data + image.fileLevelOffsets[level] : image.pixels.data() + getTextureLevelOffset(image, level);
+}
+
+// Frees the texels or the mapping once they were copied.
+inline void releaseTextureImage(TextureImage& image) noexcept
+{
+    std::vector<unsigned char>().swap(image.pixels);
+    unmapFile(image.file);
+}
+
+#endif
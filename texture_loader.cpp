@@ -0,0 +1,308 @@
+#include <texture_loader.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+void print(const char* format, ...);
+
+namespace
+{
+constexpr size_t ddsHeaderSize = 4 + 124;
+constexpr size_t ddsDx10HeaderSize = 20;
+
+constexpr uint32_t ddsFlagMipMapCount = 0x20000;
+constexpr uint32_t ddsPixelFormatFourCC = 0x4;
+constexpr uint32_t ddsPixelFormatRgb = 0x40;
+constexpr uint32_t ddsCaps2CubeMap = 0x200;
+constexpr uint32_t ddsCaps2Volume = 0x200000;
+constexpr uint32_t ddsDimensionTexture2D = 3;
+constexpr uint32_t ddsMiscTextureCube = 0x4;
+
+constexpr unsigned char ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+constexpr size_t ktx2HeaderSize = 80;
+constexpr size_t ktx2LevelIndexEntrySize = 24;
+
+uint32_t readLittleEndian32(const unsigned char* p) noexcept
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t readLittleEndian64(const unsigned char* p) noexcept
+{
+    return static_cast<uint64_t>(readLittleEndian32(p)) | (static_cast<uint64_t>(readLittleEndian32(p + 4)) << 32);
+}
+
+constexpr uint32_t makeFourCC(char a, char b, char c, char d) noexcept
+{
+    return static_cast<uint32_t>(static_cast<unsigned char>(a)) | (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16) | (static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24);
+}
+
+GLenum getDdsFourCCFormat(uint32_t fourCC) noexcept
+{
+    switch (fourCC)
+    {
+        case makeFourCC('D', 'X', 'T', '1'): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case makeFourCC('D', 'X', 'T', '5'): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case makeFourCC('A', 'T', 'I', '1'): return GL_COMPRESSED_RED_RGTC1;
+        case makeFourCC('B', 'C', '4', 'U'): return GL_COMPRESSED_RED_RGTC1;
+        case makeFourCC('A', 'T', 'I', '2'): return GL_COMPRESSED_RG_RGTC2;
+        case makeFourCC('B', 'C', '5', 'U'): return GL_COMPRESSED_RG_RGTC2;
+    }
+
+    return 0;
+}
+
+GLenum getDxgiFormat(uint32_t dxgiFormat) noexcept
+{
+    switch (dxgiFormat)
+    {
+        case 28: return GL_RGBA8;
+        case 29: return GL_SRGB8_ALPHA8;
+        case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+        case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        case 80: return GL_COMPRESSED_RED_RGTC1;
+        case 83: return GL_COMPRESSED_RG_RGTC2;
+        case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    }
+
+    return 0;
+}
+
+GLenum getVkFormat(uint32_t vkFormat) noexcept
+{
+    switch (vkFormat)
+    {
+        case 37: return GL_RGBA8;
+        case 43: return GL_SRGB8_ALPHA8;
+        case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+        case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        case 139: return GL_COMPRESSED_RED_RGTC1;
+        case 141: return GL_COMPRESSED_RG_RGTC2;
+        case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        case 147: return GL_COMPRESSED_RGB8_ETC2;
+        case 148: return GL_COMPRESSED_SRGB8_ETC2;
+        case 151: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case 152: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+    }
+
+    return 0;
+}
+
+// Common checks of both containers once the format and the level count are known.
+bool isValidTextureImage(const TextureImage& image) noexcept
+{
+    return image.internalFormat != 0 && image.width > 0 && image.height > 0 &&
+           image.levelCount > 0 && image.levelCount <= maxTextureLevelCount &&
+           image.levelCount <= getFullMipLevelCount(image.width, image.height);
+}
+
+bool loadDdsTexture(const MappedFile& file, TextureImage& image) noexcept
+{
+    const unsigned char* data = file.data;
+
+    if (file.size < ddsHeaderSize || readLittleEndian32(data + 4) != 124)
+    {
+        return false;
+    }
+
+    const uint32_t flags = readLittleEndian32(data + 8);
+    const uint32_t mipMapCount = readLittleEndian32(data + 28);
+    const uint32_t pixelFormatFlags = readLittleEndian32(data + 80);
+    const uint32_t fourCC = readLittleEndian32(data + 84);
+    const uint32_t caps2 = readLittleEndian32(data + 112);
+
+    if (caps2 & (ddsCaps2CubeMap | ddsCaps2Volume))
+    {
+        return false;
+    }
+
+    image.width = static_cast<GLsizei>(readLittleEndian32(data + 16));
+    image.height = static_cast<GLsizei>(readLittleEndian32(data + 12));
+    image.levelCount = (flags & ddsFlagMipMapCount) && mipMapCount > 0 ? static_cast<GLsizei>(mipMapCount) : 1;
+
+    size_t dataOffset = ddsHeaderSize;
+
+    if ((pixelFormatFlags & ddsPixelFormatFourCC) && fourCC == makeFourCC('D', 'X', '1', '0'))
+    {
+        if (file.size < ddsHeaderSize + ddsDx10HeaderSize)
+        {
+            return false;
+        }
+
+        const unsigned char* dx10 = data + ddsHeaderSize;
+
+        if (readLittleEndian32(dx10 + 4) != ddsDimensionTexture2D || (readLittleEndian32(dx10 + 8) & ddsMiscTextureCube) || readLittleEndian32(dx10 + 12) > 1)
+        {
+            return false;
+        }
+
+        image.internalFormat = getDxgiFormat(readLittleEndian32(dx10));
+        dataOffset += ddsDx10HeaderSize;
+    }
+    else if (pixelFormatFlags & ddsPixelFormatFourCC)
+    {
+        image.internalFormat = getDdsFourCCFormat(fourCC);
+    }
+    else if ((pixelFormatFlags & ddsPixelFormatRgb) && readLittleEndian32(data + 88) == 32 &&
+             readLittleEndian32(data + 92) == 0x000000FF && readLittleEndian32(data + 96) == 0x0000FF00 &&
+             readLittleEndian32(data + 100) == 0x00FF0000)
+    {
+        image.internalFormat = GL_RGBA8;
+    }
+    else
+    {
+        image.internalFormat = 0;
+    }
+
+    if (!isValidTextureImage(image))
+    {
+        return false;
+    }
+
+    // Levels follow the header back to back, level 0 first.
+    for (GLsizei level = 0; level < image.levelCount; ++level)
+    {
+        image.fileLevelOffsets[level] = dataOffset;
+        dataOffset += getTextureLevelByteCount(image, level);
+    }
+
+    return dataOffset <= file.size;
+}
+
+bool loadKtx2Texture(const MappedFile& file, TextureImage& image) noexcept
+{
+    const unsigned char* data = file.data;
+
+    if (file.size < ktx2HeaderSize)
+    {
+        return false;
+    }
+
+    const uint32_t vkFormat = readLittleEndian32(data + 12);
+    const uint32_t depth = readLittleEndian32(data + 28);
+    const uint32_t layerCount = readLittleEndian32(data + 32);
+    const uint32_t faceCount = readLittleEndian32(data + 36);
+    const uint32_t levelCount = readLittleEndian32(data + 40);
+    const uint32_t supercompressionScheme = readLittleEndian32(data + 44);
+
+    if (depth != 0 || layerCount > 1 || faceCount != 1 || supercompressionScheme != 0)
+    {
+        return false;
+    }
+
+    image.width = static_cast<GLsizei>(readLittleEndian32(data + 20));
+    image.height = static_cast<GLsizei>(readLittleEndian32(data + 24));
+
+    // Zero asks the loader to generate the levels, the single stored level is used as is.
+    image.levelCount = levelCount > 0 ? static_cast<GLsizei>(levelCount) : 1;
+    image.internalFormat = getVkFormat(vkFormat);
+
+    if (!isValidTextureImage(image) || file.size < ktx2HeaderSize + static_cast<size_t>(image.levelCount) * ktx2LevelIndexEntrySize)
+    {
+        return false;
+    }
+
+    // The level index lists level 0 first, the data itself is usually stored smallest level first.
+    for (GLsizei level = 0; level < image.levelCount; ++level)
+    {
+        const unsigned char* entry = data + ktx2HeaderSize + static_cast<size_t>(level) * ktx2LevelIndexEntrySize;
+        const uint64_t byteOffset = readLittleEndian64(entry);
+        const uint64_t byteLength = readLittleEndian64(entry + 8);
+
+        if (byteLength < getTextureLevelByteCount(image, level) || byteOffset > file.size || byteLength > file.size - byteOffset)
+        {
+            return false;
+        }
+
+        image.fileLevelOffsets[level] = static_cast<size_t>(byteOffset);
+    }
+
+    return true;
+}
+}
+
+bool loadTextureFile(const char* path, TextureImage& image) noexcept
+{
+    assert(path);
+
+    MappedFile file = mapFileForReading(path);
+
+    if (!file.data)
+    {
+        print("Cannot open texture file: %s\n", path);
+        return false;
+    }
+
+    TextureImage result;
+    bool loaded = false;
+
+    if (file.size >= sizeof(ktx2Identifier) && memcmp(file.data, ktx2Identifier, sizeof(ktx2Identifier)) == 0)
+    {
+        loaded = loadKtx2Texture(file, result);
+    }
+    else if (file.size >= 4 && memcmp(file.data, "DDS ", 4) == 0)
+    {
+        loaded = loadDdsTexture(file, result);
+    }
+
+    if (!loaded)
+    {
+        print("Texture load failed: %s is not a supported KTX2 or DDS 2D texture.\n", path);
+        unmapFile(file);
+        return false;
+    }
+
+    result.file = file;
+
+    releaseTextureImage(image);
+    image = std::move(result);
+
+    print("Mapped %s: %dx%d, %d levels, format 0x%04X\n", path, image.width, image.height, image.levelCount, image.internalFormat);
+
+    return true;
+}
+
+bool isTextureFormatSupported(GLenum internalFormat) noexcept
+{
+    if (!getTextureFormatInfo(internalFormat).isCompressed)
+    {
+        return internalFormat == GL_RGBA8 || internalFormat == GL_SRGB8_ALPHA8;
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+
+    std::vector<GLint> formats(static_cast<size_t>(formatCount > 0 ? formatCount : 0));
+
+    if (!formats.empty())
+    {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    for (GLint format : formats)
+    {
+        if (static_cast<GLenum>(format) == internalFormat)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
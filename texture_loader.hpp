@@ -0,0 +1,15 @@
+#ifndef KZ_TEXTURE_LOADER_HPP
+#define KZ_TEXTURE_LOADER_HPP
+
+#include <texture_image.hpp>
+
+// Maps a KTX2 or DDS container and points the image levels into the mapping, nothing is decoded or copied.
+// Only single 2D images are accepted: no arrays, cube maps, volumes or KTX2 supercompression.
+// Makes no GL calls, so it may run on any thread.
+bool loadTextureFile(const char* path, TextureImage& image) noexcept;
+
+// Whether the driver lists the format in GL_COMPRESSED_TEXTURE_FORMATS, uncompressed formats are always supported.
+// Render thread only.
+bool isTextureFormatSupported(GLenum internalFormat) noexcept;
+
+#endif
@@ -0,0 +1,147 @@
+#include <texture_pool.hpp>
+#include <gl_state_cache.hpp>
+
+#include <cassert>
+#include <utility>
+
+void print(const char* format, ...);
+
+namespace
+{
+bool isMatchingArray(const TextureArray& textureArray, const TextureImage& image) noexcept
+{
+    return textureArray.internalFormat == image.internalFormat && textureArray.width == image.width &&
+           textureArray.height == image.height && textureArray.levelCount == image.levelCount;
+}
+
+TextureArray createTextureArray(const TexturePool& pool, const TextureImage& image) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    TextureArray textureArray;
+    textureArray.internalFormat = image.internalFormat;
+    textureArray.width = image.width;
+    textureArray.height = image.height;
+    textureArray.levelCount = image.levelCount;
+    textureArray.layerByteCount = getTextureLevelOffset(image, image.levelCount);
+
+    const size_t fittingLayerCount = pool.arrayByteSize / textureArray.layerByteCount;
+
+    textureArray.layerCount = fittingLayerCount < 1 ? 1 : (fittingLayerCount > static_cast<size_t>(pool.maxLayerCount) ? pool.maxLayerCount : static_cast<GLsizei>(fittingLayerCount));
+
+    // Storage only, the layers arrive from the streamer.
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &textureArray.texture);
+    glTextureStorage3D(textureArray.texture, textureArray.levelCount, textureArray.internalFormat, textureArray.width, textureArray.height, textureArray.layerCount);
+
+    // Layer 0 is taken first.
+    for (GLint layer = textureArray.layerCount - 1; layer >= 0; --layer)
+    {
+        textureArray.freeLayers.push_back(layer);
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return textureArray;
+}
+}
+
+TexturePool createTexturePool(size_t arrayByteSize) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(arrayByteSize > 0);
+
+    TexturePool pool;
+    pool.arrayByteSize = arrayByteSize;
+
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &pool.maxLayerCount);
+    assert(pool.maxLayerCount >= 256);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return pool;
+}
+
+void destroyTexturePool(TexturePool& pool) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    for (TextureArray& textureArray : pool.arrays)
+    {
+        forgetCachedTexture(textureArray.texture);
+        glDeleteTextures(1, &textureArray.texture);
+    }
+
+    pool = {};
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+TexturePoolSlot addPooledTexture(TexturePool& pool, TextureStreamer& streamer, TextureImage&& image) noexcept
+{
+    assert(image.width > 0 && image.height > 0 && image.levelCount > 0);
+
+    size_t arrayIndex = 0;
+
+    while (arrayIndex < pool.arrays.size() && !(isMatchingArray(pool.arrays[arrayIndex], image) && !pool.arrays[arrayIndex].freeLayers.empty()))
+    {
+        ++arrayIndex;
+    }
+
+    if (arrayIndex == pool.arrays.size())
+    {
+        pool.arrays.push_back(createTextureArray(pool, image));
+
+        const TextureArray& textureArray = pool.arrays.back();
+
+        print("Texture pool array %zu: %dx%d, %d levels, format 0x%04X, %d layers\n",
+            arrayIndex, textureArray.width, textureArray.height, textureArray.levelCount, textureArray.internalFormat, textureArray.layerCount);
+    }
+
+    TextureArray& textureArray = pool.arrays[arrayIndex];
+
+    TexturePoolSlot slot;
+    slot.arrayIndex = static_cast<unsigned int>(arrayIndex);
+    slot.layer = textureArray.freeLayers.back();
+    textureArray.freeLayers.pop_back();
+
+    slot.upload = requestTextureLayerUpload(streamer, textureArray.texture, slot.layer, std::move(image));
+
+    return slot;
+}
+
+void removePooledTexture(TexturePool& pool, TexturePoolSlot& slot) noexcept
+{
+    assert(slot.arrayIndex < pool.arrays.size());
+    assert(slot.layer >= 0 && slot.layer < pool.arrays[slot.arrayIndex].layerCount);
+
+    pool.arrays[slot.arrayIndex].freeLayers.push_back(slot.layer);
+
+    slot.layer = -1;
+}
+
+GLuint getPooledTextureArray(const TexturePool& pool, const TexturePoolSlot& slot) noexcept
+{
+    assert(slot.arrayIndex < pool.arrays.size());
+
+    return pool.arrays[slot.arrayIndex].texture;
+}
+
+bool isPooledTextureResident(const TextureStreamer& streamer, const TexturePoolSlot& slot) noexcept
+{
+    return slot.layer >= 0 && getResidentTexture(streamer, slot.upload, 0) != 0;
+}
+
+TexturePoolStats getTexturePoolStats(const TexturePool& pool) noexcept
+{
+    TexturePoolStats stats;
+
+    for (const TextureArray& textureArray : pool.arrays)
+    {
+        ++stats.arrayCount;
+        stats.layerCount += static_cast<unsigned int>(textureArray.layerCount);
+        stats.usedLayerCount += static_cast<unsigned int>(textureArray.layerCount - static_cast<GLsizei>(textureArray.freeLayers.size()));
+        stats.byteCount += static_cast<uint64_t>(textureArray.layerByteCount) * static_cast<uint64_t>(textureArray.layerCount);
+    }
+
+    return stats;
+}
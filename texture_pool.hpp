@@ -0,0 +1,75 @@
+#ifndef KZ_TEXTURE_POOL_HPP
+#define KZ_TEXTURE_POOL_HPP
+
+#include "gl_functions.h"
+#include <texture_streaming.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// One GL_TEXTURE_2D_ARRAY, every layer has the same format, size and level count.
+struct TextureArray
+{
+    GLuint texture{};
+
+    GLenum internalFormat{};
+    GLsizei width{};
+    GLsizei height{};
+    GLsizei levelCount{};
+    GLsizei layerCount{};
+
+    // Bytes of one layer with all its levels.
+    size_t layerByteCount{};
+
+    // Unused layers, taken from the back.
+    std::vector<GLint> freeLayers;
+};
+
+// Array and layer of a pooled texture, the layer index is what draws pass per instance.
+struct TexturePoolSlot
+{
+    unsigned int arrayIndex{};
+    GLint layer{ -1 };
+
+    // Upload of the layer, the layer may be sampled once it is resident.
+    StreamedTextureID upload{};
+};
+
+struct TexturePoolStats
+{
+    unsigned int arrayCount{};
+    unsigned int usedLayerCount{};
+    unsigned int layerCount{};
+
+    // Storage of all arrays, used or not.
+    uint64_t byteCount{};
+};
+
+// Packs same-format textures into array layers, so draws of many materials share one bind.
+struct TexturePool
+{
+    std::vector<TextureArray> arrays;
+
+    // Storage of a new array, its layer count is what fits, at least one and at most the GL limit.
+    size_t arrayByteSize{};
+    GLsizei maxLayerCount{};
+};
+
+TexturePool createTexturePool(size_t arrayByteSize) noexcept;
+
+void destroyTexturePool(TexturePool& pool) noexcept;
+
+// Takes a free layer of an array with the image's format, size and level count, creating the array when all are full.
+// The image levels stream into the layer, mip levels must already be in the image.
+TexturePoolSlot addPooledTexture(TexturePool& pool, TextureStreamer& streamer, TextureImage&& image) noexcept;
+
+// Returns the layer to its array, only once the slot is resident so no copy is still queued into it.
+void removePooledTexture(TexturePool& pool, TexturePoolSlot& slot) noexcept;
+
+GLuint getPooledTextureArray(const TexturePool& pool, const TexturePoolSlot& slot) noexcept;
+
+bool isPooledTextureResident(const TextureStreamer& streamer, const TexturePoolSlot& slot) noexcept;
+
+TexturePoolStats getTexturePoolStats(const TexturePool& pool) noexcept;
+
+#endif
@@ -0,0 +1,94 @@
+#include <texture_samplers.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace
+{
+struct SharedSampler
+{
+    SamplerDescription description;
+    GLuint sampler{};
+};
+
+// Few distinct descriptions exist, a linear search is enough.
+std::vector<SharedSampler> sharedSamplers;
+
+constexpr SamplerDescription sharedSamplerDescriptions[samplerTypeCount] =
+{
+    { GL_NEAREST, GL_NEAREST, GL_REPEAT, 1.0f },
+    { GL_LINEAR, GL_LINEAR, GL_REPEAT, 1.0f },
+    { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, 1.0f },
+    { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, 16.0f },
+
+    // Immutable single level textures are mipmap complete, so the mip filter suits both.
+    { GL_NEAREST_MIPMAP_NEAREST, GL_NEAREST, GL_CLAMP_TO_EDGE, 1.0f },
+};
+
+bool isSameDescription(const SamplerDescription& a, const SamplerDescription& b) noexcept
+{
+    return a.minFilter == b.minFilter && a.magFilter == b.magFilter && a.wrap == b.wrap && a.maxAnisotropy == b.maxAnisotropy;
+}
+
+GLuint createSampler(const SamplerDescription& description) noexcept
+{
+    GLuint sampler = 0;
+    glCreateSamplers(1, &sampler);
+
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, description.minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, description.magFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, description.wrap);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, description.wrap);
+
+    if (description.maxAnisotropy > 1.0f)
+    {
+        // Core since 4.6, the same enum as EXT_texture_filter_anisotropic which every 4.5 driver exposes.
+        GLfloat maxAnisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, description.maxAnisotropy < maxAnisotropy ? description.maxAnisotropy : maxAnisotropy);
+    }
+
+    return sampler;
+}
+}
+
+GLuint getSampler(const SamplerDescription& description) noexcept
+{
+    for (const SharedSampler& shared : sharedSamplers)
+    {
+        if (isSameDescription(shared.description, description))
+        {
+            return shared.sampler;
+        }
+    }
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    SharedSampler shared;
+    shared.description = description;
+    shared.sampler = createSampler(description);
+
+    sharedSamplers.push_back(shared);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return shared.sampler;
+}
+
+GLuint getSharedSampler(SamplerType type) noexcept
+{
+    assert(type < samplerTypeCount);
+
+    return getSampler(sharedSamplerDescriptions[type]);
+}
+
+void destroySharedSamplers() noexcept
+{
+    for (const SharedSampler& shared : sharedSamplers)
+    {
+        glDeleteSamplers(1, &shared.sampler);
+    }
+
+    sharedSamplers.clear();
+}
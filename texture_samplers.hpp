@@ -0,0 +1,41 @@
+#ifndef KZ_TEXTURE_SAMPLERS_HPP
+#define KZ_TEXTURE_SAMPLERS_HPP
+
+#include "gl_functions.h"
+
+// Sampling state of a texture binding, a texture carries none of its own.
+struct SamplerDescription
+{
+    GLint minFilter{ GL_NEAREST };
+    GLint magFilter{ GL_NEAREST };
+    GLint wrap{ GL_REPEAT };
+
+    // 1 disables anisotropic filtering, clamped to the device limit.
+    GLfloat maxAnisotropy{ 1.0f };
+};
+
+// Common descriptions, each maps to one shared sampler object.
+enum SamplerType : unsigned int
+{
+    // Material textures drawn texel by texel.
+    samplerPointRepeat,
+    samplerLinearRepeat,
+
+    // Blends between the two nearest mip levels.
+    samplerTrilinearRepeat,
+    samplerAnisotropicRepeat,
+
+    // Depth and Hi-Z fetches, every mip level is complete.
+    samplerPointClamp,
+
+    samplerTypeCount,
+};
+
+// Samplers are shared by all textures with the same description, created on first use with the context current.
+GLuint getSampler(const SamplerDescription& description) noexcept;
+
+GLuint getSharedSampler(SamplerType type) noexcept;
+
+void destroySharedSamplers() noexcept;
+
+#endif
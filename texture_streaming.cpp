@@ -0,0 +1,396 @@
+#include <texture_streaming.hpp>
+#include <gl_state_cache.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Space for the rows at the head of the ring, wrapping to the start when the end is too short.
+bool allocateStagingSpace(TextureStreamer& streamer, size_t byteCount, size_t& offset, size_t& frameByteCount) noexcept
+{
+    if (streamer.stagingUsed == 0)
+    {
+        streamer.stagingHead = 0;
+        streamer.stagingTail = 0;
+    }
+
+    if (streamer.stagingUsed + byteCount > streamer.stagingSize)
+    {
+        return false;
+    }
+
+    size_t skippedByteCount = 0;
+
+    if (streamer.stagingHead >= streamer.stagingTail)
+    {
+        if (streamer.stagingSize - streamer.stagingHead >= byteCount)
+        {
+            offset = streamer.stagingHead;
+        }
+        else if (streamer.stagingTail >= byteCount)
+        {
+            // The end of the ring stays unused until the frame retires.
+            skippedByteCount = streamer.stagingSize - streamer.stagingHead;
+            offset = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else if (streamer.stagingTail - streamer.stagingHead >= byteCount)
+    {
+        offset = streamer.stagingHead;
+    }
+    else
+    {
+        return false;
+    }
+
+    streamer.stagingHead = offset + byteCount;
+    streamer.stagingUsed += skippedByteCount + byteCount;
+    frameByteCount += skippedByteCount + byteCount;
+
+    return true;
+}
+
+// Queues the texture in a released entry when there is one.
+StreamedTextureID addStreamedTexture(TextureStreamer& streamer, StreamedTexture&& texture) noexcept
+{
+    StreamedTextureID id = static_cast<StreamedTextureID>(streamer.textures.size());
+
+    if (streamer.freeTextureIDs.empty())
+    {
+        streamer.textures.push_back(std::move(texture));
+    }
+    else
+    {
+        id = streamer.freeTextureIDs.back();
+        streamer.freeTextureIDs.pop_back();
+
+        streamer.textures[id] = std::move(texture);
+    }
+
+    streamer.queue.push_back(id);
+
+    return id;
+}
+
+void retireStagingFrames(TextureStreamer& streamer) noexcept
+{
+    size_t retiredCount = 0;
+
+    for (StagingFrame& frame : streamer.frames)
+    {
+        const GLenum result = glClientWaitSync(frame.fence, 0, 0);
+
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+
+        glDeleteSync(frame.fence);
+
+        streamer.stagingTail = frame.ringEnd;
+        streamer.stagingUsed -= frame.byteCount;
+        streamer.stats.uploadedCount += frame.completedCount;
+
+        ++streamer.retiredFrameCount;
+        ++retiredCount;
+    }
+
+    streamer.frames.erase(streamer.frames.begin(), streamer.frames.begin() + retiredCount);
+}
+}
+
+TextureStreamer createTextureStreamer(size_t stagingSize, size_t frameByteBudget) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(stagingSize > 0 && frameByteBudget > 0);
+
+    TextureStreamer streamer;
+
+    streamer.stagingSize = stagingSize;
+    streamer.frameByteBudget = frameByteBudget;
+
+    // Coherent, writes through the mapping are seen by every later copy without a flush.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &streamer.stagingBuffer);
+    glNamedBufferStorage(streamer.stagingBuffer, stagingSize, nullptr, flags);
+
+    streamer.stagingMemory = static_cast<unsigned char*>(glMapNamedBufferRange(streamer.stagingBuffer, 0, stagingSize, flags));
+    assert(streamer.stagingMemory);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return streamer;
+}
+
+void destroyTextureStreamer(TextureStreamer& streamer) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    for (StagingFrame& frame : streamer.frames)
+    {
+        glDeleteSync(frame.fence);
+    }
+
+    for (StreamedTexture& texture : streamer.textures)
+    {
+        if (texture.layer < 0)
+        {
+            forgetCachedTexture(texture.texture);
+            glDeleteTextures(1, &texture.texture);
+        }
+
+        releaseTextureImage(texture.image);
+    }
+
+    glUnmapNamedBuffer(streamer.stagingBuffer);
+    glDeleteBuffers(1, &streamer.stagingBuffer);
+
+    streamer = {};
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+StreamedTextureID requestTextureUpload(TextureStreamer& streamer, TextureImage&& image, bool generateMipmaps) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(image.width > 0 && image.height > 0 && image.levelCount > 0 && image.levelCount <= maxTextureLevelCount);
+    assert(image.file.data || image.pixels.size() == getTextureLevelOffset(image, image.levelCount));
+
+    // Compressed formats are not renderable, the GPU cannot filter their levels.
+    assert(!generateMipmaps || !getTextureFormatInfo(image.internalFormat).isCompressed);
+
+    StreamedTexture texture;
+    texture.image = std::move(image);
+    texture.isMipmapGenerated = generateMipmaps;
+
+    if (generateMipmaps)
+    {
+        texture.image.levelCount = 1;
+    }
+
+    const GLsizei storageLevelCount = generateMipmaps ? getFullMipLevelCount(texture.image.width, texture.image.height) : texture.image.levelCount;
+
+    // Storage only, the rows arrive from the staging ring.
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture.texture);
+    glTextureStorage2D(texture.texture, storageLevelCount, texture.image.internalFormat, texture.image.width, texture.image.height);
+
+    const StreamedTextureID id = addStreamedTexture(streamer, std::move(texture));
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return id;
+}
+
+StreamedTextureID requestTextureLayerUpload(TextureStreamer& streamer, GLuint arrayTexture, GLint layer, TextureImage&& image) noexcept
+{
+    assert(arrayTexture != 0 && layer >= 0);
+    assert(image.width > 0 && image.height > 0 && image.levelCount > 0 && image.levelCount <= maxTextureLevelCount);
+    assert(image.file.data || image.pixels.size() == getTextureLevelOffset(image, image.levelCount));
+
+    StreamedTexture texture;
+    texture.texture = arrayTexture;
+    texture.layer = layer;
+    texture.image = std::move(image);
+
+    const StreamedTextureID id = addStreamedTexture(streamer, std::move(texture));
+
+    return id;
+}
+
+void releaseStreamedTexture(TextureStreamer& streamer, StreamedTextureID id) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(id < streamer.textures.size());
+
+    StreamedTexture& texture = streamer.textures[id];
+
+    assert(texture.copiedLevelCount == texture.image.levelCount);
+
+    // Draws already submitted keep the storage alive until they finish.
+    if (texture.layer < 0)
+    {
+        forgetCachedTexture(texture.texture);
+        glDeleteTextures(1, &texture.texture);
+    }
+
+    texture = {};
+    streamer.freeTextureIDs.push_back(id);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void updateTextureStreaming(TextureStreamer& streamer) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    ++streamer.stats.frameCount;
+
+    retireStagingFrames(streamer);
+
+    if (streamer.queueHead == streamer.queue.size())
+    {
+        return;
+    }
+
+    size_t copiedByteCount = 0;
+    size_t frameByteCount = 0;
+    unsigned int completedCount = 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamer.stagingBuffer);
+
+    while (streamer.queueHead < streamer.queue.size())
+    {
+        StreamedTexture& texture = streamer.textures[streamer.queue[streamer.queueHead]];
+        TextureImage& image = texture.image;
+
+        const TextureFormatInfo format = getTextureFormatInfo(image.internalFormat);
+
+        // Rows are rows of blocks for compressed formats.
+        const GLsizei level = texture.copiedLevelCount;
+        const GLsizei levelWidth = getMipLevelSize(image.width, level);
+        const GLsizei levelHeight = getMipLevelSize(image.height, level);
+        const GLsizei levelRowCount = getTextureLevelRowCount(image, level);
+
+        const size_t rowSize = getTextureLevelRowSize(image, level);
+        const size_t budgetRowCount = (streamer.frameByteBudget - copiedByteCount) / rowSize;
+
+        // A row wider than the whole budget still moves one row per frame.
+        size_t rowCount = static_cast<size_t>(levelRowCount - texture.copiedRowCount);
+        rowCount = budgetRowCount < rowCount ? budgetRowCount : rowCount;
+        rowCount = rowCount == 0 && copiedByteCount == 0 ? 1 : rowCount;
+
+        if (rowCount == 0)
+        {
+            ++streamer.stats.budgetLimitedCount;
+            break;
+        }
+
+        size_t offset = 0;
+
+        // The free space may be split at the end of the ring, fewer rows can still fit.
+        while (rowCount > 0 && !allocateStagingSpace(streamer, rowCount * rowSize, offset, frameByteCount))
+        {
+            rowCount /= 2;
+        }
+
+        if (rowCount == 0)
+        {
+            ++streamer.stats.ringFullCount;
+            break;
+        }
+
+        const size_t byteCount = rowCount * rowSize;
+
+        // Mapped containers are paged in by this copy, not on the render thread's first touch of the GPU data.
+        memcpy(streamer.stagingMemory + offset, getTextureLevelData(image, level) + static_cast<size_t>(texture.copiedRowCount) * rowSize, byteCount);
+
+        // Sources from the bound unpack buffer at the offset, the last block row may be cut by the level edge.
+        const GLint y = texture.copiedRowCount * format.blockHeight;
+        const GLsizei rowsHeight = static_cast<GLsizei>(rowCount) * format.blockHeight;
+        const GLsizei height = y + rowsHeight > levelHeight ? levelHeight - y : rowsHeight;
+
+        const void* source = reinterpret_cast<const void*>(offset);
+
+        if (texture.layer >= 0 && format.isCompressed)
+        {
+            glCompressedTextureSubImage3D(texture.texture, level, 0, y, texture.layer, levelWidth, height, 1, image.internalFormat, static_cast<GLsizei>(byteCount), source);
+        }
+        else if (texture.layer >= 0)
+        {
+            glTextureSubImage3D(texture.texture, level, 0, y, texture.layer, levelWidth, height, 1, format.uploadFormat, format.uploadType, source);
+        }
+        else if (format.isCompressed)
+        {
+            glCompressedTextureSubImage2D(texture.texture, level, 0, y, levelWidth, height, image.internalFormat, static_cast<GLsizei>(byteCount), source);
+        }
+        else
+        {
+            glTextureSubImage2D(texture.texture, level, 0, y, levelWidth, height, format.uploadFormat, format.uploadType, source);
+        }
+
+        texture.copiedRowCount += static_cast<GLsizei>(rowCount);
+        copiedByteCount += byteCount;
+
+        if (texture.copiedRowCount == levelRowCount)
+        {
+            ++texture.copiedLevelCount;
+            texture.copiedRowCount = 0;
+        }
+
+        if (texture.copiedLevelCount == image.levelCount)
+        {
+            // Queued behind the copies, the fence covers the filtered levels too.
+            if (texture.isMipmapGenerated)
+            {
+                glGenerateTextureMipmap(texture.texture);
+            }
+
+            texture.lastCopyFrame = streamer.frameCount;
+            releaseTextureImage(image);
+
+            ++completedCount;
+            ++streamer.queueHead;
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (frameByteCount > 0)
+    {
+        StagingFrame frame;
+        frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame.ringEnd = streamer.stagingHead;
+        frame.byteCount = frameByteCount;
+        frame.completedCount = completedCount;
+
+        streamer.frames.push_back(frame);
+        ++streamer.frameCount;
+    }
+
+    if (streamer.queueHead == streamer.queue.size())
+    {
+        streamer.queue.clear();
+        streamer.queueHead = 0;
+    }
+
+    streamer.stats.uploadedBytes += copiedByteCount;
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+bool isTextureStreamingBusy(const TextureStreamer& streamer) noexcept
+{
+    return streamer.queueHead < streamer.queue.size() || !streamer.frames.empty();
+}
+
+GLuint getResidentTexture(const TextureStreamer& streamer, StreamedTextureID id, GLuint fallback) noexcept
+{
+    assert(id < streamer.textures.size());
+
+    const StreamedTexture& texture = streamer.textures[id];
+
+    if (texture.copiedLevelCount < texture.image.levelCount || texture.lastCopyFrame >= streamer.retiredFrameCount)
+    {
+        return fallback;
+    }
+
+    return texture.texture;
+}
+
+TextureStreamingStats takeTextureStreamingStats(TextureStreamer& streamer) noexcept
+{
+    const TextureStreamingStats stats = streamer.stats;
+
+    streamer.stats = {};
+
+    return stats;
+}
@@ -0,0 +1,112 @@
+#ifndef KZ_TEXTURE_STREAMING_HPP
+#define KZ_TEXTURE_STREAMING_HPP
+
+#include "gl_functions.h"
+#include <texture_image.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Index into TextureStreamer::textures, valid until the texture is released.
+using StreamedTextureID = unsigned int;
+
+// Immutable texture filled level by level in row ranges over several frames, block rows for compressed formats.
+struct StreamedTexture
+{
+    GLuint texture{};
+
+    // Layer of a GL_TEXTURE_2D_ARRAY owned by the caller, -1 when the streamer owns the 2D texture.
+    GLint layer{ -1 };
+
+    // Rows not yet copied to the staging ring, the texels are released once all levels are copied.
+    TextureImage image;
+    GLsizei copiedLevelCount{};
+    GLsizei copiedRowCount{};
+
+    // Levels after 0 are left to glGenerateTextureMipmap.
+    bool isMipmapGenerated{};
+
+    // Staging frame of the last copy, the texture is resident once that frame retired.
+    uint64_t lastCopyFrame{};
+};
+
+// Staging ring space used by one frame, retired by its fence.
+struct StagingFrame
+{
+    GLsync fence{};
+    size_t ringEnd{};
+    size_t byteCount{};
+
+    // Textures whose last rows were copied in the frame.
+    unsigned int completedCount{};
+};
+
+struct TextureStreamingStats
+{
+    unsigned int frameCount{};
+    unsigned int uploadedCount{};
+    uint64_t uploadedBytes{};
+
+    // Frames that stopped copying at the byte budget or because the ring was full.
+    unsigned int budgetLimitedCount{};
+    unsigned int ringFullCount{};
+};
+
+// Persistent-mapped pixel unpack ring, copies are spread over frames under a byte budget.
+struct TextureStreamer
+{
+    GLuint stagingBuffer{};
+    unsigned char* stagingMemory{};
+    size_t stagingSize{};
+
+    // Written at head, retired from tail, both wrap.
+    size_t stagingHead{};
+    size_t stagingTail{};
+    size_t stagingUsed{};
+
+    size_t frameByteBudget{};
+
+    std::vector<StreamedTexture> textures;
+
+    // Released entries of textures, reused by the next requests.
+    std::vector<StreamedTextureID> freeTextureIDs;
+
+    // Textures with rows left to copy, in request order.
+    std::vector<StreamedTextureID> queue;
+    size_t queueHead{};
+
+    // Oldest first, one per frame that copied anything.
+    std::vector<StagingFrame> frames;
+    uint64_t frameCount{};
+    uint64_t retiredFrameCount{};
+
+    TextureStreamingStats stats;
+};
+
+TextureStreamer createTextureStreamer(size_t stagingSize, size_t frameByteBudget) noexcept;
+
+void destroyTextureStreamer(TextureStreamer& streamer) noexcept;
+
+// Allocates the texture storage and queues the rows, nothing is copied until the next update.
+// With generateMipmaps only level 0 of the image is uploaded and the GPU filters the full chain.
+StreamedTextureID requestTextureUpload(TextureStreamer& streamer, TextureImage&& image, bool generateMipmaps = false) noexcept;
+
+// Queues the rows of every level into one layer of an array texture with matching storage, the array stays owned by the caller.
+StreamedTextureID requestTextureLayerUpload(TextureStreamer& streamer, GLuint arrayTexture, GLint layer, TextureImage&& image) noexcept;
+
+// Deletes the texture unless the caller owns it and frees the ID, only once it is resident so no copy is still queued.
+void releaseStreamedTexture(TextureStreamer& streamer, StreamedTextureID id) noexcept;
+
+// Once per frame: publishes textures whose fences signaled and copies queued rows up to the byte budget.
+void updateTextureStreaming(TextureStreamer& streamer) noexcept;
+
+// True while rows are queued or copies wait for their fences.
+bool isTextureStreamingBusy(const TextureStreamer& streamer) noexcept;
+
+// The texture once all its rows reached the GPU, the fallback until then.
+GLuint getResidentTexture(const TextureStreamer& streamer, StreamedTextureID id, GLuint fallback) noexcept;
+
+// Returns and clears the stats gathered since the last call.
+TextureStreamingStats takeTextureStreamingStats(TextureStreamer& streamer) noexcept;
+
+#endif
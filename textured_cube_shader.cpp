@@ -1,8 +1,16 @@
 #include <textured_cube_shader.hpp>
+#include <mesh_importer.hpp>
+#include <mesh_simplifier.hpp>
+#include <meshlet.hpp>
+#include <gl_state_cache.hpp>
+#include <shader_compiler.hpp>
+#include <render_queue.hpp>
+#include <texture_samplers.hpp>
 
 #include <cmath>
-#include <string>
 #include <cassert>
+#include <cstddef>
+#include <utility>
 
 #define Invariant(cond) do { if (!(cond)) __debugbreak(); } while (0)
 
@@ -16,12 +24,6 @@
 void print(const char* format, ...);
 namespace
 {
-    void kzHaltWithMessage(const char* msg)
-    {
-        print(msg);
-        Invariant(false);
-    }
-
 // Checkerboard pattern.
 constexpr unsigned int defaultTestTexture[] = {
     0xff44aacc, 0xffffffff,
@@ -302,131 +304,342 @@ Matrix4x4 getAxisRotatedMatrix(const Matrix4x4& matrix, float angle, float x, fl
     return result;
 }
 
-void deleteShaderProgram(GLuint shaderProgram) noexcept
+// Compiled in front of every stage.
+const GLchar* shaderHeaderSource =
+R"kz_shader(
+        #version 450 core 
+    )kz_shader";
+
+const GLchar* cubeVertexShaderSource =
+R"kz_shader(
+    uniform mat4 modelViewProjectionMatrix;
+    uniform float uvRepeatCount;
+
+    layout(location = 0) in vec3 vertexPosition;
+    layout(location = 1) in vec2 uv;
+
+    // Per instance, zero for VAOs without the attribute.
+    layout(location = 3) in uint materialLayer;
+
+    out vec2 uvRepeat;
+    flat out uint layer;
+
+    void main()
+    {
+        // Transform the vertex by the fused model-view-projection matrix to GL clip-space.
+
+        gl_Position = modelViewProjectionMatrix * vec4(vertexPosition, 1.0f);
+
+        // Scale UVs by the repeat count for the texture pattern.
+
+        uvRepeat = uv * uvRepeatCount;
+
+        layer = materialLayer;
+    }
+    )kz_shader";
+
+const GLchar* cubeFragmentShaderSource =
+R"kz_shader(
+            uniform sampler2DArray TexSampler;
+
+            layout(location = 0) 
+            out vec4 fragmentColor;
+
+            layout(location = 1) 
+            in vec2 uvRepeat;
+
+            flat in uint layer;
+
+            void main()
+            {
+                // Sample the material layer of the instance.
+
+                fragmentColor = texture(TexSampler, vec3(uvRepeat, float(layer)));
+            }
+        )kz_shader";
+
+// Writes the object, draw and primitive IDs for picking.
+const GLchar* cubeRTTFragmentShaderSource =
+R"kz_shader(
+				layout (location = 0)
+				out uvec3 fragment;
+
+                layout(location = 1)
+
+				uniform uint objectID;
+				uniform uint drawID;
+
+				void main()
+				{
+					 fragment = uvec3(objectID, drawID, gl_PrimitiveID);
+				}
+        )kz_shader";
+
+ShaderProgramSource getCubeProgramSource(const GLchar* fragmentShaderSource) noexcept
 {
-    assert(glGetError() == GL_NO_ERROR);
-	assert(glIsShader(shaderProgram) && "Not valid vertex shader");
+    ShaderProgramSource source{};
+    source.headerSource = shaderHeaderSource;
+    source.stages[0] = { GL_VERTEX_SHADER, cubeVertexShaderSource };
+    source.stages[1] = { GL_FRAGMENT_SHADER, fragmentShaderSource };
+    source.stageCount = 2;
 
-    glDeleteShader(shaderProgram);
+    return source;
+}
 
-    assert(glGetError() == GL_NO_ERROR);
+ShaderProgramSource getComputeProgramSource(const GLchar* computeShaderSource) noexcept
+{
+    ShaderProgramSource source{};
+    source.headerSource = shaderHeaderSource;
+    source.stages[0] = { GL_COMPUTE_SHADER, computeShaderSource };
+    source.stageCount = 1;
+
+    return source;
 }
 
-GLuint getCompiledShaderProgram(const GLchar* headerSource, const GLchar* shaderSource, GLenum shaderType) noexcept
+// The active uniforms are reflected once here so draws never query locations.
+GLuint takeReflectedShaderProgram(const ShaderProgramSource& source, UniformReflection& reflection) noexcept
 {
-    assert(glGetError() == GL_NO_ERROR);
+    const GLuint program = takeShaderProgram(source);
 
-    assert(headerSource && shaderSource);
+    Invariant(glIsProgram(program));
 
-    // Only these 2 shaders types are supported.
-    assert(shaderType == GL_VERTEX_SHADER || shaderType == GL_FRAGMENT_SHADER);
+    reflectProgramUniforms(reflection, program);
 
-    GLuint shaderProgram = glCreateShader(shaderType);
+    return program;
+}
 
-    assert(shaderProgram);
+bool isMeshletCullingActive(const ShaderContext& shaderContext) noexcept
+{
+    return shaderContext.meshletCulling.cullProgram && shaderContext.meshletCullingEnabled;
+}
 
-    const GLchar* finalShaderSource[] = {
-        headerSource,
-        shaderSource,
-    };
+// Object occlusion for draws that do not go through the cull pass.
+bool isObjectOccludedByQuery(const ShaderContext& shaderContext) noexcept
+{
+    return shaderContext.objectQuery.query && !isMeshletCullingActive(shaderContext) && shaderContext.objectQuery.occluded;
+}
 
-    // User null-terminated shader source.
-    glShaderSource(shaderProgram, 2, finalShaderSource, nullptr);
-    glCompileShader(shaderProgram);
+// Far plane of the cube view, sort depths are clip w over it.
+constexpr float cubeViewFarZ = 200.0f;
 
-    GLint shaderCompileStatus{};
-    glGetShaderiv(shaderProgram, GL_COMPILE_STATUS, &shaderCompileStatus);
+float getObjectSortDepth(const ShaderContext& shaderContext) noexcept
+{
+    const GLfloat origin[3] = {};
+    const GLfloat* center = shaderContext.meshVAO ? shaderContext.meshBoundsCenter : origin;
+    const Matrix4x4& m = shaderContext.modelViewProjection;
 
-    if (shaderCompileStatus == GL_FALSE)
-    {
-        GLint shaderLogSize{};
-        glGetShaderiv(shaderProgram, GL_INFO_LOG_LENGTH, &shaderLogSize);
+    const float clipW = m.data[0][3] * center[0] + m.data[1][3] * center[1] + m.data[2][3] * center[2] + m.data[3][3];
 
-        if (shaderLogSize > 0)
-        {
-            std::string shaderLog;
-            shaderLog.reserve(static_cast<size_t>(shaderLogSize));
+    return clipW / cubeViewFarZ;
+}
 
-            glGetShaderInfoLog(shaderProgram, shaderLogSize, nullptr, (GLchar*)shaderLog.data());
-            printf("%s", shaderLog.c_str());
-        }
+DrawPacket* pushPassPacket(RenderQueue& queue, uint64_t sortKey, GLuint framebuffer, unsigned int viewportWidth, unsigned int viewportHeight) noexcept
+{
+    DrawPacket* packet = pushDrawPacket(queue, sortKey);
 
-        if (shaderType == GL_VERTEX_SHADER)
-        {
-            kzHaltWithMessage("Vertex shader compilation failed!\n");
-        }
-        else
-        {
-            kzHaltWithMessage("Fragment shader compilation failed!\n");
-        }
+    if (packet)
+    {
+        packet->framebuffer = framebuffer;
+        packet->viewport[2] = static_cast<GLint>(viewportWidth);
+        packet->viewport[3] = static_cast<GLint>(viewportHeight);
     }
 
-    assert(glGetError() == GL_NO_ERROR);
+    return packet;
+}
 
-    Invariant(shaderProgram > 0);
+void recordPassClear(RenderQueue& queue, RenderPass pass, GLuint framebuffer, unsigned int viewportWidth, unsigned int viewportHeight) noexcept
+{
+    DrawPacket* packet = pushPassPacket(queue, makeSortKey(pass, renderOrderClear, 0, 0, 0.0f), framebuffer, viewportWidth, viewportHeight);
+
+    if (!packet)
+    {
+        return;
+    }
 
-    return shaderProgram;
+    packet->type = drawPacketClear;
+    packet->clearColor[0] = 0.1f;
+    packet->clearColor[1] = 0.1f;
+    packet->clearColor[2] = 0.1f;
+    packet->clearColor[3] = 1.0f;
+    packet->clearMask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
 }
 
-GLuint getLinkedShaderProgram(GLuint vertexShaderID, GLuint fragmentShaderID) noexcept
+// Object packet of a cube pass with the frame MVP, the caller sets the draw.
+DrawPacket* pushObjectPacket(ShaderContext& shaderContext, RenderQueue& queue, RenderPass pass, RenderOrder order, GLuint program, const UniformReflection& uniforms,
+                             GLuint framebuffer, unsigned int viewportWidth, unsigned int viewportHeight, const GLfloat* matrix) noexcept
 {
-    assert(glGetError() == GL_NO_ERROR);
-
-    GLuint program = glCreateProgram();
+    const uint64_t sortKey = makeSortKey(pass, order, program, shaderContext.textureBinding, getObjectSortDepth(shaderContext));
+    DrawPacket* packet = pushPassPacket(queue, sortKey, framebuffer, viewportWidth, viewportHeight);
 
-    glAttachShader(program, vertexShaderID);
-    glAttachShader(program, fragmentShaderID);
+    if (!packet)
+    {
+        return nullptr;
+    }
 
-    glLinkProgram(program);
+    // The ID pass depth feeds the Hi-Z pyramid and the color pass depth the query proxy.
+    packet->depthTest = true;
+    packet->program = program;
+    packet->texture = shaderContext.textureBinding;
+    packet->sampler = shaderContext.textureSampler;
+    packet->matrix = matrix;
+    packet->uniformProgram = program;
+    // Looked up per draw, the name is hashed at compile time.
+    constexpr unsigned int matrixUniformName = uniformName("modelViewProjectionMatrix");
+    packet->matrixUniform = getUniformLocation(uniforms, matrixUniformName);
+
+    return packet;
+}
 
-    GLint shaderLinkStatus{};
-    glGetProgramiv(program, GL_LINK_STATUS, &shaderLinkStatus);
+// Records the unit cube proxy into the depth buffer of the pass without writing, the mesh is fitted inside it.
+void recordOcclusionProxy(ShaderContext& shaderContext, RenderQueue& queue, unsigned int viewportWidth, unsigned int viewportHeight, const GLfloat* matrix) noexcept
+{
+    DrawPacket* packet = pushObjectPacket(shaderContext, queue, renderPassColor, renderOrderQuery, shaderContext.cubeProgram, shaderContext.cubeUniforms, 0, viewportWidth, viewportHeight, matrix);
 
-    if (shaderLinkStatus == GL_FALSE)
+    if (!packet)
     {
-        GLint shaderLogSize{};
+        return;
+    }
 
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &shaderLogSize);
+    packet->type = drawPacketArrays;
+    packet->vertexArray = shaderContext.cubePickingVAO;
+    packet->count = 3 * 12;
+    packet->occlusionQuery = &shaderContext.objectQuery;
+}
 
-        if (shaderLogSize > 1)
+// Sets the LOD draw, culled per meshlet when the cull pre-pass is set up. The cull dispatch is issued now, before the packet is submitted.
+void setMeshTrianglesDraw(ShaderContext& shaderContext, DrawPacket& packet, unsigned int lod, MeshletCullPass pass) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(lod < shaderContext.meshLodCount);
+    assert(shaderContext.meshLodIndexCount[lod] > 0);
+
+    if (isMeshletCullingActive(shaderContext))
+    {
+        const GLfloat objectSphere[] =
         {
-            std::string shaderLog;
-            shaderLog.reserve(static_cast<size_t>(shaderLogSize));
+            shaderContext.meshBoundsCenter[0], shaderContext.meshBoundsCenter[1], shaderContext.meshBoundsCenter[2], shaderContext.meshBoundsRadius,
+        };
 
-            glGetProgramInfoLog(program, shaderLogSize, nullptr, (GLchar*)shaderLog.data());
-            printf("%s", shaderLog.c_str());
-        }
+        const HiZPyramid* hiZPyramid = shaderContext.hiZPyramid.texture ? &shaderContext.hiZPyramid : nullptr;
+
+        cullMeshlets(shaderContext.meshletCulling, pass, &shaderContext.modelViewProjection.data[0][0], objectSphere, shaderContext.meshLodFirstMeshlet[lod], shaderContext.meshLodMeshletCount[lod], hiZPyramid);
+
+        packet.type = drawPacketElementsIndirect;
+        packet.vertexArray = shaderContext.meshletCulling.outputs[pass].vertexArray;
+        packet.indirectBuffer = shaderContext.meshletCulling.outputs[pass].drawCommandBuffer;
 
-        glDeleteProgram(program);
+        assert(glGetError() == GL_NO_ERROR);
 
-        kzHaltWithMessage("Program linking failed!\n");
+        return;
     }
 
+    packet.type = drawPacketElements;
+    packet.vertexArray = shaderContext.meshVAO;
+    packet.first = shaderContext.meshLodFirstIndex[lod];
+    packet.count = static_cast<GLsizei>(shaderContext.meshLodIndexCount[lod]);
+
     assert(glGetError() == GL_NO_ERROR);
+}
 
-    Invariant(glIsProgram(program));
+// Per-instance material layer, the base instance of a draw selects the entry. Sets up the bound VAO.
+void enableMaterialLayerAttribute(GLuint materialLayerBuffer) noexcept
+{
+    constexpr GLuint materialLayerAttributeIndex = 3;
 
-    return program;
+    glBindBuffer(GL_ARRAY_BUFFER, materialLayerBuffer);
+
+    glVertexAttribIPointer(materialLayerAttributeIndex, 1, GL_UNSIGNED_INT, 0, nullptr);
+    glVertexAttribDivisor(materialLayerAttributeIndex, 1);
+    glEnableVertexAttribArray(materialLayerAttributeIndex);
 }
 
-void drawTriangleStrips(const ShaderContext& shaderContext, unsigned int stripCount) noexcept
+// Vertex array over the interleaved mesh vertices, with the same attribute locations as the cube so both cube programs can draw it.
+GLuint createMeshVertexArray(GLuint vertexBuffer, GLuint indexBuffer, GLuint materialLayerBuffer) noexcept
 {
     assert(glGetError() == GL_NO_ERROR);
 
-    for (unsigned int i = 0; i < stripCount; ++i)
+    static_assert(sizeof(MeshVertex) == 8 * sizeof(GLfloat), "Mesh vertices must be tightly packed");
+
+    GLuint vertexArray = 0;
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+
+    assert(glIsVertexArray(vertexArray));
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    // Element array binding is part of the VAO state.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    constexpr GLuint positionAttributeIndex = 0;
+    constexpr GLuint uvAttributeIndex = 1;
+    constexpr GLuint normalAttributeIndex = 2;
+
+    glVertexAttribPointer(positionAttributeIndex, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, position)));
+    glEnableVertexAttribArray(positionAttributeIndex);
+
+    glVertexAttribPointer(uvAttributeIndex, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, uv)));
+    glEnableVertexAttribArray(uvAttributeIndex);
+
+    glVertexAttribPointer(normalAttributeIndex, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, normal)));
+    glEnableVertexAttribArray(normalAttributeIndex);
+
+    enableMaterialLayerAttribute(materialLayerBuffer);
+
+    // Detach the VAO first so the element array binding stays recorded in it.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    assert(glGetError() == GL_NO_ERROR);
+
+    return vertexArray;
+}
+
+// Picks the coarsest LOD whose error projects to less than meshLodPixelError pixels with the current MVP.
+unsigned int selectMeshLod(const ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight) noexcept
+{
+    if (shaderContext.meshLodCount <= 1)
     {
-        glDrawArrays(GL_TRIANGLE_STRIP, i*4, 4);
+        return 0;
     }
 
-    assert(glGetError() == GL_NO_ERROR);
+    const Matrix4x4& mvp = shaderContext.modelViewProjection;
+    const GLfloat* center = shaderContext.meshBoundsCenter;
+
+    // Column-major: clip = x * column0 + y * column1 + z * column2 + column3.
+    const float clipW = center[0] * mvp.data[0][3] + center[1] * mvp.data[1][3] + center[2] * mvp.data[2][3] + mvp.data[3][3];
+
+    // Camera inside or behind the bounds.
+    if (clipW <= shaderContext.meshBoundsRadius)
+    {
+        return 0;
+    }
+
+    const float scaleX = std::sqrt(mvp.data[0][0] * mvp.data[0][0] + mvp.data[1][0] * mvp.data[1][0] + mvp.data[2][0] * mvp.data[2][0]);
+    const float scaleY = std::sqrt(mvp.data[0][1] * mvp.data[0][1] + mvp.data[1][1] * mvp.data[1][1] + mvp.data[2][1] * mvp.data[2][1]);
+
+    // Pixels covered by one mesh unit at the bounds center, NDC spans two units across the viewport.
+    const float pixelsPerUnitX = scaleX * 0.5f * static_cast<float>(viewportWidth);
+    const float pixelsPerUnitY = scaleY * 0.5f * static_cast<float>(viewportHeight);
+    const float pixelsPerUnit = (pixelsPerUnitX > pixelsPerUnitY ? pixelsPerUnitX : pixelsPerUnitY) / clipW;
+
+    for (unsigned int lod = shaderContext.meshLodCount - 1; lod > 0; --lod)
+    {
+        if (shaderContext.meshLodError[lod] * pixelsPerUnit <= shaderContext.meshLodPixelError)
+        {
+            return lod;
+        }
+    }
+
+    return 0;
 }
 
 }
 
 void setupCubeShaderView(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept
 {
-    assert(glGetError() == GL_NO_ERROR);
-
     const float aspectRatio = static_cast<float>(viewportHeight) / static_cast<float>(viewportWidth);
     Matrix4x4 modelView = getIdentityMatrix();
 
@@ -439,138 +652,268 @@ void setupCubeShaderView(ShaderContext& shaderContext, unsigned int viewportWidt
 
     modelView = getTranslatedMatrix(modelView, 0.0f, 0.0f, -7.0f);
 
-    Matrix4x4 projection = getProjectionMatrix(-2.8f, 2.8f, -2.8f * aspectRatio, 2.8f * aspectRatio, 3.0f, 200.0f);
+    Matrix4x4 projection = getProjectionMatrix(-2.8f, 2.8f, -2.8f * aspectRatio, 2.8f * aspectRatio, 3.0f, cubeViewFarZ);
 
     Matrix4x4 modelViewProjection = getIdentityMatrix();
     modelViewProjection = matrixMultiply(modelView, projection);
 
-    // Column-major order.
-    glUniformMatrix4fv(shaderContext.modelViewProjectionMatrixUniform, 1, GL_FALSE, &modelViewProjection.data[0][0]);
-
     shaderContext.modelViewProjection = modelViewProjection;
-
-    assert(glGetError() == GL_NO_ERROR);
 }
 
-void drawCubeShaderToTexture(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept
+void drawCubeShaderToTexture(ShaderContext& shaderContext, RenderQueue& queue, GLuint framebuffer, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept
 {
 	assert(glIsProgram(shaderContext.rttProgram));
 
-	glUseProgram(shaderContext.rttProgram);
-
-    glUniform1ui(shaderContext.objectIDUniform, 1);
-	glUniform1ui(shaderContext.drawIDUniform, 1);
+    // The depth attachment still holds the previous frame.
+    if (shaderContext.hiZPyramid.texture && isMeshletCullingActive(shaderContext))
+    {
+        buildHiZPyramid(shaderContext.hiZPyramid);
+    }
 
-	// Bind cube vertex attribute arrays.
-	glBindVertexArray(shaderContext.cubePickingVAO);
+    glProgramUniform1ui(shaderContext.rttProgram, shaderContext.objectIDUniform, 1);
+	glProgramUniform1ui(shaderContext.rttProgram, shaderContext.drawIDUniform, 1);
 
-    shaderContext.modelViewProjectionMatrixUniform = glGetUniformLocation(shaderContext.rttProgram, "modelViewProjectionMatrix");
     setupCubeShaderView(shaderContext, viewportWidth, viewportHeight, frameCounter);
 
-    // Bind the texture to map onto the cube.
-    glBindTexture(GL_TEXTURE_2D, shaderContext.textureBinding);
+    // Column-major order.
+    const GLfloat* modelViewProjection = pushFrameMatrix(queue, &shaderContext.modelViewProjection.data[0][0]);
 
-    glViewport(0, 0, static_cast<GLsizei>(viewportWidth), static_cast<GLsizei>(viewportHeight));
+    recordPassClear(queue, renderPassID, framebuffer, viewportWidth, viewportHeight);
 
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    if (shaderContext.meshVAO)
+    {
+        shaderContext.meshDrawnLod = selectMeshLod(shaderContext, viewportWidth, viewportHeight);
+        shaderContext.meshPickedLod = shaderContext.meshPickLod >= 0 ? static_cast<unsigned int>(shaderContext.meshPickLod) : shaderContext.meshDrawnLod;
 
-    // Draw the textured cube.
-    glDrawArrays(GL_TRIANGLES, 0, 3 * 12);
+        if (shaderContext.meshPickedLod >= shaderContext.meshLodCount)
+        {
+            shaderContext.meshPickedLod = shaderContext.meshLodCount - 1;
+        }
+    }
 
-    // Detach vertex buffer binding.
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (!isObjectOccludedByQuery(shaderContext))
+    {
+        DrawPacket* packet = pushObjectPacket(shaderContext, queue, renderPassID, renderOrderOpaque, shaderContext.rttProgram, shaderContext.rttUniforms, framebuffer, viewportWidth, viewportHeight, modelViewProjection);
 
-    // Detach texture binding.
-    glBindTexture(GL_TEXTURE_2D, 0);
+        if (packet && shaderContext.meshVAO)
+        {
+            setMeshTrianglesDraw(shaderContext, *packet, shaderContext.meshPickedLod, meshletIDPass);
+        }
+        else if (packet)
+        {
+            // Draw the textured cube.
+            packet->type = drawPacketArrays;
+            packet->vertexArray = shaderContext.cubePickingVAO;
+            packet->count = 3 * 12;
+        }
+    }
 
-	assert(glIsProgram(shaderContext.cubeProgram));
+    shaderContext.hiZPyramid.hasDepth = true;
 
-    // Detach current shader programs.
-    glUseProgram(0);
+	assert(glIsProgram(shaderContext.cubeProgram));
 }
 
-void drawTexturedCubeShaderToOutput(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept
+void drawTexturedCubeShaderToOutput(ShaderContext& shaderContext, RenderQueue& queue, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept
 {
 	assert(glIsProgram(shaderContext.cubeProgram));
 
-	glUseProgram(shaderContext.cubeProgram);
+    setupCubeShaderView(shaderContext, viewportWidth, viewportHeight, frameCounter);
 
-	// Bind cube vertex array attributes.
-	glBindVertexArray(shaderContext.cubeVAO);
+    // Column-major order.
+    const GLfloat* modelViewProjection = pushFrameMatrix(queue, &shaderContext.modelViewProjection.data[0][0]);
 
-    shaderContext.modelViewProjectionMatrixUniform = glGetUniformLocation(shaderContext.cubeProgram, "modelViewProjectionMatrix");
-    setupCubeShaderView(shaderContext, viewportWidth, viewportHeight, frameCounter);
+    recordPassClear(queue, renderPassColor, 0, viewportWidth, viewportHeight);
 
-    // Bind the texture to map onto the cube.
-    glBindTexture(GL_TEXTURE_2D, shaderContext.textureBinding);
+    // Results of queries issued in earlier frames.
+    if (shaderContext.objectQuery.query && !isMeshletCullingActive(shaderContext))
+    {
+        isOccludedByQuery(shaderContext.objectQuery);
+    }
 
-    glViewport(0, 0, static_cast<GLsizei>(viewportWidth), static_cast<GLsizei>(viewportHeight));
+    const bool objectOccluded = isObjectOccludedByQuery(shaderContext);
 
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    if (shaderContext.meshVAO)
+    {
+        shaderContext.meshDrawnLod = selectMeshLod(shaderContext, viewportWidth, viewportHeight);
+    }
 
-    // Draw all the faces of the cube.
-    drawTriangleStrips(shaderContext, 6);
+    if (!objectOccluded)
+    {
+        DrawPacket* packet = pushObjectPacket(shaderContext, queue, renderPassColor, renderOrderOpaque, shaderContext.cubeProgram, shaderContext.cubeUniforms, 0, viewportWidth, viewportHeight, modelViewProjection);
 
-    // Detach vertex buffer binding.
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (packet && shaderContext.meshVAO)
+        {
+            setMeshTrianglesDraw(shaderContext, *packet, shaderContext.meshDrawnLod, meshletColorPass);
+        }
+        else if (packet)
+        {
+            // Draw all the faces of the cube.
+            packet->type = drawPacketArrays;
+            packet->mode = GL_TRIANGLE_STRIP;
+            packet->vertexArray = shaderContext.cubeVAO;
+            packet->count = 4;
+            packet->drawCount = 6;
+        }
+    }
+
+    if (isMeshletCullingActive(shaderContext))
+    {
+        shaderContext.occlusionStats = shaderContext.meshletCulling.stats[meshletColorPass];
+    }
+    else if (shaderContext.objectQuery.query)
+    {
+        // Tested against this frame's depth, the result decides a later frame.
+        recordOcclusionProxy(shaderContext, queue, viewportWidth, viewportHeight, modelViewProjection);
 
-    // Detach texture binding.
-    glBindTexture(GL_TEXTURE_2D, 0);
+        shaderContext.occlusionStats = {};
+        shaderContext.occlusionStats.objectsTested = 1;
+        shaderContext.occlusionStats.objectsOccluded = objectOccluded ? 1 : 0;
+    }
 
 	assert(glIsProgram(shaderContext.cubeProgram));
-
-    // Detach current shader programs.
-    glUseProgram(0);
 }
 
-void drawCubeShaderElapsed(const ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int usElapsed) noexcept
+void uploadMeshToShader(ShaderContext& shaderContext, const MeshData& mesh) noexcept
 {
     assert(glGetError() == GL_NO_ERROR);
+    assert(!mesh.vertices.empty() && !mesh.indices.empty());
+    assert(mesh.indices.size() % 3 == 0);
 
-    glViewport(0, 0, static_cast<GLsizei>(viewportWidth), static_cast<GLsizei>(viewportHeight));
+    // Interleaved vertices, the index buffer is also read as shader storage by the meshlet cull pass.
+    glCreateBuffers(1, &shaderContext.meshVBO);
+    glNamedBufferStorage(shaderContext.meshVBO, static_cast<GLsizeiptr>(mesh.vertices.size() * sizeof(MeshVertex)), mesh.vertices.data(), 0);
 
-    glClearColor(0.1f, 0.1f, 0.1f, 0.8f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glCreateBuffers(1, &shaderContext.meshIBO);
+    glNamedBufferStorage(shaderContext.meshIBO, static_cast<GLsizeiptr>(mesh.indices.size() * sizeof(GLuint)), mesh.indices.data(), 0);
 
-    float aspectRatio = static_cast<float>(viewportHeight) / static_cast<float>(viewportWidth);
-    Matrix4x4 modelView = getIdentityMatrix();
+    shaderContext.meshVAO = createMeshVertexArray(shaderContext.meshVBO, shaderContext.meshIBO, shaderContext.materialLayerBuffer);
 
-    modelView = getAxisRotatedMatrix(modelView, (0.25f * static_cast<float>(usElapsed) / 10000), 1.0f, 0.0f, 0.0f);
-    modelView = getAxisRotatedMatrix(modelView, (0.25f * static_cast<float>(usElapsed) / 10000), 0.0f, 1.0f, 0.0f);
-    modelView = getAxisRotatedMatrix(modelView, (0.25f * static_cast<float>(usElapsed) / 10000), 0.0f, 0.0f, 1.0f);
+    shaderContext.meshIndexCount = static_cast<GLsizei>(mesh.indices.size());
 
-    modelView = getScaledMatrix(modelView, 2.5f, 2.5f, 1.0f);
+    // Until a LOD chain is set the whole index buffer is the only LOD.
+    shaderContext.meshLodFirstIndex[0] = 0;
+    shaderContext.meshLodIndexCount[0] = shaderContext.meshIndexCount;
+    shaderContext.meshLodError[0] = 0.0f;
+    shaderContext.meshLodCount = 1;
 
-    modelView = getTranslatedMatrix(modelView, 0.0f, 0.0f, -7.0f);
+    assert(glGetError() == GL_NO_ERROR);
+}
 
-    Matrix4x4 projection = getProjectionMatrix(-2.8f, 2.8f, -2.8f * aspectRatio, 2.8f * aspectRatio, 3.0f, 200.0f);
+void setMeshLodChain(ShaderContext& shaderContext, const MeshLodChain& lodChain) noexcept
+{
+    assert(!lodChain.lods.empty());
+    assert(shaderContext.meshVAO);
 
-    Matrix4x4 modelViewProjection = getIdentityMatrix();
-    modelViewProjection = matrixMultiply(modelView, projection);
+    shaderContext.meshLodCount = lodChain.lods.size() < maxMeshLodCount ? static_cast<unsigned int>(lodChain.lods.size()) : maxMeshLodCount;
 
-    glUniform1f(shaderContext.uvRepeatCountUniform, shaderContext.uvRepeatCount);
+    for (unsigned int lod = 0; lod < shaderContext.meshLodCount; ++lod)
+    {
+        assert(lodChain.lods[lod].firstIndex + lodChain.lods[lod].indexCount <= static_cast<unsigned int>(shaderContext.meshIndexCount));
 
-    // Column-major order.
-    glUniformMatrix4fv(shaderContext.modelViewProjectionMatrixUniform, 1, GL_FALSE, &modelViewProjection.data[0][0]);
+        shaderContext.meshLodFirstIndex[lod] = lodChain.lods[lod].firstIndex;
+        shaderContext.meshLodIndexCount[lod] = static_cast<GLsizei>(lodChain.lods[lod].indexCount);
+        shaderContext.meshLodError[lod] = lodChain.lods[lod].error;
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        shaderContext.meshBoundsCenter[axis] = lodChain.boundsCenter[axis];
+    }
 
-    // Bind the vertex buffers to use for the cube.
-    glBindBuffer(GL_ARRAY_BUFFER, shaderContext.cubeVBO);
+    shaderContext.meshBoundsRadius = lodChain.boundsRadius;
+}
 
-    // Bind the texture to map onto the cube.
-    glBindTexture(GL_TEXTURE_2D, shaderContext.textureBinding);
+void setupMeshletCulling(ShaderContext& shaderContext, const MeshData& mesh) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(shaderContext.meshVAO);
+    assert(static_cast<size_t>(shaderContext.meshIndexCount) == mesh.indices.size());
 
-    drawTriangleStrips(shaderContext, 6);
+    std::vector<Meshlet> meshlets;
+    GLsizei maxLodIndexCount = 0;
 
-    // Detach bindings.
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    for (unsigned int lod = 0; lod < shaderContext.meshLodCount; ++lod)
+    {
+        const size_t firstMeshlet = meshlets.size();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+        buildMeshlets(meshlets, mesh, shaderContext.meshLodFirstIndex[lod], static_cast<unsigned int>(shaderContext.meshLodIndexCount[lod]));
+
+        shaderContext.meshLodFirstMeshlet[lod] = static_cast<GLuint>(firstMeshlet);
+        shaderContext.meshLodMeshletCount[lod] = static_cast<GLuint>(meshlets.size() - firstMeshlet);
+
+        maxLodIndexCount = shaderContext.meshLodIndexCount[lod] > maxLodIndexCount ? shaderContext.meshLodIndexCount[lod] : maxLodIndexCount;
+
+        print("Mesh LOD %u: %u meshlets\n", lod, shaderContext.meshLodMeshletCount[lod]);
+    }
+
+    shaderContext.meshletCulling = createMeshletCulling(meshlets, shaderContext.meshIBO, maxLodIndexCount);
+
+    for (MeshletCullOutput& output : shaderContext.meshletCulling.outputs)
+    {
+        output.vertexArray = createMeshVertexArray(shaderContext.meshVBO, output.indexBuffer, shaderContext.materialLayerBuffer);
+    }
 
     assert(glGetError() == GL_NO_ERROR);
 }
 
+void setupOcclusionCulling(ShaderContext& shaderContext, GLuint depthTexture, GLsizei depthWidth, GLsizei depthHeight) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+
+    shaderContext.hiZPyramid = createHiZPyramid(depthTexture, depthWidth, depthHeight);
+    shaderContext.objectQuery = createOcclusionQuery();
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void setPickedPrimitiveDraw(const ShaderContext& shaderContext, DrawPacket& packet, unsigned int primitiveID) noexcept
+{
+    packet.mode = GL_TRIANGLES;
+    packet.count = 3;
+
+    if (!shaderContext.meshVAO)
+    {
+        packet.type = drawPacketArrays;
+        packet.vertexArray = shaderContext.cubePickingVAO;
+        packet.first = primitiveID * 3;
+
+        return;
+    }
+
+    packet.type = drawPacketElements;
+
+    // Primitive IDs are relative to the compacted ID pass output, or to the picked LOD when drawn unculled.
+    if (isMeshletCullingActive(shaderContext))
+    {
+        packet.vertexArray = shaderContext.meshletCulling.outputs[meshletIDPass].vertexArray;
+        packet.first = primitiveID * 3;
+    }
+    else
+    {
+        packet.vertexArray = shaderContext.meshVAO;
+        packet.first = shaderContext.meshLodFirstIndex[shaderContext.meshPickedLod] + primitiveID * 3;
+    }
+}
+
+void submitComputeShaderProgram(const GLchar* computeShaderSource) noexcept
+{
+    submitShaderProgram(getComputeProgramSource(computeShaderSource));
+}
+
+GLuint createComputeShaderProgram(const GLchar* computeShaderSource, UniformReflection& reflection) noexcept
+{
+    return takeReflectedShaderProgram(getComputeProgramSource(computeShaderSource), reflection);
+}
+
+void submitCubeShaderPrograms() noexcept
+{
+    submitShaderProgram(getCubeProgramSource(cubeFragmentShaderSource));
+    submitShaderProgram(getCubeProgramSource(cubeRTTFragmentShaderSource));
+
+    // The meshlet culling program is only needed with a mesh, it is submitted with the import.
+    submitHiZPyramidProgram();
+}
+
 void generateAndBindTexture(ShaderContext& shaderContext) noexcept
 {
     assert(glGetError() == GL_NO_ERROR);
@@ -581,12 +924,11 @@ void generateAndBindTexture(ShaderContext& shaderContext) noexcept
     assert(shaderContext.textureBpp == 4);
     assert(shaderContext.textureMemory);
 
-    glGenTextures(1, &shaderContext.textureBinding);
-    glBindTexture(GL_TEXTURE_2D, shaderContext.textureBinding);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, shaderContext.textureWidth, shaderContext.textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, shaderContext.textureMemory);
+    // Immutable storage, the driver validates completeness once. A single layer array, so the cube program samples it like the material pool.
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &shaderContext.textureBinding);
+    glTextureStorage3D(shaderContext.textureBinding, 1, GL_RGBA8, shaderContext.textureWidth, shaderContext.textureHeight, 1);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glTextureSubImage3D(shaderContext.textureBinding, 0, 0, 0, 0, shaderContext.textureWidth, shaderContext.textureHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, shaderContext.textureMemory);
 
     assert(shaderContext.textureBinding != 0);
     assert(glGetError() == GL_NO_ERROR);
@@ -607,125 +949,123 @@ void generateAndBindDefaultTexture(ShaderContext& shaderContext) noexcept
     glUniform1f(shaderContext.uvRepeatCountUniform, shaderContext.uvRepeatCount);
 
     generateAndBindTexture(shaderContext);
+
+    shaderContext.defaultTextureBinding = shaderContext.textureBinding;
 }
 
-void setDefaultGLTextureParameters(const ShaderContext& shaderContext) noexcept
+void setDefaultGLTextureParameters(ShaderContext& shaderContext) noexcept
 {
     assert(glGetError() == GL_NO_ERROR);
-    assert(shaderContext.textureBinding != 0);
 
-    glBindTexture(GL_TEXTURE_2D, shaderContext.textureBinding);
+    // Minified surfaces filter across mip levels, magnified texels stay sharp like the default pattern.
+    SamplerDescription description;
+    description.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    description.magFilter = GL_NEAREST;
+    description.wrap = GL_REPEAT;
+    description.maxAnisotropy = 8.0f;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    shaderContext.textureSampler = getSampler(description);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    assert(shaderContext.textureBinding != 0);
+    assert(shaderContext.textureSampler != 0);
     assert(glGetError() == GL_NO_ERROR);
 }
 
-ShaderContext createCubeShader() noexcept
+bool addCubeShaderMaterial(ShaderContext& shaderContext, TexturePool& pool, TextureStreamer& streamer, TextureImage&& image) noexcept
 {
-		// Load OpenGL functions.
-#define X(type, name) name = (type)wglGetProcAddress(#name); assert(name);
-		GL_FUNCTIONS(X)
-#undef X
-
-    assert(glGetError() == GL_NO_ERROR);
+    if (shaderContext.materialCount == maxCubeMaterialCount)
+    {
+        return false;
+    }
 
-    ShaderContext cubeShader = {};
+    // A second array would need a second bind, later materials must land in the array of the first.
+    if (shaderContext.materialCount > 0)
+    {
+        const TextureArray& textureArray = pool.arrays[shaderContext.materials[0].arrayIndex];
 
-    // TODO: Separate shader loading.
+        if (textureArray.internalFormat != image.internalFormat || textureArray.width != image.width ||
+            textureArray.height != image.height || textureArray.levelCount != image.levelCount || textureArray.freeLayers.empty())
+        {
+            print("Cube material %dx%d, format 0x%04X does not fit the material array.\n", image.width, image.height, image.internalFormat);
+            return false;
+        }
+    }
 
-    // Embedded shader header source string for both vertex and fragment shader.
-    const GLchar* headerSource =
-    R"kz_shader(
-        #version 450 core 
-    )kz_shader";
+    shaderContext.materials[shaderContext.materialCount++] = addPooledTexture(pool, streamer, std::move(image));
+    shaderContext.isMaterialResident = false;
 
-    // Embedded vertex shader source string.
-        const GLchar* cubeVertexShaderSource =
-        R"kz_shader(
-    uniform mat4 modelViewProjectionMatrix;
-    uniform float uvRepeatCount;
-
-    layout(location = 0) in vec3 vertexPosition;
-    layout(location = 1) in vec2 uv;
+    return true;
+}
 
-    out vec2 uvRepeat;
+void updateCubeShaderMaterials(ShaderContext& shaderContext, const TexturePool& pool, const TextureStreamer& streamer) noexcept
+{
+    if (shaderContext.materialCount == 0 || shaderContext.isMaterialResident)
+    {
+        return;
+    }
 
-    void main()
+    for (unsigned int i = 0; i < shaderContext.materialCount; ++i)
     {
-        // Transform the vertex by the fused model-view-projection matrix to GL clip-space.
+        if (!isPooledTextureResident(streamer, shaderContext.materials[i]))
+        {
+            return;
+        }
+    }
 
-        gl_Position = modelViewProjectionMatrix * vec4(vertexPosition, 1.0f);
+    assert(glGetError() == GL_NO_ERROR);
 
-        // Scale UVs by the repeat count for the texture pattern.
+    GLuint layers[maxCubeMaterialCount];
 
-        uvRepeat = uv * uvRepeatCount;
+    for (unsigned int face = 0; face < maxCubeMaterialCount; ++face)
+    {
+        layers[face] = static_cast<GLuint>(shaderContext.materials[face % shaderContext.materialCount].layer);
     }
-    )kz_shader";
 
-    // Embedded fragment shader source string.
-		const GLchar* cubeFragmentShaderSource =
-		R"kz_shader(
-            uniform sampler2D TexSampler;
+    // Earlier draws still reading the buffer are ordered before the update by the driver.
+    glNamedBufferSubData(shaderContext.materialLayerBuffer, 0, sizeof(layers), layers);
 
-            layout(location = 0) 
-            out vec4 fragmentColor;
-
-            layout(location = 1) 
-            in vec2 uvRepeat;
-
-            void main()
-            {
-                // Sample the 2D texture.
+    shaderContext.textureBinding = getPooledTextureArray(pool, shaderContext.materials[0]);
+    shaderContext.isMaterialResident = true;
 
-                fragmentColor = texture(TexSampler, uvRepeat);
-            }
-        )kz_shader";
+    assert(glGetError() == GL_NO_ERROR);
+}
 
-		// Embedded fragment shader source string.
-		const GLchar* cubeRTTFragmentShaderSource =
-		R"kz_shader(
-				layout (location = 0)
-				out uvec3 fragment;
+void setCubeShaderTextureAsset(ShaderContext& shaderContext, TextureAssetID asset) noexcept
+{
+    // The layer buffer keeps layer 0 for every face.
+    assert(shaderContext.materialCount == 0);
 
-                layout(location = 1)
+    shaderContext.textureAsset = asset;
+    shaderContext.isTextureCached = true;
+}
 
-				uniform uint objectID;
-				uniform uint drawID;
+void updateCubeShaderCachedTexture(ShaderContext& shaderContext, TextureCache& cache, TextureStreamer& streamer) noexcept
+{
+    if (shaderContext.isTextureCached)
+    {
+        shaderContext.textureBinding = getCachedTexture(cache, streamer, shaderContext.textureAsset, shaderContext.defaultTextureBinding);
+    }
+}
 
-				void main()
-				{
-					 fragment = uvec3(objectID, drawID, gl_PrimitiveID);
-				}
-        )kz_shader";
+ShaderContext createCubeShader() noexcept
+{
+		// Load OpenGL functions.
+#define X(type, name) name = (type)wglGetProcAddress(#name); assert(name);
+		GL_FUNCTIONS(X)
+#undef X
 
-    // Textured cube shader compilation/linking.
-	{
-		const GLuint cubeVertexShaderProgram = getCompiledShaderProgram(headerSource, cubeVertexShaderSource, GL_VERTEX_SHADER);
-		const GLuint cubeFragmentShaderProgram = getCompiledShaderProgram(headerSource, cubeFragmentShaderSource, GL_FRAGMENT_SHADER);
-		const GLuint cubeRTTFragmentShaderProgram = getCompiledShaderProgram(headerSource, cubeRTTFragmentShaderSource, GL_FRAGMENT_SHADER);
+    assert(glGetError() == GL_NO_ERROR);
 
-		cubeShader.cubeProgram = getLinkedShaderProgram(cubeVertexShaderProgram, cubeFragmentShaderProgram);
-		cubeShader.rttProgram = getLinkedShaderProgram(cubeVertexShaderProgram, cubeRTTFragmentShaderProgram);
+    ShaderContext cubeShader = {};
 
-		deleteShaderProgram(cubeVertexShaderProgram);
-		deleteShaderProgram(cubeFragmentShaderProgram);
-		deleteShaderProgram(cubeRTTFragmentShaderProgram);
-	}
+    // Submitted by submitCubeShaderPrograms when it ran, both compile together and share the vertex shader.
+    cubeShader.cubeProgram = takeReflectedShaderProgram(getCubeProgramSource(cubeFragmentShaderSource), cubeShader.cubeUniforms);
+    cubeShader.rttProgram = takeReflectedShaderProgram(getCubeProgramSource(cubeRTTFragmentShaderSource), cubeShader.rttUniforms);
 
-    cubeShader.uvRepeatCountUniform = glGetUniformLocation(cubeShader.cubeProgram, "uvRepeatCount");
+    cubeShader.uvRepeatCountUniform = getUniformLocation(cubeShader.cubeUniforms, uniformName("uvRepeatCount"));
 
-    cubeShader.objectIDUniform = glGetUniformLocation(cubeShader.rttProgram, "objectID");
-    cubeShader.drawIDUniform = glGetUniformLocation(cubeShader.rttProgram, "drawID");
+    cubeShader.objectIDUniform = getUniformLocation(cubeShader.rttUniforms, uniformName("objectID"));
+    cubeShader.drawIDUniform = getUniformLocation(cubeShader.rttUniforms, uniformName("drawID"));
 
-    //assert(cubeShader.modelViewProjectionMatrixUniform >= 0);
     assert(cubeShader.uvRepeatCountUniform >= 0);
 
     assert(cubeShader.objectIDUniform >= 0);
@@ -734,6 +1074,14 @@ ShaderContext createCubeShader() noexcept
     cubeShader.positionsOffset = 0;
     cubeShader.UVOffset = sizeof(cubeStripVertices);
 
+    // Every instance samples layer 0 of the default texture until the materials are resident.
+    {
+        const GLuint layers[maxCubeMaterialCount]{};
+
+        glCreateBuffers(1, &cubeShader.materialLayerBuffer);
+        glNamedBufferStorage(cubeShader.materialLayerBuffer, sizeof(layers), layers, GL_DYNAMIC_STORAGE_BIT);
+    }
+
     // Cube shader VAO/VBO setup.
     {
 
@@ -771,6 +1119,9 @@ ShaderContext createCubeShader() noexcept
         // Enable the attribute.
         glEnableVertexAttribArray(uvAttributeIndex);
 
+        // Face i is drawn as instance i.
+        enableMaterialLayerAttribute(cubeShader.materialLayerBuffer);
+
         // Detach vertex buffer and array attributes.
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
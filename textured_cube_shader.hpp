@@ -2,6 +2,20 @@
 #define KZ_CUBE_SHADER_HPP
 
 #include "gl_functions.h"
+#include <meshlet_culling.hpp>
+#include <uniform_reflection.hpp>
+#include <render_queue.hpp>
+#include <texture_streaming.hpp>
+#include <texture_pool.hpp>
+#include <texture_cache.hpp>
+
+struct MeshData;
+struct MeshLodChain;
+
+constexpr unsigned int maxMeshLodCount = 8;
+
+// One per cube face, each face is drawn as its own instance.
+constexpr unsigned int maxCubeMaterialCount = 6;
 
 struct Matrix4x4
 {
@@ -19,7 +33,10 @@ struct ShaderContext
     GLuint cubeProgram{};
     GLuint rttProgram{};
 
-    GLint modelViewProjectionMatrixUniform{};
+    // Active uniforms of both programs, reflected at link time.
+    UniformReflection cubeUniforms{};
+    UniformReflection rttUniforms{};
+
     GLint uvRepeatCountUniform{};
     GLint objectIDUniform{};
     GLint drawIDUniform{};
@@ -36,29 +53,121 @@ struct ShaderContext
     GLuint cubePickingVBO{};
 
     GLuint textureBinding{};
+    GLuint textureSampler{};
     GLsizei textureWidth{};
     GLsizei textureHeight{};
     GLsizei textureBpp{};
     const void* textureMemory{};
 
+    // Single layer array drawn until every material layer is resident.
+    GLuint defaultTextureBinding{};
+
+    // Pooled in one texture array, face i samples the layer of material i % materialCount.
+    TexturePoolSlot materials[maxCubeMaterialCount]{};
+    unsigned int materialCount{};
+    bool isMaterialResident{};
+
+    // Layer index per instance, read through a per-instance vertex attribute.
+    GLuint materialLayerBuffer{};
+
+    // Asset looked up in the texture cache every frame in place of the pooled materials.
+    TextureAssetID textureAsset{};
+    bool isTextureCached{};
+
     GLuint positionsOffset{};
     GLuint UVOffset{};
+
+    // Imported mesh drawn instead of the cube when present.
+    GLuint meshVAO{};
+    GLuint meshVBO{};
+    GLuint meshIBO{};
+    GLsizei meshIndexCount{};
+
+    // Index ranges of the mesh LOD chain inside meshIBO, LOD 0 is the full mesh.
+    GLuint meshLodFirstIndex[maxMeshLodCount]{};
+    GLsizei meshLodIndexCount[maxMeshLodCount]{};
+    GLfloat meshLodError[maxMeshLodCount]{};
+    unsigned int meshLodCount{};
+
+    GLfloat meshBoundsCenter[3]{};
+    GLfloat meshBoundsRadius{};
+
+    // Largest LOD error in pixels allowed on screen.
+    GLfloat meshLodPixelError{ 1.0f };
+
+    // LOD drawn into the ID texture, negative picks with the same LOD as the color pass.
+    int meshPickLod{ -1 };
+
+    // LODs selected for the last drawn frame.
+    unsigned int meshDrawnLod{};
+    unsigned int meshPickedLod{};
+
+    // Per-LOD meshlet ranges, the cull pre-pass replaces the plain draws once the meshlets are uploaded.
+    MeshletCullingContext meshletCulling{};
+    GLuint meshLodFirstMeshlet[maxMeshLodCount]{};
+    GLuint meshLodMeshletCount[maxMeshLodCount]{};
+    bool meshletCullingEnabled{ true };
+
+    // Max-depth pyramid of the previous ID pass depth, tests the object and meshlets in the cull pass.
+    HiZPyramid hiZPyramid{};
+
+    // Object test for draws without the cull pass, uses the unit cube as proxy.
+    OcclusionQuery objectQuery{};
+
+    // Color pass counters of the last frame.
+    OcclusionStats occlusionStats{};
 };
 
+// Starts compiling the cube, ID pass and Hi-Z programs, call it early so they compile while the rest of startup runs.
+void submitCubeShaderPrograms() noexcept;
+
 ShaderContext createCubeShader() noexcept;
 
+void uploadMeshToShader(ShaderContext& shaderContext, const MeshData& mesh) noexcept;
+
+void setMeshLodChain(ShaderContext& shaderContext, const MeshLodChain& lodChain) noexcept;
+
+// Builds meshlets for every LOD set on the context and enables the GPU cull pre-pass.
+void setupMeshletCulling(ShaderContext& shaderContext, const MeshData& mesh) noexcept;
+
+// Hi-Z pyramid over the depth attachment of the ID pass framebuffer, and the occlusion query fallback.
+void setupOcclusionCulling(ShaderContext& shaderContext, GLuint depthTexture, GLsizei depthWidth, GLsizei depthHeight) noexcept;
+
+// Sets the packet to draw one triangle of the cube or mesh as written to the ID texture by the last drawCubeShaderToTexture.
+void setPickedPrimitiveDraw(const ShaderContext& shaderContext, DrawPacket& packet, unsigned int primitiveID) noexcept;
+
+void submitComputeShaderProgram(const GLchar* computeShaderSource) noexcept;
+
+// Waits only for the compile of this program when it was submitted before.
+GLuint createComputeShaderProgram(const GLchar* computeShaderSource, UniformReflection& reflection) noexcept;
+
 void generateAndBindTexture(ShaderContext& shaderContext) noexcept;
 
 void generateAndBindDefaultTexture(ShaderContext& shaderContext) noexcept;
 
-void setDefaultGLTextureParameters(const ShaderContext& shaderContext) noexcept;
+// Picks the shared trilinear sampler the cube textures are drawn with.
+void setDefaultGLTextureParameters(ShaderContext& shaderContext) noexcept;
 
-void setupCubeShaderView(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
+// Streams the material with all its mip levels into a pool layer, materials must share format, size and level count
+// so they fit one array. Returns false when the image does not fit the array of the first material.
+bool addCubeShaderMaterial(ShaderContext& shaderContext, TexturePool& pool, TextureStreamer& streamer, TextureImage&& image) noexcept;
+
+// Switches to the material array and writes the per-instance layers once every material layer is resident.
+void updateCubeShaderMaterials(ShaderContext& shaderContext, const TexturePool& pool, const TextureStreamer& streamer) noexcept;
 
-void drawCubeShaderToTexture(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
+// Draws the asset from the texture cache on every face, reloaded by the cache whenever it was evicted.
+void setCubeShaderTextureAsset(ShaderContext& shaderContext, TextureAssetID asset) noexcept;
+
+// Marks the asset used for this frame and draws the default texture while it is not resident.
+void updateCubeShaderCachedTexture(ShaderContext& shaderContext, TextureCache& cache, TextureStreamer& streamer) noexcept;
+
+// Sets the MVP of the frame on the context.
+void setupCubeShaderView(ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
 
-void drawTexturedCubeShaderToOutput(ShaderContext& context, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
+// Records the ID pass into the framebuffer, cull dispatches are issued while recording.
+void drawCubeShaderToTexture(ShaderContext& shaderContext, RenderQueue& queue, GLuint framebuffer, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
 
-void drawCubeShaderElapsed(const ShaderContext& shaderContext, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int usElapsed) noexcept;
+// Records the color pass into the default framebuffer.
+void drawTexturedCubeShaderToOutput(ShaderContext& context, RenderQueue& queue, unsigned int viewportWidth, unsigned int viewportHeight, unsigned int frameCounter) noexcept;
 
 #endif
@@ -0,0 +1,154 @@
+#include <uniform_reflection.hpp>
+
+#include <cassert>
+#include <cstring>
+
+void print(const char* format, ...);
+
+namespace
+{
+// Linear probing from the hash, the table never fills so an empty slot ends the search.
+void insertReflectedUniform(UniformReflection& reflection, const ReflectedUniform& uniform) noexcept
+{
+    if (reflection.count + 1 >= uniformReflectionSlotCount)
+    {
+        print("Too many active uniforms to reflect\n");
+
+        return;
+    }
+
+    unsigned int slot = uniform.nameHash & (uniformReflectionSlotCount - 1);
+
+    while (reflection.used[slot])
+    {
+        // Distinct names with the same hash would make lookups ambiguous.
+        assert(reflection.slots[slot].nameHash != uniform.nameHash);
+
+        slot = (slot + 1) & (uniformReflectionSlotCount - 1);
+    }
+
+    reflection.slots[slot] = uniform;
+    reflection.used[slot] = true;
+
+    ++reflection.count;
+}
+
+unsigned int hashResourceName(GLuint program, GLenum programInterface, GLuint index, char* name, GLsizei nameCapacity) noexcept
+{
+    GLsizei length = 0;
+    glGetProgramResourceName(program, programInterface, index, nameCapacity, &length, name);
+
+    // Arrays are reported as "name[0]".
+    if (length > 3 && std::strcmp(name + length - 3, "[0]") == 0)
+    {
+        length -= 3;
+    }
+
+    return hashUniformName(name, static_cast<size_t>(length));
+}
+
+void reflectBlocks(UniformReflection& reflection, GLuint program, GLenum programInterface, char* name, GLsizei nameCapacity) noexcept
+{
+    GLint blockCount = 0;
+    glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &blockCount);
+
+    for (GLint i = 0; i < blockCount; ++i)
+    {
+        const GLenum property = GL_BUFFER_BINDING;
+        GLint binding = -1;
+
+        glGetProgramResourceiv(program, programInterface, static_cast<GLuint>(i), 1, &property, 1, nullptr, &binding);
+
+        ReflectedUniform block = {};
+        block.nameHash = hashResourceName(program, programInterface, static_cast<GLuint>(i), name, nameCapacity);
+        block.location = binding;
+        block.type = programInterface;
+        block.arraySize = 1;
+
+        insertReflectedUniform(reflection, block);
+    }
+}
+
+}
+
+void reflectProgramUniforms(UniformReflection& reflection, GLuint program) noexcept
+{
+    assert(glGetError() == GL_NO_ERROR);
+    assert(glIsProgram(program));
+
+    reflection = {};
+
+    char name[256];
+    constexpr GLsizei nameCapacity = sizeof(name);
+
+    GLint uniformCount = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        const GLenum properties[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+        GLint values[4] = {};
+
+        glGetProgramResourceiv(program, GL_UNIFORM, static_cast<GLuint>(i), 4, properties, 4, nullptr, values);
+
+        // Block members have no location, their block is reflected instead.
+        if (values[3] != -1)
+        {
+            continue;
+        }
+
+        ReflectedUniform uniform = {};
+        uniform.nameHash = hashResourceName(program, GL_UNIFORM, static_cast<GLuint>(i), name, nameCapacity);
+        uniform.location = values[0];
+        uniform.type = static_cast<GLenum>(values[1]);
+        uniform.arraySize = values[2];
+
+        insertReflectedUniform(reflection, uniform);
+    }
+
+    reflectBlocks(reflection, program, GL_UNIFORM_BLOCK, name, nameCapacity);
+    reflectBlocks(reflection, program, GL_SHADER_STORAGE_BLOCK, name, nameCapacity);
+
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+const ReflectedUniform* findReflectedUniform(const UniformReflection& reflection, unsigned int nameHash) noexcept
+{
+    unsigned int slot = nameHash & (uniformReflectionSlotCount - 1);
+
+    while (reflection.used[slot])
+    {
+        if (reflection.slots[slot].nameHash == nameHash)
+        {
+            return &reflection.slots[slot];
+        }
+
+        slot = (slot + 1) & (uniformReflectionSlotCount - 1);
+    }
+
+    return nullptr;
+}
+
+GLint getUniformLocation(const UniformReflection& reflection, unsigned int nameHash) noexcept
+{
+    const ReflectedUniform* uniform = findReflectedUniform(reflection, nameHash);
+
+    if (!uniform || uniform->type == GL_UNIFORM_BLOCK || uniform->type == GL_SHADER_STORAGE_BLOCK)
+    {
+        return -1;
+    }
+
+    return uniform->location;
+}
+
+GLint getBlockBinding(const UniformReflection& reflection, unsigned int nameHash) noexcept
+{
+    const ReflectedUniform* block = findReflectedUniform(reflection, nameHash);
+
+    if (!block || (block->type != GL_UNIFORM_BLOCK && block->type != GL_SHADER_STORAGE_BLOCK))
+    {
+        return -1;
+    }
+
+    return block->location;
+}
@@ -0,0 +1,63 @@
+#ifndef KZ_UNIFORM_REFLECTION_HPP
+#define KZ_UNIFORM_REFLECTION_HPP
+
+#include "gl_functions.h"
+
+#include <cstddef>
+
+// Slots of the open-addressed table, a power of two well above the uniform count of any program here.
+constexpr unsigned int uniformReflectionSlotCount = 64;
+
+// 32-bit FNV-1a of a uniform or block name, array names are hashed without the "[0]" suffix.
+constexpr unsigned int hashUniformName(const char* name, size_t length) noexcept
+{
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Hash of a name literal for lookups, bind it to a constexpr constant where it must not be hashed at run time.
+template<size_t N>
+constexpr unsigned int uniformName(const char (&name)[N]) noexcept
+{
+    return hashUniformName(name, N - 1);
+}
+
+struct ReflectedUniform
+{
+    unsigned int nameHash{};
+
+    // Uniform location, or the binding point for uniform and shader storage blocks.
+    GLint location{ -1 };
+
+    // GLSL type, or GL_UNIFORM_BLOCK / GL_SHADER_STORAGE_BLOCK for blocks.
+    GLenum type{};
+    GLint arraySize{};
+};
+
+// Active uniforms and blocks of one linked program.
+struct UniformReflection
+{
+    ReflectedUniform slots[uniformReflectionSlotCount]{};
+    bool used[uniformReflectionSlotCount]{};
+    unsigned int count{};
+};
+
+// Queries all active uniforms and blocks once, call right after linking.
+void reflectProgramUniforms(UniformReflection& reflection, GLuint program) noexcept;
+
+const ReflectedUniform* findReflectedUniform(const UniformReflection& reflection, unsigned int nameHash) noexcept;
+
+// Location of a uniform outside of blocks, -1 when the program has no such active uniform.
+GLint getUniformLocation(const UniformReflection& reflection, unsigned int nameHash) noexcept;
+
+// Binding point of a uniform or shader storage block, -1 when not active.
+GLint getBlockBinding(const UniformReflection& reflection, unsigned int nameHash) noexcept;
+
+#endif
@@ -9,6 +9,28 @@
 // (4.3) ARB_explicit_uniform_location: https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_explicit_uniform_location.txt
 
 #include <textured_cube_shader.hpp>
+#include <mesh_importer.hpp>
+#include <mesh_optimizer.hpp>
+#include <mesh_simplifier.hpp>
+#include <gl_state_cache.hpp>
+#include <uniform_reflection.hpp>
+#include <render_queue.hpp>
+#include <frame_recording.hpp>
+#include <job_system.hpp>
+#include <spsc_queue.hpp>
+#include <input_queue.hpp>
+#include <frame_pacing.hpp>
+#include <low_latency.hpp>
+#include <texture_streaming.hpp>
+#include <texture_samplers.hpp>
+#include <mipmap_generator.hpp>
+#include <texture_loader.hpp>
+#include <texture_encoder.hpp>
+#include <texture_pool.hpp>
+#include <image_decoder.hpp>
+#include <procedural_texture.hpp>
+#include <program_cache.hpp>
+#include <shader_compiler.hpp>
 
 #define EQ(n, p) [&]() -> bool {for(size_t i__ = 0u; i__ < (n); ++i__) { if ((p)) { return true; } } return false; }()
 #define UQ(n, p) [&]() -> bool {for(size_t i__ = 0u; i__ < (n); ++i__) { if (!(p)) { return false; } } return true; }()
@@ -28,6 +50,9 @@
 #include <algorithm>
 #include <vector>
 #include <optional>
+#include <utility>
+#include <atomic>
+#include <thread>
 
 #include <intrin.h>
 #ifdef _DEBUG
@@ -82,23 +107,160 @@ static void APIENTRY DebugCallback(
 }
 #endif
 
-static bool globalIsMouseButtonDown;
+// Window messages the render thread acts on, forwarded by WindowProc.
+struct WindowEvent
+{
+	UINT message;
+	WPARAM wparam;
+	LPARAM lparam;
+
+	// QueryPerformanceCounter ticks when WindowProc received it.
+	LONGLONG time;
+};
+
+// Posted by the render thread once it has released the window.
+constexpr UINT renderThreadExitMessage = WM_APP + 1;
+
+// Written by the message pump only.
+struct MessagePumpStats
+{
+	std::atomic<unsigned int> forwardedCount;
+	std::atomic<unsigned int> droppedCount;
+	std::atomic<LONGLONG> maxDispatchTicks;
+};
+
+static SpscQueue<WindowEvent, 1024> globalWindowEvents;
+static InputQueue globalInputEvents;
+static MessagePumpStats globalPumpStats;
+
+// Auto-reset, signaled after each forwarded event so an idle render thread wakes up.
+static HANDLE globalRenderWakeEvent;
+
+// WM_MOUSELEAVE is requested again after each leave.
+static bool globalIsTrackingMouseLeave;
+
+static void forwardWindowEvent(UINT msg, WPARAM wparam, LPARAM lparam)
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+
+	const WindowEvent event = { msg, wparam, lparam, now.QuadPart };
+
+	// A full queue means the render thread is stalled, the pump still must not wait for it.
+	if (pushQueueItem(globalWindowEvents, event))
+	{
+		globalPumpStats.forwardedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		globalPumpStats.droppedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	SetEvent(globalRenderWakeEvent);
+}
+
+static unsigned int getMouseButtons(WPARAM wparam)
+{
+	const WORD keyState = LOWORD(wparam);
+
+	unsigned int buttons = 0;
+	buttons |= (keyState & MK_LBUTTON) ? mouseButtonLeft : 0;
+	buttons |= (keyState & MK_RBUTTON) ? mouseButtonRight : 0;
+	buttons |= (keyState & MK_MBUTTON) ? mouseButtonMiddle : 0;
+	buttons |= (keyState & MK_XBUTTON1) ? mouseButtonX1 : 0;
+	buttons |= (keyState & MK_XBUTTON2) ? mouseButtonX2 : 0;
+
+	return buttons;
+}
+
+static void forwardInputEvent(InputEventType type, WPARAM wparam, LPARAM lparam)
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+
+	InputEvent event = {};
+	event.type = type;
+	event.x = (short)LOWORD(lparam);
+	event.y = (short)HIWORD(lparam);
+	event.buttons = type == inputEventMouseLeave ? 0 : getMouseButtons(wparam);
+	event.time = now.QuadPart;
+
+	if (pushInputEvent(globalInputEvents, event))
+	{
+		globalPumpStats.forwardedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		globalPumpStats.droppedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	SetEvent(globalRenderWakeEvent);
+}
 
 static LRESULT CALLBACK WindowProc(HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
     switch (msg)
     {
+	case WM_CLOSE:
+		// The render thread still draws to the window, it asks for the destruction when done.
+		forwardWindowEvent(msg, wparam, lparam);
+		return 0;
+
+	case renderThreadExitMessage:
+		DestroyWindow(wnd);
+		return 0;
+
+	case WM_PAINT:
+		// Exposed parts need a redraw when rendering on demand, DefWindowProc validates them.
+		forwardWindowEvent(msg, wparam, lparam);
+		break;
+
+	case WM_KEYDOWN:
+		// Space toggles the animation, auto-repeats are ignored.
+		if (wparam == VK_SPACE && (lparam & (1 << 30)) == 0)
+		{
+			forwardWindowEvent(msg, wparam, lparam);
+		}
+		break;
+
     case WM_DESTROY:
         PostQuitMessage(0);
         return 0;
 
+	case WM_MOUSEMOVE:
+	{
+		if (!globalIsTrackingMouseLeave)
+		{
+			TRACKMOUSEEVENT track = {};
+			track.cbSize = sizeof(track);
+			track.dwFlags = TME_LEAVE;
+			track.hwndTrack = wnd;
+
+			globalIsTrackingMouseLeave = TrackMouseEvent(&track) != FALSE;
+		}
+
+		forwardInputEvent(inputEventMouseMove, wparam, lparam);
+		break;
+	}
+
+	case WM_MOUSELEAVE:
+	{
+		globalIsTrackingMouseLeave = false;
+
+		forwardInputEvent(inputEventMouseLeave, wparam, lparam);
+		break;
+	}
+
 		// Mouse down events.
 	case WM_LBUTTONDOWN:
 	case WM_RBUTTONDOWN:
 	case WM_MBUTTONDOWN:
 	case WM_XBUTTONDOWN:
 	{
-		globalIsMouseButtonDown ^= 1;
+		// Keeps the release coming when it happens outside the window.
+		SetCapture(wnd);
+
+		forwardInputEvent(inputEventButtonDown, wparam, lparam);
 		break;
 	}
 
@@ -108,7 +270,12 @@ static LRESULT CALLBACK WindowProc(HWND wnd, UINT msg, WPARAM wparam, LPARAM lpa
 	case WM_MBUTTONUP:
 	case WM_XBUTTONUP:
 	{
-		globalIsMouseButtonDown ^= 1;
+		forwardInputEvent(inputEventButtonUp, wparam, lparam);
+
+		if (getMouseButtons(wparam) == 0)
+		{
+			ReleaseCapture();
+		}
 		break;
 	}
 
@@ -138,6 +305,10 @@ struct ProgramPipeline
     GLuint vertexShader;
     GLuint fragmentShader;
 
+    // Active uniforms of both stages, reflected when the pipeline is created.
+    UniformReflection vertexUniforms;
+    UniformReflection fragmentUniforms;
+
     // TODO: Split these.
 	GLint vertexTransformUniform;
 	GLint mousePositionUniform;
@@ -152,7 +323,8 @@ struct Vertex
 
 void print(const char* format, ...)
 {
-    static std::array<char, 1024> vaArgsBuffer;
+    // The render thread and job workers print too.
+    static thread_local std::array<char, 1024> vaArgsBuffer;
 
     kzVaArgs(format, vaArgsBuffer)
 
@@ -169,21 +341,161 @@ void print(const char* format, ...)
     }
 }
 
+// Asset IDs of the texture cache index the paths, the file is mapped again on every reload.
+static bool loadTextureAsset(void* userData, TextureAssetID asset, TextureImage& image)
+{
+	const std::vector<std::string>& paths = *(const std::vector<std::string>*)userData;
+
+	if (asset >= paths.size() || !loadTextureFile(paths[asset].c_str(), image))
+	{
+		return false;
+	}
+
+	if (!isTextureFormatSupported(image.internalFormat))
+	{
+		print("Texture format 0x%04X is not supported by the driver.\n", image.internalFormat);
+		releaseTextureImage(image);
+		return false;
+	}
+
+	return true;
+}
+
 static void drawText(const char* text, ...)
 {
     // draw to window ...
 }
 
-static void drawQuad()
+// Draws a picked primitive.
+static const char* pickingVertexShaderSource = R"glshader(
+				#version 450 core                             
+				                                              
+				layout (location=0) in vec3 a_pos;            
+				//layout (location=0) uniform mat4 modelViewProjectionMatrix;          
+
+				uniform mat4 modelViewProjectionMatrix;          
+
+				out gl_PerVertex { vec4 gl_Position; };       
+
+				void main()                                   
+				{                                             
+				    gl_Position = modelViewProjectionMatrix * vec4(a_pos, 1);
+                })glshader";
+
+static const char* pickingFragmentShaderSource = R"glshader(
+				#version 450 core                          
+				layout (location=0)                        
+				out vec4 o_color;                          
+				void main()                                
+				{                                          
+				    o_color = vec4(0.90f, 0.90f, 0.90f, 1.0f);
+                })glshader";
+
+// Draws the x and y axis through the cursor.
+static const char* axisVertexShaderSource = R"glshader(
+				#version 450 core                             
+				                                              
+				layout (location=0) in vec2 a_pos;            
+				out gl_PerVertex { vec4 gl_Position; };       
+				void main()                                   
+				{                                             
+				    gl_Position = vec4(a_pos, -1.0f, 1.0f);            
+                })glshader";
+
+static const char* axisFragmentShaderSource = R"glshader(
+				#version 450 core                          
+
+				uniform ivec2 mousePosition;          
+				//uniform int subPixelResolution;          
+
+				layout (location=0)                        
+				out vec4 o_color;                          
+
+				// Fixed point sub-pixel snapping.
+				// Pixels are centered offset by 0.5.
+				//const int fixedPointScaleFactor = 1 << subPixelResolution;
+
+				void main()
+				{
+					vec4 red = vec4(1.0f, 0.0f, 0.0f, 1.0f);
+					vec4 white = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+					vec4 green = vec4(0.0f, 1.0f, 0.0f, 1.0f);
+					vec4 black = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+					float pixelHalfWidth = 0.5f;
+
+					// Normalized othogonal directions.
+					vec2 upAxis = vec2(0.0f, 1.0f);
+					vec2 rightAxis = vec2(1.0f, 0.0f);
+
+					vec4 inputPosition = vec4(float(mousePosition.x), float(mousePosition.y), 0.0f, 0.0f);
+
+					vec4 inputVector = vec4(gl_FragCoord) - inputPosition;
+
+				    float verticalPixelDelta = dot(upAxis, inputVector.xy);
+				    float horizontalPixelDelta = dot(rightAxis, inputVector.xy);
+
+					vec2 fragVectorScaled = (gl_FragCoord.xy);
+					vec2 inputVectorScaled = (inputPosition.xy);
+
+					// Upper-left screenspace origin.
+					if (mousePosition.x != -1 && mousePosition.y != -1)
+					{
+						if (horizontalPixelDelta == pixelHalfWidth)
+						{
+							// Y axis.
+
+							if (fragVectorScaled.y - pixelHalfWidth > inputVectorScaled.y)
+							{
+								o_color = green;
+                                return;
+							}
+							if (fragVectorScaled.y - pixelHalfWidth == inputVectorScaled.y)
+							{
+								o_color = white;
+                                return;
+							}
+							else
+                            {
+                                discard;
+                            }
+						}
+						if (verticalPixelDelta == pixelHalfWidth)
+						{
+							// X axis.
+
+							if (fragVectorScaled.x - pixelHalfWidth < inputVectorScaled.x)
+							{
+								o_color = red;
+                                return;
+							}
+							else
+                            {
+                                discard;
+                            }
+						}
+					}
+                    else
+                    {
+                        discard;
+                    }
+                })glshader";
+
+static ShaderProgramSource getSeparableProgramSource(GLenum type, const char* source)
 {
-	glDrawArrays(GL_TRIANGLES, 0, 6);
+	ShaderProgramSource result = {};
+	result.stages[0] = { type, source };
+	result.stageCount = 1;
+	result.isSeparable = true;
+
+	return result;
 }
 
-// TODO:
-// Re-use this
-static void drawTriangle(int index)
+// Starts compiling both stages, createProgramPipeline takes them.
+static void submitProgramPipeline(const char* vShader, const char* fShader)
 {
-	glDrawArrays(GL_TRIANGLES, index, 3);
+	submitShaderProgram(getSeparableProgramSource(GL_VERTEX_SHADER, vShader));
+	submitShaderProgram(getSeparableProgramSource(GL_FRAGMENT_SHADER, fShader));
 }
 
 static ProgramPipeline createProgramPipeline(const char* vShader, const char* fShader)
@@ -192,8 +504,8 @@ static ProgramPipeline createProgramPipeline(const char* vShader, const char* fS
 
     ProgramPipeline result = {}; 
 
-    result.vertexShader = glCreateShaderProgramv(GL_VERTEX_SHADER, 1, &vShader);
-    result.fragmentShader = glCreateShaderProgramv(GL_FRAGMENT_SHADER, 1, &fShader);
+    result.vertexShader = takeShaderProgram(getSeparableProgramSource(GL_VERTEX_SHADER, vShader));
+    result.fragmentShader = takeShaderProgram(getSeparableProgramSource(GL_FRAGMENT_SHADER, fShader));
 
     GLint linked = {};
 
@@ -232,6 +544,9 @@ static ProgramPipeline createProgramPipeline(const char* vShader, const char* fS
 		Invariant(!"Failed to create program pipeline!");
     }
 
+	reflectProgramUniforms(result.vertexUniforms, result.vertexShader);
+	reflectProgramUniforms(result.fragmentUniforms, result.fragmentShader);
+
 	assert(glGetError() == GL_NO_ERROR);
 
     return result;
@@ -239,22 +554,7 @@ static ProgramPipeline createProgramPipeline(const char* vShader, const char* fS
 
 static void bindProgramPipeline(ProgramPipeline pp)
 {
-    glBindProgramPipeline(pp.pipeline);
-}
-
-Position getCursorWindowPosition(HWND window, int windowWidth, int windowHeight)
-{
-	Position result = {};
-
-	POINT cursorPoint = {};
-	GetCursorPos(&cursorPoint);
-
-	ScreenToClient(window, &cursorPoint);
-
-	result.x = cursorPoint.x;
-	result.y = cursorPoint.y;
-
-	return result;
+    cachedBindProgramPipeline(pp.pipeline);
 }
 
 // compares src string with dstlen characters from dst, returns 1 if they are equal, 0 if not
@@ -383,49 +683,144 @@ struct PixelBufferData
 	unsigned int primitiveID;
 };
 
-void drawCubeShaderToTexture(ShaderContext& context, int width, int height, unsigned int counter, GLuint frameBuffer) 
+// One more than the frames in flight, so a read can be issued while the pacer holds the maximum.
+constexpr unsigned int pickReadbackCount = maxPacedFramesInFlight + 1;
+
+// Texels under the cursor read into pack buffers, each taken once its fence signaled.
+// Reading into client memory would wait for the ID pass, which is queued behind the whole previous frame.
+struct PickReadback
 {
-	assert(glGetError() == GL_NO_ERROR);
-	assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	GLuint buffers[pickReadbackCount];
+	GLsync fences[pickReadbackCount];
 
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+	// Reads issued and not taken yet, the oldest is pendingCount slots before next.
+	unsigned int next;
+	unsigned int pendingCount;
 
-	// Draw cube into texture.
-	drawCubeShaderToTexture(context, width, height, counter);
+	// Newest texels taken, a frame or more behind the cursor.
+	PixelBufferData texels;
 
-	// Restore default frame buffer.
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// Frames that issued no read because every buffer was still pending.
+	unsigned int skippedCount;
+};
 
-	assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-	assert(glGetError() == GL_NO_ERROR);
+static PickReadback createPickReadback()
+{
+	PickReadback readback = {};
+
+	glCreateBuffers(pickReadbackCount, readback.buffers);
+
+	for (unsigned int i = 0; i < pickReadbackCount; ++i)
+	{
+		glNamedBufferStorage(readback.buffers[i], sizeof(PixelBufferData), NULL, 0);
+	}
+
+	return readback;
 }
 
-PixelBufferData readFromTextureCube(int x, int y, int width, int height, GLuint frameBuffer)
+static void destroyPickReadback(PickReadback& readback)
 {
-	PixelBufferData result = {};
+	for (unsigned int i = 0; i < pickReadbackCount; ++i)
+	{
+		if (readback.fences[i])
+		{
+			glDeleteSync(readback.fences[i]);
+		}
+	}
 
-	// Read from frame buffer 
-	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
-	glViewport(0, 0, width, height);
+	glDeleteBuffers(pickReadbackCount, readback.buffers);
+
+	readback = {};
+}
+
+// Issues the read of this frame's ID pass and returns the newest texels that arrived, never waiting for the GPU.
+static PixelBufferData readFromTextureCube(PickReadback& readback, int x, int y, int width, int height, GLuint frameBuffer)
+{
+	// Reads finish in order, stop at the first one still running.
+	while (readback.pendingCount > 0)
+	{
+		const unsigned int slot = (readback.next + pickReadbackCount - readback.pendingCount) % pickReadbackCount;
+		const GLenum result = glClientWaitSync(readback.fences[slot], 0, 0);
+
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		glDeleteSync(readback.fences[slot]);
+		readback.fences[slot] = NULL;
 
-	// Read from color texture
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
-	glFlush();
-	glFinish();
+		glGetNamedBufferSubData(readback.buffers[slot], 0, sizeof(PixelBufferData), &readback.texels);
+
+		--readback.pendingCount;
+	}
+
+	if (readback.pendingCount == pickReadbackCount)
+	{
+		++readback.skippedCount;
+
+		return readback.texels;
+	}
+
+	// Read from frame buffer 
+	cachedBindFramebuffer(frameBuffer);
+	cachedViewport(0, 0, width, height);
 
+	// Read from color texture into the buffer, the GPU copies it after the ID pass
 	glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
-	glReadPixels(x, height - y, 1, 1, GL_RGB_INTEGER, GL_UNSIGNED_INT, &result);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffers[readback.next]);
+	glReadPixels(x, height - y, 1, 1, GL_RGB_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.fences[readback.next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.next = (readback.next + 1) % pickReadbackCount;
+	++readback.pendingCount;
 
 	// Restore default frame buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	cachedBindFramebuffer(0);
 
-    return result;
+	return readback.texels;
+}
+
+// Removes the switch when it is the first word of the command line, e.g. "--bench --on-demand mesh.obj".
+static bool takeCommandLineSwitch(std::string_view& commandLine, std::string_view name)
+{
+	while (!commandLine.empty() && commandLine.front() == ' ')
+	{
+		commandLine.remove_prefix(1);
+	}
+
+	if (commandLine.substr(0, name.size()) != name || (commandLine.size() > name.size() && commandLine[name.size()] != ' '))
+	{
+		return false;
+	}
+
+	commandLine.remove_prefix(name.size());
+
+	return true;
+}
+
+static bool hasPathExtension(std::string_view path, std::string_view extension)
+{
+	return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
 }
 
-static void drawPrimitive(int primitiveID)
+// Returns the command line with surrounding quotes and spaces removed.
+static std::string getCommandLinePath(std::string_view path)
 {
-	drawTriangle(primitiveID*3);
+
+	while (!path.empty() && (path.front() == ' ' || path.front() == '"'))
+	{
+		path.remove_prefix(1);
+	}
+
+	while (!path.empty() && (path.back() == ' ' || path.back() == '"'))
+	{
+		path.remove_suffix(1);
+	}
+
+	return std::string(path);
 }
 
 static Position globalOldCursor;
@@ -551,121 +946,48 @@ struct S
 	int i;
 };
 
-int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, int cmdshow)
+struct RenderThreadParameters
 {
-	{
-		S s = {};
-		foo(&s);
-	}
-#if 0
-	for (int i = INT_MIN; i < INT_MAX; ++i)
-	{
-		if (i >= INT_MIN / 7 && i <= INT_MAX / 7)
-		{
-			assert(i >= INT_MIN / 7 && i <= INT_MAX / 7);
-			const int result = narrowMult(i);
-
-			if (result != i)
-			{
-				FatalError("Fatal!");
-			}
-		}
-	}
-#endif
-
-	AttachConsole(ATTACH_PARENT_PROCESS);
-
-	// get WGL functions to be able to create modern GL context
-	GetWglFunctions();
-
-	// register window class to have custom WindowProc callback
-	WNDCLASSEXW wc = {};
-	wc.cbSize = sizeof(wc);
-	wc.lpfnWndProc = WindowProc;
-	wc.hInstance = instance;
-	wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
-	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
-	wc.lpszClassName = L"opengl_window_class";
-	ATOM atom = RegisterClassExW(&wc);
-	Invariant(atom && "Failed to register window class");
-
-	// window properties - width, height and style
-	int width = CW_USEDEFAULT;
-	int height = CW_USEDEFAULT;
-	DWORD exstyle = WS_EX_APPWINDOW;
-	DWORD style = WS_POPUPWINDOW;
-
-	// uncomment in case you want fixed size window
-	style &= ~WS_THICKFRAME & ~WS_MAXIMIZEBOX & ~WS_BORDER;
-	RECT rect = { 0, 0, 800, 600 };
-	AdjustWindowRectEx(&rect, style, FALSE, exstyle);
-	width = rect.right - rect.left;
-	height = rect.bottom - rect.top;
-
-	// create window
-	HWND window = CreateWindowExW(
-		exstyle, wc.lpszClassName, L"OpenGL Window", style,
-		1920/2 - width/2, 1080/2 - height/2, width, height,
-		NULL, NULL, wc.hInstance, NULL);
-	Invariant(window && "Failed to create window");
-
-	RECT clientRectangle = {};
-	GetClientRect(window, &clientRectangle);
-
-	width = clientRectangle.right - clientRectangle.left;
-	height = clientRectangle.bottom - clientRectangle.top;
-
-	Invariant(width > 0 && width <= (rect.right - rect.left));
-	Invariant(height > 0 && height <= (rect.bottom - rect.top));
-
-	const float aspectRatio = (float)height / width;
-
-	HDC dc = GetDC(window);
-	Invariant(dc && "Failed to window device context");
-
-	// set pixel format for OpenGL context
-	{
-		int attrib[] =
-		{
-			WGL_DRAW_TO_WINDOW_ARB, GL_TRUE,
-			WGL_SUPPORT_OPENGL_ARB, GL_TRUE,
-			WGL_DOUBLE_BUFFER_ARB,  GL_TRUE,
-			WGL_PIXEL_TYPE_ARB,     WGL_TYPE_RGBA_ARB,
-			WGL_COLOR_BITS_ARB,     24,
-			WGL_DEPTH_BITS_ARB,     24,
-			WGL_STENCIL_BITS_ARB,   8,
-
-			// uncomment for sRGB framebuffer, from WGL_ARB_framebuffer_sRGB extension
-			// https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_framebuffer_sRGB.txt
-			//WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB, GL_TRUE,
-
-			// uncomment for multisampeld framebuffer, from WGL_ARB_multisample extension
-			// https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_multisample.txt
-			//WGL_SAMPLE_BUFFERS_ARB, 1,
-			//WGL_SAMPLES_ARB,        4, // 4x MSAA
+	HWND window;
+	HDC dc;
+	int width;
+	int height;
+	std::string meshPath;
+	bool lowLatency;
+	bool onDemandRedraw;
+	bool runBenchmarks;
+};
 
-			0,
-		};
+struct LatencyStats
+{
+	double totalSeconds;
+	double maxSeconds;
+	unsigned int sampleCount;
+};
 
-		int format;
-		UINT formats;
-		if (!wglChoosePixelFormatARB(dc, attrib, NULL, 1, &format, &formats) || formats == 0)
-		{
-			FatalError("OpenGL does not support required pixel format!");
-		}
+static void addLatencySample(LatencyStats& stats, double seconds)
+{
+	stats.totalSeconds += seconds;
+	stats.maxSeconds = seconds > stats.maxSeconds ? seconds : stats.maxSeconds;
+	++stats.sampleCount;
+}
 
-		PIXELFORMATDESCRIPTOR desc = {};
-		desc.nSize = sizeof(desc);
-		int ok = DescribePixelFormat(dc, format, sizeof(desc), &desc);
-		Invariant(ok && "Failed to describe OpenGL pixel format");
+static double getAverageMilliseconds(const LatencyStats& stats)
+{
+	return stats.sampleCount ? stats.totalSeconds * 1000.0 / stats.sampleCount : 0.0;
+}
 
-		if (!SetPixelFormat(dc, format, &desc))
-		{
-			FatalError("Cannot set OpenGL selected pixel format!");
-		}
-	}
+// Owns the GL context from creation to release, window events and input arrive through globalWindowEvents and globalInputEvents.
+static void runRenderThread(RenderThreadParameters parameters)
+{
+	HWND window = parameters.window;
+	HDC dc = parameters.dc;
+	const int width = parameters.width;
+	const int height = parameters.height;
 
 	// create modern OpenGL context
+	HGLRC rc = NULL;
+	HGLRC compilerRc = NULL;
 	{
 		int attrib[] =
 		{
@@ -680,12 +1002,15 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 			0,
 		};
 
-		HGLRC rc = wglCreateContextAttribsARB(dc, NULL, attrib);
+		rc = wglCreateContextAttribsARB(dc, NULL, attrib);
 		if (!rc)
 		{
 			FatalError("Cannot create modern OpenGL context! OpenGL version 4.5 not supported?");
 		}
 
+		// shares objects with the render context, shaders compile on it when the driver cannot compile in parallel
+		compilerRc = wglCreateContextAttribsARB(dc, rc, attrib);
+
 		BOOL ok = wglMakeCurrent(dc, rc);
 		Invariant(ok && "Failed to make current OpenGL context");
 
@@ -701,8 +1026,132 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 #endif
 	}
 
+	// Linked programs are stored per driver, later starts load them instead of compiling.
+	initializeProgramCache("shader_cache");
+
+	// Programs compile on driver threads, or on a thread with its own context when the driver has none.
+	initializeShaderCompiler(dc, compilerRc);
+
+	// Every startup program is submitted before the first is taken, so startup waits for the slowest compile rather than all of them.
+	submitCubeShaderPrograms();
+	submitProgramPipeline(pickingVertexShaderSource, pickingFragmentShaderSource);
+	submitProgramPipeline(axisVertexShaderSource, axisFragmentShaderSource);
+
 	ShaderContext cubeShader = createCubeShader();
 
+	// Uploads at most 4 MB per frame through a 16 MB staging ring.
+	TextureStreamer textureStreamer = createTextureStreamer(16 * 1024 * 1024, 4 * 1024 * 1024);
+
+	// Texture preparation runs on all other cores, the render thread joins in while it waits.
+	JobSystem* jobSystem = createJobSystem(getDefaultWorkerThreadCount());
+
+	// Materials of the same format and size share 64 MB texture arrays.
+	TexturePool texturePool = createTexturePool(64 * 1024 * 1024);
+
+	// File textures by asset ID, at most 256 MB of them stay on the GPU.
+	std::vector<std::string> texturePaths;
+	TextureCache textureCache = createTextureCache(256 * 1024 * 1024, loadTextureAsset, &texturePaths);
+
+	// A KTX2 or DDS file given on the command line replaces the texture, its levels stream straight from the mapping.
+	// A PNG, JPEG or TGA file is decoded on the job system and becomes the material.
+	const std::string_view commandLinePath = parameters.meshPath;
+	const bool isTexturePath = hasPathExtension(commandLinePath, ".ktx2") || hasPathExtension(commandLinePath, ".dds");
+	const bool isImagePath = hasPathExtension(commandLinePath, ".png") || hasPathExtension(commandLinePath, ".jpg") ||
+		hasPathExtension(commandLinePath, ".jpeg") || hasPathExtension(commandLinePath, ".tga");
+
+	if (isTexturePath)
+	{
+		texturePaths.push_back(parameters.meshPath);
+		setCubeShaderTextureAsset(cubeShader, 0);
+	}
+	else
+	{
+		std::vector<TextureImage> materialImages;
+
+		if (isImagePath)
+		{
+			const char* imagePaths[] = { parameters.meshPath.c_str() };
+
+			materialImages.resize(std::size(imagePaths));
+
+			const ImageDecodeStats decodeStats = decodeImageFiles(jobSystem, imagePaths, (unsigned int)std::size(imagePaths), materialImages.data());
+
+			print("Decoded %u of %u images, %.1f Mtexels in %.3f ms\n", decodeStats.imageCount - decodeStats.failedCount, decodeStats.imageCount,
+				(double)decodeStats.texelCount * 1e-6, decodeStats.seconds * 1000.0);
+
+			materialImages.erase(std::remove_if(materialImages.begin(), materialImages.end(), [](const TextureImage& image) { return image.pixels.empty(); }), materialImages.end());
+		}
+
+		// Otherwise high resolution copies of the default pattern in three colors, one array layer each, so the faces
+		// alternate materials in a single draw.
+		if (materialImages.empty())
+		{
+			for (const unsigned int color : { 0xccaa44u, 0x44aaccu, 0xaa44ccu })
+			{
+				// Two by two cells like the default test texture, generated on the job system.
+				ProceduralTextureDesc checkerDesc;
+				checkerDesc.width = 2048;
+				checkerDesc.height = 2048;
+				checkerDesc.layerCount = 1;
+				checkerDesc.layers[0].pattern = proceduralChecker;
+				checkerDesc.layers[0].firstColor = color;
+				checkerDesc.layers[0].cellCount = 2;
+
+				ProceduralTexture checkerTexture;
+				updateProceduralTexture(checkerTexture, checkerDesc, jobSystem);
+
+				materialImages.push_back(std::move(checkerTexture.image));
+			}
+		}
+
+		// Encoded to BC7 on the job system when the driver has it.
+		const bool isBptcSupported = isTextureFormatSupported(GL_COMPRESSED_RGBA_BPTC_UNORM);
+
+		for (TextureImage& materialImage : materialImages)
+		{
+			generateMipChain(materialImage, mipFilterKaiser, jobSystem);
+
+			TextureImage compressedImage;
+
+			if (isBptcSupported && encodeTextureImage(materialImage, GL_COMPRESSED_RGBA_BPTC_UNORM, compressedImage, jobSystem))
+			{
+				materialImage = std::move(compressedImage);
+			}
+
+			addCubeShaderMaterial(cubeShader, texturePool, textureStreamer, std::move(materialImage));
+		}
+	}
+
+	// Import the mesh given on the command line in place of the cube.
+	{
+		const std::string& meshPath = parameters.meshPath;
+
+		if (!meshPath.empty() && !isTexturePath && !isImagePath)
+		{
+			if (parameters.runBenchmarks)
+			{
+				benchmarkMeshImport(meshPath.c_str(), 3);
+			}
+
+			// compiles while the mesh is imported and simplified
+			submitMeshletCullingProgram();
+
+			MeshData mesh;
+
+			if (importMesh(meshPath.c_str(), mesh))
+			{
+				fitMeshToUnitCube(mesh);
+				optimizeMesh(mesh);
+
+				const MeshLodChain lodChain = generateMeshLodChain(mesh, maxMeshLodCount);
+
+				uploadMeshToShader(cubeShader, mesh);
+				setMeshLodChain(cubeShader, lodChain);
+				setupMeshletCulling(cubeShader, mesh);
+			}
+		}
+	}
+
 	GLuint quadVAO = 0;
 	{
 		// TODO: wrap the quad vao
@@ -747,167 +1196,51 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 	// render to texture
 	GLuint rttFramebuffer = 0;
 	{
+		// make the texture the same size as the viewport, it is only read back and never sampled
 		GLuint rttTexture = 0;
-		glGenTextures(1, &rttTexture);
-		glBindTexture(GL_TEXTURE_2D, rttTexture);
+		glCreateTextures(GL_TEXTURE_2D, 1, &rttTexture);
+		glTextureStorage2D(rttTexture, 1, GL_RGB32UI, width, height);
 
-		// make the texture the same size as the viewport
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32UI, width, height, 0, GL_RGB_INTEGER, GL_UNSIGNED_INT, NULL);
+		glCreateFramebuffers(1, &rttFramebuffer);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// attach colour texture to fb
+		glNamedFramebufferTexture(rttFramebuffer, GL_COLOR_ATTACHMENT0, rttTexture, 0);
 
-		glGenFramebuffers(1, &rttFramebuffer);
-		glBindFramebuffer(GL_FRAMEBUFFER, rttFramebuffer);
+		// depth is needed for picking non-convex meshes
+		GLuint rttDepthTexture = 0;
+		glCreateTextures(GL_TEXTURE_2D, 1, &rttDepthTexture);
+		glTextureStorage2D(rttDepthTexture, 1, GL_DEPTH24_STENCIL8, width, height);
 
-		// attach colour texture to fb
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, rttTexture, 0);
+		glNamedFramebufferTexture(rttFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, rttDepthTexture, 0);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		// previous frame depth feeds the occlusion culling of the next one
+		setupOcclusionCulling(cubeShader, rttDepthTexture, width, height);
 
-		// redirect fragment shader output 0 used to the texture that we just bound
+		// redirect fragment shader output 0 to the colour texture, the picking readback reads it too
 		GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(1, drawBuffers);
+		glNamedFramebufferDrawBuffers(rttFramebuffer, 1, drawBuffers);
+		glNamedFramebufferReadBuffer(rttFramebuffer, GL_COLOR_ATTACHMENT0);
 
-		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		if (glCheckNamedFramebufferStatus(rttFramebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		{
 			FatalError("Incomplete framebuffer status!");
 		}
-
-		// Bind default fb (number 0) so that we render normally next time
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	// Fragment & vertex shaders for drawing a picked primitive.
 	ProgramPipeline pickingPipeline = {};
 	{
-		const char* vShader = R"glshader(
-				#version 450 core                             
-				                                              
-				layout (location=0) in vec3 a_pos;            
-				//layout (location=0) uniform mat4 modelViewProjectionMatrix;          
-
-				uniform mat4 modelViewProjectionMatrix;          
-
-				out gl_PerVertex { vec4 gl_Position; };       
-
-				void main()                                   
-				{                                             
-				    gl_Position = modelViewProjectionMatrix * vec4(a_pos, 1);
-                })glshader";
-
-		const char* fShader = R"glshader(
-				#version 450 core                          
-				layout (location=0)                        
-				out vec4 o_color;                          
-				void main()                                
-				{                                          
-				    o_color = vec4(0.90f, 0.90f, 0.90f, 1.0f);
-                })glshader";
-
-		pickingPipeline = createProgramPipeline(vShader, fShader);
+		pickingPipeline = createProgramPipeline(pickingVertexShaderSource, pickingFragmentShaderSource);
 
-		pickingPipeline.vertexTransformUniform = glGetUniformLocation(pickingPipeline.vertexShader, "modelViewProjectionMatrix");
+		pickingPipeline.vertexTransformUniform = getUniformLocation(pickingPipeline.vertexUniforms, uniformName("modelViewProjectionMatrix"));
 	}
 
 	// Fragment & vertex shaders for drawing x and y axis.
 	ProgramPipeline axisPipeline = {};
 	{
-		const char* vShader = R"glshader(
-				#version 450 core                             
-				                                              
-				layout (location=0) in vec2 a_pos;            
-				out gl_PerVertex { vec4 gl_Position; };       
-				void main()                                   
-				{                                             
-				    gl_Position = vec4(a_pos, -1.0f, 1.0f);            
-                })glshader";
+		axisPipeline = createProgramPipeline(axisVertexShaderSource, axisFragmentShaderSource);
 
-		const char* fShader = R"glshader(
-				#version 450 core                          
-
-				uniform ivec2 mousePosition;          
-				//uniform int subPixelResolution;          
-
-				layout (location=0)                        
-				out vec4 o_color;                          
-
-				// Fixed point sub-pixel snapping.
-				// Pixels are centered offset by 0.5.
-				//const int fixedPointScaleFactor = 1 << subPixelResolution;
-
-				void main()
-				{
-					vec4 red = vec4(1.0f, 0.0f, 0.0f, 1.0f);
-					vec4 white = vec4(1.0f, 1.0f, 1.0f, 1.0f);
-					vec4 green = vec4(0.0f, 1.0f, 0.0f, 1.0f);
-					vec4 black = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-					float pixelHalfWidth = 0.5f;
-
-					// Normalized othogonal directions.
-					vec2 upAxis = vec2(0.0f, 1.0f);
-					vec2 rightAxis = vec2(1.0f, 0.0f);
-
-					vec4 inputPosition = vec4(float(mousePosition.x), float(mousePosition.y), 0.0f, 0.0f);
-
-					vec4 inputVector = vec4(gl_FragCoord) - inputPosition;
-
-				    float verticalPixelDelta = dot(upAxis, inputVector.xy);
-				    float horizontalPixelDelta = dot(rightAxis, inputVector.xy);
-
-					vec2 fragVectorScaled = (gl_FragCoord.xy);
-					vec2 inputVectorScaled = (inputPosition.xy);
-
-					// Upper-left screenspace origin.
-					if (mousePosition.x != -1 && mousePosition.y != -1)
-					{
-						if (horizontalPixelDelta == pixelHalfWidth)
-						{
-							// Y axis.
-
-							if (fragVectorScaled.y - pixelHalfWidth > inputVectorScaled.y)
-							{
-								o_color = green;
-                                return;
-							}
-							if (fragVectorScaled.y - pixelHalfWidth == inputVectorScaled.y)
-							{
-								o_color = white;
-                                return;
-							}
-							else
-                            {
-                                discard;
-                            }
-						}
-						if (verticalPixelDelta == pixelHalfWidth)
-						{
-							// X axis.
-
-							if (fragVectorScaled.x - pixelHalfWidth < inputVectorScaled.x)
-							{
-								o_color = red;
-                                return;
-							}
-							else
-                            {
-                                discard;
-                            }
-						}
-					}
-                    else
-                    {
-                        discard;
-                    }
-                })glshader";
-
-		axisPipeline = createProgramPipeline(vShader, fShader);
-
-		axisPipeline.mousePositionUniform = glGetUniformLocation(axisPipeline.fragmentShader, "mousePosition");
+		axisPipeline.mousePositionUniform = getUniformLocation(axisPipeline.fragmentUniforms, uniformName("mousePosition"));
 	}
 
 	{
@@ -925,7 +1258,7 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 		//glUseProgram(cubeShader.axisProgram);
 		bindProgramPipeline(axisPipeline);
 
-		cubeShader.subPixelResolutionUniform = glGetUniformLocation(axisPipeline.fragmentShader, "subPixelResolution");
+		cubeShader.subPixelResolutionUniform = getUniformLocation(axisPipeline.fragmentUniforms, uniformName("subPixelResolution"));
 
 		glProgramUniform1i(axisPipeline.fragmentShader, cubeShader.subPixelResolutionUniform, subPixelResolution);
 
@@ -935,18 +1268,61 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 
 	// Setup global GL state
 	{
-		glEnable(GL_BLEND);
+		// Setup above binds objects directly.
+		invalidateGLStateCache();
+
+		cachedEnable(GL_BLEND, true);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		glEnable(GL_CULL_FACE);
+		cachedEnable(GL_CULL_FACE, true);
+	}
+
+	// Every startup program exists by now.
+	{
+		const char* compileModeNames[] = { "the render thread", "driver threads", "a worker context" };
+
+		ProgramCacheStats programStats = getProgramCacheStats();
+		ShaderCompilerStats compilerStats = getShaderCompilerStats();
+		print("Programs: %u from cache, %u compiled on %s (%u binaries rejected), %u waited for in %.3f ms, %s start\n",
+			compilerStats.cachedCount, compilerStats.compiledCount, compileModeNames[compilerStats.mode], programStats.rejectedCount,
+			compilerStats.waitedCount, compilerStats.waitSeconds * 1000.0, compilerStats.compiledCount == 0 ? "warm" : "cold");
+	}
+
+	// Draws of both passes are recorded here and submitted sorted.
+	RenderQueue renderQueue = createRenderQueue(256, 64 * 1024);
+
+	// --bench times the renderer's subsystems before the first frame, printing the results to the console.
+	if (parameters.runBenchmarks)
+	{
+		benchmarkRenderQueue();
+		benchmarkParallelRecording();
+		benchmarkJobSystem();
+		benchmarkMipGeneration();
+		benchmarkTextureEncoding();
+		benchmarkImageDecoding();
+		benchmarkProceduralTextures();
 	}
 
 	// set to FALSE to disable vsync
 	BOOL vsync = TRUE;
 	wglSwapIntervalEXT(vsync ? 1 : 0);
 
-	// show the window
-	ShowWindow(window, SW_SHOWDEFAULT);
+	// --low-latency delays the start of each frame to just before it is due, instead of recording as early as the pacer allows
+	const bool lowLatency = parameters.lowLatency;
+
+	// --on-demand draws only when input, animation or window events change the frame
+	const bool continuousRedraw = !parameters.onDemandRedraw;
+
+	// Up to 3 frames in flight, reduced while GPU bound and raised when presents are missed.
+	// Low-latency mode keeps a single frame in flight and delays its start instead.
+	FramePacer framePacer = lowLatency ? createFramePacer(1, 1) : createFramePacer(1, 3);
+	LowLatencyScheduler lowLatencyScheduler = createLowLatencyScheduler(lowLatency);
+
+	// Picking reads the ID pass a frame late, so it does not hold the CPU to the GPU.
+	PickReadback pickReadback = createPickReadback();
+
+	// show the window, the pump thread owns it
+	ShowWindowAsync(window, SW_SHOWDEFAULT);
 
 	LARGE_INTEGER freq, c1;
 	QueryPerformanceFrequency(&freq);
@@ -954,27 +1330,118 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 
 	//float angle = 0;
 
+	// Space toggles it in on demand redraw, which starts with a still cube.
+	bool isAnimating = continuousRedraw;
+	unsigned int animationFrame = 0;
+
+	// Frames still drawn after the last change, occlusion results arrive frames after their queries.
+	unsigned int settleFrameCount = maxPacedFramesInFlight;
+
+	InputState inputState = {};
+	InputBatch inputBatch = {};
+	unsigned int inputEventCount = 0;
+	unsigned int coalescedInputCount = 0;
+
+	LatencyStats frameTimes = {};
+	LatencyStats swapTimes = {};
+	LatencyStats eventLatency = {};
+	LatencyStats inputLatency = {};
+	LatencyStats idleTimes = {};
+
 	for (;;)
 	{
-		// process all incoming Windows messages
-		MSG msg;
-		if (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
+		if (!continuousRedraw && !isAnimating && settleFrameCount == 0)
 		{
-			if (msg.message == WM_QUIT)
+			LARGE_INTEGER idleStart, idleEnd;
+			QueryPerformanceCounter(&idleStart);
+
+			// Every forwarded window or input event signals it, nothing is drawn until then.
+			WaitForSingleObject(globalRenderWakeEvent, INFINITE);
+
+			QueryPerformanceCounter(&idleEnd);
+			addLatencySample(idleTimes, (double)(idleEnd.QuadPart - idleStart.QuadPart) / freq.QuadPart);
+
+			// Neither the idle gap nor the missed vsyncs count against the next frame.
+			resumeFramePacing(framePacer);
+			c1 = idleEnd;
+		}
+
+		// Drain the forwarded window events, neither thread ever waits for the other.
+		bool isCloseRequested = false;
+		bool isFrameDirty = false;
+
+		WindowEvent event;
+		while (popQueueItem(globalWindowEvents, event))
+		{
+			LARGE_INTEGER now;
+			QueryPerformanceCounter(&now);
+
+			addLatencySample(eventLatency, (double)(now.QuadPart - event.time) / freq.QuadPart);
+
+			switch (event.message)
 			{
+			case WM_CLOSE:
+				isCloseRequested = true;
+				break;
+
+			case WM_KEYDOWN:
+				// Continuous redraw always animates.
+				isAnimating = continuousRedraw || !isAnimating;
 				break;
 			}
-			TranslateMessage(&msg);
-			DispatchMessageW(&msg);
-			continue;
+
+			isFrameDirty = true;
 		}
 
+		if (isCloseRequested)
+		{
+			break;
+		}
+
+		// Keeps the CPU from recording too far ahead of the GPU.
+		beginPacedFrame(framePacer);
+
+		// Starts no earlier than the predicted frame cost requires to make the next vsync.
+		waitForLatestFrameStart(lowLatencyScheduler, framePacer);
+		beginTimedFrame(lowLatencyScheduler);
+
+		// Copies within the frame budget, a texture is drawn only after its fence signaled.
+		updateTextureStreaming(textureStreamer);
+		updateTextureCache(textureCache, textureStreamer);
+		updateCubeShaderMaterials(cubeShader, texturePool, textureStreamer);
+		updateCubeShaderCachedTexture(cubeShader, textureCache, textureStreamer);
+
 		LARGE_INTEGER c2;
 		QueryPerformanceCounter(&c2);
 		float delta = (float)((double)(c2.QuadPart - c1.QuadPart) / freq.QuadPart);
 		c1 = c2;
 
-		const Position cursorPos = getCursorWindowPosition(window, width, height);
+		addLatencySample(frameTimes, delta);
+
+		unsigned static int counter = 0;
+
+		beginRenderQueueFrame(renderQueue);
+
+		drawCubeShaderToTexture(cubeShader, renderQueue, rttFramebuffer, width, height, animationFrame);
+		submitRenderQueue(renderQueue);
+
+		// Input since the last frame, sampled as late as possible: the ID pass does not depend on it.
+		LARGE_INTEGER inputSampleTime;
+		QueryPerformanceCounter(&inputSampleTime);
+
+		readInputBatch(globalInputEvents, inputBatch);
+		applyInputBatch(inputState, inputBatch);
+
+		if (inputBatch.eventCount > 0)
+		{
+			addLatencySample(inputLatency, (double)(inputSampleTime.QuadPart - inputBatch.oldestTime) / freq.QuadPart);
+
+			inputEventCount += inputBatch.eventCount;
+			coalescedInputCount += inputBatch.coalescedCount;
+		}
+
+		const bool isMouseButtonDown = inputState.buttons != 0;
+		const Position cursorPos = { inputState.x, inputState.y };
 
 		int mouseUniform[] = {-1, -1};
 
@@ -992,16 +1459,11 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 		// Set mouse position uniform.
 		glProgramUniform2iv(axisPipeline.fragmentShader, axisPipeline.mousePositionUniform, 1, mouseUniform);
 
-		unsigned static int counter = 0;
-
-		drawCubeShaderToTexture(cubeShader, width, height, counter, rttFramebuffer);
-		PixelBufferData rttTexels = readFromTextureCube(cursorPos.x, cursorPos.y, width, height, rttFramebuffer);
-
-		drawTexturedCubeShaderToOutput(cubeShader, width, height, counter);
+		PixelBufferData rttTexels = readFromTextureCube(pickReadback, cursorPos.x, cursorPos.y, width, height, rttFramebuffer);
 
-		++counter;
+		drawTexturedCubeShaderToOutput(cubeShader, renderQueue, width, height, animationFrame);
 
-		if (globalIsMouseButtonDown && rttTexels.objectID == 1)
+		if (isMouseButtonDown && rttTexels.objectID == 1)
 		{
 			if (isPrimitiveIDChanged(rttTexels.primitiveID))
 			{
@@ -1009,31 +1471,347 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, in
 			}
 
 			// Draw selected primitive.
-			bindProgramPipeline(pickingPipeline);
-
-			// Set vertex transform uniform.
-			glProgramUniformMatrix4fv(pickingPipeline.vertexShader, pickingPipeline.vertexTransformUniform, 1, GL_FALSE, &cubeShader.modelViewProjection.data[0][0]);
+			DrawPacket* packet = pushDrawPacket(renderQueue, makeSortKey(renderPassPicking, renderOrderOpaque, pickingPipeline.pipeline, 0, 0.0f));
 
-			glBindVertexArray(cubeShader.cubePickingVAO);
+			if (packet)
+			{
+				packet->pipeline = pickingPipeline.pipeline;
+				packet->viewport[2] = width;
+				packet->viewport[3] = height;
 
-			glDisable(GL_DEPTH_TEST);
+				// Set vertex transform uniform.
+				packet->matrix = pushFrameMatrix(renderQueue, &cubeShader.modelViewProjection.data[0][0]);
+				packet->uniformProgram = pickingPipeline.vertexShader;
+				packet->matrixUniform = pickingPipeline.vertexTransformUniform;
 
-			drawPrimitive(rttTexels.primitiveID);
+				setPickedPrimitiveDraw(cubeShader, *packet, rttTexels.primitiveID);
+			}
 		}
 
-		if (globalIsMouseButtonDown)
+		if (isMouseButtonDown)
 		{
 			// Draw coordinate-axis.
-			bindProgramPipeline(axisPipeline);
-			glBindVertexArray(quadVAO);
-			glEnable(GL_DEPTH_TEST);
-			drawQuad();
+			DrawPacket* packet = pushDrawPacket(renderQueue, makeSortKey(renderPassAxis, renderOrderOpaque, axisPipeline.pipeline, 0, 0.0f));
+
+			if (packet)
+			{
+				packet->type = drawPacketArrays;
+				packet->depthTest = true;
+				packet->pipeline = axisPipeline.pipeline;
+				packet->vertexArray = quadVAO;
+				packet->viewport[2] = width;
+				packet->viewport[3] = height;
+				packet->count = 6;
+			}
+		}
+
+		submitRenderQueue(renderQueue);
+
+		if (counter % 256 == 0)
+		{
+			const OcclusionStats& stats = cubeShader.occlusionStats;
+			print("Occlusion: objects %u/%u occluded, meshlets %u tested, %u frustum, %u cone, %u occluded, %u visible\n",
+				stats.objectsOccluded, stats.objectsTested, stats.meshletsTested, stats.meshletsFrustumCulled, stats.meshletsConeCulled, stats.meshletsOccluded, stats.meshletsVisible);
+
+			const GLStateCacheStats stateStats = getGLStateCacheStats();
+			print("GL state calls: %u issued, %u elided\n", stateStats.issuedCount, stateStats.elidedCount);
+
+			const RenderQueueStats& queueStats = renderQueue.frameStats;
+			print("Render queue: %u packets, %u program, %u vertex array, %u texture changes\n",
+				queueStats.packetCount, queueStats.programChanges, queueStats.vertexArrayChanges, queueStats.textureChanges);
+
+			print("Render thread: frame %.3f ms avg, %.3f ms max, swap %.3f ms avg, %.3f ms max, %u window events %.3f ms avg, %.3f ms max queue latency\n",
+				getAverageMilliseconds(frameTimes), frameTimes.maxSeconds * 1000.0, getAverageMilliseconds(swapTimes), swapTimes.maxSeconds * 1000.0,
+				eventLatency.sampleCount, getAverageMilliseconds(eventLatency), eventLatency.maxSeconds * 1000.0);
+
+			const unsigned int forwardedCount = globalPumpStats.forwardedCount.exchange(0, std::memory_order_relaxed);
+			const unsigned int droppedCount = globalPumpStats.droppedCount.exchange(0, std::memory_order_relaxed);
+			const LONGLONG maxDispatchTicks = globalPumpStats.maxDispatchTicks.exchange(0, std::memory_order_relaxed);
+
+			print("Message pump: %u events forwarded, %u dropped, %.3f ms max dispatch\n",
+				forwardedCount, droppedCount, (double)maxDispatchTicks * 1000.0 / freq.QuadPart);
+
+			const FramePacingStats pacingStats = takeFramePacingStats(framePacer);
+			const double presentCount = pacingStats.frameCount ? (double)pacingStats.frameCount : 1.0;
+			const double presentMean = pacingStats.presentIntervalSeconds / presentCount;
+			const double presentVariance = pacingStats.presentIntervalSquaredSeconds / presentCount - presentMean * presentMean;
+
+			print("Frame pacing: %u in flight, present %.3f ms avg, %.3f ms max, %.3f ms deviation, %u missed, fence wait %.3f ms avg, %.3f ms max, %u GPU starved\n",
+				framePacer.framesInFlight, presentMean * 1000.0, pacingStats.maxPresentIntervalSeconds * 1000.0, sqrt(presentVariance > 0.0 ? presentVariance : 0.0) * 1000.0,
+				pacingStats.missedCount, pacingStats.fenceWaitSeconds * 1000.0 / presentCount, pacingStats.maxFenceWaitSeconds * 1000.0, pacingStats.gpuStarvedCount);
+
+			print("Picking: %u reads pending, %u frames skipped\n", pickReadback.pendingCount, pickReadback.skippedCount);
+			pickReadback.skippedCount = 0;
+
+			print("Input: %u events in %u batches, %u moves coalesced, %.3f ms avg, %.3f ms max oldest event age\n",
+				inputEventCount, inputLatency.sampleCount, coalescedInputCount, getAverageMilliseconds(inputLatency), inputLatency.maxSeconds * 1000.0);
+
+			const LowLatencyStats latencyStats = takeLowLatencyStats(lowLatencyScheduler);
+			const double latencyFrameCount = latencyStats.frameCount ? (double)latencyStats.frameCount : 1.0;
+			const double inputFrameCount = latencyStats.inputFrameCount ? (double)latencyStats.inputFrameCount : 1.0;
+
+			print("Low latency: %s, delay %.3f ms avg, cpu %.3f ms, gpu %.3f ms, predicted %.3f ms, input to present %.3f ms avg, %.3f ms max in %u frames\n",
+				lowLatencyScheduler.enabled ? "on" : "off", latencyStats.delaySeconds * 1000.0 / latencyFrameCount,
+				latencyStats.cpuSeconds * 1000.0 / latencyFrameCount, latencyStats.gpuSeconds * 1000.0 / latencyFrameCount, latencyStats.predictedSeconds * 1000.0 / latencyFrameCount,
+				latencyStats.inputToPresentSeconds * 1000.0 / inputFrameCount, latencyStats.maxInputToPresentSeconds * 1000.0, latencyStats.inputFrameCount);
+
+			const TextureStreamingStats streamingStats = takeTextureStreamingStats(textureStreamer);
+
+			print("Texture streaming: %u textures, %.2f MB uploaded in %u frames, %u budget limited, %u ring full\n",
+				streamingStats.uploadedCount, (double)streamingStats.uploadedBytes / (1024.0 * 1024.0), streamingStats.frameCount,
+				streamingStats.budgetLimitedCount, streamingStats.ringFullCount);
+
+			const TexturePoolStats poolStats = getTexturePoolStats(texturePool);
+
+			print("Texture pool: %u of %u layers used in %u arrays, %.2f MB\n",
+				poolStats.usedLayerCount, poolStats.layerCount, poolStats.arrayCount, (double)poolStats.byteCount / (1024.0 * 1024.0));
+
+			const TextureCacheStats cacheStats = takeTextureCacheStats(textureCache);
+			const unsigned int cacheLookupCount = cacheStats.hitCount + cacheStats.missCount;
+
+			print("Texture cache: %u resident, %u loading, %.2f of %.2f MB, %.1f%% hits, %u loads, %u evictions\n",
+				cacheStats.residentCount, cacheStats.loadingCount, (double)cacheStats.gpuByteCount / (1024.0 * 1024.0), (double)cacheStats.byteBudget / (1024.0 * 1024.0),
+				cacheLookupCount ? 100.0 * cacheStats.hitCount / cacheLookupCount : 0.0, cacheStats.loadCount, cacheStats.evictionCount);
+
+			print("Redraw: %s, animation %s, %u idle waits %.3f ms avg, %.3f ms max\n",
+				continuousRedraw ? "continuous" : "on demand", isAnimating ? "on" : "off",
+				idleTimes.sampleCount, getAverageMilliseconds(idleTimes), idleTimes.maxSeconds * 1000.0);
+
+			frameTimes = {};
+			swapTimes = {};
+			idleTimes = {};
+			eventLatency = {};
+			inputLatency = {};
+			inputEventCount = 0;
+			coalescedInputCount = 0;
+		}
+
+		++counter;
+
+		if (isAnimating)
+		{
+			++animationFrame;
+		}
+
+		if (isFrameDirty || isAnimating || inputBatch.eventCount > 0 || isTextureStreamingBusy(textureStreamer))
+		{
+			settleFrameCount = maxPacedFramesInFlight;
+		}
+		else if (settleFrameCount > 0)
+		{
+			--settleFrameCount;
 		}
 
+		endTimedFrame(lowLatencyScheduler);
+
+		LARGE_INTEGER swapStart, swapEnd;
+		QueryPerformanceCounter(&swapStart);
+
 		// Swap the buffers to show output.
 		if (!SwapBuffers(dc))
 		{
 			FatalError("Failed to swap OpenGL buffers!");
 		}
+
+		QueryPerformanceCounter(&swapEnd);
+		addLatencySample(swapTimes, (double)(swapEnd.QuadPart - swapStart.QuadPart) / freq.QuadPart);
+
+		endPacedFrame(framePacer);
+		recordFramePresent(lowLatencyScheduler, framePacer, inputBatch.eventCount > 0 ? inputBatch.oldestTime : 0);
+		endGLStateCacheFrame();
+	}
+
+	destroyPickReadback(pickReadback);
+	destroyLowLatencyScheduler(lowLatencyScheduler);
+	destroyTextureCache(textureCache, textureStreamer);
+	destroyTextureStreamer(textureStreamer);
+	destroyTexturePool(texturePool);
+	destroySharedSamplers();
+	destroyJobSystem(jobSystem);
+	destroyFramePacer(framePacer);
+	shutdownShaderCompiler();
+
+	wglMakeCurrent(NULL, NULL);
+	wglDeleteContext(rc);
+
+	PostMessageW(window, renderThreadExitMessage, 0, 0);
+}
+
+int WINAPI WinMain(HINSTANCE instance, HINSTANCE previnstance, LPSTR cmdline, int cmdshow)
+{
+	{
+		S s = {};
+		foo(&s);
 	}
+#if 0
+	for (int i = INT_MIN; i < INT_MAX; ++i)
+	{
+		if (i >= INT_MIN / 7 && i <= INT_MAX / 7)
+		{
+			assert(i >= INT_MIN / 7 && i <= INT_MAX / 7);
+			const int result = narrowMult(i);
+
+			if (result != i)
+			{
+				FatalError("Fatal!");
+			}
+		}
+	}
+#endif
+
+	AttachConsole(ATTACH_PARENT_PROCESS);
+
+	// get WGL functions to be able to create modern GL context
+	GetWglFunctions();
+
+	// register window class to have custom WindowProc callback
+	WNDCLASSEXW wc = {};
+	wc.cbSize = sizeof(wc);
+	// The DC is used on the render thread for the lifetime of the window.
+	wc.style = CS_OWNDC;
+	wc.lpfnWndProc = WindowProc;
+	wc.hInstance = instance;
+	wc.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+	wc.lpszClassName = L"opengl_window_class";
+	ATOM atom = RegisterClassExW(&wc);
+	Invariant(atom && "Failed to register window class");
+
+	// window properties - width, height and style
+	int width = CW_USEDEFAULT;
+	int height = CW_USEDEFAULT;
+	DWORD exstyle = WS_EX_APPWINDOW;
+	DWORD style = WS_POPUPWINDOW;
+
+	// uncomment in case you want fixed size window
+	style &= ~WS_THICKFRAME & ~WS_MAXIMIZEBOX & ~WS_BORDER;
+	RECT rect = { 0, 0, 800, 600 };
+	AdjustWindowRectEx(&rect, style, FALSE, exstyle);
+	width = rect.right - rect.left;
+	height = rect.bottom - rect.top;
+
+	// create window
+	HWND window = CreateWindowExW(
+		exstyle, wc.lpszClassName, L"OpenGL Window", style,
+		1920/2 - width/2, 1080/2 - height/2, width, height,
+		NULL, NULL, wc.hInstance, NULL);
+	Invariant(window && "Failed to create window");
+
+	RECT clientRectangle = {};
+	GetClientRect(window, &clientRectangle);
+
+	width = clientRectangle.right - clientRectangle.left;
+	height = clientRectangle.bottom - clientRectangle.top;
+
+	Invariant(width > 0 && width <= (rect.right - rect.left));
+	Invariant(height > 0 && height <= (rect.bottom - rect.top));
+
+	const float aspectRatio = (float)height / width;
+
+	HDC dc = GetDC(window);
+	Invariant(dc && "Failed to window device context");
+
+	// set pixel format for OpenGL context
+	{
+		int attrib[] =
+		{
+			WGL_DRAW_TO_WINDOW_ARB, GL_TRUE,
+			WGL_SUPPORT_OPENGL_ARB, GL_TRUE,
+			WGL_DOUBLE_BUFFER_ARB,  GL_TRUE,
+			WGL_PIXEL_TYPE_ARB,     WGL_TYPE_RGBA_ARB,
+			WGL_COLOR_BITS_ARB,     24,
+			WGL_DEPTH_BITS_ARB,     24,
+			WGL_STENCIL_BITS_ARB,   8,
+
+			// uncomment for sRGB framebuffer, from WGL_ARB_framebuffer_sRGB extension
+			// https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_framebuffer_sRGB.txt
+			//WGL_FRAMEBUFFER_SRGB_CAPABLE_ARB, GL_TRUE,
+
+			// uncomment for multisampeld framebuffer, from WGL_ARB_multisample extension
+			// https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_multisample.txt
+			//WGL_SAMPLE_BUFFERS_ARB, 1,
+			//WGL_SAMPLES_ARB,        4, // 4x MSAA
+
+			0,
+		};
+
+		int format;
+		UINT formats;
+		if (!wglChoosePixelFormatARB(dc, attrib, NULL, 1, &format, &formats) || formats == 0)
+		{
+			FatalError("OpenGL does not support required pixel format!");
+		}
+
+		PIXELFORMATDESCRIPTOR desc = {};
+		desc.nSize = sizeof(desc);
+		int ok = DescribePixelFormat(dc, format, sizeof(desc), &desc);
+		Invariant(ok && "Failed to describe OpenGL pixel format");
+
+		if (!SetPixelFormat(dc, format, &desc))
+		{
+			FatalError("Cannot set OpenGL selected pixel format!");
+		}
+	}
+
+	// The render thread creates the GL context on the window and runs the frame loop.
+	std::string_view commandLine = cmdline ? cmdline : "";
+	bool lowLatency = false;
+	bool onDemandRedraw = false;
+	bool runBenchmarks = false;
+
+	// The switches come first, in any order.
+	for (;;)
+	{
+		if (takeCommandLineSwitch(commandLine, "--low-latency"))
+		{
+			lowLatency = true;
+		}
+		else if (takeCommandLineSwitch(commandLine, "--on-demand"))
+		{
+			onDemandRedraw = true;
+		}
+		else if (takeCommandLineSwitch(commandLine, "--bench"))
+		{
+			runBenchmarks = true;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	RenderThreadParameters renderParameters = { window, dc, width, height, getCommandLinePath(commandLine), lowLatency, onDemandRedraw, runBenchmarks };
+	globalRenderWakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+	if (!globalRenderWakeEvent)
+	{
+		FatalError("Failed to create render thread wake event!");
+	}
+
+	std::thread renderThread(runRenderThread, renderParameters);
+
+	// Only the message pump runs here, it never waits for the GPU.
+	MSG msg;
+	while (GetMessageW(&msg, NULL, 0, 0) > 0)
+	{
+		LARGE_INTEGER dispatchStart, dispatchEnd;
+		QueryPerformanceCounter(&dispatchStart);
+
+		TranslateMessage(&msg);
+		DispatchMessageW(&msg);
+
+		QueryPerformanceCounter(&dispatchEnd);
+
+		const LONGLONG dispatchTicks = dispatchEnd.QuadPart - dispatchStart.QuadPart;
+
+		if (dispatchTicks > globalPumpStats.maxDispatchTicks.load(std::memory_order_relaxed))
+		{
+			globalPumpStats.maxDispatchTicks.store(dispatchTicks, std::memory_order_relaxed);
+		}
+	}
+
+	renderThread.join();
+
+	CloseHandle(globalRenderWakeEvent);
+
+	return 0;
 }